@@ -10,7 +10,12 @@ public class NAVIS : ModuleRules
 	
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore" });
 
-		PrivateDependencyModuleNames.AddRange(new string[] { "NAVIS_Physics" });
+		// ANAVISBenchmarkShip implements IFloatingObjectInterface
+		PublicDependencyModuleNames.AddRange(new string[] { "NAVIS_Physics" });
+		PrivateDependencyModuleNames.AddRange(new string[] { "NAVIS_Water" });
+
+		// benchmark reports
+		PrivateDependencyModuleNames.AddRange(new string[] { "Json" });
 
 		// Uncomment if you are using Slate UI
 		// PrivateDependencyModuleNames.AddRange(new string[] { "Slate", "SlateCore" });
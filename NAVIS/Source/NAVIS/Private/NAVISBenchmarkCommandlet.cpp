@@ -0,0 +1,223 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "NAVISBenchmarkCommandlet.h"
+#include "NAVISBenchmarkShip.h"
+#include "SeaActor.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogNAVISBenchmark, Log, All);
+
+void FNAVISBenchmarkTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if(Timestamp)
+		*Timestamp = FPlatformTime::Seconds();
+}
+
+FString FNAVISBenchmarkTickFunction::DiagnosticMessage()
+{
+	return TEXT("FNAVISBenchmarkTickFunction");
+}
+
+UNAVISBenchmarkCommandlet::UNAVISBenchmarkCommandlet() : Super(), MaxFrameMs(0.f), MaxBuoyancyMs(0.f), MaxPhysicsMs(0.f), MaxMemoryGrowthMB(0.f)
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = true;
+	LogToConsole = true;
+}
+
+int32 UNAVISBenchmarkCommandlet::Main(const FString& Params)
+{
+	// scenario
+	int32 NumShips = 64;
+	float Seconds = 10.f;
+	float WarmupSeconds = 1.f;
+	float Fps = 60.f;
+	float Spacing = 2500.f;
+	FString Detection = TEXT("SurfaceTest");
+	FString ReportPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("NAVISBenchmark");
+	FParse::Value(*Params, TEXT("Ships="), NumShips);
+	FParse::Value(*Params, TEXT("Seconds="), Seconds);
+	FParse::Value(*Params, TEXT("Warmup="), WarmupSeconds);
+	FParse::Value(*Params, TEXT("Fps="), Fps);
+	FParse::Value(*Params, TEXT("Spacing="), Spacing);
+	FParse::Value(*Params, TEXT("Detection="), Detection);
+	FParse::Value(*Params, TEXT("Report="), ReportPath);
+
+	// thresholds, the command line wins over the config
+	FParse::Value(*Params, TEXT("MaxFrameMs="), MaxFrameMs);
+	FParse::Value(*Params, TEXT("MaxBuoyancyMs="), MaxBuoyancyMs);
+	FParse::Value(*Params, TEXT("MaxPhysicsMs="), MaxPhysicsMs);
+	FParse::Value(*Params, TEXT("MaxMemoryGrowthMB="), MaxMemoryGrowthMB);
+
+	NumShips = FMath::Max(NumShips, 1);
+	Fps = FMath::Max(Fps, 1.f);
+	const float DeltaSeconds = 1.f / Fps;
+	const int32 NumWarmupFrames = FMath::Max(FMath::CeilToInt(WarmupSeconds * Fps), 0);
+	const int32 NumFrames = FMath::Max(FMath::CeilToInt(Seconds * Fps), 1);
+	const ESeaDetectionMode DetectionMode = Detection.Equals(TEXT("Overlap"), ESearchCase::IgnoreCase) ? ESeaDetectionMode::Overlap : ESeaDetectionMode::SurfaceTest;
+
+	// a game world of our own, without game mode : begin play is dispatched by hand
+	UWorld * World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("NAVISBenchmark"));
+	FWorldContext &WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->bShouldSimulatePhysics = true;
+	World->InitializeActorsForPlay(FURL());
+
+	// the fleet sits on a square grid, the sea covers it
+	const int32 Side = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumShips)));
+	const float HalfSize = Side * Spacing * 0.5f;
+	ASeaActor * Sea = World->SpawnActor<ASeaActor>();
+	Sea->SetDetectionMode(DetectionMode);
+	Sea->ApplyExtent(FVector2D(HalfSize + Spacing, HalfSize + Spacing));
+
+	World->GetWorldSettings()->NotifyBeginPlay();
+
+	TArray<ANAVISBenchmarkShip *> Ships;
+	Ships.Reserve(NumShips);
+	for(int32 Idx = 0; Idx < NumShips; Idx++)
+	{
+		const FVector Location = FVector((Idx % Side + 0.5f) * Spacing - HalfSize, (Idx / Side + 0.5f) * Spacing - HalfSize, 0.f);
+		ANAVISBenchmarkShip * Ship = World->SpawnActor<ANAVISBenchmarkShip>(Location, FRotator::ZeroRotator);
+		if(Ship)
+			Ships.Add(Ship);
+	}
+
+	// physics runs between these two, whatever else runs during physics is counted with it
+	double PhysicsStart = 0.0;
+	double PhysicsEnd = 0.0;
+	FNAVISBenchmarkTickFunction PhysicsStartMarker;
+	FNAVISBenchmarkTickFunction PhysicsEndMarker;
+	PhysicsStartMarker.bCanEverTick = true;
+	PhysicsStartMarker.TickGroup = TG_StartPhysics;
+	PhysicsStartMarker.Timestamp = &PhysicsStart;
+	PhysicsStartMarker.RegisterTickFunction(World->PersistentLevel);
+	PhysicsEndMarker.bCanEverTick = true;
+	PhysicsEndMarker.TickGroup = TG_PostPhysics;
+	PhysicsEndMarker.Timestamp = &PhysicsEnd;
+	PhysicsEndMarker.RegisterTickFunction(World->PersistentLevel);
+
+	UE_LOG(LogNAVISBenchmark, Display, TEXT("%d ships, %d frames at %.0f fps after %d warmup frames, %s detection"), Ships.Num(), NumFrames, Fps, NumWarmupFrames, DetectionMode == ESeaDetectionMode::Overlap ? TEXT("overlap") : TEXT("surface test"));
+
+	TArray<FFrameSample> Samples;
+	Samples.Reserve(NumFrames);
+	double CurrentTime = FApp::GetCurrentTime();
+	for(int32 Frame = 0; Frame < NumWarmupFrames + NumFrames; Frame++)
+	{
+		CurrentTime += DeltaSeconds;
+		FApp::SetDeltaTime(DeltaSeconds);
+		FApp::SetCurrentTime(CurrentTime);
+		GFrameCounter++;
+
+		const double FrameStart = FPlatformTime::Seconds();
+		World->Tick(LEVELTICK_All, DeltaSeconds);
+		const double FrameEnd = FPlatformTime::Seconds();
+
+		uint64 BuoyancyCycles = 0;
+		for(ANAVISBenchmarkShip * Ship : Ships)
+		{
+			if(Ship && !Ship->IsPendingKill())
+				BuoyancyCycles += Ship->ConsumeBuoyancyCycles();
+		}
+
+		if(Frame < NumWarmupFrames)
+			continue;
+
+		FFrameSample Sample;
+		Sample.FrameMs    = (FrameEnd - FrameStart) * 1000.0;
+		Sample.BuoyancyMs = FPlatformTime::ToMilliseconds64(BuoyancyCycles);
+		Sample.PhysicsMs  = PhysicsEnd > PhysicsStart ? (PhysicsEnd - PhysicsStart) * 1000.0 : 0.0;
+		Sample.UsedMB     = FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0);
+		Samples.Add(Sample);
+	}
+
+	PhysicsStartMarker.UnRegisterTickFunction();
+	PhysicsEndMarker.UnRegisterTickFunction();
+
+	const FString Scenario = FString::Printf(TEXT("%d ships, %.1f s at %.0f fps, %s"), Ships.Num(), Seconds, Fps, *Detection);
+	const bool bPassed = WriteReport(ReportPath, Samples, Scenario);
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+
+	return bPassed ? 0 : 1;
+}
+
+bool UNAVISBenchmarkCommandlet::WriteReport(const FString &reportPath, const TArray<FFrameSample> &samples, const FString &scenario) const
+{
+	bool bPassed = true;
+	TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+	Report->SetStringField(TEXT("scenario"), scenario);
+	Report->SetNumberField(TEXT("frames"), samples.Num());
+
+	// one entry per metric : average, 95th percentile and worst frame, checked on the average
+	auto AddMetric = [&](const TCHAR * name, double FFrameSample::* member, float threshold)
+	{
+		TArray<double> Values;
+		Values.Reserve(samples.Num());
+		double Sum = 0.0;
+		for(const FFrameSample &Sample : samples)
+		{
+			Values.Add(Sample.*member);
+			Sum += Sample.*member;
+		}
+		Values.Sort();
+
+		const double Average = Values.Num() > 0 ? Sum / Values.Num() : 0.0;
+		const bool bMetricPassed = threshold <= 0.f || Average <= threshold;
+		bPassed &= bMetricPassed;
+
+		TSharedRef<FJsonObject> Metric = MakeShared<FJsonObject>();
+		Metric->SetNumberField(TEXT("average"), Average);
+		Metric->SetNumberField(TEXT("p95"), Values.Num() > 0 ? Values[FMath::Min(Values.Num() * 95 / 100, Values.Num() - 1)] : 0.0);
+		Metric->SetNumberField(TEXT("max"), Values.Num() > 0 ? Values.Last() : 0.0);
+		Metric->SetNumberField(TEXT("threshold"), threshold);
+		Metric->SetBoolField(TEXT("passed"), bMetricPassed);
+		Report->SetObjectField(name, Metric);
+
+		UE_LOG(LogNAVISBenchmark, Display, TEXT("%-12s average %8.3f  p95 %8.3f  max %8.3f  %s"), name, Average, Metric->GetNumberField(TEXT("p95")), Metric->GetNumberField(TEXT("max")), bMetricPassed ? TEXT("") : TEXT("FAILED"));
+	};
+
+	AddMetric(TEXT("frame_ms"),    &FFrameSample::FrameMs,    MaxFrameMs);
+	AddMetric(TEXT("buoyancy_ms"), &FFrameSample::BuoyancyMs, MaxBuoyancyMs);
+	AddMetric(TEXT("physics_ms"),  &FFrameSample::PhysicsMs,  MaxPhysicsMs);
+
+	const double MemoryGrowth = samples.Num() > 0 ? samples.Last().UsedMB - samples[0].UsedMB : 0.0;
+	const bool bMemoryPassed = MaxMemoryGrowthMB <= 0.f || MemoryGrowth <= MaxMemoryGrowthMB;
+	bPassed &= bMemoryPassed;
+	TSharedRef<FJsonObject> Memory = MakeShared<FJsonObject>();
+	Memory->SetNumberField(TEXT("growth"), MemoryGrowth);
+	Memory->SetNumberField(TEXT("threshold"), MaxMemoryGrowthMB);
+	Memory->SetBoolField(TEXT("passed"), bMemoryPassed);
+	Report->SetObjectField(TEXT("memory_mb"), Memory);
+	UE_LOG(LogNAVISBenchmark, Display, TEXT("%-12s growth  %8.3f  %s"), TEXT("memory_mb"), MemoryGrowth, bMemoryPassed ? TEXT("") : TEXT("FAILED"));
+
+	Report->SetBoolField(TEXT("passed"), bPassed);
+
+	FString Json;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Report, Writer);
+
+	FString Csv = TEXT("frame,frame_ms,buoyancy_ms,physics_ms,used_mb\n");
+	for(int32 Idx = 0; Idx < samples.Num(); Idx++)
+	{
+		const FFrameSample &Sample = samples[Idx];
+		Csv += FString::Printf(TEXT("%d,%.4f,%.4f,%.4f,%.2f\n"), Idx, Sample.FrameMs, Sample.BuoyancyMs, Sample.PhysicsMs, Sample.UsedMB);
+	}
+
+	if(!FFileHelper::SaveStringToFile(Json, *(reportPath + TEXT(".json"))) || !FFileHelper::SaveStringToFile(Csv, *(reportPath + TEXT(".csv"))))
+		UE_LOG(LogNAVISBenchmark, Error, TEXT("cannot write the report to %s"), *reportPath);
+	else
+		UE_LOG(LogNAVISBenchmark, Display, TEXT("report written to %s.json and .csv, %s"), *reportPath, bPassed ? TEXT("passed") : TEXT("FAILED"));
+
+	return bPassed;
+}
@@ -0,0 +1,82 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "NAVISBenchmarkShip.h"
+#include "SeaActor.h"
+#include "SeaSurfaceComponent.h"
+#include "Components/BoxComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+ANAVISBenchmarkShip::ANAVISBenchmarkShip() : Super(), HullExtent(FVector(800.f, 200.f, 150.f)), LiquidDensity(1.f), Sea(nullptr), SeaSurface(nullptr), BuoyancyCycles(0)
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	HullComp = CreateDefaultSubobject<UBoxComponent>(TEXT("HullComp"));
+	HullComp->SetBoxExtent(HullExtent, false);
+	HullComp->SetCollisionProfileName(UCollisionProfile::PhysicsActor_ProfileName);
+	HullComp->SetSimulatePhysics(true);
+	RootComponent = HullComp;
+}
+
+void ANAVISBenchmarkShip::BeginPlay()
+{
+	HullComp->SetBoxExtent(HullExtent, true);
+
+	Super::BeginPlay();
+
+	if(!Sea)
+	{
+		TActorIterator<ASeaActor> Itr(GetWorld());
+		if(Itr)
+			SetSea(*Itr);
+	}
+}
+
+void ANAVISBenchmarkShip::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if(Sea)
+		Sea->UnregisterFloatingComponent(HullComp);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ANAVISBenchmarkShip::SetSea(ASeaActor * newSea)
+{
+	if(Sea)
+		Sea->UnregisterFloatingComponent(HullComp);
+
+	Sea = newSea;
+	SeaSurface = Sea ? Sea->FindComponentByClass<USeaSurfaceComponent>() : nullptr;
+
+	if(Sea)
+		Sea->RegisterFloatingComponent(HullComp);
+}
+
+void ANAVISBenchmarkShip::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if(!SeaSurface)
+		return;
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	const FVector Location = HullComp->GetComponentLocation();
+	const float SurfaceZ = SeaSurface->GetComponentLocation().Z + SeaSurface->GetWaveHeightAt(Location);
+	ApplyArchimedesForce(FPlane(FVector(Location.X, Location.Y, SurfaceZ), FVector::UpVector), LiquidDensity);
+
+	BuoyancyCycles += FPlatformTime::Cycles64() - StartCycles;
+}
+
+UPrimitiveComponent* ANAVISBenchmarkShip::GetFloatingComponent() const
+{
+	return HullComp;
+}
+
+uint64 ANAVISBenchmarkShip::ConsumeBuoyancyCycles()
+{
+	const uint64 Cycles = BuoyancyCycles;
+	BuoyancyCycles = 0;
+	return Cycles;
+}
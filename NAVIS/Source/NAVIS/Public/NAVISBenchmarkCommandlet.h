@@ -0,0 +1,92 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "Engine/EngineBaseTypes.h"
+#include "NAVISBenchmarkCommandlet.generated.h"
+
+/**
+ *  NAVIS
+ *	FNAVISBenchmarkTickFunction
+ *  Writes the time it ran at, to find out when a tick group starts or ends
+ */
+USTRUCT()
+struct FNAVISBenchmarkTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	/** Timestamp    receives FPlatformTime::Seconds() when ticked */
+	double * Timestamp = nullptr;
+
+	//~ Begin FTickFunction Interface.
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+	//~ End FTickFunction Interface.
+};
+
+template<>
+struct TStructOpsTypeTraits<FNAVISBenchmarkTickFunction> : public TStructOpsTypeTraitsBase2<FNAVISBenchmarkTickFunction>
+{
+	enum { WithCopy = false };
+};
+
+/**
+ *  NAVIS
+ *	UNAVISBenchmarkCommandlet
+ *  Repeatable performance scenario : a fleet of @see ANAVISBenchmarkShip on a sea, simulated for a fixed time with fixed steps.
+ *  Writes a JSON summary and a CSV of every frame, and fails when a threshold is exceeded.
+ *
+ *  UE4Editor-Cmd NAVIS.uproject -run=NAVISBenchmark -nullrhi [-Ships=64] [-Seconds=10] [-Fps=60] [-Spacing=2500]
+ *                [-Detection=SurfaceTest|Overlap] [-Report=<path without extension>]
+ *                [-MaxFrameMs=] [-MaxBuoyancyMs=] [-MaxPhysicsMs=] [-MaxMemoryGrowthMB=]
+ *
+ *  @note   thresholds default to the config values, see [/Script/NAVIS.NAVISBenchmarkCommandlet] in DefaultGame.ini.
+ *          A threshold of 0 is not checked
+ */
+UCLASS(config = Game)
+class NAVIS_API UNAVISBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	/** UNAVISBenchmarkCommandlet   constructor  */
+	UNAVISBenchmarkCommandlet();
+
+	//~ Begin UCommandlet Interface.
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface.
+
+protected:
+
+	/** MaxFrameMs          average game thread time of a frame, in milliseconds */
+	UPROPERTY(config)
+	float MaxFrameMs;
+
+	/** MaxBuoyancyMs       average time spent in the buoyancy of the whole fleet per frame, in milliseconds */
+	UPROPERTY(config)
+	float MaxBuoyancyMs;
+
+	/** MaxPhysicsMs        average time between the start and the end of the physics tick groups, in milliseconds */
+	UPROPERTY(config)
+	float MaxPhysicsMs;
+
+	/** MaxMemoryGrowthMB   growth of the used physical memory from the first to the last frame, in megabytes */
+	UPROPERTY(config)
+	float MaxMemoryGrowthMB;
+
+private:
+
+	/** FFrameSample    what is measured each frame */
+	struct FFrameSample
+	{
+		double FrameMs;
+		double BuoyancyMs;
+		double PhysicsMs;
+		double UsedMB;
+	};
+
+	/** WriteReport()   Save the summary as <path>.json and the frames as <path>.csv  @return false if a threshold failed */
+	bool WriteReport(const FString &reportPath, const TArray<FFrameSample> &samples, const FString &scenario) const;
+};
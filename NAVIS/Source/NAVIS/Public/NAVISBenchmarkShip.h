@@ -0,0 +1,71 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "FloatingObjectInterface.h"
+#include "NAVISBenchmarkShip.generated.h"
+
+class UBoxComponent;
+class ASeaActor;
+class USeaSurfaceComponent;
+
+/**
+ *  NAVIS
+ *	ANAVISBenchmarkShip
+ *  Simplest floating actor : a physics box pushed by Archimedes' force every tick, registered to the sea it floats on.
+ *  Used by @see UNAVISBenchmarkCommandlet to fill the sea with a fleet, it also times its buoyancy
+ */
+UCLASS(Category = "NAVIS")
+class NAVIS_API ANAVISBenchmarkShip : public AActor, public IFloatingObjectInterface
+{
+	GENERATED_BODY()
+
+public:
+
+	/** ANAVISBenchmarkShip   constructor  */
+	ANAVISBenchmarkShip();
+
+	//~ Begin AActor Interface.
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+	//~ End AActor Interface.
+
+	//~ Begin IFloatingObjectInterface Interface.
+	virtual UPrimitiveComponent* GetFloatingComponent() const override;
+	//~ End IFloatingObjectInterface Interface.
+
+	/** SetSea()    Float on this sea rather than the first one found at BeginPlay, registers the hull to it */
+	void SetSea(ASeaActor * newSea);
+
+	/** ConsumeBuoyancyCycles()    @return cycles spent in buoyancy since the last call, then starts counting again */
+	uint64 ConsumeBuoyancyCycles();
+
+protected:
+
+	/** HullExtent    half size of the hull box */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	FVector HullExtent;
+
+	/** LiquidDensity    density given to the buoyancy, 1 for water in unreal units  */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "0.0"))
+	float LiquidDensity;
+
+private:
+
+	/** HullComp    root and physics body of the ship  */
+	UPROPERTY(VisibleDefaultsOnly, meta=(AllowPrivateAccess = "true"))
+	UBoxComponent * HullComp;
+
+	/** Sea         what the ship floats on  */
+	UPROPERTY(transient)
+	ASeaActor * Sea;
+
+	/** SeaSurface  surface of @see Sea, where heights are read */
+	UPROPERTY(transient)
+	USeaSurfaceComponent * SeaSurface;
+
+	/** BuoyancyCycles  cycles accumulated since the last @see ConsumeBuoyancyCycles() */
+	uint64 BuoyancyCycles;
+};
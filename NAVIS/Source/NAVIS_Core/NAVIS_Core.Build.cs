@@ -0,0 +1,20 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class NAVIS_Core : ModuleRules
+{
+    public NAVIS_Core(ReadOnlyTargetRules Target) : base(Target)
+    {
+        PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        // plain C++ math, also built outside of the engine by Tools/NAVISCore : keep it to Core
+        PublicDependencyModuleNames.AddRange(new string[] { "Core" });
+
+        //The path for the header files
+        PublicIncludePaths.AddRange(new string[] { "NAVIS_Core/Public" });
+
+        //The path for the source files
+        PrivateIncludePaths.AddRange(new string[] { "NAVIS_Core/Private" });
+    }
+}
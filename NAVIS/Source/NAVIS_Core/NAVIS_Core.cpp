@@ -0,0 +1,20 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+#include "NAVIS_Core.h"
+
+DEFINE_LOG_CATEGORY(LogNAVIS_Core);
+
+#define LOCTEXT_NAMESPACE "NAVIS_Core"
+
+void FNAVIS_Core::StartupModule()
+{
+	UE_LOG(LogNAVIS_Core, Warning, TEXT("NAVIS_Core module has started"));
+}
+
+void FNAVIS_Core::ShutdownModule()
+{
+	UE_LOG(LogNAVIS_Core, Warning, TEXT("NAVIS_Core module has shut down"));
+}
+
+#undef LOCTEXT_NAMESPACE
+
+IMPLEMENT_MODULE(FNAVIS_Core, NAVIS_Core)
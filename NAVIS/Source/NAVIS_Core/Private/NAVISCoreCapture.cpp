@@ -0,0 +1,149 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "NAVISCoreCapture.h"
+#include <algorithm>
+#include <cstring>
+
+namespace NAVISCore
+{
+	namespace
+	{
+		const char CaptureMagic[4] = { 'N', 'A', 'V', 'C' };
+
+		enum : uint8_t
+		{
+			RecordHull = 1,
+			RecordQuery = 2,
+		};
+
+		/** FCaptureCursor	reads values out of a buffer, until the end */
+		struct FCaptureCursor
+		{
+			const uint8_t* Data;
+			size_t Size;
+			size_t Offset = 0;
+
+			FCaptureCursor(const uint8_t* InData, size_t InSize) : Data(InData), Size(InSize) {}
+
+			bool Read(void* Out, size_t Bytes)
+			{
+				if (Size - Offset < Bytes)
+					return false;
+				std::memcpy(Out, Data + Offset, Bytes);
+				Offset += Bytes;
+				return true;
+			}
+
+			template<typename Type>
+			bool Read(Type& Out) { return Read(&Out, sizeof(Type)); }
+		};
+	}
+
+	FConvexHullView FCaptureHull::GetView() const
+	{
+		FConvexHullView View;
+		View.Vertices = Vertices.data();
+		View.NumVertices = int32_t(Vertices.size());
+		View.Indices = Indices.data();
+		View.NumTriangles = int32_t(Indices.size() / 3);
+		return View;
+	}
+
+	FCaptureWriter::FCaptureWriter()
+	{
+		Write(CaptureMagic, sizeof(CaptureMagic));
+		Write(CaptureVersion);
+	}
+
+	void FCaptureWriter::Write(const void* Data, size_t Size)
+	{
+		if (Size == 0)
+			return;
+		const size_t Offset = Buffer.size();
+		Buffer.resize(Offset + Size);
+		std::memcpy(Buffer.data() + Offset, Data, Size);
+	}
+
+	template<typename Type>
+	void FCaptureWriter::Write(const Type& Value)
+	{
+		Write(&Value, sizeof(Type));
+	}
+
+	void FCaptureWriter::AddHull(uint32_t HullId, const FConvexHullView& Hull)
+	{
+		if (!WrittenHulls.insert(HullId).second)
+			return;
+
+		Write(uint8_t(RecordHull));
+		Write(HullId);
+		Write(uint32_t(Hull.NumVertices));
+		Write(uint32_t(Hull.NumTriangles));
+		Write(Hull.Vertices, sizeof(FVec3) * Hull.NumVertices);
+		Write(Hull.Indices, sizeof(uint32_t) * 3 * Hull.NumTriangles);
+	}
+
+	void FCaptureWriter::AddQuery(const FCaptureQuery& Query)
+	{
+		Write(uint8_t(RecordQuery));
+		Write(Query.HullId);
+		Write(Query.Plane.Normal);
+		Write(Query.Plane.W);
+		Write(Query.Scale);
+		Write(Query.Volume);
+	}
+
+	bool ReadCapture(const uint8_t* Data, size_t Size, std::vector<FCaptureHull>& OutHulls, std::vector<FCaptureQuery>& OutQueries)
+	{
+		OutHulls.clear();
+		OutQueries.clear();
+
+		FCaptureCursor Cursor(Data, Size);
+		char Magic[4];
+		uint32_t Version = 0;
+		if (!Cursor.Read(Magic, sizeof(Magic)) || std::memcmp(Magic, CaptureMagic, sizeof(Magic)) != 0)
+			return false;
+		if (!Cursor.Read(Version) || Version != CaptureVersion)
+			return false;
+
+		uint8_t Record = 0;
+		while (Cursor.Read(Record))
+		{
+			if (Record == RecordHull)
+			{
+				FCaptureHull Hull;
+				uint32_t NumVertices = 0, NumTriangles = 0;
+				if (!Cursor.Read(Hull.HullId) || !Cursor.Read(NumVertices) || !Cursor.Read(NumTriangles))
+					break;
+				// sizes come from the file, check them before allocating
+				if ((Size - Cursor.Offset) / sizeof(FVec3) < NumVertices)
+					break;
+				Hull.Vertices.resize(NumVertices);
+				if (!Cursor.Read(Hull.Vertices.data(), sizeof(FVec3) * NumVertices))
+					break;
+				if ((Size - Cursor.Offset) / (sizeof(uint32_t) * 3) < NumTriangles)
+					break;
+				Hull.Indices.resize(size_t(NumTriangles) * 3);
+				if (!Cursor.Read(Hull.Indices.data(), sizeof(uint32_t) * Hull.Indices.size()))
+					break;
+				if (std::any_of(Hull.Indices.begin(), Hull.Indices.end(), [NumVertices](uint32_t Index) { return Index >= NumVertices; }))
+					break;
+				OutHulls.push_back(std::move(Hull));
+			}
+			else if (Record == RecordQuery)
+			{
+				FCaptureQuery Query;
+				if (!Cursor.Read(Query.HullId) || !Cursor.Read(Query.Plane.Normal) || !Cursor.Read(Query.Plane.W)
+					|| !Cursor.Read(Query.Scale) || !Cursor.Read(Query.Volume))
+					break;
+				OutQueries.push_back(Query);
+			}
+			else
+			{
+				// unknown record, nothing after it can be trusted
+				break;
+			}
+		}
+		return true;
+	}
+}
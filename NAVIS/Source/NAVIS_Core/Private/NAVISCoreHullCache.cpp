@@ -0,0 +1,177 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "NAVISCoreHullCache.h"
+#include <algorithm>
+#include <cstring>
+
+namespace NAVISCore
+{
+	namespace
+	{
+		const char HullCacheMagic[4] = { 'N', 'A', 'V', 'H' };
+	}
+
+	bool FHullCacheView::Init(const void* Data, size_t Size)
+	{
+		*this = FHullCacheView();
+		if (Data == nullptr || Size < sizeof(FHullCacheHeader) || reinterpret_cast<uintptr_t>(Data) % alignof(FHullCacheBody) != 0)
+			return false;
+
+		const FHullCacheHeader* InHeader = static_cast<const FHullCacheHeader*>(Data);
+		if (std::memcmp(InHeader->Magic, HullCacheMagic, sizeof(HullCacheMagic)) != 0 || InHeader->Version != HullCacheVersion)
+			return false;
+
+		// counts are 32 bits, their sum cannot overflow 64 bits
+		const uint64_t Expected = sizeof(FHullCacheHeader)
+			+ uint64_t(InHeader->NumBodies) * sizeof(FHullCacheBody)
+			+ uint64_t(InHeader->NumHulls) * sizeof(FHullCacheHull)
+			+ uint64_t(InHeader->NumVertices) * sizeof(FVec3)
+			+ uint64_t(InHeader->NumIndices) * sizeof(uint32_t);
+		if (Expected > Size)
+			return false;
+
+		// nothing else is read : a corrupt record only costs the body it belongs to, when it is looked up
+		const uint8_t* Cursor = static_cast<const uint8_t*>(Data) + sizeof(FHullCacheHeader);
+		const FHullCacheBody* InBodies = reinterpret_cast<const FHullCacheBody*>(Cursor);
+		Cursor += sizeof(FHullCacheBody) * InHeader->NumBodies;
+		const FHullCacheHull* InHulls = reinterpret_cast<const FHullCacheHull*>(Cursor);
+		Cursor += sizeof(FHullCacheHull) * InHeader->NumHulls;
+		const FVec3* InVertices = reinterpret_cast<const FVec3*>(Cursor);
+		Cursor += sizeof(FVec3) * InHeader->NumVertices;
+		const uint32_t* InIndices = reinterpret_cast<const uint32_t*>(Cursor);
+
+		Header = InHeader;
+		Bodies = InBodies;
+		Hulls = InHulls;
+		Vertices = InVertices;
+		Indices = InIndices;
+		return true;
+	}
+
+	bool FHullCacheView::Validate() const
+	{
+		if (!Header)
+			return false;
+
+		for (uint32_t Idx = 0; Idx < Header->NumBodies; ++Idx)
+		{
+			const FHullCacheBody& Body = Bodies[Idx];
+			if (uint64_t(Body.FirstHull) + Body.NumHulls > Header->NumHulls)
+				return false;
+			if (Idx > 0 && Bodies[Idx - 1].Key >= Body.Key)
+				return false;
+		}
+		return std::all_of(Hulls, Hulls + Header->NumHulls, [this](const FHullCacheHull& Hull) { return IsHullValid(Hull); });
+	}
+
+	bool FHullCacheView::IsHullValid(const FHullCacheHull& Hull) const
+	{
+		if (uint64_t(Hull.FirstVertex) + Hull.NumVertices > Header->NumVertices || uint64_t(Hull.FirstIndex) + uint64_t(Hull.NumTriangles) * 3 > Header->NumIndices)
+			return false;
+
+		const uint32_t* HullIndices = Indices + Hull.FirstIndex;
+		return std::none_of(HullIndices, HullIndices + size_t(Hull.NumTriangles) * 3, [&Hull](uint32_t Index) { return Index >= Hull.NumVertices; });
+	}
+
+	const FHullCacheBody* FHullCacheView::FindBody(uint64_t Key) const
+	{
+		if (!Header)
+			return nullptr;
+
+		// unsorted keys only make the search miss
+		const FHullCacheBody* End = Bodies + Header->NumBodies;
+		const FHullCacheBody* Found = std::lower_bound(Bodies, End, Key, [](const FHullCacheBody& Body, uint64_t Value) { return Body.Key < Value; });
+		if (Found == End || Found->Key != Key || uint64_t(Found->FirstHull) + Found->NumHulls > Header->NumHulls)
+			return nullptr;
+		return Found;
+	}
+
+	FConvexHullView FHullCacheView::GetHull(const FHullCacheBody& Body, uint32_t HullIndex) const
+	{
+		FConvexHullView View;
+		if (!Header || HullIndex >= Body.NumHulls || uint64_t(Body.FirstHull) + HullIndex >= Header->NumHulls)
+			return View;
+
+		const FHullCacheHull& Hull = Hulls[Body.FirstHull + HullIndex];
+		if (!IsHullValid(Hull))
+			return View;
+
+		View.Vertices = Vertices + Hull.FirstVertex;
+		View.NumVertices = int32_t(Hull.NumVertices);
+		View.Indices = Indices + Hull.FirstIndex;
+		View.NumTriangles = int32_t(Hull.NumTriangles);
+		return View;
+	}
+
+	void FHullCacheBuilder::AddBody(uint64_t Key, const std::vector<FConvexHullView>& Hulls)
+	{
+		std::vector<FHull>& Body = Bodies[Key];
+		Body.clear();
+		for (const FConvexHullView& View : Hulls)
+		{
+			FHull Hull;
+			Hull.Vertices.assign(View.Vertices, View.Vertices + View.NumVertices);
+			Hull.Indices.assign(View.Indices, View.Indices + View.NumTriangles * 3);
+			Body.push_back(std::move(Hull));
+		}
+	}
+
+	void FHullCacheBuilder::AddBodies(const FHullCacheView& Cache)
+	{
+		for (uint32_t BodyIdx = 0; BodyIdx < Cache.GetNumBodies(); ++BodyIdx)
+		{
+			const FHullCacheBody& Body = Cache.GetBody(BodyIdx);
+			std::vector<FConvexHullView> Hulls;
+			for (uint32_t HullIdx = 0; HullIdx < Body.NumHulls; ++HullIdx)
+				Hulls.push_back(Cache.GetHull(Body, HullIdx));
+			AddBody(Body.Key, Hulls);
+		}
+	}
+
+	std::vector<uint8_t> FHullCacheBuilder::Build() const
+	{
+		std::vector<FHullCacheBody> OutBodies;
+		std::vector<FHullCacheHull> OutHulls;
+		std::vector<FVec3> OutVertices;
+		std::vector<uint32_t> OutIndices;
+
+		for (const auto& Body : Bodies)
+		{
+			OutBodies.push_back({ Body.first, uint32_t(OutHulls.size()), uint32_t(Body.second.size()) });
+			for (const FHull& Hull : Body.second)
+			{
+				OutHulls.push_back({ uint32_t(OutVertices.size()), uint32_t(Hull.Vertices.size()), uint32_t(OutIndices.size()), uint32_t(Hull.Indices.size() / 3) });
+				OutVertices.insert(OutVertices.end(), Hull.Vertices.begin(), Hull.Vertices.end());
+				OutIndices.insert(OutIndices.end(), Hull.Indices.begin(), Hull.Indices.end());
+			}
+		}
+
+		FHullCacheHeader Header = {};
+		std::memcpy(Header.Magic, HullCacheMagic, sizeof(HullCacheMagic));
+		Header.Version = HullCacheVersion;
+		Header.NumBodies = uint32_t(OutBodies.size());
+		Header.NumHulls = uint32_t(OutHulls.size());
+		Header.NumVertices = uint32_t(OutVertices.size());
+		Header.NumIndices = uint32_t(OutIndices.size());
+
+		std::vector<uint8_t> Data(sizeof(Header)
+			+ OutBodies.size() * sizeof(FHullCacheBody)
+			+ OutHulls.size() * sizeof(FHullCacheHull)
+			+ OutVertices.size() * sizeof(FVec3)
+			+ OutIndices.size() * sizeof(uint32_t));
+
+		uint8_t* Cursor = Data.data();
+		auto Append = [&Cursor](const void* Source, size_t Size)
+		{
+			if (Size > 0)
+				std::memcpy(Cursor, Source, Size);
+			Cursor += Size;
+		};
+		Append(&Header, sizeof(Header));
+		Append(OutBodies.data(), OutBodies.size() * sizeof(FHullCacheBody));
+		Append(OutHulls.data(), OutHulls.size() * sizeof(FHullCacheHull));
+		Append(OutVertices.data(), OutVertices.size() * sizeof(FVec3));
+		Append(OutIndices.data(), OutIndices.size() * sizeof(uint32_t));
+		return Data;
+	}
+}
@@ -0,0 +1,421 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "NAVISCoreMath.h"
+#include <algorithm>
+#include <utility>
+
+namespace NAVISCore
+{
+	namespace
+	{
+		/** most points of a triangle clipped by a plane */
+		const int32_t MaxClippedPoints = 4;
+
+		/** cut points closer than this fraction of the size of the hull are the same point of the waterline */
+		const float WaterlineTolerance = 1.e-5f;
+
+		const float Pi = 3.14159265358979323846f;
+
+		/** Intersection()	point of [A,B] on the plane, from the signed distances of A and B */
+		inline FVec3 Intersection(const FVec3& A, const FVec3& B, float DistA, float DistB)
+		{
+			const float Denominator = DistA - DistB;
+			if (Denominator == 0.f)
+				return A;
+			return A + (B - A) * (DistA / Denominator);
+		}
+
+		/** EdgeKey()		the same for both triangles sharing an edge */
+		inline uint64_t EdgeKey(uint32_t A, uint32_t B)
+		{
+			return A < B ? (uint64_t(A) << 32) | B : (uint64_t(B) << 32) | A;
+		}
+
+		/**
+		 *	FWaterlineSegment
+		 *	Where the plane crosses a triangle : from the edge going under the plane to the edge coming out of it.
+		 *	Every crossed edge starts one segment and ends another, so the segments chain into the waterline
+		 */
+		struct FWaterlineSegment
+		{
+			uint64_t Start;
+			uint64_t End;
+			FVec3 Point;	// cut of the start edge
+		};
+
+		/** reused by every clip of a thread, so neither the volume nor the waterline allocate once warm */
+		thread_local std::vector<FVec3> ScaledVertices;
+		thread_local std::vector<float> VertexDistances;
+		thread_local std::vector<FWaterlineSegment> WaterlineSegments;
+		thread_local std::vector<int32_t> WaterlineStarts;
+
+		/** EdgeSlot()		first slot of an edge in a table of 2^Bits entries */
+		inline uint32_t EdgeSlot(uint64_t Key, int32_t Bits)
+		{
+			return uint32_t((Key * 0x9E3779B97F4A7C15ull) >> (64 - Bits));
+		}
+
+		/** AddWaterlinePoint()	skip a point on top of the previous one, a vertex on the plane is cut by each of its edges */
+		inline void AddWaterlinePoint(std::vector<FVec3>& Points, const FVec3& Point, float Tolerance)
+		{
+			if (!Points.empty())
+			{
+				const FVec3 Delta = Points.back() - Point;
+				if (Dot(Delta, Delta) <= Tolerance * Tolerance)
+					return;
+			}
+			Points.push_back(Point);
+		}
+
+		/**
+		 *	ChainWaterline()	Follow the segments from edge to edge into a polygon
+		 *	@return				false if they do not close, when the hull is not a closed mesh
+		 *	@note				the segments are found by their start edge in an open addressed table : linear in their number, no sort
+		 */
+		bool ChainWaterline(const FWaterlineSegment* Segments, int32_t NumSegments, float Tolerance, std::vector<FVec3>& Points)
+		{
+			int32_t Bits = 4;
+			while ((int32_t(1) << Bits) < NumSegments * 2)
+				++Bits;
+			const uint32_t Mask = (uint32_t(1) << Bits) - 1;
+
+			std::vector<int32_t>& Starts = WaterlineStarts;
+			Starts.assign(size_t(1) << Bits, -1);
+			for (int32_t Idx = 0; Idx < NumSegments; ++Idx)
+			{
+				uint32_t Slot = EdgeSlot(Segments[Idx].Start, Bits);
+				while (Starts[Slot] >= 0)
+					Slot = (Slot + 1) & Mask;
+				Starts[Slot] = Idx;
+			}
+
+			int32_t Current = 0;
+			for (int32_t Count = 0; Count < NumSegments; ++Count)
+			{
+				AddWaterlinePoint(Points, Segments[Current].Point, Tolerance);
+
+				const uint64_t Next = Segments[Current].End;
+				uint32_t Slot = EdgeSlot(Next, Bits);
+				while (Starts[Slot] >= 0 && Segments[Starts[Slot]].Start != Next)
+					Slot = (Slot + 1) & Mask;
+				if (Starts[Slot] < 0)
+					return false;
+				Current = Starts[Slot];
+
+				// back to the first edge : a convex hull has a single loop
+				if (Current == 0)
+					break;
+			}
+
+			// the last point may close on the first one
+			if (Points.size() > 1)
+			{
+				const FVec3 Delta = Points.back() - Points.front();
+				if (Dot(Delta, Delta) <= Tolerance * Tolerance)
+					Points.pop_back();
+			}
+			return true;
+		}
+
+		/** FindAxes()		two unit axes orthogonal to a unit normal */
+		void FindAxes(const FVec3& Normal, FVec3& AxisX, FVec3& AxisY)
+		{
+			const FVec3 Up = std::fabs(Normal.Z) < 0.9f ? FVec3(0.f, 0.f, 1.f) : FVec3(1.f, 0.f, 0.f);
+			AxisX = Cross(Up, Normal);
+			AxisX = AxisX * (1.f / Length(AxisX));
+			AxisY = Cross(Normal, AxisX);
+		}
+	}
+
+	float ClipConvexVolume(const FConvexHullView& Hull, const FPlane3& Plane, const FVec3& Scale, std::vector<FVec3>* OutWaterline)
+	{
+		if (Hull.Vertices == nullptr || Hull.Indices == nullptr || Hull.NumVertices <= 0 || Hull.NumTriangles <= 0)
+			return -1.f;
+
+		// the tetrahedra are fanned from a point of the plane : the cap closing the cut adds nothing,
+		// so only the part of each triangle under the plane has to be kept.
+		// Each vertex is scaled and measured once, the triangles share them
+		std::vector<FVec3>& Scaled = ScaledVertices;
+		std::vector<float>& Distances = VertexDistances;
+		Scaled.resize(Hull.NumVertices);
+		Distances.resize(Hull.NumVertices);
+
+		// the waterline tolerance is relative to the size of the hull, whatever its units
+		FVec3 Center;
+		FVec3 Min = Hull.Vertices[0] * Scale;
+		FVec3 Max = Min;
+		for (int32_t Idx = 0; Idx < Hull.NumVertices; ++Idx)
+		{
+			const FVec3 Vertex = Hull.Vertices[Idx] * Scale;
+			Scaled[Idx] = Vertex;
+			Distances[Idx] = Plane.Distance(Vertex);
+			Center += Vertex;
+			if (OutWaterline)
+			{
+				Min = FVec3(std::min(Min.X, Vertex.X), std::min(Min.Y, Vertex.Y), std::min(Min.Z, Vertex.Z));
+				Max = FVec3(std::max(Max.X, Vertex.X), std::max(Max.Y, Vertex.Y), std::max(Max.Z, Vertex.Z));
+			}
+		}
+		const FVec3 Reference = Plane.Project(Center * (1.f / Hull.NumVertices));
+
+		std::vector<FWaterlineSegment>& Segments = WaterlineSegments;
+		const float Tolerance = Length(Max - Min) * WaterlineTolerance;
+		// one segment at most per triangle, written in place : the loop stays as tight as without the waterline
+		int32_t NumSegments = 0;
+		if (OutWaterline)
+		{
+			OutWaterline->clear();
+			if (Segments.size() < size_t(Hull.NumTriangles))
+				Segments.resize(Hull.NumTriangles);
+		}
+
+		float Volume = 0.f;
+		for (int32_t TriIdx = 0; TriIdx < Hull.NumTriangles; ++TriIdx)
+		{
+			const uint32_t* Tri = Hull.Indices + TriIdx * 3;
+			const float Dist[3] = { Distances[Tri[0]], Distances[Tri[1]], Distances[Tri[2]] };
+
+			// Case 0 : all points are over the plane
+			if (Dist[0] >= 0.f && Dist[1] >= 0.f && Dist[2] >= 0.f)
+				continue;
+
+			const FVec3 Points[3] = { Scaled[Tri[0]], Scaled[Tri[1]], Scaled[Tri[2]] };
+
+			// Case 1 : all points are under the plane
+			if (Dist[0] < 0.f && Dist[1] < 0.f && Dist[2] < 0.f)
+			{
+				Volume += TetrahedronVolume(Points[0], Points[1], Points[2], Reference);
+				continue;
+			}
+
+			// Case 2 : the plane crosses the triangle, keep the part under it
+			FVec3 Clipped[MaxClippedPoints];
+			int32_t NumClipped = 0;
+			FWaterlineSegment Segment;
+			for (int32_t Idx = 0; Idx < 3; ++Idx)
+			{
+				const int32_t Next = (Idx + 1) % 3;
+				const bool bUnder = Dist[Idx] < 0.f;
+				const bool bNextUnder = Dist[Next] < 0.f;
+				if (bUnder)
+					Clipped[NumClipped++] = Points[Idx];
+				if (bUnder != bNextUnder)
+				{
+					const FVec3 Cut = Intersection(Points[Idx], Points[Next], Dist[Idx], Dist[Next]);
+					Clipped[NumClipped++] = Cut;
+
+					// the cap closing the cut goes the other way around than the triangles : from the edge going under to the one coming out
+					if (bNextUnder)
+					{
+						Segment.Start = EdgeKey(Tri[Idx], Tri[Next]);
+						Segment.Point = Cut;
+					}
+					else
+					{
+						Segment.End = EdgeKey(Tri[Idx], Tri[Next]);
+					}
+				}
+			}
+
+			if (OutWaterline)
+				Segments[NumSegments++] = Segment;
+
+			for (int32_t Idx = 2; Idx < NumClipped; ++Idx)
+				Volume += TetrahedronVolume(Clipped[0], Clipped[Idx - 1], Clipped[Idx], Reference);
+		}
+
+		if (NumSegments > 0 && !ChainWaterline(Segments.data(), NumSegments, Tolerance, *OutWaterline))
+		{
+			// not a closed mesh : the cut points, ordered by angle
+			std::vector<FVec3> Cuts;
+			Cuts.reserve(NumSegments);
+			for (int32_t Idx = 0; Idx < NumSegments; ++Idx)
+				Cuts.push_back(Segments[Idx].Point);
+			SortWaterline(Cuts, Plane.Normal);
+
+			OutWaterline->clear();
+			for (const FVec3& Cut : Cuts)
+				AddWaterlinePoint(*OutWaterline, Cut, Tolerance);
+		}
+
+		return Volume;
+	}
+
+	void SortWaterline(std::vector<FVec3>& Points, const FVec3& PlaneNormal)
+	{
+		if (Points.size() < 3)
+			return;
+
+		FVec3 Centroid;
+		for (const FVec3& Point : Points)
+			Centroid += Point;
+		Centroid = Centroid * (1.f / Points.size());
+
+		FVec3 AxisX, AxisY;
+		FindAxes(PlaneNormal, AxisX, AxisY);
+
+		// one angle per point, not two per comparison
+		std::vector<std::pair<float, FVec3>> Angles;
+		Angles.reserve(Points.size());
+		for (const FVec3& Point : Points)
+		{
+			const FVec3 Relative = Point - Centroid;
+			Angles.emplace_back(std::atan2(Dot(Relative, AxisY), Dot(Relative, AxisX)), Point);
+		}
+		std::sort(Angles.begin(), Angles.end(), [](const std::pair<float, FVec3>& A, const std::pair<float, FVec3>& B) { return A.first < B.first; });
+
+		for (size_t Idx = 0; Idx < Points.size(); ++Idx)
+			Points[Idx] = Angles[Idx].second;
+	}
+
+	float SphereTruncatedVolume(const FVec3& Center, float Radius, const FPlane3& Plane)
+	{
+		const float Height = Plane.Distance(Center);
+
+		// completely over
+		if (Height >= Radius)
+			return 0.f;
+
+		// completely under
+		if (Height <= -Radius)
+			return 4.f / 3.f * Pi * Radius * Radius * Radius;
+
+		// Volume of a truncated sphere = (pi * h^2 /3) (3 * r - h)
+		const float Cap = Radius - Height;
+		return (Pi * Cap * Cap / 3.f) * ((3.f * Radius) - Cap);
+	}
+
+	float CapsuleTruncatedVolume(const FVec3& A, const FVec3& B, float Radius, const FPlane3& Plane, int32_t Steps)
+	{
+		const FVec3 Axis = B - A;
+		const float AxisLength = Length(Axis);
+		const float DistA = Plane.Distance(A);
+		const float DistB = Plane.Distance(B);
+		const float FullVolume = Pi * Radius * Radius * (AxisLength + 4.f / 3.f * Radius);
+
+		// completely over or completely under
+		if (DistA >= Radius && DistB >= Radius)
+			return 0.f;
+		if (DistA <= -Radius && DistB <= -Radius)
+			return FullVolume;
+
+		// a sphere, nothing to integrate
+		if (AxisLength <= 0.f)
+			return SphereTruncatedVolume(A, Radius, Plane);
+
+		// each slice is a disk across the axis, the plane crosses it along a line
+		const FVec3 Direction = Axis * (1.f / AxisLength);
+		const float Along = Dot(Plane.Normal, Direction);
+		const float Across = std::sqrt(std::max(0.f, 1.f - Along * Along));
+
+		// area under the plane of the disk of radius Rho at T along the axis
+		auto SliceArea = [&](float T, float Rho) -> float
+		{
+			const float Dist = DistA + Along * T;
+			if (Across < 1.e-6f)
+				return Dist < 0.f ? Pi * Rho * Rho : 0.f;
+			const float H = -Dist / Across;
+			if (H >= Rho)
+				return Pi * Rho * Rho;
+			if (H <= -Rho)
+				return 0.f;
+			return Rho * Rho * (Pi - std::acos(H / Rho)) + H * std::sqrt(Rho * Rho - H * H);
+		};
+
+		// the cylinder is exact : the cut slice only depends on H, linear along the axis, and its integral over H is known
+		float Cylinder = 0.f;
+		if (Across < 1.e-6f || std::fabs(Along) < 1.e-6f)
+		{
+			Cylinder = SliceArea(0.5f * AxisLength, Radius) * AxisLength;
+		}
+		else
+		{
+			// integral of the slice area over H, from -Radius to H
+			auto Cumulative = [Radius](float H) -> float
+			{
+				if (H <= -Radius)
+					return 0.f;
+				if (H >= Radius)
+					return Pi * Radius * Radius * (H - Radius) + Pi * Radius * Radius * Radius;
+				const float X = H / Radius;
+				const float Root = std::sqrt(std::max(0.f, Radius * Radius - H * H));
+				return Pi * Radius * Radius * H - Radius * Radius * Radius * (X * std::acos(X) - std::sqrt(std::max(0.f, 1.f - X * X))) - Root * Root * Root / 3.f;
+			};
+			const float H0 = -DistA / Across;
+			const float H1 = -(DistA + Along * AxisLength) / Across;
+			Cylinder = (Cumulative(H1) - Cumulative(H0)) * AxisLength / (H1 - H0);
+		}
+
+		// Simpson's rule, on an even number of intervals
+		auto Simpson = [](float Start, float End, int32_t Intervals, const auto& Function) -> float
+		{
+			Intervals = std::max(2, Intervals + (Intervals & 1));
+			const float Step = (End - Start) / Intervals;
+			float Sum = Function(Start) + Function(End);
+			for (int32_t Idx = 1; Idx < Intervals; ++Idx)
+				Sum += Function(Start + Idx * Step) * ((Idx & 1) ? 4.f : 2.f);
+			return Sum * Step / 3.f;
+		};
+
+		// the caps are integrated over the angle from the axis, T = Radius * sin(Angle) has no singularity at the poles.
+		// The slice area has a kink where the plane touches the edge of a slice, each cap is split there :
+		// with Along = sin(Beta) and Across = cos(Beta), that is where cos(Angle -+ Beta) = -+ Dist / Radius
+		const float Beta = std::atan2(Along, Across);
+		auto Cap = [&](float Start, float End, float Offset, float Dist) -> float
+		{
+			const float Plus = std::acos(std::min(std::max(-Dist / Radius, -1.f), 1.f));
+			const float Minus = std::acos(std::min(std::max(Dist / Radius, -1.f), 1.f));
+			float Bounds[6] = { Start, Beta + Plus, Beta - Plus, -Beta + Minus, -Beta - Minus, End };
+			std::sort(Bounds + 1, Bounds + 5);
+
+			auto Function = [&](float Angle) { return SliceArea(Offset + Radius * std::sin(Angle), Radius * std::cos(Angle)) * Radius * std::cos(Angle); };
+			float Volume = 0.f;
+			float Previous = Start;
+			for (int32_t Idx = 1; Idx < 6; ++Idx)
+			{
+				const float Next = std::min(std::max(Bounds[Idx], Start), End);
+				if (Next <= Previous)
+					continue;
+				const int32_t Intervals = static_cast<int32_t>(std::ceil(Steps * (Next - Previous) / (End - Start)));
+				Volume += Simpson(Previous, Next, Intervals, Function);
+				Previous = Next;
+			}
+			return Volume;
+		};
+		const float CapA = Cap(-Pi / 2.f, 0.f, 0.f, DistA);
+		const float CapB = Cap(0.f, Pi / 2.f, AxisLength, DistB);
+
+		return std::min(std::max(Cylinder + CapA + CapB, 0.f), FullVolume);
+	}
+
+	float BoxTruncatedVolume(const FVec3& Center, const FVec3 Axes[3], const FVec3& Extent, const FPlane3& Plane)
+	{
+		// corner i is at -Extent or +Extent along axis k depending on bit k of i
+		FVec3 Corners[8];
+		for (int32_t Idx = 0; Idx < 8; ++Idx)
+		{
+			Corners[Idx] = Center
+				+ Axes[0] * ((Idx & 1) ? Extent.X : -Extent.X)
+				+ Axes[1] * ((Idx & 2) ? Extent.Y : -Extent.Y)
+				+ Axes[2] * ((Idx & 4) ? Extent.Z : -Extent.Z);
+		}
+
+		// counter clockwise seen from the outside, for right handed axes
+		static const uint32_t Indices[36] =
+		{
+			0, 2, 3,	0, 3, 1,	// -Z
+			4, 5, 7,	4, 7, 6,	// +Z
+			0, 1, 5,	0, 5, 4,	// -Y
+			2, 6, 7,	2, 7, 3,	// +Y
+			0, 4, 6,	0, 6, 2,	// -X
+			1, 3, 7,	1, 7, 5,	// +X
+		};
+
+		FConvexHullView Hull;
+		Hull.Vertices = Corners;
+		Hull.NumVertices = 8;
+		Hull.Indices = Indices;
+		Hull.NumTriangles = 12;
+		return std::fabs(ClipConvexVolume(Hull, Plane, FVec3(1.f, 1.f, 1.f)));
+	}
+}
@@ -0,0 +1,87 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+/**
+ *	NAVIS_CORE
+ *	Capture of volume queries : every hull once, then each query against it, in a compact binary stream.
+ *	Written by NAVIS_Physics during a game ("navis.Capture.Start"), read back by Tools/NAVISCore replay
+ */
+
+#include "NAVISCoreMath.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace NAVISCore
+{
+	/**
+	 *	Layout, native endianness :
+	 *	header	: "NAVC", uint32 version
+	 *	hull	: uint8 1, uint32 id, uint32 vertices, uint32 triangles, float[3] per vertex, uint32[3] per triangle
+	 *	query	: uint8 2, uint32 hull id, float[3] plane normal, float plane W, float[3] scale, float volume
+	 */
+	const uint32_t CaptureVersion = 1;
+
+	/** FCaptureQuery	one call of ClipConvexVolume */
+	struct FCaptureQuery
+	{
+		uint32_t HullId = 0;
+		FPlane3 Plane;
+		FVec3 Scale;
+
+		/** signed volume that was returned */
+		float Volume = 0.f;
+	};
+
+	/** FCaptureHull	a hull the queries of a capture refer to */
+	struct FCaptureHull
+	{
+		uint32_t HullId = 0;
+		std::vector<FVec3> Vertices;
+		std::vector<uint32_t> Indices;
+
+		FConvexHullView GetView() const;
+	};
+
+	/**
+	 *	FCaptureWriter
+	 *	Encodes a capture into a buffer, the owner moves it to a file as it grows.
+	 *	Not thread safe
+	 */
+	class NAVIS_CORE_API FCaptureWriter
+	{
+	public:
+
+		FCaptureWriter();
+
+		/** HasHull()	whether a hull was written already */
+		bool HasHull(uint32_t HullId) const { return WrittenHulls.count(HullId) != 0; }
+
+		/** AddHull()	write a hull, once before the first query on it */
+		void AddHull(uint32_t HullId, const FConvexHullView& Hull);
+
+		void AddQuery(const FCaptureQuery& Query);
+
+		/** GetBuffer()	bytes written since the last ResetBuffer(), the header included at first */
+		const std::vector<uint8_t>& GetBuffer() const { return Buffer; }
+		void ResetBuffer() { Buffer.clear(); }
+
+	private:
+
+		template<typename Type>
+		void Write(const Type& Value);
+		void Write(const void* Data, size_t Size);
+
+		std::vector<uint8_t> Buffer;
+		std::unordered_set<uint32_t> WrittenHulls;
+	};
+
+	/**
+	 *	ReadCapture()	Decode a whole capture
+	 *	@return			false if the data is not a capture of this version. A truncated capture keeps what was complete
+	 */
+	NAVIS_CORE_API bool ReadCapture(const uint8_t* Data, size_t Size, std::vector<FCaptureHull>& OutHulls, std::vector<FCaptureQuery>& OutQueries);
+}
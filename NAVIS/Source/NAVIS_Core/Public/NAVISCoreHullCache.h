@@ -0,0 +1,135 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+/**
+ *	NAVIS_CORE
+ *	Hulls baked ahead of time, in one flat block that is used where it lies : a file mapped in memory works as it is.
+ *	Written by the NAVISBakeHulls commandlet at cook time, read by NAVIS_Physics in the cooked game
+ */
+
+#include "NAVISCoreMath.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace NAVISCore
+{
+	/**
+	 *	Layout, native endianness, every section right after the one before :
+	 *	FHullCacheHeader
+	 *	FHullCacheBody[NumBodies]	sorted by key
+	 *	FHullCacheHull[NumHulls]	the hulls of a body follow each other
+	 *	FVec3[NumVertices]
+	 *	uint32[NumIndices]			three per triangle, relative to the first vertex of their hull
+	 */
+	const uint32_t HullCacheVersion = 1;
+
+	struct FHullCacheHeader
+	{
+		char Magic[4];
+		uint32_t Version;
+		uint32_t NumBodies;
+		uint32_t NumHulls;
+		uint32_t NumVertices;
+		uint32_t NumIndices;
+		uint32_t Reserved[2];
+	};
+
+	/** FHullCacheBody	the hulls of one body, in the order of its convex elements */
+	struct FHullCacheBody
+	{
+		uint64_t Key;
+		uint32_t FirstHull;
+		uint32_t NumHulls;
+	};
+
+	struct FHullCacheHull
+	{
+		uint32_t FirstVertex;
+		uint32_t NumVertices;
+		uint32_t FirstIndex;
+		uint32_t NumTriangles;
+	};
+
+	static_assert(sizeof(FHullCacheHeader) == 32 && sizeof(FHullCacheBody) == 16 && sizeof(FHullCacheHull) == 16, "the hull cache layout is fixed");
+
+	/**
+	 *	FHullCacheView
+	 *	Reads a hull cache in place, nothing is copied. The data has to outlive the view and be 8 bytes aligned
+	 */
+	class NAVIS_CORE_API FHullCacheView
+	{
+	public:
+
+		/**
+		 *	Init()		point the view at a hull cache
+		 *	@return		false if it is not a hull cache of this version, or if its tables do not fit in Size
+		 *	@note		only the header is read, whatever the size of the cache. The records are checked when they are used :
+		 *				@see FindBody() and @see GetHull()
+		 */
+		bool Init(const void* Data, size_t Size);
+
+		/** Validate()	check every record at once, for tools that would rather reject a cache than skip its bad hulls. Reads all the indices */
+		bool Validate() const;
+
+		bool IsValid() const { return Header != nullptr; }
+
+		uint32_t GetNumBodies() const { return Header ? Header->NumBodies : 0; }
+		const FHullCacheBody& GetBody(uint32_t Index) const { return Bodies[Index]; }
+
+		/** FindBody()	@return the body, nullptr if it was not baked or if its hulls are out of the cache */
+		const FHullCacheBody* FindBody(uint64_t Key) const;
+
+		/**
+		 *	GetHull()	hull of a body, pointing into the cache
+		 *	@return		an empty hull if it is out of the cache or if one of its indices is out of its vertices.
+		 *				The indices are read each time, callers keep the hull rather than asking again
+		 */
+		FConvexHullView GetHull(const FHullCacheBody& Body, uint32_t HullIndex) const;
+
+	private:
+
+		/** IsHullValid()	whether the hull is within the cache, and its indices within its vertices */
+		bool IsHullValid(const FHullCacheHull& Hull) const;
+
+		const FHullCacheHeader* Header = nullptr;
+		const FHullCacheBody* Bodies = nullptr;
+		const FHullCacheHull* Hulls = nullptr;
+		const FVec3* Vertices = nullptr;
+		const uint32_t* Indices = nullptr;
+	};
+
+	/**
+	 *	FHullCacheBuilder
+	 *	Gathers the hulls of bodies, then lays them out as a hull cache
+	 */
+	class NAVIS_CORE_API FHullCacheBuilder
+	{
+	public:
+
+		/** AddBody()	copy the hulls of a body, replacing the ones it had */
+		void AddBody(uint64_t Key, const std::vector<FConvexHullView>& Hulls);
+
+		/** AddBodies()	copy every body of another cache */
+		void AddBodies(const FHullCacheView& Cache);
+
+		size_t GetNumBodies() const { return Bodies.size(); }
+
+		/** Build()		@return the hull cache */
+		std::vector<uint8_t> Build() const;
+
+	private:
+
+		struct FHull
+		{
+			std::vector<FVec3> Vertices;
+			std::vector<uint32_t> Indices;
+		};
+
+		/** ordered by key, as the cache wants them */
+		std::map<uint64_t, std::vector<FHull>> Bodies;
+	};
+}
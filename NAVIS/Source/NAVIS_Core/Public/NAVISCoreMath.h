@@ -0,0 +1,143 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+/**
+ *	NAVIS_CORE
+ *	Plane and volume math of NAVIS, in plain C++ without any engine type.
+ *	Built as the NAVIS_Core module in the engine, and as a static library by Tools/NAVISCore for benchmarks
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#ifndef NAVIS_CORE_API
+	#define NAVIS_CORE_API
+#endif
+
+namespace NAVISCore
+{
+	/** FVec3	same layout as FVector and PxVec3, so their arrays can be viewed as arrays of this */
+	struct FVec3
+	{
+		float X, Y, Z;
+
+		FVec3() : X(0.f), Y(0.f), Z(0.f) {}
+		FVec3(float InX, float InY, float InZ) : X(InX), Y(InY), Z(InZ) {}
+
+		FVec3 operator+(const FVec3& V) const { return FVec3(X + V.X, Y + V.Y, Z + V.Z); }
+		FVec3 operator-(const FVec3& V) const { return FVec3(X - V.X, Y - V.Y, Z - V.Z); }
+		FVec3 operator*(float S) const { return FVec3(X * S, Y * S, Z * S); }
+		FVec3 operator*(const FVec3& V) const { return FVec3(X * V.X, Y * V.Y, Z * V.Z); }
+		FVec3& operator+=(const FVec3& V) { X += V.X; Y += V.Y; Z += V.Z; return *this; }
+		bool operator==(const FVec3& V) const { return X == V.X && Y == V.Y && Z == V.Z; }
+	};
+
+	inline float Dot(const FVec3& A, const FVec3& B) { return A.X * B.X + A.Y * B.Y + A.Z * B.Z; }
+	inline FVec3 Cross(const FVec3& A, const FVec3& B) { return FVec3(A.Y * B.Z - A.Z * B.Y, A.Z * B.X - A.X * B.Z, A.X * B.Y - A.Y * B.X); }
+	inline float Length(const FVec3& V) { return std::sqrt(Dot(V, V)); }
+
+	/**
+	 *	FPlane3
+	 *	Plane of the points P where Dot(Normal, P) == W, the normal points out of the liquid
+	 */
+	struct FPlane3
+	{
+		FVec3 Normal;
+		float W;
+
+		FPlane3() : Normal(0.f, 0.f, 1.f), W(0.f) {}
+		FPlane3(const FVec3& InNormal, float InW) : Normal(InNormal), W(InW) {}
+
+		/** FromPointNormal()	plane through Point, the normal does not have to be normalized */
+		static FPlane3 FromPointNormal(const FVec3& Point, const FVec3& InNormal)
+		{
+			FPlane3 Plane(InNormal, Dot(InNormal, Point));
+			Plane.Normalize();
+			return Plane;
+		}
+
+		/** Normalize()	scale the normal to unit length, W along with it. Degenerate planes are left as they are */
+		void Normalize()
+		{
+			const float Size = Length(Normal);
+			if(Size > 0.f && Size != 1.f)
+			{
+				Normal = Normal * (1.f / Size);
+				W /= Size;
+			}
+		}
+
+		/** Distance()	signed distance of a point, negative under the plane. The normal has to be normalized */
+		float Distance(const FVec3& Point) const { return Dot(Normal, Point) - W; }
+
+		/** Project()	closest point of the plane */
+		FVec3 Project(const FVec3& Point) const { return Point - Normal * Distance(Point); }
+
+		/** GetOrigin()	point of the plane closest to the origin */
+		FVec3 GetOrigin() const { return Normal * W; }
+	};
+
+	/**
+	 *	FConvexHullView
+	 *	Closed convex mesh, triangles wound counter clockwise seen from the outside. Nothing is owned
+	 */
+	struct FConvexHullView
+	{
+		const FVec3* Vertices = nullptr;
+		int32_t NumVertices = 0;
+
+		/** three indices per triangle */
+		const uint32_t* Indices = nullptr;
+		int32_t NumTriangles = 0;
+	};
+
+	/** TetrahedronVolume()	signed volume, positive when P1 P2 P3 turn counter clockwise seen from P4 */
+	inline float TetrahedronVolume(const FVec3& P1, const FVec3& P2, const FVec3& P3, const FVec3& P4)
+	{
+		return Dot(P1 - P4, Cross(P2 - P4, P3 - P4)) / 6.0f;
+	}
+
+	/**
+	 *	ClipConvexVolume()	Volume of a convex hull under a plane
+	 *	@param Hull			the hull, in the space of the plane once scaled
+	 *	@param Plane		normalized plane, the volume under it is measured
+	 *	@param Scale		applied to the vertices of the hull
+	 *	@param OutWaterline	if not null, receives the polygon where the plane cuts the hull, counter clockwise around the normal
+	 *	@return				the volume, -1 if the hull is empty
+	 *	@note				the volume is right for any closed mesh, convex or not. Only the waterline needs a convex hull.
+	 *						The waterline is chained from edge to edge once clipped, one point per crossed edge, without sorting by angle
+	 */
+	NAVIS_CORE_API float ClipConvexVolume(const FConvexHullView& Hull, const FPlane3& Plane, const FVec3& Scale, std::vector<FVec3>* OutWaterline = nullptr);
+
+	/**
+	 *	SortWaterline()		Order the points where a convex hull crosses a plane into a polygon
+	 *	@note				the cut of a convex hull is convex, so the angle around the centroid is enough.
+	 *						Only needed for points that do not come from @see ClipConvexVolume()
+	 */
+	NAVIS_CORE_API void SortWaterline(std::vector<FVec3>& Points, const FVec3& PlaneNormal);
+
+	/**
+	 *	SphereTruncatedVolume()	Volume of a sphere under a plane
+	 *	@see https://en.wikipedia.org/wiki/Spherical_cap
+	 */
+	NAVIS_CORE_API float SphereTruncatedVolume(const FVec3& Center, float Radius, const FPlane3& Plane);
+
+	/**
+	 *	CapsuleTruncatedVolume()	Volume of a capsule under a plane
+	 *	@param A, B				centers of the two hemispheres
+	 *	@param Steps			intervals of the integration along the axis of each cap, more is slower and closer.
+	 *							Tools/NAVISCore validation measures both
+	 *	@note					the cylinder is exact, the caps are integrated slice by slice
+	 */
+	NAVIS_CORE_API float CapsuleTruncatedVolume(const FVec3& A, const FVec3& B, float Radius, const FPlane3& Plane, int32_t Steps = 8);
+
+	/**
+	 *	BoxTruncatedVolume()	Volume of an oriented box under a plane
+	 *	@param Center			center of the box
+	 *	@param Axes				unit axes of the box
+	 *	@param Extent			half size along each axis
+	 */
+	NAVIS_CORE_API float BoxTruncatedVolume(const FVec3& Center, const FVec3 Axes[3], const FVec3& Extent, const FPlane3& Plane);
+}
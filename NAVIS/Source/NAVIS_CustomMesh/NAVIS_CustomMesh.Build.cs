@@ -10,7 +10,7 @@ public class NAVIS_CustomMesh : ModuleRules
         PrivatePCHHeaderFile = "Private/NAVIS_CustomMeshPCH.h";
 
         PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject" });
-        PrivateDependencyModuleNames.AddRange(new string[] {"Engine", "RHI", "RenderCore" });
+        PrivateDependencyModuleNames.AddRange(new string[] {"Engine", "RHI", "RenderCore", "PhysicsCore", "NAVIS_Types" });
 
         PublicIncludePaths.AddRange(new string[] { "NAVIS_CustomMesh/Public" });
         PrivateIncludePaths.AddRange(new string[] { "NAVIS_CustomMesh/Private" });
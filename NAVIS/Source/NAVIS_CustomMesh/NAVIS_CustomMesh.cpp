@@ -1,5 +1,6 @@
 // Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
 #include "NAVIS_CustomMesh.h"
+#include "GeneratedMeshCollisionCache.h"
 
 DEFINE_LOG_CATEGORY(LogNAVIS_CustomMesh);
 
@@ -7,11 +8,13 @@ DEFINE_LOG_CATEGORY(LogNAVIS_CustomMesh);
 
 void FNAVIS_CustomMesh::StartupModule()
 {
+	FGeneratedMeshCollisionCache::Startup();
 	UE_LOG(LogNAVIS_CustomMesh, Warning, TEXT("NAVIS_CustomMesh module has started"));
 }
 
 void FNAVIS_CustomMesh::ShutdownModule()
 {
+	FGeneratedMeshCollisionCache::Shutdown();
 	UE_LOG(LogNAVIS_CustomMesh, Warning, TEXT("NAVIS_CustomMesh module has shut down"));
 }
 
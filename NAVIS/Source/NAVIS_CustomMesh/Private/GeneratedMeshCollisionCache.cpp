@@ -0,0 +1,181 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "GeneratedMeshCollisionCache.h"
+#include "GeneratedMeshCollisionData.h"
+#include "GeneratedMeshComponent.h"
+#include "GeneratedMeshConvexDecomposition.h"
+#include "NAVISStats.h"
+#include "Async/Async.h"
+#include "Engine/World.h"
+
+FGeneratedMeshCollisionCache* FGeneratedMeshCollisionCache::Instance = nullptr;
+
+
+bool UGeneratedMeshCollisionData::GetPhysicsTriMeshData(struct FTriMeshCollisionData* CollisionData, bool InUseAllTriData)
+{
+	CollisionData->Vertices			= Vertices;
+	CollisionData->Indices			= Indices;
+	CollisionData->MaterialIndices	= MaterialIndices;
+	CollisionData->bFlipNormals		= true;
+	return true;
+}
+
+UWorld* UGeneratedMeshCollisionData::GetWorld() const
+{
+	return World.Get();
+}
+
+
+void FGeneratedMeshCollisionCache::Startup()
+{
+	check(!Instance);
+	Instance = new FGeneratedMeshCollisionCache();
+}
+
+void FGeneratedMeshCollisionCache::Shutdown()
+{
+	delete Instance;
+	Instance = nullptr;
+}
+
+UBodySetup* FGeneratedMeshCollisionCache::Acquire(uint64 Hash, UGeneratedMeshComponent* Component, TFunctionRef<void(UGeneratedMeshCollisionData&)> Fill, bool bAsync)
+{
+	FEntry& Entry = Entries.FindOrAdd(Hash);
+	Entry.UseCount++;
+
+	// known geometry : cooked already, or cooking for someone else
+	if(Entry.Data)
+	{
+		// the world it was cooked for may be gone, a later cook of the hulls still needs one
+		if(!Entry.Data->World.IsValid())
+			Entry.Data->World = Component->GetWorld();
+
+		INC_DWORD_STAT(STAT_NAVIS_CacheHits);
+		if(Entry.bCooking)
+		{
+			Entry.Waiting.Add(Component);
+			return nullptr;
+		}
+		return Entry.Data->BodySetup;
+	}
+
+	INC_DWORD_STAT(STAT_NAVIS_CacheMisses);
+	// shared between components, so not outered to any of them. The world it reports makes the body setup cook at runtime in cooked builds
+	Entry.Data = NewObject<UGeneratedMeshCollisionData>(GetTransientPackage());
+	Entry.Data->World = Component->GetWorld();
+	Fill(*Entry.Data);
+
+	// the collision data provides the tri-mesh, so the body setup does not depend on any component
+	UBodySetup* BodySetup = NewObject<UBodySetup>(Entry.Data);
+	BodySetup->BodySetupGuid = FGuid::NewGuid();
+	BodySetup->CollisionTraceFlag = CTF_UseComplexAsSimple;
+	BodySetup->bMeshCollideAll = true;
+	BodySetup->bGenerateMirroredCollision = false;
+	BodySetup->bHasCookedCollisionData = true;
+	Entry.Data->BodySetup = BodySetup;
+
+	// simple collision from convex hulls : decompose off the game thread, cook once the hulls are in
+	if(Entry.Data->MaxConvexHulls > 0)
+	{
+		Entry.bCooking = true;
+		Entry.Waiting.Add(Component);
+
+		FGeneratedMeshDecompositionSettings Settings;
+		Settings.MaxHulls = Entry.Data->MaxConvexHulls;
+		Settings.Resolution = Entry.Data->ConvexResolution;
+
+		Async(EAsyncExecution::ThreadPool, [Hash, Settings, Vertices = Entry.Data->Vertices, Indices = Entry.Data->Indices]()
+		{
+			TArray<FKConvexElem> Hulls;
+			FGeneratedMeshConvexDecomposition::Decompose(Vertices, Indices, Settings, Hulls);
+
+			AsyncTask(ENamedThreads::GameThread, [Hash, Hulls = MoveTemp(Hulls)]() mutable
+			{
+				if(FGeneratedMeshCollisionCache* Cache = FGeneratedMeshCollisionCache::TryGet())
+				{
+					Cache->OnDecompositionFinished(Hash, MoveTemp(Hulls));
+				}
+			});
+		});
+		return nullptr;
+	}
+
+	if(bAsync)
+	{
+		Entry.bCooking = true;
+		Entry.Waiting.Add(Component);
+		BodySetup->CreatePhysicsMeshesAsync(FOnAsyncPhysicsCookFinished::CreateRaw(this, &FGeneratedMeshCollisionCache::OnCookFinished, Hash));
+		return nullptr;
+	}
+
+	// runtime cooking, works in packaged builds as the data comes from the provider
+	BodySetup->InvalidatePhysicsData();
+	BodySetup->CreatePhysicsMeshes();
+	return BodySetup;
+}
+
+void FGeneratedMeshCollisionCache::Release(uint64 Hash)
+{
+	FEntry* Entry = Entries.Find(Hash);
+	if(!Entry)
+		return;
+
+	Entry->UseCount--;
+
+	// a cooking body setup has to stay alive until the cook calls back
+	if(Entry->UseCount <= 0 && !Entry->bCooking)
+	{
+		Entries.Remove(Hash);
+	}
+}
+
+void FGeneratedMeshCollisionCache::OnCookFinished(bool bSuccess, uint64 Hash)
+{
+	FEntry* Entry = Entries.Find(Hash);
+	if(!Entry)
+		return;
+
+	Entry->bCooking = false;
+	if(Entry->UseCount <= 0)
+	{
+		Entries.Remove(Hash);
+		return;
+	}
+
+	TArray<TWeakObjectPtr<UGeneratedMeshComponent>> Waiting = MoveTemp(Entry->Waiting);
+	UBodySetup* BodySetup = Entry->Data->BodySetup;
+	for(const TWeakObjectPtr<UGeneratedMeshComponent>& Component : Waiting)
+	{
+		if(Component.IsValid())
+		{
+			Component->FinishCollisionCook(Hash, bSuccess ? BodySetup : nullptr);
+		}
+	}
+}
+
+void FGeneratedMeshCollisionCache::OnDecompositionFinished(uint64 Hash, TArray<FKConvexElem>&& Hulls)
+{
+	FEntry* Entry = Entries.Find(Hash);
+	if(!Entry)
+		return;
+
+	if(Entry->UseCount <= 0)
+	{
+		Entries.Remove(Hash);
+		return;
+	}
+
+	// hulls for simple queries and simulation, the tri-mesh stays for complex queries
+	UBodySetup* BodySetup = Entry->Data->BodySetup;
+	BodySetup->AggGeom.ConvexElems = MoveTemp(Hulls);
+	BodySetup->CollisionTraceFlag = BodySetup->AggGeom.ConvexElems.Num() > 0 ? CTF_UseDefault : CTF_UseComplexAsSimple;
+	BodySetup->CreatePhysicsMeshesAsync(FOnAsyncPhysicsCookFinished::CreateRaw(this, &FGeneratedMeshCollisionCache::OnCookFinished, Hash));
+}
+
+void FGeneratedMeshCollisionCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	for(TPair<uint64, FEntry>& Pair : Entries)
+	{
+		Collector.AddReferencedObject(Pair.Value.Data);
+	}
+}
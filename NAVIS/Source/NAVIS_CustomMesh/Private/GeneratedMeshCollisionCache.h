@@ -0,0 +1,71 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "NAVIS_CustomMeshPCH.h"
+#include "UObject/GCObject.h"
+
+class UBodySetup;
+class UGeneratedMeshComponent;
+class UGeneratedMeshCollisionData;
+
+/**
+ *	FGeneratedMeshCollisionCache
+ *	Cooked collision of generated meshes, keyed by a hash of their geometry.
+ *	Components with identical collision share the same body setup, cooked once.
+ *	Owned by the NAVIS_CustomMesh module
+ */
+class FGeneratedMeshCollisionCache : public FGCObject
+{
+public:
+
+	/** Get()	the cache, valid between module startup and shutdown */
+	static FGeneratedMeshCollisionCache& Get() { check(Instance); return *Instance; }
+
+	/** TryGet()	the cache, or nullptr once the module shut down */
+	static FGeneratedMeshCollisionCache* TryGet() { return Instance; }
+
+	/** Startup() / Shutdown()	called by the module */
+	static void Startup();
+	static void Shutdown();
+
+	/**
+	 *	Acquire()			Body setup for a geometry, cooking it if nobody uses it yet. Call @see Release() once done
+	 *	@param Hash			hash of the geometry, @see UGeneratedMeshComponent::UpdateCollision()
+	 *	@param Component	notified through FinishCollisionCook() once an async cook is done
+	 *	@param Fill			copies the geometry, only called when the hash is unknown
+	 *	@param bAsync		cook on a worker thread
+	 *	@return				the body setup if it is ready to use, nullptr while it cooks
+	 *	@note				geometry asking for convex hulls is always decomposed and cooked on worker threads
+	 */
+	UBodySetup* Acquire(uint64 Hash, UGeneratedMeshComponent* Component, TFunctionRef<void(UGeneratedMeshCollisionData&)> Fill, bool bAsync);
+
+	/** Release()	stop using a geometry, its body setup goes away with the last user */
+	void Release(uint64 Hash);
+
+	//~ Begin FGCObject Interface.
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	//~ End FGCObject Interface.
+
+private:
+
+	struct FEntry
+	{
+		UGeneratedMeshCollisionData* Data = nullptr;
+		int32 UseCount = 0;
+		bool bCooking = false;
+
+		/** Components waiting for the cook to finish */
+		TArray<TWeakObjectPtr<UGeneratedMeshComponent>> Waiting;
+	};
+
+	/** OnCookFinished()	hand the body setup to the waiting components */
+	void OnCookFinished(bool bSuccess, uint64 Hash);
+
+	/** OnDecompositionFinished()	put the hulls in the body setup, then cook it */
+	void OnDecompositionFinished(uint64 Hash, TArray<FKConvexElem>&& Hulls);
+
+	TMap<uint64, FEntry> Entries;
+
+	static FGeneratedMeshCollisionCache* Instance;
+};
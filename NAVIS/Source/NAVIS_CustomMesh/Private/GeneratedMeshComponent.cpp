@@ -2,8 +2,14 @@
 
 #include "GeneratedMeshComponent.h"
 #include "NAVIS_CustomMeshPCH.h"
-#include "GeneratedMeshVertexBuffer.h"
+#include "GeneratedMeshSceneProxy.h"
+#include "GeneratedMeshCollisionCache.h"
+#include "GeneratedMeshCollisionData.h"
+#include "NAVISStats.h"
+#include "Hash/CityHash.h"
 #include "Materials/Material.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
 
 
 
@@ -12,176 +18,522 @@
 
 UGeneratedMeshComponent::UGeneratedMeshComponent(const FObjectInitializer& ObjectInitializer )
 	: Super(ObjectInitializer)
+	, bUseDynamicVertexBuffer(false)
+	, VertexFormat(EGeneratedMeshVertexFormat::Full)
+	, bUseAsyncCooking(false)
+	, bUseConvexDecomposition(false)
+	, MaxConvexHulls(8)
+	, ConvexDecompositionResolution(32)
+	, CollisionHash(0)
 {
 	PrimaryComponentTick.bCanEverTick = false;
 }
 
+/** Weld identical positions of a triangle list into indexed geometry */
+static void WeldTriangles(const TArray<FGeneratedTriangle>& Triangles, TArray<FVector>& OutVertices, TArray<uint32>& OutIndices)
+{
+	OutVertices.Reset();
+	OutIndices.Reset(Triangles.Num() * 3);
+
+	// weld : triangles sharing a position share the vertex
+	TMap<FVector, uint32> VertexMap;
+	VertexMap.Reserve(Triangles.Num());
+	for(const FGeneratedTriangle& Tri : Triangles)
+	{
+		for(int32 Corner = 0; Corner < 3; Corner++)
+		{
+			const FVector Position = Tri[Corner];
+			if(const uint32* Found = VertexMap.Find(Position))
+			{
+				OutIndices.Add(*Found);
+			}
+			else
+			{
+				const uint32 VIndex = OutVertices.Add(Position);
+				VertexMap.Add(Position, VIndex);
+				OutIndices.Add(VIndex);
+			}
+		}
+	}
+}
+
+/** Whether indices and normals match the vertices of a section */
+static bool IsValidMeshData(const FGeneratedMeshData& Data, bool bHasNormals)
+{
+	if(Data.Indices.Num() % 3 != 0 || (bHasNormals && Data.Normals.Num() != Data.Positions.Num()))
+		return false;
+
+	for(const uint32 Index : Data.Indices)
+	{
+		if(Index >= uint32(Data.Positions.Num()))
+			return false;
+	}
+	return true;
+}
+
 bool UGeneratedMeshComponent::SetGeneratedMeshTriangles(const TArray<FGeneratedTriangle>& Triangles)
 {
-	GeneratedMeshTris = Triangles;
+	TArray<FVector> Vertices;
+	TArray<uint32> Indices;
+	WeldTriangles(Triangles, Vertices, Indices);
 
-	UpdateCollision();
+	return CreateMeshSection(0, MoveTemp(Vertices), MoveTemp(Indices));
+}
 
-	// Need to recreate scene proxy to send it over
-	MarkRenderStateDirty();
+bool UGeneratedMeshComponent::SetGeneratedMeshData(const TArray<FVector>& Vertices, const TArray<uint32>& Indices, const TArray<FVector>& Normals)
+{
+	return CreateMeshSection(0, Vertices, Indices, Normals);
+}
 
+bool UGeneratedMeshComponent::UpdateGeneratedMeshVertices(const TArray<FVector>& Positions, const TArray<FVector>& Normals, bool bUpdateCollision)
+{
+	return UpdateMeshSectionVertices(0, Positions, Normals, bUpdateCollision);
+}
+
+bool UGeneratedMeshComponent::CreateMeshSection(int32 SectionIndex, const TArray<FVector>& Vertices, const TArray<uint32>& Indices, const TArray<FVector>& Normals, bool bCreateCollision)
+{
+	return CreateMeshSection(SectionIndex, TArray<FVector>(Vertices), TArray<uint32>(Indices), TArray<FVector>(Normals), bCreateCollision);
+}
+
+bool UGeneratedMeshComponent::CreateMeshSection(int32 SectionIndex, TArray<FVector>&& Vertices, TArray<uint32>&& Indices, TArray<FVector>&& Normals, bool bCreateCollision)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NAVIS_MeshUpdate);
+
+	if(SectionIndex < 0)
+		return false;
+
+	FGeneratedMeshSection Section;
+	Section.Positions	= MoveTemp(Vertices);
+	Section.Indices		= MoveTemp(Indices);
+	Section.Normals		= MoveTemp(Normals);
+	Section.bEnableCollision = bCreateCollision;
+
+	const bool bHasNormals = Section.Normals.Num() > 0;
+	if(!IsValidMeshData(Section, bHasNormals))
+		return false;
+
+	if(!bHasNormals)
+	{
+		Section.ComputeNormals();
+	}
+	Section.LocalBox = Section.ComputeBounds();
+
+	// this one is newer than any build in flight
+	CancelSectionBuild(SectionIndex);
+	CommitMeshSection(SectionIndex, MoveTemp(Section), nullptr);
 	return true;
 }
 
+void UGeneratedMeshComponent::CreateMeshSectionAsync(int32 SectionIndex, TArray<FVector>&& Vertices, TArray<uint32>&& Indices, TArray<FVector>&& Normals, bool bCreateCollision, FOnGeneratedMeshBuilt OnBuilt)
+{
+	LaunchSectionBuild(SectionIndex, bCreateCollision,
+		[Vertices = MoveTemp(Vertices), Indices = MoveTemp(Indices), Normals = MoveTemp(Normals)](FGeneratedMeshSection& Section) mutable
+	{
+		Section.Positions	= MoveTemp(Vertices);
+		Section.Indices		= MoveTemp(Indices);
+		Section.Normals		= MoveTemp(Normals);
+		return true;
+	}, OnBuilt);
+}
+
+void UGeneratedMeshComponent::SetGeneratedMeshTrianglesAsync(TArray<FGeneratedTriangle>&& Triangles, FOnGeneratedMeshBuilt OnBuilt)
+{
+	LaunchSectionBuild(0, true,
+		[Triangles = MoveTemp(Triangles)](FGeneratedMeshSection& Section)
+	{
+		WeldTriangles(Triangles, Section.Positions, Section.Indices);
+		return true;
+	}, OnBuilt);
+}
 
-FPrimitiveSceneProxy* UGeneratedMeshComponent::CreateSceneProxy()
+void UGeneratedMeshComponent::LaunchSectionBuild(int32 SectionIndex, bool bCreateCollision, TUniqueFunction<bool(FGeneratedMeshSection&)>&& Fill, FOnGeneratedMeshBuilt OnBuilt)
 {
-	
-	/** Scene proxy defined only inside the scope of this one function */
-	class FGeneratedMeshSceneProxy : public FPrimitiveSceneProxy
+	if(SectionIndex < 0)
 	{
-	private:
+		OnBuilt.ExecuteIfBound(SectionIndex, false);
+		return;
+	}
+
+	CancelSectionBuild(SectionIndex);
+	const uint32 Serial = SectionBuildSerials[SectionIndex];
+	const EGeneratedMeshVertexFormat Format = VertexFormat;
+	TWeakObjectPtr<UGeneratedMeshComponent> WeakThis(this);
 
-		UMaterialInterface* Material;
-		FGeneratedMeshVertexBuffer VertexBuffer;
-		FGeneratedMeshIndexBuffer IndexBuffer;
-		FGeneratedMeshVertexFactory VertexFactory;
-		FMaterialRelevance MaterialRelevance;
+	Async(EAsyncExecution::ThreadPool, [WeakThis, SectionIndex, Serial, bCreateCollision, Format, Fill = MoveTemp(Fill), OnBuilt]() mutable
+	{
+		FGeneratedMeshSection Section;
+		Section.bEnableCollision = bCreateCollision;
+		FGeneratedMeshSectionRenderDataPtr RenderData = MakeShared<FGeneratedMeshSectionRenderData, ESPMode::ThreadSafe>();
 
-	public:
+		bool bSuccess = Fill(Section);
+		const bool bHasNormals = Section.Normals.Num() > 0;
+		bSuccess = bSuccess && IsValidMeshData(Section, bHasNormals);
 
-		FGeneratedMeshSceneProxy(UGeneratedMeshComponent* Component)	: FPrimitiveSceneProxy(Component)
-#if (PLATFORM_WINDOWS || PLATFORM_XBOXONE || PLATFORM_PS4)
-	, MaterialRelevance(Component->GetMaterialRelevance(ERHIFeatureLevel::SM5))
-#else 
-	, MaterialRelevance(Component->GetMaterialRelevance(ERHIFeatureLevel::ES3_1))
-#endif
+		if(bSuccess)
 		{
-			const FColor VertexColor(255,255,255);
-
-			// Add each triangle to the vertex/index buffer
-			for(int TriIdx=0; TriIdx<Component->GeneratedMeshTris.Num(); TriIdx++)
+			if(!bHasNormals)
 			{
-				FGeneratedTriangle& Tri = Component->GeneratedMeshTris[TriIdx];
-
-				const FVector Edge01 = (Tri[1] - Tri[0]);
-				const FVector Edge02 = (Tri[2] - Tri[0]);
-
-				const FVector TangentX = Edge01.GetSafeNormal();
-				const FVector TangentZ = (Edge02 ^ Edge01).GetSafeNormal();
-				const FVector TangentY = (TangentX ^ TangentZ).GetSafeNormal();
-
-				FDynamicMeshVertex Vert0;
-				Vert0.Position = Tri[0];
-				Vert0.Color = VertexColor;
-				Vert0.SetTangents(TangentX, TangentY, TangentZ);
-				int32 VIndex = VertexBuffer.Vertices.Add(Vert0);
-				IndexBuffer.Indices.Add(VIndex);
-
-				FDynamicMeshVertex Vert1;
-				Vert1.Position = Tri[1];
-				Vert1.Color = VertexColor;
-				Vert1.SetTangents(TangentX, TangentY, TangentZ);
-				VIndex = VertexBuffer.Vertices.Add(Vert1);
-				IndexBuffer.Indices.Add(VIndex);
-
-				FDynamicMeshVertex Vert2;
-				Vert2.Position = Tri[2];
-				Vert2.Color = VertexColor;
-				Vert2.SetTangents(TangentX, TangentY, TangentZ);
-				VIndex = VertexBuffer.Vertices.Add(Vert2);
-				IndexBuffer.Indices.Add(VIndex);
+				Section.ComputeNormalsParallel();
 			}
+			Section.LocalBox = Section.ComputeBoundsParallel();
+			FGeneratedMeshSceneProxy::BuildRenderData(Section, Format, *RenderData, true);
+		}
 
-			// Init vertex factory
-			VertexFactory.Init(&VertexBuffer);
+		// publish on the game thread, unless the component is gone or a newer build started
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, SectionIndex, Serial, bSuccess, Section = MoveTemp(Section), RenderData, OnBuilt]() mutable
+		{
+			UGeneratedMeshComponent* This = WeakThis.Get();
+			if(!This)
+				return;
 
-			// Enqueue initialization of render resource
-			BeginInitResource(&VertexBuffer);
-			BeginInitResource(&IndexBuffer);
-			BeginInitResource(&VertexFactory);
+			const uint32* CurrentSerial = This->SectionBuildSerials.Find(SectionIndex);
+			if(!CurrentSerial || *CurrentSerial != Serial)
+				return;
 
-			// Grab material
-			Material = Component->GetMaterial(0);
-			if(Material == NULL)
+			if(bSuccess)
 			{
-				Material = UMaterial::GetDefaultMaterial(MD_Surface);
+				SCOPE_CYCLE_COUNTER(STAT_NAVIS_MeshUpdate);
+				This->CommitMeshSection(SectionIndex, MoveTemp(Section), RenderData);
 			}
-		}
+			OnBuilt.ExecuteIfBound(SectionIndex, bSuccess);
+		});
+	});
+}
+
+void UGeneratedMeshComponent::CommitMeshSection(int32 SectionIndex, FGeneratedMeshSection&& Section, const FGeneratedMeshSectionRenderDataPtr& RenderData)
+{
+	if(SectionIndex >= MeshSections.Num())
+	{
+		MeshSections.SetNum(SectionIndex + 1, false);
+	}
 
-		virtual ~FGeneratedMeshSceneProxy()
+	const bool bHadCollision = MeshSections[SectionIndex].bEnableCollision && !MeshSections[SectionIndex].IsEmpty();
+	const bool bHasCollision = Section.bEnableCollision && !Section.IsEmpty();
+	MeshSections[SectionIndex] = MoveTemp(Section);
+
+	// sections out of the collision do not need a recook
+	if(bHadCollision || bHasCollision)
+	{
+		UpdateCollision();
+	}
+
+	PendingRenderData.Remove(SectionIndex);
+	if(!SendSectionToProxy(SectionIndex, RenderData))
+	{
+		// next proxy takes the prebuilt vertices
+		if(RenderData.IsValid())
 		{
-			VertexBuffer.ReleaseResource();
-			IndexBuffer.ReleaseResource();
-			VertexFactory.ReleaseResource();
+			PendingRenderData.Add(SectionIndex, RenderData);
 		}
 
-		virtual void DrawDynamicElements(FPrimitiveDrawInterface* PDI,const FSceneView* View)
+		// Need to recreate scene proxy to send it over
+		MarkRenderStateDirty();
+	}
+	UpdateBounds();
+	MarkRenderTransformDirty();
+}
+
+bool UGeneratedMeshComponent::UpdateMeshSectionVertices(int32 SectionIndex, const TArray<FVector>& Positions, const TArray<FVector>& Normals, bool bUpdateCollision)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NAVIS_MeshUpdate);
+
+	if(!MeshSections.IsValidIndex(SectionIndex))
+		return false;
+
+	FGeneratedMeshSection& Section = MeshSections[SectionIndex];
+	if(Positions.Num() != Section.Positions.Num() || (Normals.Num() > 0 && Normals.Num() != Positions.Num()))
+		return false;
+
+	Section.Positions = Positions;
+	if(Normals.Num() > 0)
+	{
+		Section.Normals = Normals;
+	}
+	else
+	{
+		Section.ComputeNormals();
+	}
+	Section.LocalBox = Section.ComputeBounds();
+
+	if(bUpdateCollision && Section.bEnableCollision)
+	{
+		UpdateCollision();
+	}
+
+	// prebuilt vertices of an async build are stale now
+	PendingRenderData.Remove(SectionIndex);
+
+	// same triangles : stream vertices to the existing buffer, if it was made for it
+	FGeneratedMeshSceneProxy* GeneratedProxy = GetGeneratedProxy();
+	if(GeneratedProxy && GeneratedProxy->IsDynamic())
+	{
+		FGeneratedMeshSectionRenderData NewData;
+		FGeneratedMeshSceneProxy::BuildRenderData(Section, VertexFormat, NewData);
+
+		ENQUEUE_RENDER_COMMAND(UpdateGeneratedMeshVertices)(
+			[GeneratedProxy, SectionIndex, NewData = MoveTemp(NewData)](FRHICommandListImmediate& RHICmdList) mutable
 		{
-			// if(IsSelected())
-			QUICK_SCOPE_CYCLE_COUNTER( STAT_GeneratedMeshSceneProxy_DrawDynamicElements );
+			GeneratedProxy->UpdateVertices_RenderThread(SectionIndex, MoveTemp(NewData));
+		});
 
-			const bool bWireframe = View->Family->EngineShowFlags.Wireframe;
+		// bounds are sent along the transform
+		UpdateBounds();
+		MarkRenderTransformDirty();
+	}
+	else
+	{
+		// updated once, likely to be updated again : next proxy gets a dynamic buffer
+		bUseDynamicVertexBuffer = true;
+		MarkRenderStateDirty();
+		UpdateBounds();
+	}
 
-			// if(IsSelected())
-			auto WireframeMaterialInstance = new FColoredMaterialRenderProxy(
-				GEngine->WireframeMaterial ? GEngine->WireframeMaterial->GetRenderProxy() : NULL,
-				FLinearColor(0, 0.5f, 1.f)
-				);
+	return true;
+}
 
-			FMaterialRenderProxy* MaterialProxy = NULL;
-			if(bWireframe)
-			{
-				MaterialProxy = WireframeMaterialInstance;
-			}
-			else
-			{
-				MaterialProxy = Material->GetRenderProxy();
-			}
+void UGeneratedMeshComponent::ClearMeshSection(int32 SectionIndex)
+{
+	if(!MeshSections.IsValidIndex(SectionIndex))
+		return;
+
+	const bool bHadCollision = MeshSections[SectionIndex].bEnableCollision && !MeshSections[SectionIndex].IsEmpty();
+	MeshSections[SectionIndex] = FGeneratedMeshSection();
+	PendingRenderData.Remove(SectionIndex);
+	CancelSectionBuild(SectionIndex);
+
+	if(bHadCollision)
+	{
+		UpdateCollision();
+	}
+
+	if(!SendSectionToProxy(SectionIndex))
+	{
+		MarkRenderStateDirty();
+	}
+	UpdateBounds();
+	MarkRenderTransformDirty();
+}
+
+void UGeneratedMeshComponent::ClearAllMeshSections()
+{
+	for(int32 SectionIdx = 0; SectionIdx < MeshSections.Num(); SectionIdx++)
+	{
+		CancelSectionBuild(SectionIdx);
+	}
+	MeshSections.Empty();
+	PendingRenderData.Empty();
+	UpdateCollision();
+	MarkRenderStateDirty();
+	UpdateBounds();
+}
+
+void UGeneratedMeshComponent::SetMeshSectionVisible(int32 SectionIndex, bool bNewVisibility)
+{
+	if(!MeshSections.IsValidIndex(SectionIndex) || MeshSections[SectionIndex].bSectionVisible == bNewVisibility)
+		return;
 
-			// Draw the mesh.
-			FMeshBatch Mesh;
-			FMeshBatchElement& BatchElement = Mesh.Elements[0];
-			BatchElement.IndexBuffer = &IndexBuffer;
-			Mesh.bWireframe = bWireframe;
-			Mesh.VertexFactory = &VertexFactory;
-			Mesh.MaterialRenderProxy = MaterialProxy;
-			// 4.23 @todo might try to put DrawVelocity to true
-#if ENGINE_MINOR_VERSION < 23
-			BatchElement.PrimitiveUniformBuffer = CreatePrimitiveUniformBufferImmediate(GetLocalToWorld(), GetBounds(), GetLocalBounds(), true, false);
-#else
-			BatchElement.PrimitiveUniformBuffer = CreatePrimitiveUniformBufferImmediate(GetLocalToWorld(), GetBounds(), GetLocalBounds(), GetLocalBounds(), true, false);
-#endif
-			BatchElement.FirstIndex = 0;
-			BatchElement.NumPrimitives = IndexBuffer.Indices.Num() / 3;
-			BatchElement.MinVertexIndex = 0;
-			BatchElement.MaxVertexIndex = VertexBuffer.Vertices.Num() - 1;
-			Mesh.ReverseCulling = IsLocalToWorldDeterminantNegative();
-			Mesh.Type = PT_TriangleList;
-			Mesh.DepthPriorityGroup = SDPG_World;
-			PDI->DrawMesh(Mesh);
+	MeshSections[SectionIndex].bSectionVisible = bNewVisibility;
+
+	// cached draw commands of a static proxy would still draw the section
+	FGeneratedMeshSceneProxy* GeneratedProxy = GetGeneratedProxy();
+	if(GeneratedProxy && GeneratedProxy->IsDynamic())
+	{
+		ENQUEUE_RENDER_COMMAND(SetGeneratedMeshSectionVisibility)(
+			[GeneratedProxy, SectionIndex, bNewVisibility](FRHICommandListImmediate& RHICmdList)
+		{
+			GeneratedProxy->SetSectionVisibility_RenderThread(SectionIndex, bNewVisibility);
+		});
+	}
+	else
+	{
+		MarkRenderStateDirty();
+	}
+}
+
+bool UGeneratedMeshComponent::IsMeshSectionVisible(int32 SectionIndex) const
+{
+	return MeshSections.IsValidIndex(SectionIndex) && MeshSections[SectionIndex].bSectionVisible;
+}
+
+FGeneratedMeshSceneProxy* UGeneratedMeshComponent::GetGeneratedProxy() const
+{
+	// subclasses may draw with a proxy of their own
+	if(SceneProxy && SceneProxy->GetTypeHash() == FGeneratedMeshSceneProxy::StaticTypeHash())
+	{
+		return static_cast<FGeneratedMeshSceneProxy*>(SceneProxy);
+	}
+	return nullptr;
+}
+
+bool UGeneratedMeshComponent::SendSectionToProxy(int32 SectionIndex, const FGeneratedMeshSectionRenderDataPtr& RenderData)
+{
+	FGeneratedMeshSceneProxy* GeneratedProxy = GetGeneratedProxy();
+	if(!GeneratedProxy || !GeneratedProxy->IsDynamic())
+	{
+		// the first replaced section switches to dynamic buffers for good, as more are likely to follow
+		if(GeneratedProxy)
+		{
+			bUseDynamicVertexBuffer = true;
 		}
+		return false;
+	}
+
+	const FGeneratedMeshSection& Section = MeshSections[SectionIndex];
+	FGeneratedMeshProxySection* NewSection = nullptr;
+	if(!Section.IsEmpty())
+	{
+		// the view relevance of the proxy is built from its materials : a new kind of material needs a new proxy
+		const ERHIFeatureLevel::Type FeatureLevel = GeneratedProxy->GetScene().GetFeatureLevel();
+		UMaterialInterface* Material = GetMaterial(SectionIndex) ? GetMaterial(SectionIndex) : UMaterial::GetDefaultMaterial(MD_Surface);
+		if(!GeneratedProxy->HasMaterialRelevance(Material->GetRelevance_Concurrent(FeatureLevel)))
+			return false;
+
+		NewSection = new FGeneratedMeshProxySection(FeatureLevel, Section, Material, true, VertexFormat, RenderData.Get());
+	}
+
+	ENQUEUE_RENDER_COMMAND(SetGeneratedMeshSection)(
+		[GeneratedProxy, SectionIndex, NewSection](FRHICommandListImmediate& RHICmdList)
+	{
+		GeneratedProxy->SetSection_RenderThread(SectionIndex, NewSection);
+	});
+
+	return true;
+}
+
+void FGeneratedMeshData::ComputeNormals()
+{
+	Normals.Reset();
+	Normals.AddZeroed(Positions.Num());
+
+	for(int32 Idx = 0; Idx + 2 < Indices.Num(); Idx += 3)
+	{
+		const uint32 I0 = Indices[Idx], I1 = Indices[Idx + 1], I2 = Indices[Idx + 2];
+
+		// not normalized : the cross product length is twice the face area, which weights the average
+		const FVector FaceNormal = (Positions[I2] - Positions[I0]) ^ (Positions[I1] - Positions[I0]);
+		Normals[I0] += FaceNormal;
+		Normals[I1] += FaceNormal;
+		Normals[I2] += FaceNormal;
+	}
+
+	for(FVector& Normal : Normals)
+	{
+		Normal = Normal.GetSafeNormal(SMALL_NUMBER, FVector::UpVector);
+	}
+}
 
-		virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override
+void FGeneratedMeshData::ComputeNormalsParallel()
+{
+	const int32 NumVertices	= Positions.Num();
+	const int32 NumTris		= NumTriangles();
+	const int32 ChunkSize	= 4096;
+
+	// face normals, not normalized : the length weights the average
+	TArray<FVector> FaceNormals;
+	FaceNormals.SetNumUninitialized(NumTris);
+	ParallelFor(FMath::DivideAndRoundUp(NumTris, ChunkSize), [&](int32 ChunkIdx)
+	{
+		const int32 LastTri = FMath::Min(NumTris, (ChunkIdx + 1) * ChunkSize);
+		for(int32 TriIdx = ChunkIdx * ChunkSize; TriIdx < LastTri; TriIdx++)
 		{
-			FPrimitiveViewRelevance Result;
-			Result.bDrawRelevance = IsShown(View);
-			Result.bShadowRelevance = IsShadowCast(View);
-			Result.bDynamicRelevance = true;
-			MaterialRelevance.SetPrimitiveViewRelevance(Result);
-			return Result;
+			const FVector& P0 = Positions[Indices[3 * TriIdx]];
+			const FVector& P1 = Positions[Indices[3 * TriIdx + 1]];
+			const FVector& P2 = Positions[Indices[3 * TriIdx + 2]];
+			FaceNormals[TriIdx] = (P2 - P0) ^ (P1 - P0);
 		}
+	});
+
+	// faces around each vertex, so every vertex is summed by a single thread
+	TArray<int32> FirstFace;
+	FirstFace.SetNumZeroed(NumVertices + 1);
+	for(const uint32 Index : Indices)
+	{
+		FirstFace[Index + 1]++;
+	}
+	for(int32 VertIdx = 0; VertIdx < NumVertices; VertIdx++)
+	{
+		FirstFace[VertIdx + 1] += FirstFace[VertIdx];
+	}
+
+	TArray<int32> VertexFaces;
+	VertexFaces.SetNumUninitialized(Indices.Num());
+	TArray<int32> NextFace(FirstFace.GetData(), NumVertices);
+	for(int32 Idx = 0; Idx < Indices.Num(); Idx++)
+	{
+		VertexFaces[NextFace[Indices[Idx]]++] = Idx / 3;
+	}
 
-		virtual bool CanBeOccluded() const override
+	Normals.SetNumUninitialized(NumVertices);
+	ParallelFor(FMath::DivideAndRoundUp(NumVertices, ChunkSize), [&](int32 ChunkIdx)
+	{
+		const int32 LastVertex = FMath::Min(NumVertices, (ChunkIdx + 1) * ChunkSize);
+		for(int32 VertIdx = ChunkIdx * ChunkSize; VertIdx < LastVertex; VertIdx++)
 		{
-			return !MaterialRelevance.bDisableDepthTest;
+			FVector Normal = FVector::ZeroVector;
+			for(int32 FaceIdx = FirstFace[VertIdx]; FaceIdx < FirstFace[VertIdx + 1]; FaceIdx++)
+			{
+				Normal += FaceNormals[VertexFaces[FaceIdx]];
+			}
+			Normals[VertIdx] = Normal.GetSafeNormal(SMALL_NUMBER, FVector::UpVector);
 		}
+	});
+}
 
-		virtual uint32 GetMemoryFootprint( void ) const { return( sizeof( *this ) + GetAllocatedSize() ); }
+/** Bounds of a range of positions, min and max are kept in vector registers */
+static FBox ComputeBoundsVectorized(const FVector* Positions, int32 Count)
+{
+	if(Count <= 0)
+		return FBox(ForceInit);
 
-		uint32 GetAllocatedSize( void ) const { return( FPrimitiveSceneProxy::GetAllocatedSize() ); }
+	VectorRegister Min = VectorLoadFloat3(Positions);
+	VectorRegister Max = Min;
+	for(int32 VertIdx = 1; VertIdx < Count; VertIdx++)
+	{
+		const VectorRegister Position = VectorLoadFloat3(Positions + VertIdx);
+		Min = VectorMin(Min, Position);
+		Max = VectorMax(Max, Position);
+	}
 
-		virtual SIZE_T GetTypeHash() const override {return 336103622995LL /*NAVIS in ASCII */; }
-	
-	};
-	
+	FVector BoxMin, BoxMax;
+	VectorStoreFloat3(Min, &BoxMin);
+	VectorStoreFloat3(Max, &BoxMax);
+	return FBox(BoxMin, BoxMax);
+}
+
+FBox FGeneratedMeshData::ComputeBounds() const
+{
+	return ComputeBoundsVectorized(Positions.GetData(), Positions.Num());
+}
+
+FBox FGeneratedMeshData::ComputeBoundsParallel() const
+{
+	const int32 NumVertices	= Positions.Num();
+	const int32 ChunkSize	= 16384;
+	const int32 NumChunks	= FMath::DivideAndRoundUp(NumVertices, ChunkSize);
+
+	// one box per chunk, merged afterwards
+	TArray<FBox> ChunkBoxes;
+	ChunkBoxes.Init(FBox(ForceInit), NumChunks);
+	ParallelFor(NumChunks, [&](int32 ChunkIdx)
+	{
+		const int32 FirstVertex = ChunkIdx * ChunkSize;
+		const int32 Count = FMath::Min(NumVertices, FirstVertex + ChunkSize) - FirstVertex;
+		ChunkBoxes[ChunkIdx] = ComputeBoundsVectorized(Positions.GetData() + FirstVertex, Count);
+	});
+
+	FBox Box(ForceInit);
+	for(const FBox& ChunkBox : ChunkBoxes)
+	{
+		Box += ChunkBox;
+	}
+	return Box;
+}
+
+
+FPrimitiveSceneProxy* UGeneratedMeshComponent::CreateSceneProxy()
+{
 	//Only create if have enough tris
-	if(GeneratedMeshTris.IsValidIndex(0))
+	if(MeshSections.ContainsByPredicate([](const FGeneratedMeshSection& Section) { return !Section.IsEmpty(); }))
 	{
 		return new FGeneratedMeshSceneProxy(this);
 	}
@@ -193,53 +545,51 @@ FPrimitiveSceneProxy* UGeneratedMeshComponent::CreateSceneProxy()
 
 int32 UGeneratedMeshComponent::GetNumMaterials() const
 {
-	return 1;
+	// one material slot per section
+	return FMath::Max(1, MeshSections.Num());
 }
 
 
 FBoxSphereBounds UGeneratedMeshComponent::CalcBounds(const FTransform & LocalToWorld) const
 {
-
-	auto min = [](const FVector &A, const FVector &B )-> FVector { 
-			return FVector (FMath::Min(A.X,B.X), FMath::Min(A.Y,B.Y), FMath::Min(A.Z,B.Z));
-			};
-	
-	auto max = [](const FVector &A, const FVector &B )-> FVector { 
-			return FVector (FMath::Min(A.X,B.X), FMath::Min(A.Y,B.Y), FMath::Min(A.Z,B.Z));
-			};
-
-	if(GeneratedMeshTris.IsValidIndex(0))
+	// cached per section, only the transform is applied here
+	FBox LocalBox(ForceInit);
+	for(const FGeneratedMeshSection& Section : MeshSections)
 	{
-		FVector vecMin = min(min(GeneratedMeshTris[0].V(0), GeneratedMeshTris[0].V(1)),GeneratedMeshTris[0].V(2));
-		FVector vecMax = max(max(GeneratedMeshTris[0].V(0), GeneratedMeshTris[0].V(1)),GeneratedMeshTris[0].V(2));
-		// Get maximum and minimum X, Y and Z positions of vectors
-		for (int32 TriIdx = 0; TriIdx < GeneratedMeshTris.Num(); TriIdx++)
+		if(Section.LocalBox.IsValid)
 		{
-			vecMin = min(min(GeneratedMeshTris[TriIdx].V(0), GeneratedMeshTris[TriIdx].V(1)),min(GeneratedMeshTris[TriIdx].V(2),vecMin ));
-			vecMax = max(max(GeneratedMeshTris[TriIdx].V(0), GeneratedMeshTris[TriIdx].V(1)),max(GeneratedMeshTris[TriIdx].V(2),vecMax ));
+			LocalBox += Section.LocalBox;
 		}
-		
-		FVector vecOrigin = ((vecMax - vecMin) / 2) + vecMin;	/* Origin = ((Max Vertex's Vector - Min Vertex's Vector) / 2 ) + Min Vertex's Vector */
-		FVector BoxPoint = vecMax - vecMin;			/* The difference between the "Maximum Vertex" and the "Minimum Vertex" is our actual Bounds Box */
-		return FBoxSphereBounds(vecOrigin, BoxPoint, BoxPoint.Size()).TransformBy(LocalToWorld);
 	}
-	return FBoxSphereBounds();
+
+	if(LocalBox.IsValid)
+	{
+		return FBoxSphereBounds(LocalBox).TransformBy(LocalToWorld);
+	}
+	return FBoxSphereBounds(LocalToWorld.GetLocation(), FVector::ZeroVector, 0.f);
 }
 
 
 bool UGeneratedMeshComponent::GetPhysicsTriMeshData(struct FTriMeshCollisionData* CollisionData, bool InUseAllTriData)
 {
+	// shared vertices, the same as the render buffers. Material index tells the section apart
 	FTriIndices Triangle;
+	for(int32 SectionIdx = 0; SectionIdx < MeshSections.Num(); SectionIdx++) {
+		const FGeneratedMeshSection& Section = MeshSections[SectionIdx];
+		if(!Section.bEnableCollision || Section.IsEmpty())
+			continue;
 
-	for(int32 i=0;i<GeneratedMeshTris.Num();i++) {
-		const FGeneratedTriangle& tri = GeneratedMeshTris[i];
+		const int32 VertexBase = CollisionData->Vertices.Num();
+		CollisionData->Vertices.Append(Section.Positions);
 
-		Triangle.v0 = CollisionData->Vertices.Add(tri[0]);
-		Triangle.v1 = CollisionData->Vertices.Add(tri[1]);
-		Triangle.v2 = CollisionData->Vertices.Add(tri[2]);
-		
-		CollisionData->Indices.Add(Triangle);
-		CollisionData->MaterialIndices.Add(i);
+		for(int32 Idx = 0; Idx + 2 < Section.Indices.Num(); Idx += 3) {
+			Triangle.v0 = VertexBase + Section.Indices[Idx];
+			Triangle.v1 = VertexBase + Section.Indices[Idx + 1];
+			Triangle.v2 = VertexBase + Section.Indices[Idx + 2];
+
+			CollisionData->Indices.Add(Triangle);
+			CollisionData->MaterialIndices.Add(SectionIdx);
+		}
 	}
 
 	CollisionData->bFlipNormals = true;
@@ -249,30 +599,85 @@ bool UGeneratedMeshComponent::GetPhysicsTriMeshData(struct FTriMeshCollisionData
 
 bool UGeneratedMeshComponent::ContainsPhysicsTriMeshData(bool InUseAllTriData) const
 {
-	return (GeneratedMeshTris.Num() > 0);
+	return MeshSections.ContainsByPredicate([](const FGeneratedMeshSection& Section) { return Section.bEnableCollision && !Section.IsEmpty(); });
 }
 
 void UGeneratedMeshComponent::UpdateBodySetup() {
 	if (ModelBodySetup == NULL)	{
-		ModelBodySetup = NewObject<UBodySetup>(this, UBodySetup::StaticClass());
-		ModelBodySetup->CollisionTraceFlag = CTF_UseComplexAsSimple;
-		ModelBodySetup->bMeshCollideAll = true;
+		UpdateCollision();
 	}
 }
 
 void UGeneratedMeshComponent::UpdateCollision() {
-	if (bPhysicsStateCreated) {
-		DestroyPhysicsState();
-		UpdateBodySetup();
-		CreatePhysicsState();
+	// gather : every collision section, material index tells the section apart
+	FTriMeshCollisionData CollisionData;
+	GetPhysicsTriMeshData(&CollisionData, true);
+
+	uint64 NewHash = 0;
+	if (CollisionData.Indices.Num() > 0) {
+		NewHash = CityHash64(reinterpret_cast<const char*>(CollisionData.Vertices.GetData()), CollisionData.Vertices.Num() * sizeof(FVector));
+		NewHash = CityHash64WithSeed(reinterpret_cast<const char*>(CollisionData.Indices.GetData()), CollisionData.Indices.Num() * sizeof(FTriIndices), NewHash);
+		NewHash = CityHash64WithSeed(reinterpret_cast<const char*>(CollisionData.MaterialIndices.GetData()), CollisionData.MaterialIndices.Num() * sizeof(uint16), NewHash);
+		// decomposed geometry is not the same collision as the bare tri-mesh
+		if (bUseConvexDecomposition) {
+			const int32 Decomposition[] = { MaxConvexHulls, ConvexDecompositionResolution };
+			NewHash = CityHash64WithSeed(reinterpret_cast<const char*>(Decomposition), sizeof(Decomposition), NewHash);
+		}
+		// 0 stands for no collision
+		NewHash = NewHash ? NewHash : 1;
+	}
+
+	if (NewHash == CollisionHash)
+		return;
+
+	FGeneratedMeshCollisionCache& Cache = FGeneratedMeshCollisionCache::Get();
+	const uint64 OldHash = CollisionHash;
+	CollisionHash = NewHash;
 
-                ModelBodySetup->InvalidatePhysicsData(); //Will not work in Packaged build
-                                                         //Epic needs to add support for this
-		ModelBodySetup->CreatePhysicsMeshes();
+	if (NewHash == 0) {
+		ModelBodySetup = nullptr;
+		RecreatePhysicsState();
+	}
+	else {
+		UBodySetup* Shared = Cache.Acquire(NewHash, this, [this, &CollisionData](UGeneratedMeshCollisionData& Data)
+		{
+			Data.Vertices			= MoveTemp(CollisionData.Vertices);
+			Data.Indices			= MoveTemp(CollisionData.Indices);
+			Data.MaterialIndices	= MoveTemp(CollisionData.MaterialIndices);
+			Data.MaxConvexHulls		= bUseConvexDecomposition ? MaxConvexHulls : 0;
+			Data.ConvexResolution	= ConvexDecompositionResolution;
+		}, bUseAsyncCooking);
+
+		// still cooking : keep the previous collision until FinishCollisionCook()
+		if (Shared) {
+			ModelBodySetup = Shared;
+			RecreatePhysicsState();
+		}
+	}
+
+	if (OldHash != 0) {
+		Cache.Release(OldHash);
 	}
 }
 
+void UGeneratedMeshComponent::FinishCollisionCook(uint64 Hash, UBodySetup* CookedBodySetup) {
+	if (Hash != CollisionHash || !CookedBodySetup)
+		return;
+
+	ModelBodySetup = CookedBodySetup;
+	RecreatePhysicsState();
+}
+
+void UGeneratedMeshComponent::BeginDestroy() {
+	Super::BeginDestroy();
+
+	FGeneratedMeshCollisionCache* Cache = FGeneratedMeshCollisionCache::TryGet();
+	if (Cache && CollisionHash != 0) {
+		Cache->Release(CollisionHash);
+	}
+	CollisionHash = 0;
+}
+
 UBodySetup* UGeneratedMeshComponent::GetBodySetup() {
-	UpdateBodySetup();
 	return ModelBodySetup;
-}
\ No newline at end of file
+}
@@ -0,0 +1,448 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "GeneratedMeshConvexDecomposition.h"
+#include "Async/ParallelFor.h"
+
+
+/** Axes of the 26-DOP, each gives a min and a max extreme */
+static const FIntVector KDopAxes[] =
+{
+	FIntVector(1, 0, 0), FIntVector(0, 1, 0), FIntVector(0, 0, 1),
+	FIntVector(1, 1, 0), FIntVector(1,-1, 0), FIntVector(1, 0, 1),
+	FIntVector(1, 0,-1), FIntVector(0, 1, 1), FIntVector(0, 1,-1),
+	FIntVector(1, 1, 1), FIntVector(1, 1,-1), FIntVector(1,-1, 1),
+	FIntVector(-1, 1, 1)
+};
+static const int32 NumKDopAxes = ARRAY_COUNT(KDopAxes);
+
+static FORCEINLINE int32 Dot(const FIntVector& A, const FIntVector& B)
+{
+	return A.X * B.X + A.Y * B.Y + A.Z * B.Z;
+}
+
+static FORCEINLINE FIntVector Cross(const FIntVector& A, const FIntVector& B)
+{
+	return FIntVector(A.Y * B.Z - A.Z * B.Y, A.Z * B.X - A.X * B.Z, A.X * B.Y - A.Y * B.X);
+}
+
+/** FloorDiv()	integer division rounding down, whatever the signs */
+static FORCEINLINE int64 FloorDiv(int64 A, int64 B)
+{
+	const int64 Quotient = A / B;
+	return (A % B != 0 && ((A < 0) != (B < 0))) ? Quotient - 1 : Quotient;
+}
+
+static FORCEINLINE int64 CeilDiv(int64 A, int64 B)
+{
+	return -FloorDiv(-A, B);
+}
+
+static int32 GreatestCommonDivisor(int32 A, int32 B)
+{
+	A = FMath::Abs(A);
+	B = FMath::Abs(B);
+	while(B != 0)
+	{
+		const int32 Remainder = A % B;
+		A = B;
+		B = Remainder;
+	}
+	return A;
+}
+
+/**
+ *	FHullPlane
+ *	Face of a hull in doubled voxel coordinates : the points P inside have Dot(Normal, P) <= Distance
+ */
+struct FHullPlane
+{
+	FIntVector Normal;
+	int64 Distance;
+
+	bool operator==(const FHullPlane& Other) const { return Normal == Other.Normal && Distance == Other.Distance; }
+};
+
+/**
+ *	FindHullPlanes()	Faces of the convex hull of a few points, by trying every triple of them
+ *	@note				cubic in the points, meant for the 26 extremes of a k-DOP. Exact, the points are integral
+ */
+static void FindHullPlanes(const TArray<FIntVector>& Points, TArray<FHullPlane>& OutPlanes)
+{
+	OutPlanes.Reset();
+	for(int32 I = 0; I < Points.Num(); I++)
+	{
+		for(int32 J = I + 1; J < Points.Num(); J++)
+		{
+			for(int32 K = J + 1; K < Points.Num(); K++)
+			{
+				FIntVector Normal = Cross(Points[J] - Points[I], Points[K] - Points[I]);
+				if(Normal == FIntVector::ZeroValue)
+					continue;
+
+				// a face has every point on the same side
+				const int32 Distance = Dot(Normal, Points[I]);
+				bool bAbove = false, bBelow = false;
+				for(const FIntVector& Point : Points)
+				{
+					const int32 Side = Dot(Normal, Point) - Distance;
+					bAbove |= Side > 0;
+					bBelow |= Side < 0;
+				}
+				if(bAbove && bBelow)
+					continue;
+
+				// coplanar points give the same face many times, reduced it is found again
+				const int32 Divisor = GreatestCommonDivisor(GreatestCommonDivisor(Normal.X, Normal.Y), Normal.Z);
+				const int32 Sign = bAbove ? -1 : 1;
+				Normal = FIntVector(Normal.X * Sign / Divisor, Normal.Y * Sign / Divisor, Normal.Z * Sign / Divisor);
+				OutPlanes.AddUnique({ Normal, Dot(Normal, Points[I]) });
+			}
+		}
+	}
+}
+
+/**
+ *	FVoxelPart
+ *	A set of filled voxels, with the hull of their 26-DOP extremes standing for their convex hull
+ */
+struct FVoxelPart
+{
+	TArray<FIntVector> Cells;
+	FIntVector Min;
+	FIntVector Max;
+
+	/** extent of the voxel corners along each axis */
+	int32 AxisMin[NumKDopAxes];
+	int32 AxisMax[NumKDopAxes];
+
+	/** voxel corner reaching each extent */
+	FIntVector CornerMin[NumKDopAxes];
+	FIntVector CornerMax[NumKDopAxes];
+
+	/** voxels whose center is in the hull of the corners, filled or not. The same hull as the one emitted */
+	int32 HullCells = 0;
+
+	/** set once no cut can be found, a single voxel layer for instance */
+	bool bCannotSplit = false;
+
+	/** EmptyCells()	hull volume the part does not fill, in voxels. A few cells of a thin part may stick out of the hull of the corners */
+	int32 EmptyCells() const { return FMath::Max(HullCells - Cells.Num(), 0); }
+
+	/** Concavity()		empty part of the hull */
+	float Concavity() const { return HullCells > 0 ? float(EmptyCells()) / float(HullCells) : 0.f; }
+
+	/** Build()		compute the bounds, the 26-DOP extremes and the volume of their hull from the cells */
+	void Build()
+	{
+		Min = FIntVector(MAX_int32);
+		Max = FIntVector(MIN_int32);
+		for(int32 AxisIdx = 0; AxisIdx < NumKDopAxes; AxisIdx++)
+		{
+			AxisMin[AxisIdx] = MAX_int32;
+			AxisMax[AxisIdx] = MIN_int32;
+		}
+
+		for(const FIntVector& Cell : Cells)
+		{
+			Min = FIntVector(FMath::Min(Min.X, Cell.X), FMath::Min(Min.Y, Cell.Y), FMath::Min(Min.Z, Cell.Z));
+			Max = FIntVector(FMath::Max(Max.X, Cell.X), FMath::Max(Max.Y, Cell.Y), FMath::Max(Max.Z, Cell.Z));
+
+			// the corner furthest along an axis is the one on the positive side of each component
+			for(int32 AxisIdx = 0; AxisIdx < NumKDopAxes; AxisIdx++)
+			{
+				const FIntVector& Axis = KDopAxes[AxisIdx];
+				const FIntVector High = Cell + FIntVector(Axis.X > 0, Axis.Y > 0, Axis.Z > 0);
+				const FIntVector Low  = Cell + FIntVector(Axis.X < 0, Axis.Y < 0, Axis.Z < 0);
+				const int32 HighDot = Dot(High, Axis);
+				const int32 LowDot  = Dot(Low, Axis);
+				if(HighDot > AxisMax[AxisIdx])
+				{
+					AxisMax[AxisIdx] = HighDot;
+					CornerMax[AxisIdx] = High;
+				}
+				if(LowDot < AxisMin[AxisIdx])
+				{
+					AxisMin[AxisIdx] = LowDot;
+					CornerMin[AxisIdx] = Low;
+				}
+			}
+		}
+
+		// the emitted hull is the one of the corners, in doubled coordinates so the voxel centers are integral too
+		TArray<FIntVector> Corners;
+		for(int32 AxisIdx = 0; AxisIdx < NumKDopAxes; AxisIdx++)
+		{
+			Corners.AddUnique(CornerMin[AxisIdx] * 2);
+			Corners.AddUnique(CornerMax[AxisIdx] * 2);
+		}
+		TArray<FHullPlane> Planes;
+		FindHullPlanes(Corners, Planes);
+
+		// each row of voxels along X enters and leaves the hull once : every face clamps the range of the row
+		HullCells = 0;
+		for(int32 Z = Min.Z; Z <= Max.Z; Z++)
+		{
+			for(int32 Y = Min.Y; Y <= Max.Y; Y++)
+			{
+				int64 First = Min.X;
+				int64 Last = Max.X;
+				for(const FHullPlane& Plane : Planes)
+				{
+					// Normal.X * (2X + 1) <= Distance - Normal.Y * (2Y + 1) - Normal.Z * (2Z + 1)
+					const int64 Remaining = Plane.Distance - int64(Plane.Normal.Y) * (2 * Y + 1) - int64(Plane.Normal.Z) * (2 * Z + 1);
+					if(Plane.Normal.X > 0)
+					{
+						Last = FMath::Min(Last, FloorDiv(FloorDiv(Remaining, Plane.Normal.X) - 1, 2));
+					}
+					else if(Plane.Normal.X < 0)
+					{
+						First = FMath::Max(First, CeilDiv(CeilDiv(Remaining, Plane.Normal.X) - 1, 2));
+					}
+					else if(Remaining < 0)
+					{
+						Last = First - 1;
+					}
+				}
+				HullCells += int32(FMath::Max<int64>(Last - First + 1, 0));
+			}
+		}
+	}
+
+	/** Split()		cut along an axis, cells below Plane go to OutLow */
+	void Split(int32 Axis, int32 Plane, FVoxelPart& OutLow, FVoxelPart& OutHigh) const
+	{
+		for(const FIntVector& Cell : Cells)
+		{
+			(Cell[Axis] < Plane ? OutLow : OutHigh).Cells.Add(Cell);
+		}
+		OutLow.Build();
+		OutHigh.Build();
+	}
+};
+
+/**
+ *	EdgeFunction()	twice the signed area of A, B and the column in XY, positive when they turn counter clockwise.
+ *	Exactly the opposite for B, A : the two triangles sharing an edge agree on which columns are on it
+ */
+static FORCEINLINE float EdgeFunction(const FVector& A, const FVector& B, float PX, float PY)
+{
+	const bool bOrdered = A.X < B.X || (A.X == B.X && A.Y < B.Y);
+	const FVector& From = bOrdered ? A : B;
+	const FVector& To = bOrdered ? B : A;
+	const float Value = (To.X - From.X) * (PY - From.Y) - (To.Y - From.Y) * (PX - From.X);
+	return bOrdered ? Value : -Value;
+}
+
+/**
+ *	IsTopLeft()		whether a column on the edge from A to B, of a counter clockwise triangle, belongs to that triangle.
+ *	Of two triangles sharing the edge, on both sides of it, only one owns it : a column crosses the surface once
+ */
+static FORCEINLINE bool IsTopLeft(const FVector& A, const FVector& B)
+{
+	const float DX = B.X - A.X;
+	const float DY = B.Y - A.Y;
+	return DY > 0.f || (DY == 0.f && DX < 0.f);
+}
+
+/** Fill the voxels inside a closed mesh, by parity of the crossings along Z columns */
+static void Voxelize(const TArray<FVector>& Vertices, const TArray<FTriIndices>& Indices, const FVector& GridMin, float VoxelSize, const FIntVector& Dims, TArray<FIntVector>& OutCells)
+{
+	// crossings of each column with the surface
+	TArray<TArray<float>> Crossings;
+	Crossings.SetNum(Dims.X * Dims.Y);
+
+	for(const FTriIndices& Triangle : Indices)
+	{
+		const FVector& A = Vertices[Triangle.v0];
+		const FVector* B = &Vertices[Triangle.v1];
+		const FVector* C = &Vertices[Triangle.v2];
+
+		// vertical triangles have no area in the XY plane, their neighbours get the crossing
+		const float Area = (B->X - A.X) * (C->Y - A.Y) - (C->X - A.X) * (B->Y - A.Y);
+		if(Area == 0.f)
+			continue;
+
+		// counter clockwise seen from above, whichever way the triangle faces
+		if(Area < 0.f)
+			Swap(B, C);
+
+		const int32 MinX = FMath::Max(0, FMath::FloorToInt((FMath::Min3(A.X, B->X, C->X) - GridMin.X) / VoxelSize - 0.5f));
+		const int32 MaxX = FMath::Min(Dims.X - 1, FMath::CeilToInt((FMath::Max3(A.X, B->X, C->X) - GridMin.X) / VoxelSize - 0.5f));
+		const int32 MinY = FMath::Max(0, FMath::FloorToInt((FMath::Min3(A.Y, B->Y, C->Y) - GridMin.Y) / VoxelSize - 0.5f));
+		const int32 MaxY = FMath::Min(Dims.Y - 1, FMath::CeilToInt((FMath::Max3(A.Y, B->Y, C->Y) - GridMin.Y) / VoxelSize - 0.5f));
+
+		const bool bOwnsBC = IsTopLeft(*B, *C);
+		const bool bOwnsCA = IsTopLeft(*C, A);
+		const bool bOwnsAB = IsTopLeft(A, *B);
+
+		for(int32 Y = MinY; Y <= MaxY; Y++)
+		{
+			for(int32 X = MinX; X <= MaxX; X++)
+			{
+				const float PX = GridMin.X + (X + 0.5f) * VoxelSize;
+				const float PY = GridMin.Y + (Y + 0.5f) * VoxelSize;
+
+				// barycentric weights of the column in the projected triangle, a column on an edge only counts for one of its triangles
+				const float U = EdgeFunction(*B, *C, PX, PY);
+				const float V = EdgeFunction(*C, A, PX, PY);
+				const float W = EdgeFunction(A, *B, PX, PY);
+				if(U < 0.f || V < 0.f || W < 0.f)
+					continue;
+				if((U == 0.f && !bOwnsBC) || (V == 0.f && !bOwnsCA) || (W == 0.f && !bOwnsAB))
+					continue;
+
+				const float Sum = U + V + W;
+				if(Sum <= 0.f)
+					continue;
+				Crossings[Y * Dims.X + X].Add((U * A.Z + V * B->Z + W * C->Z) / Sum);
+			}
+		}
+	}
+
+	// inside between each pair of crossings
+	FCriticalSection CellsLock;
+	ParallelFor(Dims.Y, [&](int32 Y)
+	{
+		TArray<FIntVector> RowCells;
+		for(int32 X = 0; X < Dims.X; X++)
+		{
+			TArray<float>& Column = Crossings[Y * Dims.X + X];
+			Column.Sort();
+			for(int32 CrossIdx = 0; CrossIdx + 1 < Column.Num(); CrossIdx += 2)
+			{
+				const int32 FirstZ = FMath::Max(0, FMath::CeilToInt((Column[CrossIdx] - GridMin.Z) / VoxelSize - 0.5f));
+				const int32 LastZ = FMath::Min(Dims.Z - 1, FMath::FloorToInt((Column[CrossIdx + 1] - GridMin.Z) / VoxelSize - 0.5f));
+				for(int32 Z = FirstZ; Z <= LastZ; Z++)
+				{
+					RowCells.Add(FIntVector(X, Y, Z));
+				}
+			}
+		}
+		FScopeLock Lock(&CellsLock);
+		OutCells.Append(RowCells);
+	});
+}
+
+/** Hull of a point cloud reduced to its 26-DOP extremes */
+static FKConvexElem MakeKDopHull(const TArray<FVector>& Points)
+{
+	FKConvexElem Hull;
+	for(const FIntVector& IntAxis : KDopAxes)
+	{
+		const FVector Axis(IntAxis.X, IntAxis.Y, IntAxis.Z);
+		int32 MinIdx = 0, MaxIdx = 0;
+		for(int32 PointIdx = 1; PointIdx < Points.Num(); PointIdx++)
+		{
+			const float PointDot = Points[PointIdx] | Axis;
+			MinIdx = PointDot < (Points[MinIdx] | Axis) ? PointIdx : MinIdx;
+			MaxIdx = PointDot > (Points[MaxIdx] | Axis) ? PointIdx : MaxIdx;
+		}
+		Hull.VertexData.AddUnique(Points[MinIdx]);
+		Hull.VertexData.AddUnique(Points[MaxIdx]);
+	}
+	Hull.UpdateElemBox();
+	return Hull;
+}
+
+void FGeneratedMeshConvexDecomposition::Decompose(const TArray<FVector>& Vertices, const TArray<FTriIndices>& Indices, const FGeneratedMeshDecompositionSettings& Settings, TArray<FKConvexElem>& OutHulls)
+{
+	OutHulls.Reset();
+	if(Vertices.Num() == 0 || Indices.Num() == 0)
+		return;
+
+	const FBox Bounds(Vertices);
+	const float VoxelSize = FMath::Max(Bounds.GetSize().GetMax() / FMath::Max(1, Settings.Resolution), KINDA_SMALL_NUMBER);
+	const FIntVector Dims(
+		FMath::Clamp(FMath::CeilToInt(Bounds.GetSize().X / VoxelSize), 1, Settings.Resolution),
+		FMath::Clamp(FMath::CeilToInt(Bounds.GetSize().Y / VoxelSize), 1, Settings.Resolution),
+		FMath::Clamp(FMath::CeilToInt(Bounds.GetSize().Z / VoxelSize), 1, Settings.Resolution));
+
+	TArray<FVoxelPart> Parts;
+	Parts.AddDefaulted();
+	Voxelize(Vertices, Indices, Bounds.Min, VoxelSize, Dims, Parts[0].Cells);
+
+	// open or flat : nothing to split, keep a single hull
+	if(Parts[0].Cells.Num() == 0)
+	{
+		OutHulls.Add(MakeKDopHull(Vertices));
+		return;
+	}
+	Parts[0].Build();
+
+	while(Parts.Num() < Settings.MaxHulls)
+	{
+		// the part leaving the most empty space in its hull goes first
+		int32 WorstIdx = INDEX_NONE;
+		for(int32 PartIdx = 0; PartIdx < Parts.Num(); PartIdx++)
+		{
+			const FVoxelPart& Part = Parts[PartIdx];
+			if(Part.bCannotSplit || Part.Concavity() <= Settings.MaxConcavity)
+				continue;
+			if(WorstIdx == INDEX_NONE || Part.EmptyCells() > Parts[WorstIdx].EmptyCells())
+			{
+				WorstIdx = PartIdx;
+			}
+		}
+		if(WorstIdx == INDEX_NONE)
+			break;
+
+		// a few planes per axis, evaluated in parallel
+		const FVoxelPart& Worst = Parts[WorstIdx];
+		const int32 PlanesPerAxis = 5;
+		TArray<TPair<int32, int32>> Candidates;
+		for(int32 Axis = 0; Axis < 3; Axis++)
+		{
+			const int32 Extent = Worst.Max[Axis] - Worst.Min[Axis] + 1;
+			for(int32 PlaneIdx = 1; PlaneIdx <= PlanesPerAxis && Extent > 1; PlaneIdx++)
+			{
+				const int32 Plane = Worst.Min[Axis] + FMath::Max(1, (Extent * PlaneIdx) / (PlanesPerAxis + 1));
+				Candidates.AddUnique(TPair<int32, int32>(Axis, Plane));
+			}
+		}
+
+		TArray<int32> Costs;
+		Costs.Init(MAX_int32, Candidates.Num());
+		ParallelFor(Candidates.Num(), [&](int32 CandidateIdx)
+		{
+			FVoxelPart Low, High;
+			Worst.Split(Candidates[CandidateIdx].Key, Candidates[CandidateIdx].Value, Low, High);
+			if(Low.Cells.Num() > 0 && High.Cells.Num() > 0)
+			{
+				Costs[CandidateIdx] = Low.EmptyCells() + High.EmptyCells();
+			}
+		});
+
+		int32 BestIdx = INDEX_NONE;
+		for(int32 CandidateIdx = 0; CandidateIdx < Candidates.Num(); CandidateIdx++)
+		{
+			if(Costs[CandidateIdx] != MAX_int32 && (BestIdx == INDEX_NONE || Costs[CandidateIdx] < Costs[BestIdx]))
+			{
+				BestIdx = CandidateIdx;
+			}
+		}
+		if(BestIdx == INDEX_NONE)
+		{
+			Parts[WorstIdx].bCannotSplit = true;
+			continue;
+		}
+
+		FVoxelPart Low, High;
+		Worst.Split(Candidates[BestIdx].Key, Candidates[BestIdx].Value, Low, High);
+		Parts[WorstIdx] = MoveTemp(Low);
+		Parts.Add(MoveTemp(High));
+	}
+
+	// the 26-DOP corners of each part, back in component space
+	for(const FVoxelPart& Part : Parts)
+	{
+		FKConvexElem& Hull = OutHulls.AddDefaulted_GetRef();
+		for(int32 AxisIdx = 0; AxisIdx < NumKDopAxes; AxisIdx++)
+		{
+			for(const FIntVector& Corner : { Part.CornerMin[AxisIdx], Part.CornerMax[AxisIdx] })
+			{
+				Hull.VertexData.AddUnique(Bounds.Min + FVector(Corner.X, Corner.Y, Corner.Z) * VoxelSize);
+			}
+		}
+		Hull.UpdateElemBox();
+	}
+}
@@ -0,0 +1,45 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "NAVIS_CustomMeshPCH.h"
+#include "PhysicsEngine/ConvexElem.h"
+
+/**
+ *	FGeneratedMeshDecompositionSettings
+ *	How far a generated mesh is split into convex hulls
+ */
+struct FGeneratedMeshDecompositionSettings
+{
+	/** Most hulls produced, parts are split by decreasing concavity until this is reached */
+	int32 MaxHulls = 8;
+
+	/** Voxels along the longest side of the mesh */
+	int32 Resolution = 32;
+
+	/** Parts with less of their hull empty than this ratio are not split further */
+	float MaxConcavity = 0.05f;
+};
+
+/**
+ *	FGeneratedMeshConvexDecomposition
+ *	Approximate convex decomposition of a closed tri-mesh, in the spirit of V-HACD :
+ *	the mesh is voxelized, then the part whose hull is the least filled is cut by the plane that
+ *	leaves the least empty space in both halves, until the hull budget or the concavity target is reached.
+ *	Hulls are k-DOP reductions of their part, 26 points at most.
+ *	@note	thread safe, meant to run on worker threads
+ */
+class FGeneratedMeshConvexDecomposition
+{
+public:
+
+	/**
+	 *	Decompose()			Split a mesh into convex hulls
+	 *	@param Vertices		positions of the mesh, in component space
+	 *	@param Indices		triangles of the mesh
+	 *	@param Settings		hull budget and precision
+	 *	@param OutHulls		one element per hull, empty if the mesh has no triangle
+	 *	@note				open meshes cannot be voxelized, they get a single hull around their vertices
+	 */
+	static void Decompose(const TArray<FVector>& Vertices, const TArray<FTriIndices>& Indices, const FGeneratedMeshDecompositionSettings& Settings, TArray<FKConvexElem>& OutHulls);
+};
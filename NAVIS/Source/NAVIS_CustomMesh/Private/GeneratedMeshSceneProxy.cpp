@@ -0,0 +1,303 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "GeneratedMeshSceneProxy.h"
+#include "GeneratedMeshComponent.h"
+#include "Materials/Material.h"
+#include "Async/ParallelFor.h"
+
+
+FGeneratedMeshProxySection::FGeneratedMeshProxySection(ERHIFeatureLevel::Type InFeatureLevel, const FGeneratedMeshSection& Section, UMaterialInterface* InMaterial, bool bDynamic, EGeneratedMeshVertexFormat Format, FGeneratedMeshSectionRenderData* RenderData)
+	: Material(InMaterial)
+	, VertexFactory(InFeatureLevel, "NAVIS_MESH_GENERATOR")
+	, bSectionVisible(Section.bSectionVisible)
+{
+	// vertices built on worker threads, nothing left to do here
+	const bool bCompact = Format == EGeneratedMeshVertexFormat::Compact;
+	if(RenderData && RenderData->bCompact == bCompact && RenderData->NumVertices() == Section.Positions.Num())
+	{
+		SetRenderData(MoveTemp(*RenderData));
+	}
+	else
+	{
+		FGeneratedMeshSectionRenderData NewData;
+		FGeneratedMeshSceneProxy::BuildRenderData(Section, Format, NewData);
+		SetRenderData(MoveTemp(NewData));
+	}
+	VertexBuffer.bDynamic = bDynamic;
+
+	IndexBuffer.Indices = Section.Indices;
+	IndexBuffer.bUse16BitIndices = Section.Use16BitIndices();
+
+	if(Material == NULL)
+	{
+		Material = UMaterial::GetDefaultMaterial(MD_Surface);
+	}
+}
+
+void FGeneratedMeshProxySection::SetRenderData(FGeneratedMeshSectionRenderData&& RenderData)
+{
+	VertexBuffer.bCompact = RenderData.bCompact;
+	VertexBuffer.Vertices = MoveTemp(RenderData.Vertices);
+	VertexBuffer.CompactVertices = MoveTemp(RenderData.CompactVertices);
+}
+
+void FGeneratedMeshProxySection::InitResources()
+{
+	// Init vertex factory
+	VertexFactory.Init(&VertexBuffer);
+
+	// Enqueue initialization of render resource
+	BeginInitResource(&VertexBuffer);
+	BeginInitResource(&IndexBuffer);
+	BeginInitResource(&VertexFactory);
+}
+
+void FGeneratedMeshProxySection::InitResources_RenderThread()
+{
+	VertexBuffer.InitResource();
+	IndexBuffer.InitResource();
+	VertexFactory.Init_RenderThread(&VertexBuffer);
+	VertexFactory.InitResource();
+}
+
+void FGeneratedMeshProxySection::ReleaseResources()
+{
+	VertexBuffer.ReleaseResource();
+	IndexBuffer.ReleaseResource();
+	VertexFactory.ReleaseResource();
+}
+
+
+FGeneratedMeshSceneProxy::FGeneratedMeshSceneProxy(UGeneratedMeshComponent* Component)	: FPrimitiveSceneProxy(Component)
+	, MaterialRelevance(Component->GetMaterialRelevance(GetScene().GetFeatureLevel()))
+	, bDynamicBuffers(Component->bUseDynamicVertexBuffer)
+{
+	// empty sections keep their slot, so indices match the component
+	Sections.AddZeroed(Component->MeshSections.Num());
+	for(int32 SectionIdx = 0; SectionIdx < Component->MeshSections.Num(); SectionIdx++)
+	{
+		const FGeneratedMeshSection& Section = Component->MeshSections[SectionIdx];
+		if(Section.IsEmpty())
+			continue;
+
+		const FGeneratedMeshSectionRenderDataPtr* RenderData = Component->PendingRenderData.Find(SectionIdx);
+		Sections[SectionIdx] = new FGeneratedMeshProxySection(GetScene().GetFeatureLevel(), Section, Component->GetMaterial(SectionIdx), bDynamicBuffers, Component->VertexFormat, RenderData ? RenderData->Get() : nullptr);
+		Sections[SectionIdx]->InitResources();
+	}
+
+	// consumed, later proxies build from the sections
+	Component->PendingRenderData.Empty();
+}
+
+FGeneratedMeshSceneProxy::~FGeneratedMeshSceneProxy()
+{
+	for(FGeneratedMeshProxySection* Section : Sections)
+	{
+		if(Section)
+		{
+			Section->ReleaseResources();
+			delete Section;
+		}
+	}
+}
+
+/** ToCompact()	half of a component space coordinate, clamped to the largest half instead of turning infinite */
+static FORCEINLINE FFloat16 ToCompact(float Value)
+{
+	const float MaxHalf = 65504.f;
+	return FFloat16(FMath::Clamp(Value, -MaxHalf, MaxHalf));
+}
+
+void FGeneratedMeshSceneProxy::BuildRenderData(const FGeneratedMeshSection& Data, EGeneratedMeshVertexFormat Format, FGeneratedMeshSectionRenderData& OutData, bool bParallel)
+{
+	const FColor VertexColor(255,255,255);
+	const int32 NumVertices = Data.Positions.Num();
+
+	OutData.LocalBox = Data.LocalBox;
+	OutData.bCompact = Format == EGeneratedMeshVertexFormat::Compact;
+
+	// only one of the arrays is used
+	OutData.Vertices.Empty(OutData.bCompact ? 0 : NumVertices);
+	OutData.CompactVertices.Empty(OutData.bCompact ? NumVertices : 0);
+	if(OutData.bCompact)
+	{
+		OutData.CompactVertices.SetNumUninitialized(NumVertices);
+	}
+	else
+	{
+		OutData.Vertices.SetNumUninitialized(NumVertices);
+	}
+
+	// chunks keep the task overhead small against the work of a single vertex
+	const int32 ChunkSize = 4096;
+	const int32 NumChunks = FMath::DivideAndRoundUp(NumVertices, ChunkSize);
+
+	ParallelFor(NumChunks, [&](int32 ChunkIdx)
+	{
+		const int32 LastVertex = FMath::Min(NumVertices, (ChunkIdx + 1) * ChunkSize);
+		for(int32 VertIdx = ChunkIdx * ChunkSize; VertIdx < LastVertex; VertIdx++)
+		{
+			// tangents follow the smooth normals
+			const FVector TangentZ = Data.Normals[VertIdx];
+			FVector TangentX, TangentY;
+			TangentZ.FindBestAxisVectors(TangentX, TangentY);
+
+			if(OutData.bCompact)
+			{
+				const FVector& Position = Data.Positions[VertIdx];
+
+				FGeneratedMeshCompactVertex& Vert = OutData.CompactVertices[VertIdx];
+				Vert.Position[0] = ToCompact(Position.X);
+				Vert.Position[1] = ToCompact(Position.Y);
+				Vert.Position[2] = ToCompact(Position.Z);
+				Vert.Position[3] = FFloat16(1.f);
+				Vert.TangentX = TangentX;
+				Vert.TangentZ = FVector4(TangentZ, GetBasisDeterminantSign(TangentX, TangentY, TangentZ));
+				Vert.TextureCoordinate = FVector2D::ZeroVector;
+			}
+			else
+			{
+				FDynamicMeshVertex& Vert = OutData.Vertices[VertIdx];
+				Vert = FDynamicMeshVertex(Data.Positions[VertIdx]);
+				Vert.Color = VertexColor;
+				Vert.SetTangents(TangentX, TangentY, TangentZ);
+			}
+		}
+	}, !bParallel);
+}
+
+void FGeneratedMeshSceneProxy::UpdateVertices_RenderThread(int32 SectionIndex, FGeneratedMeshSectionRenderData&& NewData)
+{
+	check(IsInRenderingThread());
+
+	// topology changes go through SetSection_RenderThread, not here
+	FGeneratedMeshProxySection* Section = Sections.IsValidIndex(SectionIndex) ? Sections[SectionIndex] : nullptr;
+	if(!Section || !Section->VertexBuffer.bDynamic || NewData.bCompact != Section->IsCompact() || NewData.NumVertices() != Section->VertexBuffer.NumVertices())
+		return;
+
+	Section->SetRenderData(MoveTemp(NewData));
+	Section->VertexBuffer.CopyVertices();
+}
+
+void FGeneratedMeshSceneProxy::SetSection_RenderThread(int32 SectionIndex, FGeneratedMeshProxySection* NewSection)
+{
+	check(IsInRenderingThread());
+
+	if(SectionIndex >= Sections.Num())
+	{
+		Sections.AddZeroed(SectionIndex + 1 - Sections.Num());
+	}
+
+	if(FGeneratedMeshProxySection* OldSection = Sections[SectionIndex])
+	{
+		OldSection->ReleaseResources();
+		delete OldSection;
+	}
+
+	Sections[SectionIndex] = NewSection;
+	if(NewSection)
+	{
+		NewSection->InitResources_RenderThread();
+	}
+}
+
+void FGeneratedMeshSceneProxy::SetSectionVisibility_RenderThread(int32 SectionIndex, bool bNewVisibility)
+{
+	check(IsInRenderingThread());
+
+	if(Sections.IsValidIndex(SectionIndex) && Sections[SectionIndex])
+	{
+		Sections[SectionIndex]->bSectionVisible = bNewVisibility;
+	}
+}
+
+void FGeneratedMeshSceneProxy::InitMeshBatch(FMeshBatch& Mesh, const FGeneratedMeshProxySection& Section, const FMaterialRenderProxy* MaterialProxy, bool bWireframe) const
+{
+	FMeshBatchElement& BatchElement = Mesh.Elements[0];
+	BatchElement.IndexBuffer = &Section.IndexBuffer;
+	BatchElement.FirstIndex = 0;
+	BatchElement.NumPrimitives = Section.IndexBuffer.Indices.Num() / 3;
+	BatchElement.MinVertexIndex = 0;
+	BatchElement.MaxVertexIndex = Section.VertexBuffer.NumVertices() - 1;
+	Mesh.bWireframe = bWireframe;
+	Mesh.VertexFactory = &Section.VertexFactory;
+	Mesh.MaterialRenderProxy = MaterialProxy;
+	Mesh.ReverseCulling = IsLocalToWorldDeterminantNegative();
+	Mesh.Type = PT_TriangleList;
+	Mesh.DepthPriorityGroup = SDPG_World;
+	Mesh.LODIndex = 0;
+}
+
+void FGeneratedMeshSceneProxy::DrawStaticElements(FStaticPrimitiveDrawInterface* PDI)
+{
+	// dynamic buffers go through GetDynamicMeshElements, they are expected to change
+	if(bDynamicBuffers)
+		return;
+
+	// built once, the renderer caches the draw commands
+	for(const FGeneratedMeshProxySection* Section : Sections)
+	{
+		if(!Section || !Section->bSectionVisible)
+			continue;
+
+		FMeshBatch Mesh;
+		InitMeshBatch(Mesh, *Section, Section->Material->GetRenderProxy(), false);
+		Mesh.Elements[0].PrimitiveUniformBuffer = GetUniformBuffer();
+		Mesh.CastShadow = true;
+		PDI->DrawMesh(Mesh, FLT_MAX);
+	}
+}
+
+void FGeneratedMeshSceneProxy::GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const
+{
+	QUICK_SCOPE_CYCLE_COUNTER( STAT_GeneratedMeshSceneProxy_GetDynamicMeshElements );
+
+	const bool bWireframe = AllowDebugViewmodes() && ViewFamily.EngineShowFlags.Wireframe;
+
+	// wireframe proxy lives as long as the frame
+	FColoredMaterialRenderProxy* WireframeMaterialInstance = nullptr;
+	if(bWireframe)
+	{
+		WireframeMaterialInstance = new FColoredMaterialRenderProxy(
+			GEngine->WireframeMaterial ? GEngine->WireframeMaterial->GetRenderProxy() : nullptr,
+			FLinearColor(0, 0.5f, 1.f)
+			);
+		Collector.RegisterOneFrameMaterialProxy(WireframeMaterialInstance);
+	}
+
+	for(int32 ViewIndex = 0; ViewIndex < Views.Num(); ViewIndex++)
+	{
+		if(!(VisibilityMap & (1 << ViewIndex)))
+			continue;
+
+		for(const FGeneratedMeshProxySection* Section : Sections)
+		{
+			if(!Section || !Section->bSectionVisible)
+				continue;
+
+			FMaterialRenderProxy* MaterialProxy = bWireframe ? WireframeMaterialInstance : Section->Material->GetRenderProxy();
+
+			// every section is in component space, the primitive uniform buffer has their transform
+			FMeshBatch& Mesh = Collector.AllocateMesh();
+			InitMeshBatch(Mesh, *Section, MaterialProxy, bWireframe);
+			Mesh.Elements[0].PrimitiveUniformBuffer = GetUniformBuffer();
+			Mesh.bCanApplyViewModeOverrides = false;
+			Collector.AddMesh(ViewIndex, Mesh);
+		}
+	}
+}
+
+FPrimitiveViewRelevance FGeneratedMeshSceneProxy::GetViewRelevance(const FSceneView* View) const
+{
+	// static meshes use cached draw commands, unless the view needs per frame batches
+	const bool bStatic = !bDynamicBuffers && !IsRichView(*View->Family) && !View->Family->EngineShowFlags.Wireframe;
+
+	FPrimitiveViewRelevance Result;
+	Result.bDrawRelevance = IsShown(View);
+	Result.bShadowRelevance = IsShadowCast(View);
+	Result.bStaticRelevance = bStatic;
+	Result.bDynamicRelevance = !bStatic;
+	Result.bRenderInMainPass = ShouldRenderInMainPass();
+	MaterialRelevance.SetPrimitiveViewRelevance(Result);
+	return Result;
+}
@@ -0,0 +1,157 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "NAVIS_CustomMeshPCH.h"
+#include "GeneratedMeshVertexBuffer.h"
+
+class UGeneratedMeshComponent;
+struct FGeneratedMeshSection;
+enum class EGeneratedMeshVertexFormat : uint8;
+
+/**
+ *	FGeneratedMeshSectionRenderData
+ *	What an async build computes besides the section itself, handed over to the proxy
+ */
+struct FGeneratedMeshSectionRenderData
+{
+	/** Render vertices, moved into the vertex buffer */
+	TArray<FDynamicMeshVertex> Vertices;
+
+	/** Render vertices of the compact format, @see bCompact */
+	TArray<FGeneratedMeshCompactVertex> CompactVertices;
+
+	/** Which of the vertex arrays is filled */
+	bool bCompact = false;
+
+	/** Bounds of the section, in component space */
+	FBox LocalBox = FBox(ForceInit);
+
+	int32 NumVertices() const { return bCompact ? CompactVertices.Num() : Vertices.Num(); }
+};
+
+/**
+ *	FGeneratedMeshProxySection
+ *	Render resources of one section of a generated mesh
+ */
+class FGeneratedMeshProxySection
+{
+public:
+
+	UMaterialInterface* Material;
+	FGeneratedMeshVertexBuffer VertexBuffer;
+	FGeneratedMeshIndexBuffer IndexBuffer;
+	FGeneratedMeshVertexFactory VertexFactory;
+	bool bSectionVisible;
+
+	/**
+	 *	@param Format		layout of the vertices
+	 *	@param RenderData	prebuilt vertices taken from it when they match the section and the format, may be nullptr
+	 */
+	FGeneratedMeshProxySection(ERHIFeatureLevel::Type InFeatureLevel, const FGeneratedMeshSection& Section, UMaterialInterface* InMaterial, bool bDynamic, EGeneratedMeshVertexFormat Format, FGeneratedMeshSectionRenderData* RenderData = nullptr);
+
+	/** IsCompact()	vertices use @see FGeneratedMeshCompactVertex */
+	bool IsCompact() const { return VertexBuffer.bCompact; }
+
+	/** SetRenderData()	move built vertices into the vertex buffer, the buffer itself is not touched */
+	void SetRenderData(FGeneratedMeshSectionRenderData&& RenderData);
+
+	/** InitResources()	enqueue the initialization of the buffers, from the game thread */
+	void InitResources();
+
+	/** InitResources_RenderThread()	initialize the buffers right away, for sections replaced on the render thread */
+	void InitResources_RenderThread();
+
+	/** ReleaseResources()	render thread only */
+	void ReleaseResources();
+};
+
+/**
+ *	FGeneratedMeshSceneProxy
+ *	Draws the indexed geometry of a UGeneratedMeshComponent, one batch per section.
+ *	With a dynamic vertex buffer, vertices can be rewritten in place as long as the triangles do not change,
+ *	and sections can be replaced one by one.
+ *	Otherwise the mesh is drawn once in DrawStaticElements, and the renderer caches its draw commands
+ */
+class FGeneratedMeshSceneProxy : public FPrimitiveSceneProxy
+{
+private:
+
+	/** Sections, at their index in the component. nullptr for empty ones */
+	TArray<FGeneratedMeshProxySection*> Sections;
+	FMaterialRelevance MaterialRelevance;
+
+	/** Whether the buffers accept in place updates */
+	bool bDynamicBuffers;
+
+public:
+
+	FGeneratedMeshSceneProxy(UGeneratedMeshComponent* Component);
+
+	virtual ~FGeneratedMeshSceneProxy();
+
+	//~ Begin FPrimitiveSceneProxy Interface.
+	virtual void DrawStaticElements(FStaticPrimitiveDrawInterface* PDI) override;
+	virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const override;
+	virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override;
+	//~ End FPrimitiveSceneProxy Interface.
+
+	virtual bool CanBeOccluded() const override
+	{
+		return !MaterialRelevance.bDisableDepthTest;
+	}
+
+	virtual uint32 GetMemoryFootprint( void ) const { return( sizeof( *this ) + GetAllocatedSize() ); }
+
+	uint32 GetAllocatedSize( void ) const { return( FPrimitiveSceneProxy::GetAllocatedSize() + Sections.GetAllocatedSize() ); }
+
+	virtual SIZE_T GetTypeHash() const override { return StaticTypeHash(); }
+
+	/** StaticTypeHash()	lets the component check that its scene proxy is one of ours */
+	static SIZE_T StaticTypeHash() { return 336103622995LL /*NAVIS in ASCII */; }
+
+	/** IsDynamic()		whether the buffers accept @see UpdateVertices_RenderThread() and @see SetSection_RenderThread() */
+	bool IsDynamic() const { return bDynamicBuffers; }
+
+	/**
+	 *	HasMaterialRelevance()	whether the view relevance of the proxy already covers a material, so a section drawn with it can be sent over
+	 *	@note					safe from the game thread, the relevance is fixed when the proxy is created
+	 */
+	bool HasMaterialRelevance(const FMaterialRelevance& Relevance) const
+	{
+		FMaterialRelevance Combined = MaterialRelevance;
+		Combined |= Relevance;
+		return FMemory::Memcmp(&Combined, &MaterialRelevance, sizeof(FMaterialRelevance)) == 0;
+	}
+
+	/**
+	 *	BuildRenderData()	Render vertices of indexed geometry, tangents follow the normals
+	 *	@param Data			positions and normals to convert
+	 *	@param Format		layout of the vertices
+	 *	@param OutData		vertices resized to match Data, with the bounds
+	 *	@param bParallel	split the work in chunks over worker threads
+	 */
+	static void BuildRenderData(const FGeneratedMeshSection& Data, EGeneratedMeshVertexFormat Format, FGeneratedMeshSectionRenderData& OutData, bool bParallel = false);
+
+	/**
+	 *	UpdateVertices_RenderThread()	Rewrite the dynamic vertex buffer of a section, without recreating it
+	 *	@param SectionIndex				section to update
+	 *	@param NewData					same count and format as the current vertices, moved into the proxy
+	 */
+	void UpdateVertices_RenderThread(int32 SectionIndex, FGeneratedMeshSectionRenderData&& NewData);
+
+	/**
+	 *	SetSection_RenderThread()	Replace the resources of a section, the other ones are untouched
+	 *	@param SectionIndex			section to replace
+	 *	@param NewSection			created on the game thread, owned by the proxy from now on. nullptr to clear the section
+	 */
+	void SetSection_RenderThread(int32 SectionIndex, FGeneratedMeshProxySection* NewSection);
+
+	/** SetSectionVisibility_RenderThread()	show or hide a section */
+	void SetSectionVisibility_RenderThread(int32 SectionIndex, bool bNewVisibility);
+
+private:
+
+	/** InitMeshBatch()	fill what static and dynamic batches have in common, the uniform buffer is left to the caller */
+	void InitMeshBatch(FMeshBatch& Mesh, const FGeneratedMeshProxySection& Section, const FMaterialRenderProxy* MaterialProxy, bool bWireframe) const;
+};
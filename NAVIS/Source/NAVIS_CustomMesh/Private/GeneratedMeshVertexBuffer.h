@@ -3,41 +3,91 @@
 
 #include "NAVIS_CustomMeshPCH.h"
 #include "DynamicMeshBuilder.h"
+#include "Math/Float16.h"
+
+/**
+ *	Vertex of the compact format, @see EGeneratedMeshVertexFormat::Compact
+ *	20 bytes : half position in component space, packed tangents and half UV, no color.
+ *	The vertex fetch expands the halfs, so the mesh keeps the transform of its primitive and its cached draw commands
+ */
+struct FGeneratedMeshCompactVertex
+{
+	/** Position in component space, W is always one */
+	FFloat16 Position[4];
+	FPackedNormal TangentX;
+	FPackedNormal TangentZ;
+	FVector2DHalf TextureCoordinate;
+};
 
 class FGeneratedMeshVertexBuffer : public FVertexBuffer
 {
 public:
 	TArray<FDynamicMeshVertex> Vertices;
 
+	/** used instead of Vertices when bCompact is set */
+	TArray<FGeneratedMeshCompactVertex> CompactVertices;
+
+	/** created for frequent CPU writes, @see CopyVertices() */
+	bool bDynamic = false;
+
+	/** vertices use the compact format */
+	bool bCompact = false;
+
+	int32 NumVertices() const { return bCompact ? CompactVertices.Num() : Vertices.Num(); }
+
+	uint32 GetStride() const { return bCompact ? sizeof(FGeneratedMeshCompactVertex) : sizeof(FDynamicMeshVertex); }
+
 	virtual void InitRHI()
 	{
 		FRHIResourceCreateInfo CreateInfo;
-		VertexBufferRHI = RHICreateVertexBuffer(Vertices.Num() * sizeof(FDynamicMeshVertex), BUF_Static, CreateInfo);
+		VertexBufferRHI = RHICreateVertexBuffer(NumVertices() * GetStride(), bDynamic ? BUF_Dynamic : BUF_Static, CreateInfo);
 
-		// Copy the vertex data into the vertex buffer.
-		void* VertexBufferData = RHILockVertexBuffer(VertexBufferRHI, 0, Vertices.Num() * sizeof(FDynamicMeshVertex), RLM_WriteOnly);
-		FMemory::Memcpy(VertexBufferData, Vertices.GetData(), Vertices.Num() * sizeof(FDynamicMeshVertex));
-		RHIUnlockVertexBuffer(VertexBufferRHI);
+		CopyVertices();
+	}
+
+	/** Copy the vertex data into the vertex buffer, render thread only. */
+	void CopyVertices()
+	{
+		const uint32 Size = NumVertices() * GetStride();
+		const void* Source = bCompact ? static_cast<const void*>(CompactVertices.GetData()) : static_cast<const void*>(Vertices.GetData());
 
+		void* VertexBufferData = RHILockVertexBuffer(VertexBufferRHI, 0, Size, RLM_WriteOnly);
+		FMemory::Memcpy(VertexBufferData, Source, Size);
+		RHIUnlockVertexBuffer(VertexBufferRHI);
 	}
 
 };
 
-/** Index Buffer */
+/** Index Buffer, 16 bits when the vertices allow it */
 class FGeneratedMeshIndexBuffer : public FIndexBuffer
 {
 public:
-	TArray<int32> Indices;
+	TArray<uint32> Indices;
+
+	/** written as uint16 on the GPU, @see FGeneratedMeshData::Use16BitIndices() */
+	bool bUse16BitIndices = false;
 
 	virtual void InitRHI()
 	{
+		const uint32 Stride = bUse16BitIndices ? sizeof(uint16) : sizeof(uint32);
 
 		FRHIResourceCreateInfo CreateInfo;
-		IndexBufferRHI = RHICreateIndexBuffer(sizeof(int32), Indices.Num() * sizeof(int32), BUF_Static, CreateInfo);
+		IndexBufferRHI = RHICreateIndexBuffer(Stride, Indices.Num() * Stride, BUF_Static, CreateInfo);
 
 		// Write the indices to the index buffer.
-		void* Buffer = RHILockIndexBuffer(IndexBufferRHI, 0, Indices.Num() * sizeof(int32), RLM_WriteOnly);
-		FMemory::Memcpy(Buffer, Indices.GetData(), Indices.Num() * sizeof(int32));
+		void* Buffer = RHILockIndexBuffer(IndexBufferRHI, 0, Indices.Num() * Stride, RLM_WriteOnly);
+		if(bUse16BitIndices)
+		{
+			uint16* Dest = static_cast<uint16*>(Buffer);
+			for(int32 Idx = 0; Idx < Indices.Num(); Idx++)
+			{
+				Dest[Idx] = static_cast<uint16>(Indices[Idx]);
+			}
+		}
+		else
+		{
+			FMemory::Memcpy(Buffer, Indices.GetData(), Indices.Num() * sizeof(uint32));
+		}
 		RHIUnlockIndexBuffer(IndexBufferRHI);
 	}
 };
@@ -66,19 +116,40 @@ public:
 		// Fixed for 4.22
 		FGeneratedMeshVertexFactory* This = this; // remove const
 		ENQUEUE_RENDER_COMMAND(InitGeneratedMeshVertexFactory)(
-			[This, &VertexBuffer](FRHICommandListImmediate& RHICmdList)
+			[This, VertexBuffer](FRHICommandListImmediate& RHICmdList)
 		{
-			FDataType NewData;
-			// Initialize the vertex factory's stream components.
-			NewData.PositionComponent = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FDynamicMeshVertex, Position, VET_Float3);
+			This->Init_RenderThread(VertexBuffer);
+		});
+	}
+
+	/** Initialization, for factories created on the render thread */
+	void Init_RenderThread(const FGeneratedMeshVertexBuffer* VertexBuffer)
+	{
+		check(IsInRenderingThread());
+
+		FDataType NewData;
+		if(VertexBuffer->bCompact)
+		{
+			// no color stream : the factory binds a null one
+			NewData.PositionComponent = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FGeneratedMeshCompactVertex, Position, VET_Half4);
 			NewData.TextureCoordinates.Add(
-				FVertexStreamComponent(VertexBuffer, STRUCT_OFFSET(FDynamicMeshVertex, TextureCoordinate), sizeof(FDynamicMeshVertex), VET_Float2)
+				FVertexStreamComponent(VertexBuffer, STRUCT_OFFSET(FGeneratedMeshCompactVertex, TextureCoordinate), sizeof(FGeneratedMeshCompactVertex), VET_Half2)
 			);
-			NewData.TangentBasisComponents[0] = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FDynamicMeshVertex, TangentX, VET_PackedNormal);
-			NewData.TangentBasisComponents[1] = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FDynamicMeshVertex, TangentZ, VET_PackedNormal);
-			NewData.ColorComponent = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FDynamicMeshVertex, Color, VET_Color);
-			This->SetData(NewData);
-		});
+			NewData.TangentBasisComponents[0] = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FGeneratedMeshCompactVertex, TangentX, VET_PackedNormal);
+			NewData.TangentBasisComponents[1] = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FGeneratedMeshCompactVertex, TangentZ, VET_PackedNormal);
+			SetData(NewData);
+			return;
+		}
+
+		// Initialize the vertex factory's stream components.
+		NewData.PositionComponent = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FDynamicMeshVertex, Position, VET_Float3);
+		NewData.TextureCoordinates.Add(
+			FVertexStreamComponent(VertexBuffer, STRUCT_OFFSET(FDynamicMeshVertex, TextureCoordinate), sizeof(FDynamicMeshVertex), VET_Float2)
+		);
+		NewData.TangentBasisComponents[0] = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FDynamicMeshVertex, TangentX, VET_PackedNormal);
+		NewData.TangentBasisComponents[1] = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FDynamicMeshVertex, TangentZ, VET_PackedNormal);
+		NewData.ColorComponent = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FDynamicMeshVertex, Color, VET_Color);
+		SetData(NewData);
 	}
 };
 
@@ -0,0 +1,57 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "UObject/Object.h"
+#include "Interfaces/Interface_CollisionDataProvider.h"
+#include "GeneratedMeshCollisionData.generated.h"
+
+class UBodySetup;
+class UWorld;
+
+/**
+ *	NAVIS_CUSTOMMESH - minimalAPI
+ *	UGeneratedMeshCollisionData
+ *	Collision geometry of one or several generated meshes, outer of the body setup that cooks it.
+ *	Identical geometries share one of these, and so one cooked tri-mesh
+ *	@see FGeneratedMeshCollisionCache
+ */
+UCLASS(minimalAPI, transient)
+class UGeneratedMeshCollisionData : public UObject, public IInterface_CollisionDataProvider
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Vertices, copied from the sections so they can change while this cooks */
+	TArray<FVector> Vertices;
+
+	/** Triangles, in the same winding as the sections */
+	TArray<FTriIndices> Indices;
+
+	/** Section of each triangle */
+	TArray<uint16> MaterialIndices;
+
+	/** Convex hulls to split the geometry into for simple collision, 0 keeps the tri-mesh only */
+	int32 MaxConvexHulls = 0;
+
+	/** Voxels along the longest side of the geometry, for the convex decomposition */
+	int32 ConvexResolution = 32;
+
+	/** BodySetup	cooks and holds the tri-mesh, shared by every component using this geometry */
+	UPROPERTY()
+	UBodySetup* BodySetup;
+
+	/** World of the components using this geometry. The body setup looks for a game world through its outer to cook at runtime */
+	TWeakObjectPtr<UWorld> World;
+
+	// Begin UObject Interface
+	virtual UWorld* GetWorld() const override;
+	// End UObject Interface
+
+	// Begin Interface_CollisionDataProvider Interface
+	virtual bool GetPhysicsTriMeshData(struct FTriMeshCollisionData* CollisionData, bool InUseAllTriData) override;
+	virtual bool ContainsPhysicsTriMeshData(bool InUseAllTriData) const override { return Indices.Num() > 0; }
+	virtual bool WantsNegXTriMesh() override { return false; }
+	// End Interface_CollisionDataProvider Interface
+};
@@ -62,6 +62,75 @@ public:
 
 };
 
+/**
+ *	Indexed geometry of a generated mesh, vertices are shared between triangles
+ *	@note	three times less vertices than one triangle list for a closed mesh, and normals are smooth
+ */
+struct FGeneratedMeshData
+{
+	/** Vertices positions, in component space */
+	TArray<FVector> Positions;
+
+	/** Vertices normals, one per position */
+	TArray<FVector> Normals;
+
+	/** Three indices per triangle, with the same winding as @see FGeneratedTriangle */
+	TArray<uint32> Indices;
+
+	int32 NumTriangles() const { return Indices.Num() / 3; }
+
+	bool IsEmpty() const { return Indices.Num() < 3; }
+
+	/** Use16BitIndices()	whether every index fits in 16 bits, halving the index buffer */
+	bool Use16BitIndices() const { return Positions.Num() <= MAX_uint16 + 1; }
+
+	/** ComputeNormals()	area weighted average of the normals of the faces around each vertex */
+	NAVIS_CUSTOMMESH_API void ComputeNormals();
+
+	/** ComputeNormalsParallel()	same as @see ComputeNormals(), split over worker threads for large meshes */
+	NAVIS_CUSTOMMESH_API void ComputeNormalsParallel();
+
+	/** ComputeBounds()	bounds of the positions, min and max are reduced in vector registers */
+	NAVIS_CUSTOMMESH_API FBox ComputeBounds() const;
+
+	/** ComputeBoundsParallel()	same as @see ComputeBounds(), split over worker threads for large meshes */
+	NAVIS_CUSTOMMESH_API FBox ComputeBoundsParallel() const;
+};
+
+/**
+ *	Part of a generated mesh with its own material slot, GPU buffers and collision flag
+ *	@note	the material slot is the index of the section
+ */
+struct FGeneratedMeshSection : public FGeneratedMeshData
+{
+	/** Whether this section is drawn */
+	bool bSectionVisible = true;
+
+	/** Whether this section is part of the collision, @see UGeneratedMeshComponent::GetPhysicsTriMeshData() */
+	bool bEnableCollision = true;
+
+	/** Bounds of the positions, computed when they are set so the component bounds never scan them */
+	FBox LocalBox = FBox(ForceInit);
+};
+
+/** Layout of the vertices sent to the GPU */
+UENUM(BlueprintType)
+enum class EGeneratedMeshVertexFormat : uint8
+{
+	Full		UMETA(DisplayName = "Full"),		/** float positions, tangents and color, 88 bytes per vertex	*/
+	Compact		UMETA(DisplayName = "Compact")		/** half positions, packed tangents, no color, 20 bytes per vertex	*/
+};
+
+/** Render data of a section built off the game thread, @see UGeneratedMeshComponent::CreateMeshSectionAsync() */
+typedef TSharedPtr<struct FGeneratedMeshSectionRenderData, ESPMode::ThreadSafe> FGeneratedMeshSectionRenderDataPtr;
+
+/**
+ *	Called on the game thread once an async build is in place
+ *	@param SectionIndex		section that was built
+ *	@param bSuccess			false if the indices did not match the vertices, the section is then untouched
+ */
+DECLARE_DELEGATE_TwoParams(FOnGeneratedMeshBuilt, int32 /*SectionIndex*/, bool /*bSuccess*/);
+
 /**
  *	Component that allows you to specify custom triangle mesh geometry
  *	We only expose overrides to other modules
@@ -75,13 +144,118 @@ public:
 
 	UGeneratedMeshComponent(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 
-	/** Set the geometry to use on this triangle mesh */
+	/** Set the geometry to use on this triangle mesh, identical vertices get welded. Replaces the first section */
 	bool SetGeneratedMeshTriangles(const TArray<FGeneratedTriangle>& Triangles);
 
-	/** Description of collision */
+	/**
+	 *	SetGeneratedMeshData()	Set indexed geometry to use on the first section of this mesh
+	 *	@param Vertices			positions, in component space
+	 *	@param Indices			three per triangle, each one within Vertices
+	 *	@param Normals			one per vertex, or empty to compute smooth normals
+	 *	@return					false if the indices do not match the vertices
+	 */
+	NAVIS_CUSTOMMESH_API bool SetGeneratedMeshData(const TArray<FVector>& Vertices, const TArray<uint32>& Indices, const TArray<FVector>& Normals = TArray<FVector>());
+
+	/**
+	 *	UpdateGeneratedMeshVertices()	Move the vertices, keeping the triangles. Written in place in the GPU buffer
+	 *	@param Positions				one per current vertex
+	 *	@param Normals					one per current vertex, or empty to compute smooth normals
+	 *	@param bUpdateCollision			also recook collision, which is costly
+	 *	@return							false if the vertex count changed, use @see SetGeneratedMeshData() then
+	 *	@note							the first update of a static mesh switches it to @see bUseDynamicVertexBuffer
+	 */
+	NAVIS_CUSTOMMESH_API bool UpdateGeneratedMeshVertices(const TArray<FVector>& Positions, const TArray<FVector>& Normals = TArray<FVector>(), bool bUpdateCollision = false);
+
+	/**
+	 *	CreateMeshSection()		Create or replace a section, other sections keep their buffers
+	 *	@param SectionIndex		index of the section, also its material slot
+	 *	@param Vertices			positions, in component space
+	 *	@param Indices			three per triangle, each one within Vertices
+	 *	@param Normals			one per vertex, or empty to compute smooth normals
+	 *	@param bCreateCollision	whether this section is part of the collision
+	 *	@return					false if the indices do not match the vertices
+	 */
+	NAVIS_CUSTOMMESH_API bool CreateMeshSection(int32 SectionIndex, const TArray<FVector>& Vertices, const TArray<uint32>& Indices, const TArray<FVector>& Normals = TArray<FVector>(), bool bCreateCollision = true);
+
+	/**
+	 *	UpdateMeshSectionVertices()		Move the vertices of a section, keeping its triangles
+	 *	@see							UpdateGeneratedMeshVertices()
+	 */
+	NAVIS_CUSTOMMESH_API bool UpdateMeshSectionVertices(int32 SectionIndex, const TArray<FVector>& Positions, const TArray<FVector>& Normals = TArray<FVector>(), bool bUpdateCollision = false);
+
+	/** ClearMeshSection()		Remove the geometry of a section, its material slot stays */
+	NAVIS_CUSTOMMESH_API void ClearMeshSection(int32 SectionIndex);
+
+	/** ClearAllMeshSections()	Remove every section */
+	NAVIS_CUSTOMMESH_API void ClearAllMeshSections();
+
+	/** SetMeshSectionVisible()	Show or hide a section without touching its buffers */
+	NAVIS_CUSTOMMESH_API void SetMeshSectionVisible(int32 SectionIndex, bool bNewVisibility);
+
+	/** CreateMeshSection()	move overload, the arrays are not copied */
+	NAVIS_CUSTOMMESH_API bool CreateMeshSection(int32 SectionIndex, TArray<FVector>&& Vertices, TArray<uint32>&& Indices, TArray<FVector>&& Normals = TArray<FVector>(), bool bCreateCollision = true);
+
+	/**
+	 *	CreateMeshSectionAsync()	Build a section on worker threads : normals, tangents, bounds and render vertices
+	 *	@param SectionIndex			index of the section, also its material slot
+	 *	@param Vertices				positions, moved in
+	 *	@param Indices				three per triangle, moved in
+	 *	@param Normals				one per vertex, moved in, or empty to compute smooth normals
+	 *	@param bCreateCollision		whether this section is part of the collision
+	 *	@param OnBuilt				called on the game thread once the section is in place
+	 *	@note						a newer build or a synchronous change of the same section discards this one, OnBuilt is then not called
+	 */
+	NAVIS_CUSTOMMESH_API void CreateMeshSectionAsync(int32 SectionIndex, TArray<FVector>&& Vertices, TArray<uint32>&& Indices, TArray<FVector>&& Normals = TArray<FVector>(), bool bCreateCollision = true, FOnGeneratedMeshBuilt OnBuilt = FOnGeneratedMeshBuilt());
+
+	/** SetGeneratedMeshTrianglesAsync()	weld and build the first section on worker threads, @see CreateMeshSectionAsync() */
+	NAVIS_CUSTOMMESH_API void SetGeneratedMeshTrianglesAsync(TArray<FGeneratedTriangle>&& Triangles, FOnGeneratedMeshBuilt OnBuilt = FOnGeneratedMeshBuilt());
+
+	/** IsMeshSectionVisible()	@return whether a section exists and is drawn */
+	NAVIS_CUSTOMMESH_API bool IsMeshSectionVisible(int32 SectionIndex) const;
+
+	/** GetNumSections()		@return number of sections, including cleared ones */
+	int32 GetNumSections() const { return MeshSections.Num(); }
+
+	/**
+	 *	Vertex buffers are made for frequent updates, @see UpdateGeneratedMeshVertices()
+	 *	@note	sections are then also replaced one by one on the render thread instead of recreating the proxy
+	 *	@note	the first update or replaced section of a registered mesh sets it for good, the mesh then leaves the cached draw commands.
+	 *			Clear it and mark the render state dirty once the mesh settles to get them back
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Rendering")
+	bool bUseDynamicVertexBuffer;
+
+	/**
+	 *	Layout of the vertices, compact ones cut the memory and bandwidth of large meshes by four
+	 *	@note	compact positions are halfs in component space : precise to about 1/2048 of their distance to the component origin,
+	 *			and clamped to 65504 units. Meant for props and hulls, a 20 meters mesh is off by half a centimeter at most
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Rendering")
+	EGeneratedMeshVertexFormat VertexFormat;
+
+	/** Description of collision, shared with the components that have the same collision geometry */
 	UPROPERTY(BlueprintReadOnly, Category = "Collision")
 		class UBodySetup* ModelBodySetup;
 
+	/** Cook collision on a worker thread, the previous collision stays until it is done */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Collision")
+	bool bUseAsyncCooking;
+
+	/**
+	 *	Split the collision geometry into convex hulls, used for simple collision, simulation and buoyancy
+	 *	@note	decomposed and cooked on worker threads, shared between identical geometries like the tri-mesh
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Collision")
+	bool bUseConvexDecomposition;
+
+	/** Most convex hulls the geometry is split into */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Collision", meta = (EditCondition = "bUseConvexDecomposition", ClampMin = "1", ClampMax = "64"))
+	int32 MaxConvexHulls;
+
+	/** Voxels along the longest side of the geometry, finer finds better cuts but takes longer */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Collision", meta = (EditCondition = "bUseConvexDecomposition", ClampMin = "8", ClampMax = "128"))
+	int32 ConvexDecompositionResolution;
+
 	// Begin UMeshComponent interface.
 	NAVIS_CUSTOMMESH_API virtual int32 GetNumMaterials() const override;
 	// End UMeshComponent interface.
@@ -99,18 +273,68 @@ public :
 	NAVIS_CUSTOMMESH_API virtual class UBodySetup* GetBodySetup() override;
 	// End UPrimitiveComponent interface.
 
+	/** UpdateBodySetup()	make sure @see ModelBodySetup matches the collision sections */
 	void UpdateBodySetup();
+
+	/**
+	 *	UpdateCollision()	Hash the collision geometry and get its body setup, cooking it if no other component has
+	 *	@note				the cooked tri-mesh and convex hulls are shared through the hash, @see FGeneratedMeshCollisionCache
+	 */
 	void UpdateCollision();
-private:
 
+	/**
+	 *	FinishCollisionCook()	Called once an async cook is done
+	 *	@param Hash				geometry that was cooked, ignored if the collision changed since
+	 *	@param CookedBodySetup	nullptr if the cook failed
+	 */
+	void FinishCollisionCook(uint64 Hash, class UBodySetup* CookedBodySetup);
 
+	// Begin UObject interface.
+	NAVIS_CUSTOMMESH_API virtual void BeginDestroy() override;
+	// End UObject interface.
+protected:
 
 	// Begin USceneComponent interface.
 	NAVIS_CUSTOMMESH_API virtual FBoxSphereBounds CalcBounds(const FTransform & LocalToWorld) const override;
 	// Begin USceneComponent interface.
 
-	/** Array of the triangle we created */
-	TArray<FGeneratedTriangle> GeneratedMeshTris;
+private:
+
+	/**
+	 *	SendSectionToProxy()	Rebuild one section of the scene proxy on the render thread
+	 *	@return					false when the whole proxy has to be recreated instead : static buffers, or a material the proxy is not relevant for
+	 */
+	bool SendSectionToProxy(int32 SectionIndex, const FGeneratedMeshSectionRenderDataPtr& RenderData = nullptr);
+
+	/**
+	 *	CommitMeshSection()		Put a built section in place, then update collision, bounds and the proxy
+	 *	@param RenderData		vertices already built off the game thread, or nullptr
+	 */
+	void CommitMeshSection(int32 SectionIndex, FGeneratedMeshSection&& Section, const FGeneratedMeshSectionRenderDataPtr& RenderData);
+
+	/**
+	 *	LaunchSectionBuild()	Run Fill then the build of a section on worker threads, and commit the result on the game thread
+	 *	@param Fill				fills the geometry of the section, returns false if it is invalid
+	 */
+	void LaunchSectionBuild(int32 SectionIndex, bool bCreateCollision, TUniqueFunction<bool(FGeneratedMeshSection&)>&& Fill, FOnGeneratedMeshBuilt OnBuilt);
+
+	/** CancelSectionBuild()	discard any async build of a section still in flight */
+	void CancelSectionBuild(int32 SectionIndex) { SectionBuildSerials.FindOrAdd(SectionIndex)++; }
+
+	/** GetGeneratedProxy()	@return scene proxy if it is one of ours, nullptr otherwise */
+	class FGeneratedMeshSceneProxy* GetGeneratedProxy() const;
+
+	/** Sections of indexed geometry we created */
+	TArray<FGeneratedMeshSection> MeshSections;
+
+	/** Render data built by async builds, consumed by the next scene proxy */
+	TMap<int32, FGeneratedMeshSectionRenderDataPtr> PendingRenderData;
+
+	/** Serial of the latest build of each section, so older async builds get dropped */
+	TMap<int32, uint32> SectionBuildSerials;
+
+	/** Hash of the collision geometry in use, 0 for none */
+	uint64 CollisionHash;
 
 	friend class FGeneratedMeshSceneProxy;
 };
\ No newline at end of file
@@ -0,0 +1,21 @@
+// Copyright 1998-2018 Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class NAVIS_Island : ModuleRules
+{
+    public NAVIS_Island(ReadOnlyTargetRules Target) : base(Target)
+    {
+        PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+        PrivatePCHHeaderFile = "Private/NAVIS_IslandPCH.h";
+
+        PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine" });
+        PublicDependencyModuleNames.AddRange(new string[] { "NAVIS_CustomMesh" });
+
+        //The path for the header files
+        PublicIncludePaths.AddRange(new string[] { "NAVIS_Island/Public" });
+
+        //The path for the source files
+        PrivateIncludePaths.AddRange(new string[] { "NAVIS_Island/Private" });
+    }
+}
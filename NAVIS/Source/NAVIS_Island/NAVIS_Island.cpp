@@ -0,0 +1,20 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+#include "NAVIS_Island.h"
+
+DEFINE_LOG_CATEGORY(LogNAVIS_Island);
+
+#define LOCTEXT_NAMESPACE "NAVIS_Island"
+
+void FNAVIS_Island::StartupModule()
+{
+	UE_LOG(LogNAVIS_Island, Warning, TEXT("NAVIS_Island module has started"));
+}
+
+void FNAVIS_Island::ShutdownModule()
+{
+	UE_LOG(LogNAVIS_Island, Warning, TEXT("NAVIS_Island module has shut down"));
+}
+
+#undef LOCTEXT_NAMESPACE
+
+IMPLEMENT_MODULE(FNAVIS_Island, NAVIS_Island)
\ No newline at end of file
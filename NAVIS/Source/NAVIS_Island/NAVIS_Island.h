@@ -0,0 +1,18 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "ModuleManager.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogNAVIS_Island, All, All);
+
+class FNAVIS_Island : public IModuleInterface
+{
+public:
+
+	/* This will get called when the editor loads the module */
+	virtual void StartupModule() override;
+
+	/* This will get called when the editor unloads the module */
+	virtual void ShutdownModule() override;
+};
\ No newline at end of file
@@ -0,0 +1,271 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "NAVISIslandActor.h"
+#include "NAVIS_Island.h"
+#include "NAVISCustomMeshComponent.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/World.h"
+#include "Materials/MaterialInterface.h"
+
+/** most levels of detail of a chunk, @see ANAVISIslandActor::NumLODs */
+static const int32 IslandMaxLODs = 6;
+
+ANAVISIslandActor::ANAVISIslandActor() : Super(), Material(nullptr), ChunkCells(128), NumLODs(4), LODDistance(40000.f), CollisionLOD(1), GenerationSerial(0)
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	RootComp = CreateDefaultSubobject<USceneComponent>(TEXT("RootComp"));
+	RootComponent = RootComp;
+}
+
+void ANAVISIslandActor::BeginPlay()
+{
+	Super::BeginPlay();
+	Generate();
+}
+
+void ANAVISIslandActor::Generate()
+{
+	// every level of detail has to cut the chunk in whole cells
+	const int32 LODs = FMath::Clamp(NumLODs, 1, IslandMaxLODs);
+	const int32 LODStep = 1 << (LODs - 1);
+	const int32 Cells = FMath::Max(FMath::DivideAndRoundUp(ChunkCells, LODStep), 1) * LODStep;
+	const int32 IslandCells = FMath::CeilToInt(Settings.Size / FMath::Max(Settings.CellSize, 1.f));
+	const int32 NumChunks = FMath::Max(FMath::DivideAndRoundUp(IslandCells, Cells), 1);
+
+	const uint32 Serial = ++GenerationSerial;
+	TWeakObjectPtr<ANAVISIslandActor> WeakThis(this);
+	Async(EAsyncExecution::ThreadPool, [WeakThis, Serial, IslandSettings = Settings, NumChunks, Cells, LODs]()
+	{
+		const double StartTime = FPlatformTime::Seconds();
+
+		TSharedPtr<FNAVISIslandHeightfield, ESPMode::ThreadSafe> NewHeightfield = MakeShared<FNAVISIslandHeightfield, ESPMode::ThreadSafe>();
+		NewHeightfield->Generate(IslandSettings, NumChunks * Cells);
+
+		TArray<FNAVISIslandChunkMesh> Meshes;
+		Meshes.SetNum(NumChunks * NumChunks * LODs);
+		ParallelFor(Meshes.Num(), [&NewHeightfield, &Meshes, NumChunks, Cells, LODs](int32 Idx)
+		{
+			const int32 Chunk = Idx / LODs;
+			BuildChunkMesh(*NewHeightfield, Chunk % NumChunks, Chunk / NumChunks, Cells, Idx % LODs, Meshes[Idx]);
+		});
+
+		UE_LOG(LogNAVIS_Island, Log, TEXT("Island of %d x %d samples in %d chunks generated in %.1f ms"),
+			NewHeightfield->GetResolution(), NewHeightfield->GetResolution(), NumChunks * NumChunks, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Serial, NewHeightfield, Meshes = MoveTemp(Meshes), NumChunks, LODs]() mutable
+		{
+			ANAVISIslandActor * This = WeakThis.Get();
+			if(This && This->GenerationSerial == Serial)
+			{
+				This->OnGenerated(NewHeightfield, MoveTemp(Meshes), NumChunks, LODs);
+			}
+		});
+	});
+}
+
+void ANAVISIslandActor::OnGenerated(TSharedPtr<FNAVISIslandHeightfield, ESPMode::ThreadSafe> NewHeightfield, TArray<FNAVISIslandChunkMesh> &&Meshes, int32 NumChunks, int32 LODs)
+{
+	Heightfield = NewHeightfield;
+
+	// chunks are kept when their number does not change : the collision they get again has the same hash, it is not cooked again
+	UpdateChunks(NumChunks);
+
+	UWorld * World = GetWorld();
+	const TArray<FVector> * ViewLocations = World ? &World->ViewLocationsRenderedLastFrame : nullptr;
+	const int32 CollisionSection = FMath::Clamp(CollisionLOD, 0, LODs - 1);
+	for(int32 Chunk = 0; Chunk < Chunks.Num(); Chunk++)
+	{
+		UNAVISCustomMeshComponent * ChunkComp = Chunks[Chunk];
+		ChunkBounds[Chunk] = Meshes[Chunk * LODs].Bounds;
+
+		// levels of detail removed since the last generation
+		for(int32 Section = LODs; Section < ChunkComp->GetNumSections(); Section++)
+		{
+			ChunkComp->ClearMeshSection(Section);
+		}
+
+		for(int32 LOD = 0; LOD < LODs; LOD++)
+		{
+			FNAVISIslandChunkMesh &Mesh = Meshes[Chunk * LODs + LOD];
+			ChunkComp->SetMaterial(LOD, Material);
+			ChunkComp->CreateMeshSectionAsync(LOD, MoveTemp(Mesh.Vertices), MoveTemp(Mesh.Indices), MoveTemp(Mesh.Normals), LOD == CollisionSection,
+				FOnGeneratedMeshBuilt::CreateUObject(this, &ANAVISIslandActor::OnChunkSectionBuilt, Chunk));
+		}
+
+		ChunkLODs[Chunk] = ViewLocations && ViewLocations->Num() > 0 ? FMath::Min(SelectChunkLOD(Chunk, *ViewLocations), LODs - 1) : 0;
+	}
+}
+
+void ANAVISIslandActor::UpdateChunks(int32 NumChunks)
+{
+	const int32 Num = NumChunks * NumChunks;
+	if(Chunks.Num() != Num)
+	{
+		for(UNAVISCustomMeshComponent * ChunkComp : Chunks)
+		{
+			if(ChunkComp)
+				ChunkComp->DestroyComponent();
+		}
+
+		Chunks.Reset(Num);
+		for(int32 Chunk = 0; Chunk < Num; Chunk++)
+		{
+			UNAVISCustomMeshComponent * ChunkComp = NewObject<UNAVISCustomMeshComponent>(this, NAME_None, RF_Transient);
+			// sections are then shown and hidden with a render command instead of a new scene proxy
+			ChunkComp->bUseDynamicVertexBuffer = true;
+			ChunkComp->bUseAsyncCooking = true;
+			ChunkComp->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+			ChunkComp->SetupAttachment(RootComp);
+			ChunkComp->RegisterComponent();
+			Chunks.Add(ChunkComp);
+		}
+	}
+
+	ChunkBounds.Init(FBox(ForceInit), Num);
+	ChunkLODs.Init(0, Num);
+}
+
+void ANAVISIslandActor::OnChunkSectionBuilt(int32 SectionIndex, bool bSuccess, int32 Chunk)
+{
+	if(Chunks.IsValidIndex(Chunk))
+		ApplyChunkLOD(Chunk);
+}
+
+void ANAVISIslandActor::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// views of the last frame are good enough, a chunk is far bigger than what a view moves in a frame
+	const UWorld * World = GetWorld();
+	if(!World || World->ViewLocationsRenderedLastFrame.Num() == 0 || ChunkLODs.Num() != Chunks.Num())
+		return;
+
+	for(int32 Chunk = 0; Chunk < Chunks.Num(); Chunk++)
+	{
+		const int32 LOD = SelectChunkLOD(Chunk, World->ViewLocationsRenderedLastFrame);
+		if(LOD != ChunkLODs[Chunk])
+		{
+			ChunkLODs[Chunk] = LOD;
+			ApplyChunkLOD(Chunk);
+		}
+	}
+}
+
+int32 ANAVISIslandActor::SelectChunkLOD(int32 Chunk, const TArray<FVector> &ViewLocations) const
+{
+	const UNAVISCustomMeshComponent * ChunkComp = Chunks[Chunk];
+	if(!ChunkComp || !ChunkBounds[Chunk].IsValid)
+		return 0;
+
+	const FBox Bounds = ChunkBounds[Chunk].TransformBy(GetActorTransform());
+	float ClosestSquared = MAX_flt;
+	for(const FVector &ViewLocation : ViewLocations)
+	{
+		ClosestSquared = FMath::Min(ClosestSquared, Bounds.ComputeSquaredDistanceToPoint(ViewLocation));
+	}
+
+	const int32 MaxLOD = FMath::Max(ChunkComp->GetNumSections() - 1, 0);
+	int32 LOD = 0;
+	float Distance = LODDistance;
+	while(LOD < MaxLOD && ClosestSquared > FMath::Square(Distance))
+	{
+		LOD++;
+		Distance *= 2.f;
+	}
+	return LOD;
+}
+
+void ANAVISIslandActor::ApplyChunkLOD(int32 Chunk)
+{
+	UNAVISCustomMeshComponent * ChunkComp = Chunks[Chunk];
+	if(!ChunkComp)
+		return;
+
+	for(int32 Section = 0; Section < ChunkComp->GetNumSections(); Section++)
+	{
+		ChunkComp->SetMeshSectionVisible(Section, Section == ChunkLODs[Chunk]);
+	}
+}
+
+float ANAVISIslandActor::GetHeightAt(const FVector &location) const
+{
+	const FTransform &Transform = GetActorTransform();
+	if(!Heightfield.IsValid())
+		return Transform.GetLocation().Z;
+
+	const FVector Local = Transform.InverseTransformPosition(location);
+	return Transform.TransformPosition(FVector(Local.X, Local.Y, Heightfield->GetHeightAt(FVector2D(Local.X, Local.Y)))).Z;
+}
+
+void ANAVISIslandActor::BuildChunkMesh(const FNAVISIslandHeightfield &Heightfield, int32 ChunkX, int32 ChunkY, int32 ChunkCells, int32 LOD, FNAVISIslandChunkMesh &outMesh)
+{
+	const int32 Step = 1 << LOD;
+	const int32 N = ChunkCells / Step;
+	const int32 Stride = N + 1;
+	const int32 NumPerimeter = 4 * N;
+	const float CellSize = Heightfield.GetCellSize();
+	const float Origin = Heightfield.GetOrigin();
+	// deep enough for the height difference with a coarser neighbour over one of our cells
+	const float SkirtDepth = 2.f * Step * CellSize;
+
+	outMesh.Vertices.Reset(Stride * Stride + NumPerimeter);
+	outMesh.Normals.Reset(Stride * Stride + NumPerimeter);
+	outMesh.Indices.Reset(6 * N * N + 6 * NumPerimeter);
+
+	// normals come from the full resolution heights, so every level of detail is lit the same
+	for(int32 Y = 0; Y <= N; Y++)
+	{
+		const int32 SampleY = ChunkY * ChunkCells + Y * Step;
+		for(int32 X = 0; X <= N; X++)
+		{
+			const int32 SampleX = ChunkX * ChunkCells + X * Step;
+			outMesh.Vertices.Add(FVector(Origin + SampleX * CellSize, Origin + SampleY * CellSize, Heightfield.GetSample(SampleX, SampleY)));
+			outMesh.Normals.Add(Heightfield.GetSampleNormal(SampleX, SampleY));
+		}
+	}
+
+	for(int32 Y = 0; Y < N; Y++)
+	{
+		for(int32 X = 0; X < N; X++)
+		{
+			const uint32 V00 = Y * Stride + X;
+			const uint32 V10 = V00 + 1;
+			const uint32 V01 = V00 + Stride;
+			const uint32 V11 = V01 + 1;
+			outMesh.Indices.Append({ V00, V01, V11, V00, V11, V10 });
+		}
+	}
+
+	// skirts hang under the edge, walked counterclockwise seen from above so they face outward
+	TArray<uint32> Perimeter;
+	Perimeter.Reserve(NumPerimeter);
+	for(int32 Idx = 0; Idx < N; Idx++) Perimeter.Add(Idx);
+	for(int32 Idx = 0; Idx < N; Idx++) Perimeter.Add(Idx * Stride + N);
+	for(int32 Idx = 0; Idx < N; Idx++) Perimeter.Add(N * Stride + N - Idx);
+	for(int32 Idx = 0; Idx < N; Idx++) Perimeter.Add((N - Idx) * Stride);
+
+	const uint32 FirstSkirt = outMesh.Vertices.Num();
+	for(uint32 Top : Perimeter)
+	{
+		const FVector Bottom = outMesh.Vertices[Top] - FVector(0.f, 0.f, SkirtDepth);
+		const FVector Normal = outMesh.Normals[Top];
+		outMesh.Vertices.Add(Bottom);
+		outMesh.Normals.Add(Normal);
+	}
+
+	for(int32 Idx = 0; Idx < NumPerimeter; Idx++)
+	{
+		const int32 Next = (Idx + 1) % NumPerimeter;
+		const uint32 T0 = Perimeter[Idx];
+		const uint32 T1 = Perimeter[Next];
+		const uint32 B0 = FirstSkirt + Idx;
+		const uint32 B1 = FirstSkirt + Next;
+		outMesh.Indices.Append({ T0, T1, B1, T0, B1, B0 });
+	}
+
+	outMesh.Bounds = FBox(outMesh.Vertices);
+}
@@ -0,0 +1,228 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "NAVISIslandHeightfield.h"
+#include "Async/ParallelFor.h"
+
+/** most octaves of noise, @see FNAVISIslandSettings::Octaves */
+static const int32 IslandMaxOctaves = 12;
+
+namespace
+{
+	/** Floor4()	floor of four values, truncation rounds the negative ones up */
+	FORCEINLINE VectorRegister Floor4(const VectorRegister &Value)
+	{
+		const VectorRegister Truncated = VectorIntToFloat(VectorFloatToInt(Value));
+		return VectorSubtract(Truncated, VectorBitwiseAnd(VectorCompareGT(Truncated, Value), VectorOne()));
+	}
+
+	/** Hash4()		scrambled bits of four lattice points, different for every seed */
+	FORCEINLINE VectorRegisterInt Hash4(const VectorRegisterInt &X, const VectorRegisterInt &Y, const VectorRegisterInt &Seed)
+	{
+		const VectorRegisterInt PrimeX = MakeVectorRegisterInt(73856093, 73856093, 73856093, 73856093);
+		const VectorRegisterInt PrimeY = MakeVectorRegisterInt(19349663, 19349663, 19349663, 19349663);
+		const VectorRegisterInt Mix = MakeVectorRegisterInt(1274126177, 1274126177, 1274126177, 1274126177);
+
+		VectorRegisterInt Hash = VectorIntXor(VectorIntXor(VectorIntMultiply(X, PrimeX), VectorIntMultiply(Y, PrimeY)), Seed);
+		Hash = VectorIntMultiply(VectorIntXor(Hash, VectorShiftRightImmLogical(Hash, 13)), Mix);
+		return VectorIntXor(Hash, VectorShiftRightImmLogical(Hash, 16));
+	}
+
+	/** Gradient4()	dot product of the offsets to four lattice points with their gradients, picked from 10 bits of the hash each */
+	FORCEINLINE VectorRegister Gradient4(const VectorRegisterInt &Hash, const VectorRegister &OffsetX, const VectorRegister &OffsetY)
+	{
+		const VectorRegisterInt Bits = MakeVectorRegisterInt(1023, 1023, 1023, 1023);
+		const VectorRegister Scale = VectorSetFloat1(2.f / 1023.f);
+		const VectorRegister MinusOne = VectorSetFloat1(-1.f);
+
+		const VectorRegister GradientX = VectorMultiplyAdd(VectorIntToFloat(VectorIntAnd(Hash, Bits)), Scale, MinusOne);
+		const VectorRegister GradientY = VectorMultiplyAdd(VectorIntToFloat(VectorIntAnd(VectorShiftRightImmLogical(Hash, 10), Bits)), Scale, MinusOne);
+		return VectorMultiplyAdd(GradientX, OffsetX, VectorMultiply(GradientY, OffsetY));
+	}
+
+	/** Fade4()		6t^5 - 15t^4 + 10t^3, flat at both ends so the noise has no creases at the lattice */
+	FORCEINLINE VectorRegister Fade4(const VectorRegister &T)
+	{
+		const VectorRegister Inner = VectorMultiplyAdd(T, VectorMultiplyAdd(T, VectorSetFloat1(6.f), VectorSetFloat1(-15.f)), VectorSetFloat1(10.f));
+		return VectorMultiply(VectorMultiply(VectorMultiply(T, T), T), Inner);
+	}
+
+	/** Noise4()	gradient noise at four locations, in lattice units, roughly within [-1, 1] */
+	VectorRegister Noise4(const VectorRegister &X, const VectorRegister &Y, const VectorRegisterInt &Seed)
+	{
+		const VectorRegisterInt IntOne = MakeVectorRegisterInt(1, 1, 1, 1);
+
+		const VectorRegister FloorX = Floor4(X);
+		const VectorRegister FloorY = Floor4(Y);
+		const VectorRegisterInt X0 = VectorFloatToInt(FloorX);
+		const VectorRegisterInt Y0 = VectorFloatToInt(FloorY);
+		const VectorRegisterInt X1 = VectorIntAdd(X0, IntOne);
+		const VectorRegisterInt Y1 = VectorIntAdd(Y0, IntOne);
+
+		const VectorRegister OffsetX0 = VectorSubtract(X, FloorX);
+		const VectorRegister OffsetY0 = VectorSubtract(Y, FloorY);
+		const VectorRegister OffsetX1 = VectorSubtract(OffsetX0, VectorOne());
+		const VectorRegister OffsetY1 = VectorSubtract(OffsetY0, VectorOne());
+
+		const VectorRegister N00 = Gradient4(Hash4(X0, Y0, Seed), OffsetX0, OffsetY0);
+		const VectorRegister N10 = Gradient4(Hash4(X1, Y0, Seed), OffsetX1, OffsetY0);
+		const VectorRegister N01 = Gradient4(Hash4(X0, Y1, Seed), OffsetX0, OffsetY1);
+		const VectorRegister N11 = Gradient4(Hash4(X1, Y1, Seed), OffsetX1, OffsetY1);
+
+		const VectorRegister U = Fade4(OffsetX0);
+		const VectorRegister V = Fade4(OffsetY0);
+		const VectorRegister Bottom = VectorMultiplyAdd(U, VectorSubtract(N10, N00), N00);
+		const VectorRegister Top    = VectorMultiplyAdd(U, VectorSubtract(N11, N01), N01);
+		return VectorMultiplyAdd(V, VectorSubtract(Top, Bottom), Bottom);
+	}
+}
+
+void FNAVISIslandHeightfield::Generate(const FNAVISIslandSettings &Settings, int32 Cells)
+{
+	Resolution = FMath::Max(Cells, 1) + 1;
+	CellSize = FMath::Max(Settings.CellSize, 1.f);
+	Heights.SetNumUninitialized(Resolution * Resolution);
+
+	const int32 Tiles = FMath::DivideAndRoundUp(Resolution, TileSize);
+	ParallelFor(Tiles * Tiles, [this, &Settings, Tiles](int32 Tile)
+	{
+		GenerateTile(Settings, Tile % Tiles, Tile / Tiles);
+	});
+
+	Erode(Settings);
+}
+
+void FNAVISIslandHeightfield::GenerateTile(const FNAVISIslandSettings &Settings, int32 TileX, int32 TileY)
+{
+	const int32 BeginX = TileX * TileSize;
+	const int32 BeginY = TileY * TileSize;
+	const int32 EndX = FMath::Min(BeginX + TileSize, Resolution);
+	const int32 EndY = FMath::Min(BeginY + TileSize, Resolution);
+	const float Origin = GetOrigin();
+	const float HalfSize = 0.5f * FMath::Max(Settings.Size, 1.f);
+
+	// each octave has its own seed and offset, so their lattices never line up
+	const int32 Octaves = FMath::Clamp(Settings.Octaves, 1, IslandMaxOctaves);
+	VectorRegister Frequencies[IslandMaxOctaves];
+	VectorRegister Amplitudes[IslandMaxOctaves];
+	VectorRegister Offsets[IslandMaxOctaves];
+	VectorRegisterInt Seeds[IslandMaxOctaves];
+	float Frequency = 1.f / FMath::Max(Settings.Wavelength, 1.f);
+	float Amplitude = 1.f;
+	float AmplitudeSum = 0.f;
+	for(int32 Octave = 0; Octave < Octaves; Octave++)
+	{
+		const int32 OctaveSeed = int32(HashCombine(GetTypeHash(Settings.Seed), GetTypeHash(Octave)));
+		Frequencies[Octave] = VectorSetFloat1(Frequency);
+		Amplitudes[Octave] = VectorSetFloat1(Amplitude);
+		Offsets[Octave] = VectorSetFloat1(1000.f + 31.7f * Octave);
+		Seeds[Octave] = MakeVectorRegisterInt(OctaveSeed, OctaveSeed, OctaveSeed, OctaveSeed);
+		AmplitudeSum += Amplitude;
+		Frequency *= 2.f;
+		Amplitude *= Settings.Persistence;
+	}
+	const float Normalize = 1.f / AmplitudeSum;
+
+	const VectorRegister Lanes = MakeVectorRegister(0.f, 1.f, 2.f, 3.f);
+	const VectorRegister VCellSize = VectorSetFloat1(CellSize);
+	float Noise[4];
+	for(int32 Y = BeginY; Y < EndY; Y++)
+	{
+		const float LocationY = Origin + Y * CellSize;
+		const VectorRegister VY = VectorSetFloat1(LocationY);
+		for(int32 X = BeginX; X < EndX; X += 4)
+		{
+			const VectorRegister VX = VectorMultiplyAdd(Lanes, VCellSize, VectorSetFloat1(Origin + X * CellSize));
+			VectorRegister Sum = VectorZero();
+			for(int32 Octave = 0; Octave < Octaves; Octave++)
+			{
+				const VectorRegister OctaveX = VectorMultiplyAdd(VX, Frequencies[Octave], Offsets[Octave]);
+				const VectorRegister OctaveY = VectorMultiplyAdd(VY, Frequencies[Octave], Offsets[Octave]);
+				Sum = VectorMultiplyAdd(Noise4(OctaveX, OctaveY, Seeds[Octave]), Amplitudes[Octave], Sum);
+			}
+			VectorStore(Sum, Noise);
+
+			// the last samples of a row may not fill the register
+			const int32 NumLanes = FMath::Min(4, EndX - X);
+			for(int32 Lane = 0; Lane < NumLanes; Lane++)
+			{
+				const float LocationX = Origin + (X + Lane) * CellSize;
+				const float Value = FMath::Clamp(Noise[Lane] * Normalize, -1.f, 1.f);
+
+				// the noise pushes the coast in and out, the land rises inland and the seabed goes down around it
+				const float Radius = FMath::Sqrt(LocationX * LocationX + LocationY * LocationY) / HalfSize;
+				const float Inland = FMath::SmoothStep(0.f, 1.f, 1.f - Radius - Settings.CoastRoughness * Value);
+				const float LandHeight = Settings.MaxHeight * FMath::Square(0.5f + 0.5f * Value);
+				Heights[Y * Resolution + X + Lane] = FMath::Lerp(-Settings.SeaDepth, LandHeight, Inland);
+			}
+		}
+	}
+}
+
+void FNAVISIslandHeightfield::Erode(const FNAVISIslandSettings &Settings)
+{
+	if(Settings.ErosionIterations <= 0 || Heights.Num() == 0)
+		return;
+
+	// what goes from one sample to a neighbour is taken from the first and given to the second : nothing is lost
+	const float Talus = FMath::Tan(FMath::DegreesToRadians(Settings.TalusAngle)) * CellSize;
+	const float Rate = 0.25f * Settings.ErosionRate;
+
+	TArray<float> Next;
+	Next.SetNumUninitialized(Heights.Num());
+	for(int32 Iteration = 0; Iteration < Settings.ErosionIterations; Iteration++)
+	{
+		const float * Source = Heights.GetData();
+		float * Destination = Next.GetData();
+		ParallelFor(Resolution, [this, Source, Destination, Talus, Rate](int32 Y)
+		{
+			for(int32 X = 0; X < Resolution; X++)
+			{
+				const int32 Idx = Y * Resolution + X;
+				const float Height = Source[Idx];
+				const int32 Neighbours[4] =
+				{
+					X > 0 ? Idx - 1 : INDEX_NONE,
+					X < Resolution - 1 ? Idx + 1 : INDEX_NONE,
+					Y > 0 ? Idx - Resolution : INDEX_NONE,
+					Y < Resolution - 1 ? Idx + Resolution : INDEX_NONE
+				};
+
+				float Delta = 0.f;
+				for(int32 Neighbour : Neighbours)
+				{
+					if(Neighbour == INDEX_NONE)
+						continue;
+					const float Difference = Source[Neighbour] - Height;
+					if(Difference > Talus)
+						Delta += Rate * (Difference - Talus);
+					else if(Difference < -Talus)
+						Delta -= Rate * (-Difference - Talus);
+				}
+				Destination[Idx] = Height + Delta;
+			}
+		});
+		Swap(Heights, Next);
+	}
+}
+
+FVector FNAVISIslandHeightfield::GetSampleNormal(int32 X, int32 Y) const
+{
+	const float SlopeX = (GetSample(X + 1, Y) - GetSample(X - 1, Y)) / (2.f * CellSize);
+	const float SlopeY = (GetSample(X, Y + 1) - GetSample(X, Y - 1)) / (2.f * CellSize);
+	return FVector(-SlopeX, -SlopeY, 1.f).GetSafeNormal(SMALL_NUMBER, FVector::UpVector);
+}
+
+float FNAVISIslandHeightfield::GetHeightAt(const FVector2D &Location) const
+{
+	if(IsEmpty())
+		return 0.f;
+
+	const FVector2D Grid = (Location - FVector2D(GetOrigin(), GetOrigin())) / CellSize;
+	const int32 X0 = FMath::FloorToInt(Grid.X);
+	const int32 Y0 = FMath::FloorToInt(Grid.Y);
+	const float AlphaX = FMath::Clamp(Grid.X - X0, 0.f, 1.f);
+	const float AlphaY = FMath::Clamp(Grid.Y - Y0, 0.f, 1.f);
+	const float Bottom = FMath::Lerp(GetSample(X0, Y0), GetSample(X0 + 1, Y0), AlphaX);
+	const float Top    = FMath::Lerp(GetSample(X0, Y0 + 1), GetSample(X0 + 1, Y0 + 1), AlphaX);
+	return FMath::Lerp(Bottom, Top, AlphaY);
+}
@@ -0,0 +1,6 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "NAVIS_Island.h"
+#include "CoreMinimal.h"
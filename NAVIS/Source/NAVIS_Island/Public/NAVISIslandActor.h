@@ -0,0 +1,135 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "NAVISIslandHeightfield.h"
+#include "NAVISIslandActor.generated.h"
+
+class UNAVISCustomMeshComponent;
+class UMaterialInterface;
+
+/**
+ *  NAVIS_ISLAND
+ *	FNAVISIslandChunkMesh
+ *  Geometry of one level of detail of a chunk, built on worker threads and moved into its section
+ */
+struct FNAVISIslandChunkMesh
+{
+	TArray<FVector> Vertices;
+	TArray<uint32> Indices;
+	TArray<FVector> Normals;
+	FBox Bounds = FBox(ForceInit);
+};
+
+/**
+ *  NAVIS_ISLAND
+ *	ANAVISIslandActor
+ *  Procedural island : a heightfield generated on worker threads, cut into square chunks of generated mesh.
+ *  Every chunk is its own component with one section per level of detail, the closest view picks the visible one.
+ *  Only @see CollisionLOD has collision, so the island is world static geometry for traces and the bathymetry bake.
+ */
+UCLASS(Category = "NAVIS", hideCategories = ("Input", "Replication"))
+class NAVIS_ISLAND_API ANAVISIslandActor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+
+	/** ANAVISIslandActor   constructor  */
+	ANAVISIslandActor();
+
+	//~ Begin AActor Interface.
+	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual bool ShouldTickIfViewportsOnly() const override { return true; }
+	//~ End AActor Interface.
+
+	/**
+	 * 	Generate()		Generate the island from @see Settings, on worker threads
+	 *	@note			the chunks are replaced once done, a newer call discards an older one still running.
+	 *					Chunks are transient : the island is generated again at BeginPlay
+	 */
+	UFUNCTION(CallInEditor, BlueprintCallable, Category = "Island")
+	void Generate();
+
+	/**
+	 * 	GetHeightAt()	Height of the ground under a location, from the heightfield rather than the collision
+	 *	@param location	world location, only X and Y matter
+	 *	@return			world Z of the ground, the actor Z until generated
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Island")
+	float GetHeightAt(const FVector &location) const;
+
+protected:
+
+	/** Settings		shape of the island */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Island")
+	FNAVISIslandSettings Settings;
+
+	/** Material		given to every level of detail of every chunk */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Island")
+	UMaterialInterface * Material;
+
+	/**
+	 *  ChunkCells		cells along the side of a chunk at the finest level of detail
+	 *  @note			rounded to a multiple of what the coarsest level of detail needs
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Chunks", meta = (ClampMin = "16", ClampMax = "256"))
+	int32 ChunkCells;
+
+	/** NumLODs			levels of detail of a chunk, each one has half the cells of the previous one along a side */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Chunks", meta = (ClampMin = "1", ClampMax = "6"))
+	int32 NumLODs;
+
+	/** LODDistance		distance of a chunk to the closest view under which it shows the finest level of detail, doubled for every next one */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Chunks", meta = (ClampMin = "0.0"))
+	float LODDistance;
+
+	/**
+	 *  CollisionLOD	level of detail cooked as collision, the others are only drawn
+	 *  @note			the cooked collision is shared through its geometry hash : generating the same island again does not cook it again
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Chunks", meta = (ClampMin = "0", ClampMax = "5"))
+	int32 CollisionLOD;
+
+private:
+
+	/** BuildChunkMesh()	geometry of a level of detail of a chunk, with skirts hiding the cracks between levels of detail */
+	static void BuildChunkMesh(const FNAVISIslandHeightfield &Heightfield, int32 ChunkX, int32 ChunkY, int32 ChunkCells, int32 LOD, FNAVISIslandChunkMesh &outMesh);
+
+	/** UpdateChunks()		make sure there is one component per chunk, creating or destroying them */
+	void UpdateChunks(int32 NumChunks);
+
+	/** OnGenerated()		game thread part of @see Generate(), sends the meshes to the chunks */
+	void OnGenerated(TSharedPtr<FNAVISIslandHeightfield, ESPMode::ThreadSafe> NewHeightfield, TArray<FNAVISIslandChunkMesh> &&Meshes, int32 NumChunks, int32 LODs);
+
+	/** OnChunkSectionBuilt()	a level of detail is in place, only the current one of its chunk stays visible */
+	void OnChunkSectionBuilt(int32 SectionIndex, bool bSuccess, int32 Chunk);
+
+	/** SelectChunkLOD()	level of detail a chunk should show, from its distance to the closest view */
+	int32 SelectChunkLOD(int32 Chunk, const TArray<FVector> &ViewLocations) const;
+
+	/** ApplyChunkLOD()		show the current level of detail of a chunk and hide the others */
+	void ApplyChunkLOD(int32 Chunk);
+
+	/** RootComp		root of the chunks  */
+	UPROPERTY(VisibleDefaultsOnly, meta=(AllowPrivateAccess = "true"))
+	USceneComponent * RootComp;
+
+	/** Chunks			one component per chunk, row after row */
+	UPROPERTY(transient)
+	TArray<UNAVISCustomMeshComponent*> Chunks;
+
+	/** ChunkBounds		of every chunk, in actor space */
+	TArray<FBox> ChunkBounds;
+
+	/** ChunkLODs		level of detail shown by every chunk */
+	TArray<int32> ChunkLODs;
+
+	/** Heightfield		of the last generated island, shared with the worker threads */
+	TSharedPtr<FNAVISIslandHeightfield, ESPMode::ThreadSafe> Heightfield;
+
+	/** GenerationSerial	of the latest @see Generate(), older generations are dropped once done */
+	uint32 GenerationSerial;
+};
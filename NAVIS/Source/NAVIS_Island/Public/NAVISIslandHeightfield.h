@@ -0,0 +1,134 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NAVISIslandHeightfield.generated.h"
+
+/**
+ *  NAVIS_ISLAND
+ *  FNAVISIslandSettings
+ *	Shape of a generated island, the same settings always give the same island
+ */
+USTRUCT(BlueprintType)
+struct NAVIS_ISLAND_API FNAVISIslandSettings
+{
+	GENERATED_BODY()
+
+	/** Seed		picks the island */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Island")
+	int32 Seed;
+
+	/** Size		side of the square the island and its seabed fill, in unreal units */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Island", meta = (ClampMin = "1000.0"))
+	float Size;
+
+	/** CellSize	distance between two heights, the finest level of detail of the mesh */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Island", meta = (ClampMin = "10.0"))
+	float CellSize;
+
+	/** MaxHeight	height of the highest peaks above the sea level */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Island", meta = (ClampMin = "0.0"))
+	float MaxHeight;
+
+	/** SeaDepth	depth of the seabed around the island */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Island", meta = (ClampMin = "0.0"))
+	float SeaDepth;
+
+	/** Octaves		layers of noise, each one twice as fine and @see Persistence times as high as the last */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", meta = (ClampMin = "1", ClampMax = "12"))
+	int32 Octaves;
+
+	/** Wavelength	size of the features of the first octave */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", meta = (ClampMin = "100.0"))
+	float Wavelength;
+
+	/** Persistence	height of an octave relative to the previous one */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float Persistence;
+
+	/** CoastRoughness	how far the noise pushes the coast in and out, relative to the radius of the island */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float CoastRoughness;
+
+	/** ErosionIterations	steps of thermal erosion, each one moves material down the slopes steeper than @see TalusAngle */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Erosion", meta = (ClampMin = "0", ClampMax = "256"))
+	int32 ErosionIterations;
+
+	/** TalusAngle	steepest slope that stays, in degrees */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Erosion", meta = (ClampMin = "1.0", ClampMax = "89.0"))
+	float TalusAngle;
+
+	/** ErosionRate	fraction of the excess moved at each step */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Erosion", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float ErosionRate;
+
+	FNAVISIslandSettings()
+		: Seed(0), Size(400000.f), CellSize(400.f), MaxHeight(40000.f), SeaDepth(5000.f)
+		, Octaves(7), Wavelength(150000.f), Persistence(0.5f), CoastRoughness(0.3f)
+		, ErosionIterations(24), TalusAngle(40.f), ErosionRate(0.5f)
+	{}
+};
+
+/**
+ *  NAVIS_ISLAND
+ *  FNAVISIslandHeightfield
+ *	Heights of an island on a square grid centered on the origin, Z = 0 being the sea level.
+ *	The noise is evaluated four samples at a time in vector registers, tiles of the grid on worker threads,
+ *	then eroded a row at a time on worker threads.
+ */
+class NAVIS_ISLAND_API FNAVISIslandHeightfield
+{
+public:
+
+	/** Samples along the side of a generated tile */
+	static const int32 TileSize = 64;
+
+	/**
+	 * 	Generate()		Fill the heights from the settings, on worker threads
+	 *	@param Cells	cells along a side, at least the size of the island, a multiple of what the chunks need
+	 *	@note			blocks until done, call it from a worker thread to keep the game thread going
+	 */
+	void Generate(const FNAVISIslandSettings &Settings, int32 Cells);
+
+	/** GetResolution()	samples along a side, cells + 1 */
+	int32 GetResolution() const { return Resolution; }
+
+	/** GetCellSize()	distance between two samples */
+	float GetCellSize() const { return CellSize; }
+
+	/** GetOrigin()		location of the sample (0, 0), relative to the center */
+	float GetOrigin() const { return -0.5f * (Resolution - 1) * CellSize; }
+
+	/** GetSample()		height of a sample, clamped to the grid */
+	float GetSample(int32 X, int32 Y) const
+	{
+		X = FMath::Clamp(X, 0, Resolution - 1);
+		Y = FMath::Clamp(Y, 0, Resolution - 1);
+		return Heights[Y * Resolution + X];
+	}
+
+	/** GetSampleNormal()	normal at a sample, from the slope to its neighbours. The same for every level of detail */
+	FVector GetSampleNormal(int32 X, int32 Y) const;
+
+	/**
+	 * 	GetHeightAt()	bilinear height at a location relative to the center
+	 *	@return			the height of the closest edge outside of the grid
+	 */
+	float GetHeightAt(const FVector2D &Location) const;
+
+	/** IsEmpty()		@return true until generated */
+	bool IsEmpty() const { return Heights.Num() == 0; }
+
+private:
+
+	/** GenerateTile()	noise, then the island shape, of a tile of samples */
+	void GenerateTile(const FNAVISIslandSettings &Settings, int32 TileX, int32 TileY);
+
+	/** Erode()			thermal erosion, every step reads one buffer and writes the other */
+	void Erode(const FNAVISIslandSettings &Settings);
+
+	int32 Resolution = 0;
+	float CellSize = 0.f;
+	TArray<float> Heights;
+};
@@ -18,6 +18,13 @@ public class NAVIS_Physics : ModuleRules
         PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine" });
         PublicDependencyModuleNames.AddRange(new string[] { "PhysX"/* ,"APEX" */ });
         PublicDependencyModuleNames.AddRange(new string[] { "NAVIS_Types"});
+        PrivateDependencyModuleNames.AddRange(new string[] { "NAVIS_Core", "TraceLog"});
+        PrivateDependencyModuleNames.AddRange(new string[] { "AssetRegistry"});
+        if (Target.bBuildEditor)
+        {
+            // hulls baked by UNAVISBakeHullsCommandlet
+            PrivateDependencyModuleNames.AddRange(new string[] { "DerivedDataCache"});
+        }
 
         //The path for the header files
         PublicIncludePaths.AddRange(new string[] { "NAVIS_Physics/Public" });
@@ -1,5 +1,7 @@
 // Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
 #include "NAVIS_Physics.h"
+#include "NAVISBuoyancyCapture.h"
+#include "NAVISHullCache.h"
 
 DEFINE_LOG_CATEGORY(LogNAVIS_Physics);
 
@@ -8,10 +10,16 @@ DEFINE_LOG_CATEGORY(LogNAVIS_Physics);
 void FNAVIS_Physics::StartupModule()
 {
 	UE_LOG(LogNAVIS_Physics, Warning, TEXT("NAVIS_Physics module has started"));
+	FNAVISHullCache::Get().Load();
 }
 
 void FNAVIS_Physics::ShutdownModule()
 {
+#if NAVIS_BUOYANCY_CAPTURE
+	// a capture left running still gets a complete file
+	FNAVISBuoyancyCapture::Get().Stop();
+#endif // NAVIS_BUOYANCY_CAPTURE
+	FNAVISHullCache::Get().Unload();
 	UE_LOG(LogNAVIS_Physics, Warning, TEXT("NAVIS_Physics module has shut down"));
 }
 
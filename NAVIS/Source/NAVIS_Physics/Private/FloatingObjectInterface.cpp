@@ -2,9 +2,11 @@
 
 #include "FloatingObjectInterface.h"
 #include "NAVISPhysicsStatics.h"
+#include "NAVISStats.h"
 
 void IFloatingObjectInterface::ApplyArchimedesForce(const FPlane &liquidPlane, float density,  FName boneName)
 {
+    SCOPE_CYCLE_COUNTER(STAT_NAVIS_ForceApplication);
 
     UPrimitiveComponent* FloatingObject = GetFloatingComponent();
 
@@ -1,20 +1,152 @@
 #include "LiquidActorComponent.h"
+#include "LiquidVolumeTree.h"
 #include "GameFramework/Actor.h"
+#include "Components/SceneComponent.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
 
-ULiquidActorComponent::ULiquidActorComponent(const FObjectInitializer& ObjectInitializer ) :Super(ObjectInitializer)
+/** Points resolved by one worker at a time */
+static const int32 LiquidQueryChunkSize = 256;
+
+void FLiquidQueryTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if(Target && !Target->IsPendingKill())
+	{
+		Target->PublishQueries();
+		// enabled again by the next launch
+		SetTickFunctionEnable(false);
+	}
+}
+
+FString FLiquidQueryTickFunction::DiagnosticMessage()
+{
+	return TEXT("FLiquidQueryTickFunction");
+}
+
+ULiquidActorComponent::ULiquidActorComponent(const FObjectInitializer& ObjectInitializer ) :Super(ObjectInitializer), Priority(0), Density(1.f), LiquidExtent(100.f, 100.f, 100.f), LiquidSurface(FVector::UpVector, 0.f, 1.f), QuerySurface(FVector::UpVector, 0.f, 1.f), NextBatchSerial(1)
+{
+	// only tick once there are queries, @see SubmitQuery()
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+
+	QueryPublishTick.bCanEverTick = true;
+	QueryPublishTick.bStartWithTickEnabled = false;
+	QueryPublishTick.TickGroup = TG_PostUpdateWork;
+
+	PendingQueries.Reset(NextBatchSerial++);
+}
+
+void ULiquidActorComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	// the owner is only placed once registered, not when this is constructed
+	if(GetOwner())
+	{
+		LiquidSurface = FLiquidSurface(GetOwner()->GetActorLocation(), GetOwner()->GetActorUpVector(), Density);
+
+		USceneComponent * Root = GetOwner()->GetRootComponent();
+		if(Root)
+		{
+			OwnerTransformHandle = Root->TransformUpdated.AddUObject(this, &ULiquidActorComponent::OnOwnerTransformUpdated);
+			OwnerRoot = Root;
+		}
+	}
+	UpdateLiquidBounds();
+}
+
+void ULiquidActorComponent::OnUnregister()
+{
+	// the workers read this component
+	if(InFlightTask.IsValid())
+	{
+		InFlightTask.Wait();
+		InFlightTask = TFuture<void>();
+	}
+
+	if(USceneComponent * Root = OwnerRoot.Get())
+	{
+		Root->TransformUpdated.Remove(OwnerTransformHandle);
+	}
+	OwnerTransformHandle.Reset();
+	OwnerRoot.Reset();
+
+	if(FLiquidVolumeTree * Tree = FLiquidVolumeTree::Find(GetWorld()))
+	{
+		Tree->Remove(this);
+	}
+	Super::OnUnregister();
+}
+
+void ULiquidActorComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	LaunchQueries();
+
+	// enabled again by the next submission
+	SetComponentTickEnabled(false);
+}
+
+void ULiquidActorComponent::RegisterComponentTickFunctions(bool bRegister)
+{
+	Super::RegisterComponentTickFunctions(bRegister);
+
+	if(bRegister)
+	{
+		if(SetupActorComponentTickFunction(&QueryPublishTick))
+		{
+			QueryPublishTick.Target = this;
+			QueryPublishTick.AddPrerequisite(this, PrimaryComponentTick);
+		}
+	}
+	else if(QueryPublishTick.IsTickFunctionRegistered())
+	{
+		QueryPublishTick.UnRegisterTickFunction();
+	}
+}
+
+void ULiquidActorComponent::SetLiquidExtent(const FVector &newExtent)
+{
+	LiquidExtent = newExtent.ComponentMax(FVector::ZeroVector);
+	UpdateLiquidBounds();
+}
+
+FBox ULiquidActorComponent::GetLiquidBounds() const
+{
+	if(!GetOwner())
+		return FBox(ForceInit);
+
+	// the surface goes through the owner location, the liquid is under it
+	const FBox LocalBounds(FVector(-LiquidExtent.X, -LiquidExtent.Y, -LiquidExtent.Z), FVector(LiquidExtent.X, LiquidExtent.Y, 0.f));
+	return LocalBounds.TransformBy(GetOwner()->GetActorTransform());
+}
+
+void ULiquidActorComponent::UpdateLiquidBounds()
+{
+	if(!IsRegistered())
+		return;
+
+	if(FLiquidVolumeTree * Tree = FLiquidVolumeTree::Get(GetWorld()))
+	{
+		Tree->Update(this, GetLiquidBounds(), Priority);
+	}
+}
+
+void ULiquidActorComponent::OnOwnerTransformUpdated(USceneComponent * updatedComponent, EUpdateTransformFlags updateTransformFlags, ETeleportType teleport)
 {
-    if(GetOwner())
-    {
-         LiquidSurface = FLiquidSurface(GetOwner()->GetActorLocation(),GetOwner()->GetActorUpVector(), 1.f);
-    }
-    else
-    {
-        LiquidSurface = FLiquidSurface(FVector::UpVector,0.f, 1.f);
-    }
+	if(GetOwner())
+	{
+		LiquidSurface = FLiquidSurface(GetOwner()->GetActorLocation(), GetOwner()->GetActorUpVector(), Density);
+	}
+	UpdateLiquidBounds();
+}
 
+FLiquidSurface ULiquidActorComponent::GetLiquidSurfaceAt(const FVector &location) const
+{
+	return FLiquidSurface(GetSurfaceLocationUnderPoint(location), GetSurfaceNormal(), Density);
 }
 
-  
 FVector ULiquidActorComponent::GetSurfaceNormal() const
 {
     return LiquidSurface;
@@ -24,9 +156,129 @@ FVector ULiquidActorComponent::GetLocalSurfaceNormal() const
 {
     return LiquidSurface;
 }
-    
+
 FVector ULiquidActorComponent::GetSurfaceLocationUnderPoint(FVector traceOrigin ) const
 {
-   return LiquidSurface;
+   return LiquidSurface.GetClosestPoint(traceOrigin);
+}
+
+void ULiquidActorComponent::GetSurfaceLocationsUnderPoints(TArrayView<const FVector> points, TArrayView<FVector> outLocations) const
+{
+	check(points.Num() == outLocations.Num());
+	for(int32 Idx = 0; Idx < points.Num(); Idx++)
+	{
+		outLocations[Idx] = GetSurfaceLocationUnderPoint(points[Idx]);
+	}
 }
 
+void ULiquidActorComponent::SnapshotQueries()
+{
+	QuerySurface = LiquidSurface;
+}
+
+void ULiquidActorComponent::ResolveQueries(TArrayView<const FVector> points, TArrayView<FVector> outLocations) const
+{
+	check(points.Num() == outLocations.Num());
+	for(int32 Idx = 0; Idx < points.Num(); Idx++)
+	{
+		outLocations[Idx] = QuerySurface.GetClosestPoint(points[Idx]);
+	}
+}
+
+FLiquidQueryHandle ULiquidActorComponent::SubmitQuery(const TArray<FVector> &points)
+{
+	check(IsInGameThread());
+
+	FLiquidQueryHandle Handle;
+	Handle.Batch = PendingQueries.Serial;
+	Handle.Index = PendingQueries.Offsets.Add(PendingQueries.Points.Num());
+	PendingQueries.Points.Append(points);
+
+	// launched by the next tick in TG_PostPhysics, this one or the next frame
+	if(!IsComponentTickEnabled())
+		SetComponentTickEnabled(true);
+	return Handle;
+}
+
+bool ULiquidActorComponent::GetQueryResults(const FLiquidQueryHandle &handle, TArray<FVector> &outLocations, bool bSynchronousFallback) const
+{
+	int32 Begin, Num;
+	if(handle.Batch == ReadyQueries.Serial && ReadyQueries.GetRange(handle.Index, Begin, Num))
+	{
+		outLocations.Reset(Num);
+		outLocations.Append(ReadyQueries.Locations.GetData() + Begin, Num);
+		return true;
+	}
+
+	if(!bSynchronousFallback)
+		return false;
+
+	// the workers only read the points of the batch in flight, they can be read here too
+	const FQueryBatch * Batch = handle.Batch == InFlightQueries.Serial ? &InFlightQueries : handle.Batch == PendingQueries.Serial ? &PendingQueries : nullptr;
+	if(!Batch || !Batch->GetRange(handle.Index, Begin, Num))
+		return false;
+
+	outLocations.SetNumUninitialized(Num);
+	GetSurfaceLocationsUnderPoints(MakeArrayView(Batch->Points.GetData() + Begin, Num), MakeArrayView(outLocations));
+	return true;
+}
+
+void ULiquidActorComponent::LaunchQueries()
+{
+	if(PendingQueries.Points.Num() == 0)
+		return;
+
+	// published in TG_PostUpdateWork of the last frame, unless that tick did not run
+	PublishQueries();
+
+	Swap(InFlightQueries, PendingQueries);
+	PendingQueries.Reset(NextBatchSerial++);
+
+	// the workers read the copies, the game thread goes on changing the rest
+	SnapshotQueries();
+
+	FQueryBatch * Batch = &InFlightQueries;
+	Batch->Locations.SetNumUninitialized(Batch->Points.Num(), false);
+	QueryPublishTick.SetTickFunctionEnable(true);
+	InFlightTask = Async(EAsyncExecution::TaskGraph, [this, Batch]()
+	{
+		const int32 NumChunks = FMath::DivideAndRoundUp(Batch->Points.Num(), LiquidQueryChunkSize);
+		ParallelFor(NumChunks, [this, Batch](int32 Chunk)
+		{
+			const int32 Begin = Chunk * LiquidQueryChunkSize;
+			const int32 Num = FMath::Min(LiquidQueryChunkSize, Batch->Points.Num() - Begin);
+			ResolveQueries(MakeArrayView(Batch->Points.GetData() + Begin, Num), MakeArrayView(Batch->Locations.GetData() + Begin, Num));
+		});
+	});
+}
+
+void ULiquidActorComponent::PublishQueries()
+{
+	if(!InFlightTask.IsValid())
+		return;
+
+	InFlightTask.Wait();
+	InFlightTask = TFuture<void>();
+
+	// the results of the last batch go, their buffers get filled again later
+	Swap(ReadyQueries, InFlightQueries);
+	InFlightQueries.Reset(0);
+}
+
+bool ULiquidActorComponent::FQueryBatch::GetRange(int32 Index, int32 &OutBegin, int32 &OutNum) const
+{
+	if(!Offsets.IsValidIndex(Index))
+		return false;
+
+	OutBegin = Offsets[Index];
+	OutNum = (Index + 1 < Offsets.Num() ? Offsets[Index + 1] : Points.Num()) - OutBegin;
+	return true;
+}
+
+void ULiquidActorComponent::FQueryBatch::Reset(uint32 NewSerial)
+{
+	Serial = NewSerial;
+	Points.Reset();
+	Locations.Reset();
+	Offsets.Reset();
+}
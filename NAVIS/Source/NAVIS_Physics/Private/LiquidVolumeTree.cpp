@@ -0,0 +1,241 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "LiquidVolumeTree.h"
+#include "LiquidActorComponent.h"
+#include "Engine/World.h"
+#include "Misc/ScopeLock.h"
+
+/** most volumes in a leaf */
+static const int32 LiquidTreeLeafSize = 4;
+
+namespace
+{
+	TMap<const UWorld*, TUniquePtr<FLiquidVolumeTree>> & GetWorldTrees()
+	{
+		static TMap<const UWorld*, TUniquePtr<FLiquidVolumeTree>> Trees;
+		return Trees;
+	}
+
+	FCriticalSection & GetWorldTreesLock()
+	{
+		static FCriticalSection TreesLock;
+		return TreesLock;
+	}
+
+	/** IsBetterLiquid()	order of the volumes where they overlap : highest priority, then smallest */
+	bool IsBetterLiquid(int32 Priority, const FBox &Bounds, int32 OtherPriority, const FBox &OtherBounds)
+	{
+		if(Priority != OtherPriority)
+			return Priority > OtherPriority;
+		return Bounds.GetVolume() < OtherBounds.GetVolume();
+	}
+}
+
+FLiquidVolumeTree * FLiquidVolumeTree::Get(const UWorld * World)
+{
+	if(!World)
+		return nullptr;
+
+	FScopeLock ScopeLock(&GetWorldTreesLock());
+	TUniquePtr<FLiquidVolumeTree> &Tree = GetWorldTrees().FindOrAdd(World);
+	if(!Tree.IsValid())
+	{
+		static bool bCleanupBound = false;
+		if(!bCleanupBound)
+		{
+			FWorldDelegates::OnWorldCleanup.AddStatic(&FLiquidVolumeTree::OnWorldCleanup);
+			bCleanupBound = true;
+		}
+		Tree = MakeUnique<FLiquidVolumeTree>();
+	}
+	return Tree.Get();
+}
+
+FLiquidVolumeTree * FLiquidVolumeTree::Find(const UWorld * World)
+{
+	if(!World)
+		return nullptr;
+
+	FScopeLock ScopeLock(&GetWorldTreesLock());
+	const TUniquePtr<FLiquidVolumeTree> * Tree = GetWorldTrees().Find(World);
+	return Tree ? Tree->Get() : nullptr;
+}
+
+void FLiquidVolumeTree::OnWorldCleanup(UWorld * World, bool bSessionEnded, bool bCleanupResources)
+{
+	if(!bCleanupResources)
+		return;
+
+	FScopeLock ScopeLock(&GetWorldTreesLock());
+	GetWorldTrees().Remove(World);
+}
+
+void FLiquidVolumeTree::Update(const ULiquidActorComponent * Liquid, const FBox &Bounds, int32 Priority)
+{
+	check(IsInGameThread());
+	if(!Liquid)
+		return;
+
+	if(!Bounds.IsValid)
+	{
+		Remove(Liquid);
+		return;
+	}
+
+	FRWScopeLock ScopeLock(Lock, SLT_Write);
+	if(const int32 * Index = VolumeIndices.Find(Liquid))
+	{
+		FVolume &Volume = Volumes[*Index];
+		if(Volume.Bounds == Bounds && Volume.Priority == Priority)
+			return;
+		Volume.Bounds = Bounds;
+		Volume.Priority = Priority;
+	}
+	else
+	{
+		VolumeIndices.Add(Liquid, Volumes.Add({ const_cast<ULiquidActorComponent*>(Liquid), Bounds, Priority }));
+	}
+	bDirty = true;
+}
+
+void FLiquidVolumeTree::Remove(const ULiquidActorComponent * Liquid)
+{
+	check(IsInGameThread());
+
+	FRWScopeLock ScopeLock(Lock, SLT_Write);
+	int32 Index;
+	if(!VolumeIndices.RemoveAndCopyValue(Liquid, Index))
+		return;
+
+	// the last volume takes the place of the removed one
+	Volumes.RemoveAtSwap(Index, 1, false);
+	if(Volumes.IsValidIndex(Index))
+	{
+		VolumeIndices.Add(Volumes[Index].Liquid, Index);
+	}
+	bDirty = true;
+}
+
+int32 FLiquidVolumeTree::Num() const
+{
+	FRWScopeLock ScopeLock(Lock, SLT_ReadOnly);
+	return Volumes.Num();
+}
+
+ULiquidActorComponent * FLiquidVolumeTree::FindAtLocation(const FVector &Location) const
+{
+	// copied, the volumes may change once the query is over
+	FVolume Best = { nullptr, FBox(ForceInit), 0 };
+	Query([&Location](const FBox &Bounds) { return Bounds.IsInsideOrOn(Location); }, [&Best](const FVolume &Volume)
+	{
+		if(!Best.Liquid || IsBetterLiquid(Volume.Priority, Volume.Bounds, Best.Priority, Best.Bounds))
+			Best = Volume;
+	});
+	return Best.Liquid;
+}
+
+void FLiquidVolumeTree::FindInBox(const FBox &Box, TArray<ULiquidActorComponent*> &outLiquids) const
+{
+	outLiquids.Reset();
+	if(!Box.IsValid)
+		return;
+
+	TArray<FVolume, TInlineAllocator<8>> Found;
+	Query([&Box](const FBox &Bounds) { return Bounds.Intersect(Box); }, [&Found](const FVolume &Volume) { Found.Add(Volume); });
+
+	Found.Sort([](const FVolume &A, const FVolume &B) { return IsBetterLiquid(A.Priority, A.Bounds, B.Priority, B.Bounds); });
+	for(const FVolume &Volume : Found)
+	{
+		outLiquids.Add(Volume.Liquid);
+	}
+}
+
+template<typename TestType, typename FuncType>
+void FLiquidVolumeTree::Query(const TestType &Test, const FuncType &Func) const
+{
+	// changes only mark the tree dirty, the first query after them builds it again
+	Lock.ReadLock();
+	while(bDirty)
+	{
+		Lock.ReadUnlock();
+		{
+			FRWScopeLock ScopeLock(Lock, SLT_Write);
+			if(bDirty)
+				Build();
+		}
+		Lock.ReadLock();
+	}
+
+	TArray<int32, TInlineAllocator<64>> Stack;
+	if(Nodes.Num() > 0)
+		Stack.Add(0);
+
+	while(Stack.Num() > 0)
+	{
+		const FNode &Node = Nodes[Stack.Pop(false)];
+		if(!Test(Node.Bounds))
+			continue;
+
+		if(!Node.IsLeaf())
+		{
+			Stack.Add(Node.Children[0]);
+			Stack.Add(Node.Children[1]);
+			continue;
+		}
+
+		for(int32 Idx = Node.Begin; Idx < Node.Begin + Node.Num; Idx++)
+		{
+			const FVolume &Volume = Volumes[Order[Idx]];
+			if(Test(Volume.Bounds))
+				Func(Volume);
+		}
+	}
+
+	Lock.ReadUnlock();
+}
+
+void FLiquidVolumeTree::Build() const
+{
+	Nodes.Reset();
+	Order.SetNumUninitialized(Volumes.Num());
+	for(int32 Idx = 0; Idx < Volumes.Num(); Idx++)
+	{
+		Order[Idx] = Idx;
+	}
+
+	if(Volumes.Num() > 0)
+		BuildNode(0, Volumes.Num());
+
+	bDirty = false;
+}
+
+int32 FLiquidVolumeTree::BuildNode(int32 Begin, int32 Num) const
+{
+	FBox Bounds(ForceInit);
+	FBox Centers(ForceInit);
+	for(int32 Idx = Begin; Idx < Begin + Num; Idx++)
+	{
+		const FBox &VolumeBounds = Volumes[Order[Idx]].Bounds;
+		Bounds += VolumeBounds;
+		Centers += VolumeBounds.GetCenter();
+	}
+
+	// Nodes grows while the children are built, the node is only written through its index
+	const int32 NodeIndex = Nodes.Add({ Bounds, { INDEX_NONE, INDEX_NONE }, Begin, Num });
+	if(Num <= LiquidTreeLeafSize)
+		return NodeIndex;
+
+	const FVector Size = Centers.GetSize();
+	const int32 Axis = Size.X >= Size.Y && Size.X >= Size.Z ? 0 : Size.Y >= Size.Z ? 1 : 2;
+	Sort(Order.GetData() + Begin, Num, [this, Axis](int32 A, int32 B)
+	{
+		return Volumes[A].Bounds.GetCenter()[Axis] < Volumes[B].Bounds.GetCenter()[Axis];
+	});
+
+	const int32 Half = Num / 2;
+	const int32 Left = BuildNode(Begin, Half);
+	const int32 Right = BuildNode(Begin + Half, Num - Half);
+	Nodes[NodeIndex].Children[0] = Left;
+	Nodes[NodeIndex].Children[1] = Right;
+	return NodeIndex;
+}
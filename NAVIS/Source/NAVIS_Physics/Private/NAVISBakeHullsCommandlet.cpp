@@ -0,0 +1,121 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "NAVISBakeHullsCommandlet.h"
+#include "NAVISHullCache.h"
+#include "NAVISVolumeMath.h"
+#include "AssetRegistryModule.h"
+#include "Engine/StaticMesh.h"
+#include "Hash/CityHash.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if WITH_EDITOR
+	#include "DerivedDataCacheInterface.h"
+#endif // WITH_EDITOR
+
+/** Change it to bake every hull again, when the way they are triangulated changes */
+#define NAVIS_HULL_DERIVED_DATA_VER TEXT("5C0E2B7A91D44F6C8A3E0D1B2F4A6C81")
+
+UNAVISBakeHullsCommandlet::UNAVISBakeHullsCommandlet() : Super()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UNAVISBakeHullsCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR && WITH_PHYSX
+	FString Paths = TEXT("/Game");
+	FParse::Value(*Params, TEXT("Paths="), Paths);
+
+	IAssetRegistry &AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	FARFilter Filter;
+	Filter.ClassNames.Add(UStaticMesh::StaticClass()->GetFName());
+	Filter.bRecursivePaths = true;
+	TArray<FString> PackagePaths;
+	Paths.ParseIntoArray(PackagePaths, TEXT("+"));
+	for (const FString &PackagePath : PackagePaths)
+		Filter.PackagePaths.Add(*PackagePath);
+
+	TArray<FAssetData> Assets;
+	AssetRegistry.GetAssets(Filter, Assets);
+
+	NAVISCore::FHullCacheBuilder Builder;
+	int32 NumBuilt = 0;
+	for (const FAssetData &Asset : Assets)
+	{
+		const UStaticMesh *Mesh = Cast<UStaticMesh>(Asset.GetAsset());
+		UBodySetup *BodySetup = Mesh ? Mesh->BodySetup : nullptr;
+		if (!BodySetup || BodySetup->AggGeom.ConvexElems.Num() == 0)
+			continue;
+
+		// the key changes with the hulls, a stale bake is never found
+		const TArray<FKConvexElem> &ConvexElems = BodySetup->AggGeom.ConvexElems;
+		uint64 GeometryHash = 0;
+		for (const FKConvexElem &Elem : ConvexElems)
+			GeometryHash = CityHash64WithSeed(reinterpret_cast<const char *>(Elem.VertexData.GetData()), Elem.VertexData.Num() * sizeof(FVector), GeometryHash);
+		const uint64 BodyKey = FNAVISHullCache::GetBodyKey(BodySetup);
+		const FString DerivedDataKey = FDerivedDataCacheInterface::BuildCacheKey(TEXT("NAVIS_HULLS"), NAVIS_HULL_DERIVED_DATA_VER,
+			*FString::Printf(TEXT("%u_%016llx_%016llx"), NAVISCore::HullCacheVersion, BodyKey, GeometryHash));
+
+		// the derived data is a hull cache of this body alone
+		TArray<uint8> DerivedData;
+		if (!GetDerivedDataCacheRef().GetSynchronous(*DerivedDataKey, DerivedData))
+		{
+			BodySetup->CreatePhysicsMeshes();
+
+			TArray<TArray<uint32>> Indices;
+			std::vector<NAVISCore::FConvexHullView> Hulls;
+			Indices.SetNum(ConvexElems.Num());
+			for (int32 ElemIdx = 0; ElemIdx < ConvexElems.Num(); ElemIdx++)
+			{
+				const physx::PxConvexMesh *ConvexMesh = ConvexElems[ElemIdx].GetConvexMesh();
+				if (!ConvexMesh)
+					break;
+				FNAVISVolumeMath::GetPhysXConvexIndices(ConvexMesh, Indices[ElemIdx]);
+				Hulls.push_back(FNAVISVolumeMath::GetPhysXConvexView(ConvexMesh, Indices[ElemIdx]));
+			}
+			// hulls are found by the index of their element, all of them or none
+			if (int32(Hulls.size()) != ConvexElems.Num())
+			{
+				UE_LOG(LogNAVIS_Physics, Warning, TEXT("%s : convex elements without a PhysX mesh, not baked"), *Asset.ObjectPath.ToString());
+				continue;
+			}
+
+			NAVISCore::FHullCacheBuilder BodyBuilder;
+			BodyBuilder.AddBody(BodyKey, Hulls);
+			const std::vector<uint8_t> BodyData = BodyBuilder.Build();
+			DerivedData = TArray<uint8>(BodyData.data(), BodyData.size());
+			GetDerivedDataCacheRef().Put(*DerivedDataKey, DerivedData);
+			NumBuilt++;
+		}
+
+		NAVISCore::FHullCacheView BodyView;
+		if (!BodyView.Init(DerivedData.GetData(), DerivedData.Num()) || !BodyView.Validate())
+		{
+			UE_LOG(LogNAVIS_Physics, Warning, TEXT("%s : bad derived data, not baked"), *Asset.ObjectPath.ToString());
+			continue;
+		}
+		Builder.AddBodies(BodyView);
+	}
+
+	const std::vector<uint8_t> CacheData = Builder.Build();
+	const FString CachePath = FNAVISHullCache::GetCachePath();
+	if (!FFileHelper::SaveArrayToFile(TArrayView<const uint8>(CacheData.data(), CacheData.size()), *CachePath))
+	{
+		UE_LOG(LogNAVIS_Physics, Error, TEXT("Cannot write %s"), *CachePath);
+		return 1;
+	}
+
+	UE_LOG(LogNAVIS_Physics, Display, TEXT("Baked %d bodies to %s (%d triangulated, the others from the derived data cache), %d bytes"),
+		int32(Builder.GetNumBodies()), *CachePath, NumBuilt, int32(CacheData.size()));
+	return 0;
+#else
+	UE_LOG(LogNAVIS_Physics, Error, TEXT("NAVISBakeHulls needs the editor and PhysX"));
+	return 1;
+#endif // WITH_EDITOR && WITH_PHYSX
+}
@@ -0,0 +1,113 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "NAVISBuoyancyCapture.h"
+#include "HAL/FileManager.h"
+#include "Hash/CityHash.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+#if NAVIS_BUOYANCY_CAPTURE
+
+/** Encoded bytes kept in memory before they go to the file */
+static const int32 CaptureFlushSize = 1024 * 1024;
+
+static FAutoConsoleCommand CmdNAVISCaptureStart(
+	TEXT("navis.Capture.Start"),
+	TEXT("Stream every hull volume query to a file, for Tools/NAVISCore replay. Usage : navis.Capture.Start [File]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString> &Args)
+	{
+		FNAVISBuoyancyCapture::Get().Start(Args.Num() > 0 ? Args[0] : FString());
+	}));
+
+static FAutoConsoleCommand CmdNAVISCaptureStop(
+	TEXT("navis.Capture.Stop"),
+	TEXT("Close the capture started by navis.Capture.Start"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FNAVISBuoyancyCapture::Get().Stop();
+	}));
+
+FNAVISBuoyancyCapture &FNAVISBuoyancyCapture::Get()
+{
+	static FNAVISBuoyancyCapture Instance;
+	return Instance;
+}
+
+bool FNAVISBuoyancyCapture::Start(const FString &FileName)
+{
+	Stop();
+
+	FScopeLock ScopeLock(&Lock);
+
+	FilePath = FileName;
+	if (FilePath.IsEmpty())
+		FilePath = FPaths::ProfilingDir() / TEXT("NAVIS") / FString::Printf(TEXT("Buoyancy-%s.navcap"), *FDateTime::Now().ToString());
+
+	File.Reset(IFileManager::Get().CreateFileWriter(*FilePath));
+	if (!File)
+	{
+		UE_LOG(LogNAVIS_Physics, Error, TEXT("navis.Capture.Start : cannot write %s"), *FilePath);
+		return false;
+	}
+
+	Writer = MakeUnique<NAVISCore::FCaptureWriter>();
+	HullIds.Reset();
+	NumQueries = 0;
+	bCapturing = true;
+	UE_LOG(LogNAVIS_Physics, Display, TEXT("Capturing buoyancy queries to %s"), *FilePath);
+	return true;
+}
+
+void FNAVISBuoyancyCapture::Stop()
+{
+	FScopeLock ScopeLock(&Lock);
+	if (!bCapturing)
+		return;
+
+	bCapturing = false;
+	Flush();
+	File->Close();
+	File.Reset();
+	Writer.Reset();
+	UE_LOG(LogNAVIS_Physics, Display, TEXT("Captured %llu queries on %d hulls to %s"), NumQueries, HullIds.Num(), *FilePath);
+}
+
+void FNAVISBuoyancyCapture::Record(const NAVISCore::FConvexHullView &Hull, const NAVISCore::FPlane3 &Plane, const NAVISCore::FVec3 &Scale, float Volume)
+{
+	// hashed before taking the lock, the sizes are in the seed so the split between vertices and indices counts
+	const uint64 VerticesHash = CityHash64WithSeed(reinterpret_cast<const char *>(Hull.Vertices), uint32(sizeof(NAVISCore::FVec3) * Hull.NumVertices), uint64(Hull.NumVertices));
+	const uint64 HullKey = CityHash64WithSeed(reinterpret_cast<const char *>(Hull.Indices), uint32(sizeof(uint32_t) * 3 * Hull.NumTriangles), VerticesHash);
+
+	FScopeLock ScopeLock(&Lock);
+	// stopped while waiting for the lock
+	if (!bCapturing)
+		return;
+
+	uint32 *HullId = HullIds.Find(HullKey);
+	if (!HullId)
+	{
+		HullId = &HullIds.Add(HullKey, HullIds.Num());
+		Writer->AddHull(*HullId, Hull);
+	}
+
+	NAVISCore::FCaptureQuery Query;
+	Query.HullId = *HullId;
+	Query.Plane = Plane;
+	Query.Scale = Scale;
+	Query.Volume = Volume;
+	Writer->AddQuery(Query);
+	NumQueries++;
+
+	if (Writer->GetBuffer().size() >= CaptureFlushSize)
+		Flush();
+}
+
+void FNAVISBuoyancyCapture::Flush()
+{
+	const std::vector<uint8_t> &Buffer = Writer->GetBuffer();
+	File->Serialize(const_cast<uint8_t *>(Buffer.data()), Buffer.size());
+	Writer->ResetBuffer();
+}
+
+#endif // NAVIS_BUOYANCY_CAPTURE
@@ -0,0 +1,69 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "NAVIS_PhysicsPCH.h"
+#include "NAVISCoreCapture.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeBool.h"
+
+#define NAVIS_BUOYANCY_CAPTURE !UE_BUILD_SHIPPING
+
+#if NAVIS_BUOYANCY_CAPTURE
+
+/**
+ *	FNAVISBuoyancyCapture
+ *	Streams the hull volume queries to a file, between "navis.Capture.Start [File]" and "navis.Capture.Stop".
+ *	The file is a NAVIS_Core capture, Tools/NAVISCore NAVISCoreReplay runs it again outside of the game
+ */
+class FNAVISBuoyancyCapture
+{
+public:
+
+	static FNAVISBuoyancyCapture &Get();
+
+	/** Start()		open a new capture, closing the one running. An empty name goes to Saved/Profiling/NAVIS */
+	bool Start(const FString &FileName);
+
+	/** Stop()		write what is left and close the file */
+	void Stop();
+
+	bool IsCapturing() const { return bCapturing; }
+
+	/**
+	 *	Record()	a query on a hull, the hull is written the first time it is seen
+	 *	@note		hulls are told apart by a hash of their vertices and indices : an engine mesh freed then allocated
+	 *				at the same address is a new hull, and two copies of the same mesh are one
+	 */
+	void Record(const NAVISCore::FConvexHullView &Hull, const NAVISCore::FPlane3 &Plane, const NAVISCore::FVec3 &Scale, float Volume);
+
+private:
+
+	/** Flush()		move the encoded queries to the file */
+	void Flush();
+
+	FThreadSafeBool bCapturing;
+
+	/** volumes may be asked from any thread */
+	FCriticalSection Lock;
+
+	TUniquePtr<FArchive> File;
+	TUniquePtr<NAVISCore::FCaptureWriter> Writer;
+	FString FilePath;
+	/** id in the capture of every hull written, by hash of its content */
+	TMap<uint64, uint32> HullIds;
+	uint64 NumQueries = 0;
+};
+
+#define NAVIS_CAPTURE_QUERY(Hull, Plane, Scale, Volume) \
+	do \
+	{ \
+		if (FNAVISBuoyancyCapture::Get().IsCapturing()) \
+			FNAVISBuoyancyCapture::Get().Record(Hull, Plane, Scale, Volume); \
+	} while (0)
+
+#else
+
+#define NAVIS_CAPTURE_QUERY(Hull, Plane, Scale, Volume) do {} while (0)
+
+#endif // NAVIS_BUOYANCY_CAPTURE
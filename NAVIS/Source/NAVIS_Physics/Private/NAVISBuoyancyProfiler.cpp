@@ -0,0 +1,204 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "NAVISBuoyancyProfiler.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/ScopeLock.h"
+#include "Trace/Trace.h"
+
+#if NAVIS_BUOYANCY_PROFILER
+
+static TAutoConsoleVariable<int32> CVarNAVISProfileBuoyancy(
+	TEXT("navis.Profile.Buoyancy"),
+	0,
+	TEXT("Collect the buoyancy cost of each floating object, for navis.DumpTopFloating.\n")
+	TEXT("0: off, 1: on"));
+
+static TAutoConsoleVariable<int32> CVarNAVISTraceBuoyancy(
+	TEXT("navis.Trace.Buoyancy"),
+	0,
+	TEXT("Send the buoyancy cost of each floating object to the trace, as NAVIS.Buoyancy events.\n")
+	TEXT("0: off, 1: on"));
+
+static FAutoConsoleCommand CmdNAVISDumpTopFloating(
+	TEXT("navis.DumpTopFloating"),
+	TEXT("Log the most expensive floating objects of the last second. Usage : navis.DumpTopFloating [Count=10]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString> &Args)
+	{
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10;
+		FNAVISBuoyancyProfiler::Get().Dump(FMath::Max(Count, 1));
+	}));
+
+#if UE_TRACE_ENABLED
+UE_TRACE_EVENT_BEGIN(NAVIS, BuoyancyObject)
+	UE_TRACE_EVENT_FIELD(uint32, ObjectId)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(NAVIS, Buoyancy)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, Duration)
+	UE_TRACE_EVENT_FIELD(uint32, ObjectId)
+UE_TRACE_EVENT_END()
+#endif // UE_TRACE_ENABLED
+
+FNAVISBuoyancyProfiler &FNAVISBuoyancyProfiler::Get()
+{
+	static FNAVISBuoyancyProfiler Instance;
+	return Instance;
+}
+
+bool FNAVISBuoyancyProfiler::IsEnabled()
+{
+	return CVarNAVISProfileBuoyancy.GetValueOnAnyThread() != 0 || CVarNAVISTraceBuoyancy.GetValueOnAnyThread() != 0;
+}
+
+FNAVISBuoyancyProfiler::FNAVISBuoyancyProfiler()
+{
+	FCoreDelegates::OnEndFrame.AddRaw(this, &FNAVISBuoyancyProfiler::OnEndFrame);
+}
+
+FNAVISBuoyancyProfiler::~FNAVISBuoyancyProfiler()
+{
+	FCoreDelegates::OnEndFrame.RemoveAll(this);
+}
+
+FNAVISBuoyancyProfiler::FThreadSamples &FNAVISBuoyancyProfiler::GetThreadSamples()
+{
+	static thread_local FThreadSamples *Samples = nullptr;
+	if (!Samples)
+	{
+		FScopeLock ScopeLock(&ThreadsLock);
+		Samples = Threads.Add_GetRef(MakeUnique<FThreadSamples>()).Get();
+	}
+	return *Samples;
+}
+
+void FNAVISBuoyancyProfiler::AddSample(const UObject *Object, uint64 StartCycles, uint32 Cycles)
+{
+	if (!Object)
+		return;
+
+	const bool bTrace = CVarNAVISTraceBuoyancy.GetValueOnAnyThread() != 0;
+	const uint64 Window = uint64(StartCycles * FPlatformTime::GetSecondsPerCycle64());
+	const FObjectKey Key(Object);
+
+	FThreadSamples &Samples = GetThreadSamples();
+	{
+		FScopeLock ScopeLock(&Samples.Lock);
+		if (Window != Samples.CurrentWindow)
+		{
+			Samples.Previous = MoveTemp(Samples.Current);
+			Samples.PreviousWindow = Samples.CurrentWindow;
+			Samples.Current.Reset();
+			Samples.CurrentWindow = Window;
+		}
+
+		FEntry *Entry = Samples.Current.Find(Key);
+		if (!Entry)
+		{
+			Entry = &Samples.Current.Add(Key);
+			if (bTrace)
+				Samples.ToName.Add(Key);
+		}
+		Entry->Cycles += Cycles;
+		Entry->Calls++;
+	}
+
+#if UE_TRACE_ENABLED
+	if (bTrace)
+	{
+		UE_TRACE_LOG(NAVIS, Buoyancy)
+			<< Buoyancy.Cycle(StartCycles)
+			<< Buoyancy.Duration(Cycles)
+			<< Buoyancy.ObjectId(Object->GetUniqueID());
+	}
+#endif // UE_TRACE_ENABLED
+}
+
+void FNAVISBuoyancyProfiler::OnEndFrame()
+{
+	TArray<FObjectKey> ToName;
+	{
+		FScopeLock ScopeLock(&ThreadsLock);
+		for (const TUniquePtr<FThreadSamples> &Samples : Threads)
+		{
+			FScopeLock SamplesLock(&Samples->Lock);
+			ToName.Append(Samples->ToName);
+			Samples->ToName.Reset();
+		}
+	}
+
+#if UE_TRACE_ENABLED
+	for (const FObjectKey &Key : ToName)
+	{
+		bool bAlreadyNamed = false;
+		TracedNames.Add(Key, &bAlreadyNamed);
+		const UObject *Object = Key.ResolveObjectPtr();
+		if (bAlreadyNamed || !Object)
+			continue;
+
+		const FString Name = Object->GetPathName();
+		const uint16 NameSize = uint16((Name.Len() + 1) * sizeof(TCHAR));
+		UE_TRACE_LOG(NAVIS, BuoyancyObject, NameSize)
+			<< BuoyancyObject.ObjectId(Object->GetUniqueID())
+			<< BuoyancyObject.Attachment(*Name, NameSize);
+	}
+#endif // UE_TRACE_ENABLED
+}
+
+void FNAVISBuoyancyProfiler::Dump(int32 Count)
+{
+	if (!IsEnabled())
+	{
+		UE_LOG(LogNAVIS_Physics, Display, TEXT("Nothing collected, run navis.Profile.Buoyancy 1 first"));
+		return;
+	}
+
+	// the last full second of every thread, or the running one if none finished yet
+	const uint64 Window = uint64(FPlatformTime::Cycles64() * FPlatformTime::GetSecondsPerCycle64());
+	TMap<FObjectKey, FEntry> Merged;
+	auto Merge = [&Merged](const TMap<FObjectKey, FEntry> &Entries)
+	{
+		for (const TPair<FObjectKey, FEntry> &Pair : Entries)
+		{
+			FEntry &Entry = Merged.FindOrAdd(Pair.Key);
+			Entry.Cycles += Pair.Value.Cycles;
+			Entry.Calls += Pair.Value.Calls;
+		}
+	};
+	{
+		FScopeLock ScopeLock(&ThreadsLock);
+		for (const TUniquePtr<FThreadSamples> &Samples : Threads)
+		{
+			FScopeLock SamplesLock(&Samples->Lock);
+			if (Samples->CurrentWindow + 1 == Window)
+				Merge(Samples->Current);
+			else if (Samples->PreviousWindow + 1 == Window)
+				Merge(Samples->Previous);
+		}
+		if (Merged.Num() == 0)
+		{
+			for (const TUniquePtr<FThreadSamples> &Samples : Threads)
+			{
+				FScopeLock SamplesLock(&Samples->Lock);
+				if (Samples->CurrentWindow == Window)
+					Merge(Samples->Current);
+			}
+		}
+	}
+
+	Merged.ValueSort([](const FEntry &A, const FEntry &B) { return A.Cycles > B.Cycles; });
+
+	UE_LOG(LogNAVIS_Physics, Display, TEXT("Top %d floating objects of the last second, out of %d :"), FMath::Min(Count, Merged.Num()), Merged.Num());
+	int32 Idx = 0;
+	for (const TPair<FObjectKey, FEntry> &Pair : Merged)
+	{
+		if (Idx >= Count)
+			break;
+		const UObject *Object = Pair.Key.ResolveObjectPtr();
+		const double Milliseconds = FPlatformTime::ToMilliseconds64(Pair.Value.Cycles);
+		UE_LOG(LogNAVIS_Physics, Display, TEXT("  %2d. %8.3f ms  %5u calls  %s"), ++Idx, Milliseconds, Pair.Value.Calls, Object ? *Object->GetPathName() : TEXT("(destroyed)"));
+	}
+}
+
+#endif // NAVIS_BUOYANCY_PROFILER
@@ -0,0 +1,96 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "NAVIS_PhysicsPCH.h"
+#include "UObject/ObjectKey.h"
+#include "HAL/CriticalSection.h"
+
+#define NAVIS_BUOYANCY_PROFILER !UE_BUILD_SHIPPING
+
+#if NAVIS_BUOYANCY_PROFILER
+
+/**
+ *	FNAVISBuoyancyProfiler
+ *	Buoyancy cost of each floating object, over the last second.
+ *	Nothing is collected until "navis.Profile.Buoyancy 1" or "navis.Trace.Buoyancy 1".
+ *	"navis.DumpTopFloating [N]" logs the most expensive ones,
+ *	"navis.Trace.Buoyancy 1" sends every sample to the trace as a NAVIS.Buoyancy event
+ */
+class FNAVISBuoyancyProfiler
+{
+public:
+
+	static FNAVISBuoyancyProfiler &Get();
+
+	/** IsEnabled()	@return true if the profile or the trace wants samples */
+	static bool IsEnabled();
+
+	/** AddSample()	cycles spent on the buoyancy of an object, added to the samples of the calling thread */
+	void AddSample(const UObject *Object, uint64 StartCycles, uint32 Cycles);
+
+	/** Dump()		log the Count most expensive objects of the last full second. Game thread, names are looked up here */
+	void Dump(int32 Count);
+
+private:
+
+	FNAVISBuoyancyProfiler();
+	~FNAVISBuoyancyProfiler();
+
+	struct FEntry
+	{
+		uint64 Cycles = 0;
+		uint32 Calls = 0;
+	};
+
+	/** FThreadSamples	samples of one thread, its lock is only contended while dumping or naming */
+	struct FThreadSamples
+	{
+		FCriticalSection Lock;
+
+		/** the second being filled, and the one before it, counted in seconds of FPlatformTime::Cycles64() */
+		TMap<FObjectKey, FEntry> Current;
+		TMap<FObjectKey, FEntry> Previous;
+		uint64 CurrentWindow = 0;
+		uint64 PreviousWindow = 0;
+
+		/** objects seen while tracing, named on the game thread at the end of the frame */
+		TArray<FObjectKey> ToName;
+	};
+
+	/** GetThreadSamples()	samples of the calling thread, created on its first sample */
+	FThreadSamples &GetThreadSamples();
+
+	/** OnEndFrame()	send the names of the objects traced this frame */
+	void OnEndFrame();
+
+	/** every thread that ever sampled, they are never removed */
+	TArray<TUniquePtr<FThreadSamples>> Threads;
+	FCriticalSection ThreadsLock;
+
+	/** objects already named in the trace, game thread only */
+	TSet<FObjectKey> TracedNames;
+};
+
+/** FNAVISBuoyancyScope	adds the time spent in its scope to an object, does not even read the clock when the profiler is off */
+struct FNAVISBuoyancyScope
+{
+	explicit FNAVISBuoyancyScope(const UObject *InObject) : Object(FNAVISBuoyancyProfiler::IsEnabled() ? InObject : nullptr), StartCycles(Object ? FPlatformTime::Cycles64() : 0) {}
+	~FNAVISBuoyancyScope()
+	{
+		if (Object)
+			FNAVISBuoyancyProfiler::Get().AddSample(Object, StartCycles, uint32(FPlatformTime::Cycles64() - StartCycles));
+	}
+
+private:
+	const UObject *Object;
+	uint64 StartCycles;
+};
+
+#define NAVIS_BUOYANCY_SCOPE(Object) FNAVISBuoyancyScope NAVISBuoyancyScope(Object)
+
+#else
+
+#define NAVIS_BUOYANCY_SCOPE(Object)
+
+#endif // NAVIS_BUOYANCY_PROFILER
@@ -0,0 +1,145 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "NAVISHullCache.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Hash/CityHash.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if WITH_PHYSX
+	#include "PhysXPublic.h"
+#endif // WITH_PHYSX
+
+FNAVISHullCache &FNAVISHullCache::Get()
+{
+	static FNAVISHullCache Instance;
+	return Instance;
+}
+
+FString FNAVISHullCache::GetCachePath()
+{
+	// staged next to the pak, a file inside of it could not be mapped : see DirectoriesToAlwaysStageAsNonUFS in DefaultGame.ini
+	return FPaths::ProjectContentDir() / TEXT("NAVIS") / TEXT("HullCache.navhull");
+}
+
+uint64 FNAVISHullCache::GetBodyKey(const UBodySetup *BodySetup)
+{
+	return CityHash64(reinterpret_cast<const char *>(&BodySetup->BodySetupGuid), sizeof(FGuid));
+}
+
+bool FNAVISHullCache::Load()
+{
+	Unload();
+
+	// the editor may have changed the meshes since the last bake
+	if (!FPlatformProperties::RequiresCookedData())
+		return false;
+
+	const FString Path = GetCachePath();
+	const void *Data = nullptr;
+	int64 Size = 0;
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+	if (MappedFile)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	}
+	if (MappedRegion)
+	{
+		Data = MappedRegion->GetMappedPtr();
+		Size = MappedRegion->GetMappedSize();
+	}
+	else if (FFileHelper::LoadFileToArray(LoadedData, *Path, FILEREAD_Silent))
+	{
+		Data = LoadedData.GetData();
+		Size = LoadedData.Num();
+	}
+	else
+	{
+		return false;
+	}
+
+	if (!View.Init(Data, Size))
+	{
+		UE_LOG(LogNAVIS_Physics, Warning, TEXT("%s is not a hull cache of version %u, bake it again"), *Path, NAVISCore::HullCacheVersion);
+		Unload();
+		return false;
+	}
+
+	UE_LOG(LogNAVIS_Physics, Log, TEXT("Hull cache %s : %u bodies%s"), *Path, View.GetNumBodies(), MappedRegion ? TEXT(", mapped") : TEXT(""));
+	return true;
+}
+
+void FNAVISHullCache::Unload()
+{
+	FRWScopeLock ScopeLock(Lock, SLT_Write);
+	View = NAVISCore::FHullCacheView();
+	Hulls.Reset();
+	RegisteredBodySetups.Reset();
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	LoadedData.Empty();
+}
+
+void FNAVISHullCache::RegisterBodySetup(const UBodySetup *BodySetup)
+{
+	if (!View.IsValid() || !BodySetup)
+		return;
+
+	{
+		FRWScopeLock ScopeLock(Lock, SLT_ReadOnly);
+		if (RegisteredBodySetups.Contains(BodySetup))
+			return;
+	}
+
+	// hulls are checked out of the lock, the cache does not change while it is loaded
+	TArray<TPair<const void *, FRegisteredHull>, TInlineAllocator<8>> NewHulls;
+#if WITH_PHYSX
+	const NAVISCore::FHullCacheBody *Body = View.FindBody(GetBodyKey(BodySetup));
+	const TArray<FKConvexElem> &ConvexElems = BodySetup->AggGeom.ConvexElems;
+	if (Body && Body->NumHulls == uint32(ConvexElems.Num()))
+	{
+		for (int32 ElemIdx = 0; ElemIdx < ConvexElems.Num(); ElemIdx++)
+		{
+			// mirrored meshes are left to the triangulation at runtime, and so are hulls the cache has wrong
+			const physx::PxConvexMesh *ConvexMesh = ConvexElems[ElemIdx].GetConvexMesh();
+			const NAVISCore::FConvexHullView Hull = View.GetHull(*Body, ElemIdx);
+			if (!ConvexMesh || int32(ConvexMesh->getNbVertices()) != Hull.NumVertices)
+				continue;
+			NewHulls.Emplace(ConvexMesh, FRegisteredHull{ BodySetup, ElemIdx, Hull });
+		}
+	}
+#endif // WITH_PHYSX
+
+	// another thread may have registered it meanwhile, it found the same hulls
+	FRWScopeLock ScopeLock(Lock, SLT_Write);
+	bool bAlreadyRegistered = false;
+	RegisteredBodySetups.Add(BodySetup, &bAlreadyRegistered);
+	if (bAlreadyRegistered)
+		return;
+	for (const TPair<const void *, FRegisteredHull> &NewHull : NewHulls)
+		Hulls.Add(NewHull.Key, NewHull.Value);
+}
+
+#if WITH_PHYSX
+bool FNAVISHullCache::FindHull(const physx::PxConvexMesh *ConvexMesh, NAVISCore::FConvexHullView &OutHull) const
+{
+	if (!View.IsValid())
+		return false;
+
+	FRWScopeLock ScopeLock(Lock, SLT_ReadOnly);
+	const FRegisteredHull *Registered = Hulls.Find(ConvexMesh);
+	if (!Registered)
+		return false;
+
+	// the address may belong to another mesh by now
+	const UBodySetup *BodySetup = Registered->BodySetup.Get();
+	if (!BodySetup || !BodySetup->AggGeom.ConvexElems.IsValidIndex(Registered->ElemIndex)
+		|| BodySetup->AggGeom.ConvexElems[Registered->ElemIndex].GetConvexMesh() != ConvexMesh)
+		return false;
+
+	OutHull = Registered->Hull;
+	return true;
+}
+#endif // WITH_PHYSX
@@ -0,0 +1,75 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "NAVIS_PhysicsPCH.h"
+#include "NAVISCoreHullCache.h"
+#include "Misc/ScopeRWLock.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+namespace physx
+{
+	class PxConvexMesh;
+}
+
+/**
+ *	FNAVISHullCache
+ *	Triangulated convex hulls baked at cook time by @see UNAVISBakeHullsCommandlet.
+ *	The cache file is mapped in memory and read in place : loading it costs nothing whatever the number of ships.
+ *	Only cooked builds use it, the editor triangulates the hulls as they are
+ */
+class FNAVISHullCache
+{
+public:
+
+	static FNAVISHullCache &Get();
+
+	/** GetCachePath()	where the commandlet writes the cache, and where the game reads it */
+	static FString GetCachePath();
+
+	/** GetBodyKey()	what a body setup is known as in the cache */
+	static uint64 GetBodyKey(const UBodySetup *BodySetup);
+
+	/** Load()		map the cache file, @return false if there is none or it is not of this version */
+	bool Load();
+
+	void Unload();
+
+	bool IsLoaded() const { return View.IsValid(); }
+
+	/**
+	 *	RegisterBodySetup()	let the convex meshes of a body setup use their baked hulls.
+	 *	Does nothing for a body setup already seen, or without a cache
+	 */
+	void RegisterBodySetup(const UBodySetup *BodySetup);
+
+#if WITH_PHYSX
+	/** FindHull()	@return true if the convex mesh has a baked hull, in OutHull */
+	bool FindHull(const physx::PxConvexMesh *ConvexMesh, NAVISCore::FConvexHullView &OutHull) const;
+#endif // WITH_PHYSX
+
+private:
+
+	struct FRegisteredHull
+	{
+		/** the mesh is only trusted while its body setup still has it */
+		TWeakObjectPtr<const UBodySetup> BodySetup;
+		int32 ElemIndex;
+		NAVISCore::FConvexHullView Hull;
+	};
+
+	/** the file, mapped. Platforms that cannot map it read it in LoadedData instead */
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TArray<uint8> LoadedData;
+
+	NAVISCore::FHullCacheView View;
+
+	TMap<const void *, FRegisteredHull> Hulls;
+	TSet<TWeakObjectPtr<const UBodySetup>> RegisteredBodySetups;
+
+	/** volumes may be asked from any thread */
+	mutable FRWLock Lock;
+};
@@ -3,6 +3,10 @@
 #include "NAVISPhysicsStatics.h"
 #include "NAVIS_PhysicsPCH.h"
 #include "NAVISVolumeMath.h"
+#include "NAVISBuoyancyProfiler.h"
+#include "NAVISHullCache.h"
+#include "LiquidVolumeTree.h"
+#include "LiquidActorComponent.h"
 #include "Engine/World.h"
 
 FVector UNAVISPhysicsStatics::GetGravityDirectionAndStrength(const UObject *WorldContextObject)
@@ -54,22 +58,25 @@ float UNAVISPhysicsStatics::GetPrimitiveVolumeAtLevel(const UPrimitiveComponent
 	if (!in)
 		return -1.f;
 
-	const FVector PlaneRelativePosition = in->GetComponentToWorld().InverseTransformPosition(worldPlane.GetPosition());
+	// in the space of the body : the component without its scale
+	const FTransform &ComponentToWorld = in->GetComponentToWorld();
+	const FNavisPlane RelativePlane(worldPlane.GetLocalPosition(ComponentToWorld), worldPlane.GetLocalNormal(ComponentToWorld));
 
-	float Volume = GetBodyInstanceVolumeAtLevel(in->BodyInstance, FNavisPlane(PlaneRelativePosition, worldPlane.GetNormal()));
+	float Volume = GetBodyInstanceVolumeAtLevel(in->BodyInstance, RelativePlane);
 	if (Volume >= 0) // no error Volume != -1
 		return Volume;
 	if(in->BodyInstance.BodySetup.Get())
-		return GetBodySetupVolumeAtLevel(in->BodyInstance.BodySetup.Get(), FNavisPlane(PlaneRelativePosition, worldPlane.GetNormal()));
+		return GetBodySetupVolumeAtLevel(in->BodyInstance.BodySetup.Get(), RelativePlane, ComponentToWorld.GetScale3D());
 
 	return -1.f;
 }
 
-float UNAVISPhysicsStatics::GetBodySetupVolumeAtLevel(const UBodySetup *in, const FNavisPlane &relativePlane)
+float UNAVISPhysicsStatics::GetBodySetupVolumeAtLevel(const UBodySetup *in, const FNavisPlane &relativePlane, const FVector &scale)
 {
+	SCOPE_CYCLE_COUNTER(STAT_NAVIS_Clipping);
 
 	float Volume = 0.f;
-	FVector Scale = FVector::OneVector;
+	const FVector &Scale = scale;
 	// Sphere			:
 	for (auto itr : in->AggGeom.SphereElems)
 		Volume += FNAVISVolumeMath::GetSphereTruncatedVolume(itr, relativePlane.GetPosition(), relativePlane.GetNormal(), Scale);
@@ -93,11 +100,17 @@ float UNAVISPhysicsStatics::GetBodySetupVolumeAtLevel(const UBodySetup *in, cons
 
 float UNAVISPhysicsStatics::GetBodyInstanceVolumeAtLevel(const FBodyInstance &in, const FNavisPlane &relativePlane)
 {
-	float Volume = -1.f;
 	TArray<FPhysicsShapeHandle> Shapes;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_NAVIS_ShapeGathering);
+		in.GetAllShapes_AssumesLocked(Shapes);
+	}
+	if (Shapes.Num() == 0)
+		return -1.f;
 
-	in.GetAllShapes_AssumesLocked(Shapes);
+	FNAVISHullCache::Get().RegisterBodySetup(in.BodySetup.Get());
 
+	float Volume = 0.f;
 	for (FPhysicsShapeHandle Itr : Shapes)
 	{
 		Volume += FNAVISVolumeMath::GetPhysicsTruncatedVolume(Itr, relativePlane.GetPosition(), relativePlane.GetNormal(), FVector::OneVector);
@@ -105,6 +118,72 @@ float UNAVISPhysicsStatics::GetBodyInstanceVolumeAtLevel(const FBodyInstance &in
 	return Volume;
 }
 
+FVector FNAVISWaterline::GetCentroid() const
+{
+	FVector Centroid = FVector::ZeroVector;
+	for (const FVector &Point : Points)
+		Centroid += Point;
+	return Points.Num() > 0 ? Centroid / Points.Num() : Centroid;
+}
+
+float FNAVISWaterline::GetPerimeter() const
+{
+	float Perimeter = 0.f;
+	for (int32 Idx = 0; Idx < Points.Num() && Points.Num() > 1; Idx++)
+		Perimeter += FVector::Dist(Points[Idx], Points[(Idx + 1) % Points.Num()]);
+	return Perimeter;
+}
+
+bool UNAVISPhysicsStatics::GetPrimitiveWaterline(const UPrimitiveComponent *in, const FNavisPlane &worldPlane, TArray<FNAVISWaterline> &outWaterlines)
+{
+	outWaterlines.Reset();
+	if (!in)
+		return false;
+
+	// everything happens in the space of the body : the component without its scale.
+	// PhysX shapes are already scaled there, the body setup elements get the scale of the component
+	const FTransform &ComponentToWorld = in->GetComponentToWorld();
+	const FVector PlaneRelativePosition = worldPlane.GetLocalPosition(ComponentToWorld);
+	const FVector PlaneRelativeNormal = worldPlane.GetLocalNormal(ComponentToWorld);
+
+	// the volume is thrown away, the waterline comes out of the same clipping
+	auto AddWaterline = [&](TArray<FVector> &Points)
+	{
+		if (Points.Num() < 3)
+			return;
+		FNAVISWaterline &Waterline = outWaterlines.AddDefaulted_GetRef();
+		Waterline.Points = MoveTemp(Points);
+		for (FVector &Point : Waterline.Points)
+			Point = ComponentToWorld.TransformPositionNoScale(Point);
+	};
+
+	TArray<FPhysicsShapeHandle> Shapes;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_NAVIS_ShapeGathering);
+		in->BodyInstance.GetAllShapes_AssumesLocked(Shapes);
+	}
+	for (FPhysicsShapeHandle Itr : Shapes)
+	{
+		TArray<FVector> Points;
+		FNAVISVolumeMath::GetPhysicsTruncatedVolume(Itr, PlaneRelativePosition, PlaneRelativeNormal, FVector::OneVector, &Points);
+		AddWaterline(Points);
+	}
+
+	// no physics state yet, the body setup still has the elements
+	if (Shapes.Num() == 0 && in->BodyInstance.BodySetup.IsValid())
+	{
+		SCOPE_CYCLE_COUNTER(STAT_NAVIS_Clipping);
+		for (const FKConvexElem &Elem : in->BodyInstance.BodySetup.Get()->AggGeom.ConvexElems)
+		{
+			TArray<FVector> Points;
+			FNAVISVolumeMath::GetConvexTruncatedVolume(Elem, PlaneRelativePosition, PlaneRelativeNormal, ComponentToWorld.GetScale3D(), &Points);
+			AddWaterline(Points);
+		}
+	}
+
+	return outWaterlines.Num() > 0;
+}
+
 FVector UNAVISPhysicsStatics::GetArchimedesForce(const UPrimitiveComponent *solid, const FLiquidSurface &liquidWorldPlane)
 {
 	// We estimate the liquid to be uniform in density, In the real world, sea is not .
@@ -112,10 +191,17 @@ FVector UNAVISPhysicsStatics::GetArchimedesForce(const UPrimitiveComponent *soli
 
 	if (!solid)
 		return FVector::ZeroVector;
+
+	NAVIS_BUOYANCY_SCOPE(solid);
+
+	// in the space of the body : the component without its scale
+	const FTransform &ComponentToWorld = solid->GetComponentToWorld();
+	const FNavisPlane RelativePlane(liquidWorldPlane.GetLocalPosition(ComponentToWorld), liquidWorldPlane.GetLocalNormal(ComponentToWorld));
+
 	if(solid->GetBodyInstance())
 	{
 		FBodyInstance solidBodyInst = *solid->GetBodyInstance();
-		const auto volume = GetBodyInstanceVolumeAtLevel(solidBodyInst, FNavisPlane(liquidWorldPlane.GetLocalPosition(solid->GetComponentToWorld()), liquidWorldPlane.GetLocalNormal(solid->GetComponentToWorld())));
+		const auto volume = GetBodyInstanceVolumeAtLevel(solidBodyInst, RelativePlane);
 		float forceN = liquidWorldPlane.GetDensity() * volume;
 		return forceN * direction;
 	}
@@ -124,10 +210,35 @@ FVector UNAVISPhysicsStatics::GetArchimedesForce(const UPrimitiveComponent *soli
 	if(mutablesolid->GetBodySetup())
 	{
 		UBodySetup * solidBodySetup = mutablesolid->GetBodySetup();
-		const auto volume = GetBodySetupVolumeAtLevel(solidBodySetup, FNavisPlane(liquidWorldPlane.GetLocalPosition(solid->GetComponentToWorld()), liquidWorldPlane.GetLocalNormal(solid->GetComponentToWorld())));
+		const auto volume = GetBodySetupVolumeAtLevel(solidBodySetup, RelativePlane, ComponentToWorld.GetScale3D());
 		float forceN = liquidWorldPlane.GetDensity() * volume;
 		return forceN * direction;
 	}
 
 	return FVector::ZeroVector;
 }
+
+ULiquidActorComponent * UNAVISPhysicsStatics::FindLiquidAtLocation(const UObject *WorldContextObject, const FVector &location)
+{
+	const FLiquidVolumeTree * Tree = WorldContextObject ? FLiquidVolumeTree::Find(WorldContextObject->GetWorld()) : nullptr;
+	return Tree ? Tree->FindAtLocation(location) : nullptr;
+}
+
+bool UNAVISPhysicsStatics::GetLiquidSurfaceAtLocation(const UObject *WorldContextObject, const FVector &location, FLiquidSurface &outSurface)
+{
+	const ULiquidActorComponent * Liquid = FindLiquidAtLocation(WorldContextObject, location);
+	if (!Liquid)
+		return false;
+
+	outSurface = Liquid->GetLiquidSurfaceAt(location);
+	return true;
+}
+
+bool UNAVISPhysicsStatics::FindLiquidsInBox(const UObject *WorldContextObject, const FBox &box, TArray<ULiquidActorComponent*> &outLiquids)
+{
+	outLiquids.Reset();
+	const FLiquidVolumeTree * Tree = WorldContextObject ? FLiquidVolumeTree::Find(WorldContextObject->GetWorld()) : nullptr;
+	if (Tree)
+		Tree->FindInBox(box, outLiquids);
+	return outLiquids.Num() > 0;
+}
@@ -3,8 +3,10 @@
 #pragma once
  
 #include "NAVIS_PhysicsPCH.h"
-#include "GenericPlatform/GenericPlatformMath.h" // To ceil
-#include "Kismet/KismetMathLibrary.h"
+#include "NAVISCoreMath.h"
+#include "NAVISStats.h"
+#include "NAVISBuoyancyCapture.h"
+#include "NAVISHullCache.h"
 
 
 #if WITH_PHYSX
@@ -19,227 +21,160 @@
 struct FNAVISVolumeMath
 {
 private :
-	// typedef for more readability
-	typedef TPair<FVector,FVector> FSegment;
+	/** ToCore()	view an engine vector as a NAVIS_Core one */
+	static NAVISCore::FVec3 ToCore(const FVector &Vector)
+	{
+		return NAVISCore::FVec3(Vector.X, Vector.Y, Vector.Z);
+	}
 
+	/** ToCorePlane()	plane through a point, normalized for NAVIS_Core */
+	static NAVISCore::FPlane3 ToCorePlane(const FVector &PlaneRelativePosition, const FVector &PlaneNormal)
+	{
+		return NAVISCore::FPlane3::FromPointNormal(ToCore(PlaneRelativePosition), ToCore(PlaneNormal));
+	}
 
-	static float TetrahedronVolume(const FVector& p1, const FVector& p2, const FVector& p3 ,const FVector& p4) 
+	/** CopyWaterline()	move a waterline found by NAVIS_Core to engine vectors */
+	static void CopyWaterline(const std::vector<NAVISCore::FVec3> &Points, TArray<FVector> &OutWaterline)
 	{
-		return FVector::DotProduct(p1 - p4, FVector::CrossProduct(p2 - p4, p3 - p4)) / 6.0f;
+		OutWaterline.Reset(Points.size());
+		for (const NAVISCore::FVec3 &Point : Points)
+			OutWaterline.Add(FVector(Point.X, Point.Y, Point.Z));
 	}
 
 #if WITH_PHYSX
-	// GetPhysXConvexTruncatedVolume()	works for all convex meshes as all are using physx Convex mesh
-	static float GetPhysXConvexTruncatedVolume(physx::PxConvexMesh * convexMesh, const FPlane &cuttingPlane, const FVector& scale)
+	/**
+	 *	GetPhysXConvexTruncatedVolume()	works for all convex meshes as all are using physx Convex mesh
+	 *	@param OutWaterline				if not null, receives the polygon where the plane cuts the hull, counter clockwise around the plane normal
+	 *	@note							PhysX stores polygons, they are fanned into triangles for NAVIS_Core
+	 */
+	static float GetPhysXConvexTruncatedVolume(physx::PxConvexMesh * convexMesh, const FVector &PlaneRelativePosition, const FVector &PlaneNormal, const FVector& scale, TArray<FVector> * OutWaterline = nullptr)
 	{
-		float Volume = -1.0f;
-		
-		
-		if (convexMesh != NULL )
+		if (convexMesh == nullptr)
+			return -1.f;
+
+		// baked at cook time, or triangulated now
+		NAVISCore::FConvexHullView Hull;
+		TArray<uint32, TInlineAllocator<256>> Indices;
+		if (!FNAVISHullCache::Get().FindHull(convexMesh, Hull))
 		{
-			// Preparation for convex mesh scaling implemented in another changelist
-			FTransform ScaleTransform = FTransform(FQuat::Identity, FVector::ZeroVector, scale);
+			GetPhysXConvexIndices(convexMesh, Indices);
+			Hull = GetPhysXConvexView(convexMesh, Indices);
+		}
 
+		INC_DWORD_STAT(STAT_NAVIS_HullsProcessed);
+		INC_DWORD_STAT_BY(STAT_NAVIS_TrianglesClipped, Hull.NumTriangles);
 
-			int32 NumPolys = convexMesh->getNbPolygons();
-			PxHullPolygon PolyData;
+		std::vector<NAVISCore::FVec3> Waterline;
+		const NAVISCore::FPlane3 Plane = ToCorePlane(PlaneRelativePosition, PlaneNormal);
+		const float Volume = NAVISCore::ClipConvexVolume(Hull, Plane, ToCore(scale), OutWaterline ? &Waterline : nullptr);
+		NAVIS_CAPTURE_QUERY(Hull, Plane, ToCore(scale), Volume);
+		if (OutWaterline)
+			CopyWaterline(Waterline, *OutWaterline);
+		return Volume;
+	}
 
-			const PxVec3 *Vertices = convexMesh->getVertices();
-			const PxU8 *Indices = convexMesh->getIndexBuffer();
+	/**
+	 *	GetPhysXTriangleMeshTruncatedVolume()	Volume of a tri-mesh under a plane
+	 *	@note									only right for closed meshes, open ones give whatever their triangles enclose with the plane
+	 */
+	static float GetPhysXTriangleMeshTruncatedVolume(physx::PxTriangleMesh * triMesh, const FVector &PlaneRelativePosition, const FVector &PlaneNormal, const FVector& scale)
+	{
+		if (triMesh == nullptr)
+			return -1.f;
 
-			TArray<FVector>	AddedVertices;
-		
-			// extracting plane info
-			const FVector PlaneUp = FVector(cuttingPlane.X, cuttingPlane.Y, cuttingPlane.Z);
-			const float ratio = PlaneUp.Size() != 0.f ? PlaneUp.Size() : 1;
-			const FVector PlaneNormal = PlaneUp / ratio;
-			const FVector PlaneRelativePosition = (cuttingPlane.W / ratio) * PlaneNormal;
-			const FPlane Plane = FPlane(PlaneRelativePosition, PlaneNormal);
+		const int32 NumTriangles = triMesh->getNbTriangles();
+		TArray<uint32> Indices;
+		Indices.SetNumUninitialized(NumTriangles * 3);
+		if (triMesh->getTriangleMeshFlags() & PxTriangleMeshFlag::e16_BIT_INDICES)
+		{
+			const PxU16 * Triangles = static_cast<const PxU16*>(triMesh->getTriangles());
+			for (int32 Idx = 0; Idx < Indices.Num(); ++Idx)
+				Indices[Idx] = Triangles[Idx];
+		}
+		else
+		{
+			FMemory::Memcpy(Indices.GetData(), triMesh->getTriangles(), Indices.Num() * sizeof(uint32));
+		}
 
-			// finding object center on plane
-			auto bounds = convexMesh->getLocalBounds();
-			FVector Center = P2UVector(bounds.getCenter());
-			const FVector PlaneObjectCenter = FVector::PointPlaneProject(Center,Plane); 
-			
-			for (int32 PolyIdx = 0; PolyIdx < NumPolys; ++PolyIdx)
-			{
-				if (convexMesh->getPolygonData(PolyIdx, PolyData))
-				{
-					for (int32 VertIdx = 2; VertIdx < PolyData.mNbVerts; ++VertIdx)
-					{
-						// Grab triangle indices that we hit
-						int32 I0 = Indices[PolyData.mIndexBase + 0];
-						int32 I1 = Indices[PolyData.mIndexBase + (VertIdx - 1)];
-						int32 I2 = Indices[PolyData.mIndexBase + VertIdx];
-					
-						//
-						// We have to determine if our points are under our plane or not
-						auto IsUnderPlane = [&PlaneRelativePosition, &PlaneNormal](const FVector &Position) -> bool {
-							const FVector Orient = Position - PlaneRelativePosition;
-							return FVector::DotProduct(Orient, PlaneNormal) < 0;
-						};
+		NAVISCore::FConvexHullView Mesh;
+		Mesh.Vertices = reinterpret_cast<const NAVISCore::FVec3*>(triMesh->getVertices());
+		Mesh.NumVertices = triMesh->getNbVertices();
+		Mesh.Indices = Indices.GetData();
+		Mesh.NumTriangles = NumTriangles;
 
-						const FVector V0 = ScaleTransform.TransformPosition(P2UVector(Vertices[I0]));
-						const FVector V1 = ScaleTransform.TransformPosition(P2UVector(Vertices[I1]));
-						const FVector V2 = ScaleTransform.TransformPosition(P2UVector(Vertices[I2]));
-						const FVector V3 = ScaleTransform.TransformPosition(PlaneObjectCenter);
+		INC_DWORD_STAT(STAT_NAVIS_HullsProcessed);
+		INC_DWORD_STAT_BY(STAT_NAVIS_TrianglesClipped, NumTriangles);
+		// the winding of cooked tri-meshes depends on the cooking, only the size matters here
+		const NAVISCore::FPlane3 Plane = ToCorePlane(PlaneRelativePosition, PlaneNormal);
+		const float Volume = NAVISCore::ClipConvexVolume(Mesh, Plane, ToCore(scale));
+		NAVIS_CAPTURE_QUERY(Mesh, Plane, ToCore(scale), Volume);
+		return FMath::Abs(Volume);
+	}
+#endif // WITH_PHYSX
 	
-						const bool I0UnderPlane = IsUnderPlane(V0);
-						const bool I1UnderPlane = IsUnderPlane(V1);
-						const bool I2UnderPlane = IsUnderPlane(V2);
-
-						//
-						// We have four possibilities :
-
-						//
-						// Case 0 : All points are over the plane :
-						if (!I0UnderPlane && !I1UnderPlane && !I2UnderPlane)
-						{
-							continue; // ignore those points
-						}
-						//
-						// Case 1 : All points are below the plane :
-						if (I0UnderPlane && I1UnderPlane && I2UnderPlane)
-						{
-							Volume += TetrahedronVolume(V0,V1,V2,V3);
-							continue;
-						}
-						//
-						// Case 2 : at least one point is under the plane :
-						if(I0UnderPlane || I1UnderPlane || I2UnderPlane)
-						{
-							auto Intersection = [&PlaneRelativePosition, &PlaneNormal](const FVector &A, const FVector &B) -> FVector {
-								const FVector Segment = B - A;
-								if (Segment.Size() == 0)
-									return A;
-								const FVector NSegment = Segment.GetUnsafeNormal();
-								const FVector PlaneToA = A - PlaneRelativePosition;
-								const float S = FVector::DotProduct(PlaneNormal, PlaneToA) / FVector::DotProduct(PlaneNormal, NSegment);
-								return NSegment * S;
-							};
-
-							// we will always have two cuts
-							FVector CutA, CutB;
+public:
 
-							auto AddVertices = [&AddedVertices](FVector &A, FVector &B) {
-								AddedVertices.AddUnique(A);
-								AddedVertices.AddUnique(B);
-								};
+#if WITH_PHYSX
+	/**
+	 *	GetPhysXConvexIndices()	fan the polygons of a PhysX convex mesh into triangles, three indices each
+	 *	@see FNAVISHullCache, that keeps them from the cook
+	 */
+	template<typename AllocatorType>
+	static void GetPhysXConvexIndices(const physx::PxConvexMesh * convexMesh, TArray<uint32, AllocatorType> &OutIndices)
+	{
+		const PxU8 *PolyIndices = convexMesh->getIndexBuffer();
+		const int32 NumPolys = convexMesh->getNbPolygons();
+		PxHullPolygon PolyData;
 
-	
-							if ((I0UnderPlane && (!I1UnderPlane && !I2UnderPlane)) || (I1UnderPlane && I2UnderPlane && !I0UnderPlane))
-							{
-								CutA = Intersection(V0, V1);
-								CutB = Intersection(V0, V2);
-								if (I0UnderPlane)
-								{
-									AddVertices(CutA, CutB);
-									Volume += TetrahedronVolume(V0, CutA, CutB, V3);
-								}
-								else // neg alpha
-								{
-									AddVertices(CutB, CutA);
-									Volume += TetrahedronVolume(V1, V2, CutA, V3);
-									Volume += TetrahedronVolume(CutA, V2, CutB, V3);
-								}
-							}
-							
-							else if ((I1UnderPlane && (!I0UnderPlane && !I2UnderPlane)) || (I0UnderPlane && I2UnderPlane && !I1UnderPlane))
-							{
-								CutA = Intersection(V1, V0);
-								CutB = Intersection(V1, V2);
-								if (I1UnderPlane)
-								{
-									AddVertices(CutB, CutA);
-									Volume += TetrahedronVolume(CutA, V1, CutB, V3);
-								}
-								else // neg beta
-								{
-									AddVertices(CutA, CutB);
-									Volume += TetrahedronVolume(V0, CutA, V2, V3);
-									Volume += TetrahedronVolume(CutA, CutB, V2, V3);
-								}
-							}
-							else if ((I2UnderPlane && (!I0UnderPlane && !I1UnderPlane)) || (I1UnderPlane && I0UnderPlane && !I2UnderPlane))
-							{
-								CutA = Intersection(V2, V0);
-								CutB = Intersection(V2, V1);
-								if (I2UnderPlane)
-								{
-									AddVertices(CutA, CutB);
-									Volume += TetrahedronVolume(CutA, CutB, V2, V3);
-								}
-								else // neg gamma
-								{
-									AddVertices(CutA, CutB);
-									Volume += TetrahedronVolume(V0, V1, CutB, V3);
-									Volume += TetrahedronVolume(V0, CutB, CutA, V3);
-								}
-							}
-							else
-							{
-								UE_LOG(LogNAVIS_Physics, Error, TEXT("wrong cut, not possible"));
-								Volume += TetrahedronVolume(V0,V1,V2,V3);
-								continue;
-							}
-						}
+		OutIndices.Reset();
+		for (int32 PolyIdx = 0; PolyIdx < NumPolys; ++PolyIdx)
+		{
+			if (!convexMesh->getPolygonData(PolyIdx, PolyData))
+				continue;
+			for (int32 VertIdx = 2; VertIdx < PolyData.mNbVerts; ++VertIdx)
+			{
+				OutIndices.Add(PolyIndices[PolyData.mIndexBase + 0]);
+				OutIndices.Add(PolyIndices[PolyData.mIndexBase + (VertIdx - 1)]);
+				OutIndices.Add(PolyIndices[PolyData.mIndexBase + VertIdx]);
+			}
+		}
+	}
 
-					} // end of for (int32 VertIdx = 2; VertIdx < PolyData.mNbVerts; ++ VertIdx)
-				} // if (ConvexMesh->getPolygonData(PolyIdx, PolyData))
-			} // for (int32 PolyIdx = 0; PolyIdx < NumPolys; ++PolyIdx)
-		} // if (ConvexMesh != NULL )
-		return Volume;
+	/** GetPhysXConvexView()	the vertices of a PhysX convex mesh, with triangles from @see GetPhysXConvexIndices() */
+	template<typename AllocatorType>
+	static NAVISCore::FConvexHullView GetPhysXConvexView(const physx::PxConvexMesh * convexMesh, const TArray<uint32, AllocatorType> &Indices)
+	{
+		// PxVec3 is three floats, like NAVISCore::FVec3
+		static_assert(sizeof(PxVec3) == sizeof(NAVISCore::FVec3), "PxVec3 cannot be viewed as NAVISCore::FVec3");
+		NAVISCore::FConvexHullView Hull;
+		Hull.Vertices = reinterpret_cast<const NAVISCore::FVec3*>(convexMesh->getVertices());
+		Hull.NumVertices = convexMesh->getNbVertices();
+		Hull.Indices = Indices.GetData();
+		Hull.NumTriangles = Indices.Num() / 3;
+		return Hull;
 	}
 #endif // WITH_PHYSX
-	
-public:
-	
+
 	/** 
 	 *	GetConvexTruncatedVolume Calculate volume of a Convex element (of a body setup for example) when cut by a plane  
 	 */
-	static float GetConvexTruncatedVolume(const FKConvexElem &ConvexElement, const FVector &PlaneRelativePosition, const FVector &PlaneNormal, const FVector& Scale)
+	static float GetConvexTruncatedVolume(const FKConvexElem &ConvexElement, const FVector &PlaneRelativePosition, const FVector &PlaneNormal, const FVector& Scale, TArray<FVector> * OutWaterline = nullptr)
 	{	
 	#if WITH_PHYSX
 		auto pxConvex = ConvexElement.GetConvexMesh();
-		return GetPhysXConvexTruncatedVolume(pxConvex, FPlane(PlaneRelativePosition, PlaneNormal), Scale);
+		return GetPhysXConvexTruncatedVolume(pxConvex, PlaneRelativePosition, PlaneNormal, Scale, OutWaterline);
 	#endif // WITH_PHYSX
 		return -1.f;
 	}
 
 	/** 
-	 *	GetSphylTruncatedVolume Calculate volume of a sphyl element (of a body setup for example) when cut by a plane
+	 *	GetSphereTruncatedVolume Calculate volume of a sphere element (of a body setup for example) when cut by a plane
 	 *	@see https://en.wikipedia.org/wiki/Spherical_cap
 	 */
 	static float GetSphereTruncatedVolume(const FKSphereElem &SphereElement, const FVector &PlaneRelativePosition, const FVector &PlaneNormal, const FVector& Scale)
 	{
-		float Volume = 0.f;
-
-
 		const float Radius = SphereElement.Radius * Scale.GetMin();
-		
-		//we first need to se ethe sphere in the Plane local space
-		const FVector NormalizedPlaneNormal =  PlaneNormal.GetSafeNormal();
-		const FRotator PlaneOrientation =  UKismetMathLibrary::MakeRotFromZ(NormalizedPlaneNormal);
-		// get the plane transform
-		const FTransform PlaneTrans = FTransform(PlaneOrientation, PlaneRelativePosition, FVector::OneVector);
-		
-		// get the sphere location compared to the plane
-		const FVector RelPos = PlaneTrans.InverseTransformPosition(SphereElement.Center);
-
-		// completely over 
-		if(RelPos.Z >= Radius )
-			return Volume;
-
-		// completely under
-		if(RelPos.Z <= Radius )
-			return SphereElement.GetVolume(Scale);
-		
-		const float height = (Radius - RelPos.Z);
-		// Volume of a sphere  :  {  4 / 3 * PI * FMath::Pow(Radius * Scale.GetMin(), 3); }
-		// Volume of a truncated sphere = (pi * h^2 /3) (3 * r - h)
-		Volume =  (PI * FMath::Pow(height, 2) / 3) * ((3 * Radius) - height) ;
-
-		return Volume;	
+		return NAVISCore::SphereTruncatedVolume(ToCore(SphereElement.Center * Scale), Radius, ToCorePlane(PlaneRelativePosition, PlaneNormal));
 	}
 	
 	/** 
@@ -247,8 +182,11 @@ public:
 	 */
 	static float GetSphylTruncatedVolume(const FKSphylElem &SphylElement, const FVector &PlaneRelativePosition, const FVector &PlaneNormal, const FVector& Scale)
 	{
-		UE_LOG(LogNAVIS_Physics, Error, TEXT("Sphyl not implemented"));
-		return 0.f;
+		// sphyls are along their Z axis
+		const FVector HalfAxis = SphylElement.Rotation.Quaternion().GetAxisZ() * (SphylElement.Length * 0.5f * Scale.Z);
+		const FVector Center = SphylElement.Center * Scale;
+		const float Radius = SphylElement.Radius * FMath::Min(Scale.X, Scale.Y);
+		return NAVISCore::CapsuleTruncatedVolume(ToCore(Center - HalfAxis), ToCore(Center + HalfAxis), Radius, ToCorePlane(PlaneRelativePosition, PlaneNormal));
 	}
 
 	/** 
@@ -262,32 +200,23 @@ public:
 	
 	/** 
 	 *	GetBoxTruncatedVolume Calculate volume of a box element (of a body setup for example) when cut by a plane  
-	 *	https://math.stackexchange.com/a/455711
 	 */
 	static float GetBoxTruncatedVolume(const FKBoxElem &BoxElement, const FVector &PlaneRelativePosition, const FVector &PlaneNormal, const FVector& Scale)
 	{
-		UE_LOG(LogNAVIS_Physics, Error, TEXT("box not implemented"));
-#if 0
-		// first find a scale that turn the cuboid into a real cube :
-		const FVector BoxScale = FVector(BoxElement.X, BoxElement.Y, BoxElement.Z);
-
-		// we consider the box in 0.0; with extend only in the positive 
-		FVector BoxDimension = FVector(BoxElement.X * 2, BoxElement.Y * 2, BoxElement.Z * 2);
-		const FVector PlaneBoxPos = PlaneRelativePosition - BoxScale;
-		//const float Alpha = 
-		const FVector NormalizedPlaneNormal = PlaneNormal.GetSafeNormal();
-		// now we can work in a 1:1:1 scale for the plane 
-		const FTransform PlaneTransform = FTransform(UKismetMathLibrary::MakeRotFromZ(NormalizedPlaneNormal), PlaneBoxPos,  BoxScale);
-		const float Volume = 0.f;
-#endif
-		return 0.f;
+		const FQuat Rotation = BoxElement.Rotation.Quaternion();
+		const NAVISCore::FVec3 Axes[3] = { ToCore(Rotation.GetAxisX()), ToCore(Rotation.GetAxisY()), ToCore(Rotation.GetAxisZ()) };
+		const FVector Extent = FVector(BoxElement.X, BoxElement.Y, BoxElement.Z) * Scale * 0.5f;
+		return NAVISCore::BoxTruncatedVolume(ToCore(BoxElement.Center * Scale), Axes, ToCore(Extent), ToCorePlane(PlaneRelativePosition, PlaneNormal));
 	}
 
 	/** 
 	 *	GetPhysicsTruncatedVolume Calculate volume of a Physx element (of a body instance most likely) when cut by a plane  
+	 *	@param OutWaterline		if not null, receives the polygon where the plane cuts the element. Only convex elements fill it
 	 */
-	static float GetPhysicsTruncatedVolume(FPhysicsShapeHandle &PhysXElement, const FVector &PlaneRelativePosition, const FVector &PlaneNormal, const FVector& Scale )
+	static float GetPhysicsTruncatedVolume(FPhysicsShapeHandle &PhysXElement, const FVector &PlaneRelativePosition, const FVector &PlaneNormal, const FVector& Scale, TArray<FVector> * OutWaterline = nullptr)
 	{
+		SCOPE_CYCLE_COUNTER(STAT_NAVIS_Clipping);
+
 		float Volume = 0.f;
 	#if WITH_PHYSX
 
@@ -298,17 +227,23 @@ public:
 		switch(Type)
 		{
 			case physx::PxGeometryType::eCAPSULE 		:
-			UE_LOG(LogNAVIS_Physics, Error, TEXT("GetPhysxTruncatedVolume : PhysX PxCapsuleGeometry direct calculation not implemented"));
 			{
+				// PhysX capsules are along their X axis
 				physx::PxCapsuleGeometry Capsule;
 				PhysXElement.Shape->getCapsuleGeometry(Capsule);
+				const FTransform Pose = P2UTransform(PhysXElement.Shape->getLocalPose());
+				const FVector HalfAxis = Pose.GetUnitAxis(EAxis::X) * Capsule.halfHeight * Scale;
+				const FVector Center = Pose.GetLocation() * Scale;
+				Volume = NAVISCore::CapsuleTruncatedVolume(ToCore(Center - HalfAxis), ToCore(Center + HalfAxis), Capsule.radius * Scale.GetMin(), ToCorePlane(PlaneRelativePosition, PlaneNormal));
 			}
 			break;
 			case physx::PxGeometryType::eBOX	 		:
-			UE_LOG(LogNAVIS_Physics, Error, TEXT("GetPhysxTruncatedVolume : PhysX PxBoxGeometry direct calculation not implemented"));
 			{
 				physx::PxBoxGeometry Box;
 				PhysXElement.Shape->getBoxGeometry(Box);
+				const FTransform Pose = P2UTransform(PhysXElement.Shape->getLocalPose());
+				const NAVISCore::FVec3 Axes[3] = { ToCore(Pose.GetUnitAxis(EAxis::X)), ToCore(Pose.GetUnitAxis(EAxis::Y)), ToCore(Pose.GetUnitAxis(EAxis::Z)) };
+				Volume = NAVISCore::BoxTruncatedVolume(ToCore(Pose.GetLocation() * Scale), Axes, ToCore(P2UVector(Box.halfExtents) * Scale), ToCorePlane(PlaneRelativePosition, PlaneNormal));
 			}
 			break;
 			case physx::PxGeometryType::eCONVEXMESH	:
@@ -317,20 +252,30 @@ public:
 				PhysXElement.Shape->getConvexMeshGeometry(Convex);
 				if(Convex.isValid() && Convex.convexMesh)
 				{
-					Volume = GetPhysXConvexTruncatedVolume(Convex.convexMesh, FPlane(PlaneRelativePosition, PlaneNormal), Scale);
+					Volume = GetPhysXConvexTruncatedVolume(Convex.convexMesh, PlaneRelativePosition, PlaneNormal, Scale * P2UVector(Convex.scale.scale), OutWaterline);
 				}
 			}
 			break;
 			case physx::PxGeometryType::eSPHERE			:	
-			UE_LOG(LogNAVIS_Physics, Error, TEXT("GetPhysxTruncatedVolume : PhysX PxSphereGeometry direct calculation not implemented"));
 			{
 				physx::PxSphereGeometry Sphere;
 				PhysXElement.Shape->getSphereGeometry(Sphere);
+				const FVector Center = P2UVector(PhysXElement.Shape->getLocalPose().p) * Scale;
+				Volume = NAVISCore::SphereTruncatedVolume(ToCore(Center), Sphere.radius * Scale.GetMin(), ToCorePlane(PlaneRelativePosition, PlaneNormal));
+			}
+			break;
+			case physx::PxGeometryType::eTRIANGLEMESH	:
+			{
+				physx::PxTriangleMeshGeometry TriMesh;
+				PhysXElement.Shape->getTriangleMeshGeometry(TriMesh);
+				if(TriMesh.isValid() && TriMesh.triangleMesh)
+				{
+					Volume = GetPhysXTriangleMeshTruncatedVolume(TriMesh.triangleMesh, PlaneRelativePosition, PlaneNormal, Scale * P2UVector(TriMesh.scale.scale));
+				}
 			}
 			break;
 			case physx::PxGeometryType::eHEIGHTFIELD	:
 			case physx::PxGeometryType::ePLANE			:
-			case physx::PxGeometryType::eTRIANGLEMESH	:
 			default :
 			UE_LOG(LogNAVIS_Physics, Error, TEXT("GetPhysxTruncatedVolume : PhysX Extra cases direct calculation not implemented"));
 			break;
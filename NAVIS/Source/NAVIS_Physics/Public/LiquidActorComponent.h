@@ -1,17 +1,70 @@
 #pragma once
 
 #include "Components/ActorComponent.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Async/Future.h"
+#include "Engine/EngineTypes.h"
 #include "NAVISPlane.h"
 #include "LiquidActorComponent.generated.h"
 
+class ULiquidActorComponent;
+class USceneComponent;
 
 /**
- *  NAVIS_PHYSICS - minimalAPI
+ *  NAVIS_PHYSICS
+ *  FLiquidQueryHandle
+ *	Points submitted together with @see ULiquidActorComponent::SubmitQuery(), to get their surface locations back
+ */
+struct FLiquidQueryHandle
+{
+	/** Batch	launch the points belong to, 0 for none */
+	uint32 Batch = 0;
+
+	/** Index	submission in that batch */
+	int32 Index = INDEX_NONE;
+
+	bool IsValid() const { return Batch != 0; }
+};
+
+/**
+ *  NAVIS_PHYSICS
+ *	FLiquidQueryTickFunction
+ *  Publishes the queries resolved on worker threads, late in the frame
+ */
+USTRUCT()
+struct FLiquidQueryTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	/** Target	the component that launched the queries */
+	ULiquidActorComponent * Target = nullptr;
+
+	//~ Begin FTickFunction Interface.
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+	//~ End FTickFunction Interface.
+};
+
+template<>
+struct TStructOpsTypeTraits<FLiquidQueryTickFunction> : public TStructOpsTypeTraitsBase2<FLiquidQueryTickFunction>
+{
+	enum { WithCopy = false };
+};
+
+/**
+ *  NAVIS_PHYSICS
  *  ULiquidActorComponent
  *	UActorComonent class that handle waves, forces call etc...
+ *
+ *	Surface queries can be batched : every system submits its points during the frame with @see SubmitQuery(),
+ *	the points are resolved together on worker threads from TG_PostPhysics to TG_PostUpdateWork,
+ *	and @see GetQueryResults() returns them the next frame. Results are double buffered, the ones of the last batch
+ *	stay readable while the next one is resolved.
+ *
+ *	Each liquid registers its bounds in the @see FLiquidVolumeTree of its world, to be found from a location.
  */
-UCLASS(minimalAPI)
-class ULiquidActorComponent : public UActorComponent
+UCLASS()
+class NAVIS_PHYSICS_API ULiquidActorComponent : public UActorComponent
 {
     GENERATED_BODY()
 public:
@@ -21,7 +74,53 @@ public:
 	 */
 	ULiquidActorComponent(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 
-  
+	//~ Begin UActorComponent Interface.
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+	virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
+	virtual void RegisterComponentTickFunctions(bool bRegister) override;
+	//~ End UActorComponent Interface.
+
+	/** Priority	where liquid volumes overlap, the highest priority governs. Equal ones leave it to the smallest volume */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Liquid")
+	int32 Priority;
+
+	/** Density		of the liquid, pure water has a value of 1 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Liquid", meta = (ClampMin = "0"))
+	float Density;
+
+	/**
+	 *	LiquidExtent	half size along X and Y, and depth along Z, of the liquid under the surface of the owner
+	 *	@see			GetLiquidBounds()
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Liquid", meta = (ClampMin = "0"))
+	FVector LiquidExtent;
+
+	/**
+	 * 	SetLiquidExtent()		change @see LiquidExtent and register the new bounds
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Liquid")
+	void SetLiquidExtent(const FVector &newExtent);
+
+	/**
+	 * 	GetLiquidBounds()		world space box where this liquid governs
+	 *	@note					@see LiquidExtent under the owner location, turned with the owner. Other components of the owner do not count
+	 */
+	virtual FBox GetLiquidBounds() const;
+
+	/**
+	 * 	UpdateLiquidBounds()	register @see GetLiquidBounds() again in the tree of the world
+	 *	@note					done when the owner moves, owners that resize have to call it
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Liquid")
+	void UpdateLiquidBounds();
+
+	/**
+	 * 	GetLiquidSurfaceAt()	Surface plane and density of this liquid at a location
+	 *	@param location			the plane goes through the surface location under it
+	 */
+	virtual FLiquidSurface GetLiquidSurfaceAt(const FVector &location) const;
+
 	/**
 	 * 	GetSurfaceNormal()			Gets the global surface normal unaffected by surface variations (ie Waves)
 	 */
@@ -31,18 +130,102 @@ public:
 	 * 	GetLocalSurfaceNormal()			Gets the surface normal affected by surface variations (ie Waves)
 	 */
     virtual FVector GetLocalSurfaceNormal() const;
-    
+
     /**
-	 * 	GetSurfaceLocationUnderPoint()	Calculate Force applied to a component when put in water
+	 * 	GetSurfaceLocationUnderPoint()	Project a point onto the liquid surface, along the surface normal
 	 *	@param traceOrigin  			Position of a point above (or inside) liquid that you want to project onto the liquid surface
-	 * 	@param surfaceNormal			the normal you use for projection, defaults to GetSurfaceNormal();
 	 */
     virtual FVector GetSurfaceLocationUnderPoint(FVector traceOrigin) const;
-    
+
+    /**
+	 * 	GetSurfaceLocationsUnderPoints()	Batched @see GetSurfaceLocationUnderPoint()
+	 *	@param points  						Positions to project onto the liquid surface
+	 *	@param outLocations					receives the projection of each point, same size as points
+	 *	@note								game thread, the batched queries go through @see ResolveQueries()
+	 */
+    virtual void GetSurfaceLocationsUnderPoints(TArrayView<const FVector> points, TArrayView<FVector> outLocations) const;
+
+    /**
+	 * 	SubmitQuery()			Queue points to project onto the surface, resolved with the others of this frame
+	 *	@param points  			Positions to project, copied
+	 *	@return					the handle to get the results with @see GetQueryResults(), the next frame
+	 *	@note					game thread only. Points submitted after this component ticked in TG_PostPhysics wait for the next batch
+	 */
+    FLiquidQueryHandle SubmitQuery(const TArray<FVector> &points);
+
+    /**
+	 * 	GetQueryResults()		Surface locations of submitted points
+	 *	@param handle  			what @see SubmitQuery() returned
+	 *	@param outLocations		receives a location per submitted point
+	 *	@param bSynchronousFallback	resolve the points right now if their batch is not published yet
+	 *	@return					false if the results are not ready, or were replaced by a newer batch
+	 */
+    bool GetQueryResults(const FLiquidQueryHandle &handle, TArray<FVector> &outLocations, bool bSynchronousFallback = false) const;
+
+protected:
+
+	/**
+	 * 	SnapshotQueries()		copy what @see ResolveQueries() reads, on the game thread right before a batch launches
+	 *	@note					overrides call the parent, the game thread may change anything not copied while the workers run
+	 */
+	virtual void SnapshotQueries();
+
+	/**
+	 * 	ResolveQueries()		@see GetSurfaceLocationsUnderPoints() for a batch, on worker threads
+	 *	@note					may only read what @see SnapshotQueries() copied
+	 */
+	virtual void ResolveQueries(TArrayView<const FVector> points, TArrayView<FVector> outLocations) const;
+
+	/** LaunchQueries()		resolve the submitted points on worker threads, from TickComponent() */
+	void LaunchQueries();
+
+	/** PublishQueries()	wait for the worker threads and swap their results in, from @see QueryPublishTick */
+	void PublishQueries();
+
+	/**
+	 *	QueryPublishTick	ticks in TG_PostUpdateWork, after this component
+	 *	@note				both only tick while there is work : this component once points are submitted, this one once they launched
+	 */
+	FLiquidQueryTickFunction QueryPublishTick;
+
+	friend struct FLiquidQueryTickFunction;
 
 private:
 
+	/** OnOwnerTransformUpdated()	the surface and bounds follow the root of the owner */
+	void OnOwnerTransformUpdated(USceneComponent * updatedComponent, EUpdateTransformFlags updateTransformFlags, ETeleportType teleport);
+
+	/** OwnerTransformHandle	binding to the root of the owner, while registered */
+	FDelegateHandle OwnerTransformHandle;
+	TWeakObjectPtr<USceneComponent> OwnerRoot;
+
 	UPROPERTY()
     FLiquidSurface LiquidSurface;
 
-};
\ No newline at end of file
+	/** QuerySurface	@see LiquidSurface when the batch in flight launched */
+	FLiquidSurface QuerySurface;
+
+	/** FQueryBatch	points submitted in one frame, and their results */
+	struct FQueryBatch
+	{
+		uint32 Serial = 0;
+		TArray<FVector> Points;
+		TArray<FVector> Locations;
+
+		/** first point of each submission */
+		TArray<int32> Offsets;
+
+		/** GetRange()	points of a submission, @return false if there is no such submission */
+		bool GetRange(int32 Index, int32 &OutBegin, int32 &OutNum) const;
+
+		void Reset(uint32 NewSerial);
+	};
+
+	/** filled by @see SubmitQuery(), resolved by the worker threads, then read : the three are swapped rather than copied */
+	FQueryBatch PendingQueries;
+	FQueryBatch InFlightQueries;
+	FQueryBatch ReadyQueries;
+
+	TFuture<void> InFlightTask;
+	uint32 NextBatchSerial;
+};
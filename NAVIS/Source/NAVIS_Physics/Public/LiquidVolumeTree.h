@@ -0,0 +1,105 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeRWLock.h"
+
+class UWorld;
+class ULiquidActorComponent;
+
+/**
+ *  NAVIS_PHYSICS
+ *  FLiquidVolumeTree
+ *	Bounding volume hierarchy of the liquids of a world, to find the one governing a point without testing them all.
+ *
+ *	Every @see ULiquidActorComponent registers its bounds here, and updates them when its owner moves or resizes.
+ *	Changes only mark the tree dirty : it is rebuilt by the next query, in O(n log n) for a handful of volumes,
+ *	and queries then go down the tree in O(log n).
+ *	Where volumes overlap, the highest @see ULiquidActorComponent::Priority wins, then the smallest volume :
+ *	a harbour basin placed in the sea governs the points inside it.
+ *	@note	changes on the game thread only, queries from any thread. A liquid leaves the tree when it unregisters,
+ *			on the game thread : a liquid returned to another thread may only be used while the game thread waits for it
+ */
+class NAVIS_PHYSICS_API FLiquidVolumeTree
+{
+public:
+
+	/**
+	 * 	Get()			tree of a world, created on first use and deleted when the world is cleaned up
+	 *	@return			nullptr without a world
+	 */
+	static FLiquidVolumeTree * Get(const UWorld * World);
+
+	/** Find()		like @see Get(), without creating the tree */
+	static FLiquidVolumeTree * Find(const UWorld * World);
+
+	/**
+	 * 	Update()		add a liquid, or change its bounds and priority
+	 *	@param Bounds	world space box the liquid governs, a liquid with an invalid box is removed
+	 */
+	void Update(const ULiquidActorComponent * Liquid, const FBox &Bounds, int32 Priority);
+
+	/** Remove()	forget a liquid, nothing happens if it was not added */
+	void Remove(const ULiquidActorComponent * Liquid);
+
+	/**
+	 * 	FindAtLocation()	liquid governing a point
+	 *	@return				nullptr if the point is in no liquid volume
+	 */
+	ULiquidActorComponent * FindAtLocation(const FVector &Location) const;
+
+	/**
+	 * 	FindInBox()			every liquid whose volume overlaps a box, highest priority first
+	 *	@param outLiquids	emptied first
+	 */
+	void FindInBox(const FBox &Box, TArray<ULiquidActorComponent*> &outLiquids) const;
+
+	/** Num()	liquids in this tree */
+	int32 Num() const;
+
+private:
+
+	/**
+	 *	FVolume		what a liquid registered
+	 *	@note		a raw pointer : a weak one can only be resolved on the game thread, and liquids are removed there
+	 */
+	struct FVolume
+	{
+		ULiquidActorComponent * Liquid;
+		FBox	Bounds;
+		int32	Priority;
+	};
+
+	/** FNode		inner nodes have two children, leaves a range of @see Order */
+	struct FNode
+	{
+		FBox	Bounds;
+		int32	Children[2];
+		int32	Begin;
+		int32	Num;
+
+		bool IsLeaf() const { return Children[0] == INDEX_NONE; }
+	};
+
+	/** Build()		top down, splitting the centers at the median of their longest axis. Called with the write lock */
+	void Build() const;
+	int32 BuildNode(int32 Begin, int32 Num) const;
+
+	/** Query()		call Func on every volume passing Test, after walking the nodes passing it too */
+	template<typename TestType, typename FuncType>
+	void Query(const TestType &Test, const FuncType &Func) const;
+
+	/** OnWorldCleanup()	delete the tree of a world going away */
+	static void OnWorldCleanup(UWorld * World, bool bSessionEnded, bool bCleanupResources);
+
+	TArray<FVolume> Volumes;
+	TMap<const ULiquidActorComponent*, int32> VolumeIndices;
+
+	/** the tree over @see Volumes, rebuilt when dirty */
+	mutable TArray<FNode> Nodes;
+	mutable TArray<int32> Order;
+	mutable bool bDirty = false;
+
+	mutable FRWLock Lock;
+};
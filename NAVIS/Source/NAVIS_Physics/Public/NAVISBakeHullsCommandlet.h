@@ -0,0 +1,30 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "NAVISBakeHullsCommandlet.generated.h"
+
+/**
+ *  NAVIS_PHYSICS
+ *	UNAVISBakeHullsCommandlet
+ *  Triangulates the convex hulls of every static mesh and writes them to the hull cache the cooked game maps in memory.
+ *  Each body goes through the derived data cache : only new or changed meshes are triangulated again.
+ *  Run it before cooking, the cache is staged as a loose file by DefaultGame.ini.
+ *
+ *  UE4Editor-Cmd NAVIS.uproject -run=NAVISBakeHulls [-Paths=/Game/Ships+/Game/Props]
+ */
+UCLASS()
+class NAVIS_PHYSICS_API UNAVISBakeHullsCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+
+	/** UNAVISBakeHullsCommandlet   constructor  */
+	UNAVISBakeHullsCommandlet();
+
+	//~ Begin UCommandlet Interface.
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface.
+};
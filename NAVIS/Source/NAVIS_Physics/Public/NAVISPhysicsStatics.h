@@ -9,6 +9,28 @@
 // forward declarations
 class UBodySetup;
 class AActor;
+class ULiquidActorComponent;
+
+/**
+ *  NAVIS_PHYSICS
+ *  FNAVISWaterline
+ *	Polygon where a liquid surface cuts one convex element of a body
+ */
+USTRUCT(BlueprintType)
+struct NAVIS_PHYSICS_API FNAVISWaterline
+{
+	GENERATED_BODY()
+
+	/** Points		ordered around the surface normal, in world space */
+	UPROPERTY(BlueprintReadOnly)
+	TArray<FVector> Points;
+
+	/** GetCentroid()	average of the points */
+	FVector GetCentroid() const;
+
+	/** GetPerimeter()	length of the closed polygon */
+	float GetPerimeter() const;
+};
 
 /**
  *  NAVIS_PHYSICS
@@ -94,19 +116,33 @@ public:
 	/**
 	 * 	GetBodySetupVolumeAtLevel()		Calculate Volume for a body setup when cut by a plane (like a sea level)
 	 * 	@param in						The body setup to consider.
- 	 *	@param relativePlane			Plane made of a position of a point of the plane in relative space and its normal
+ 	 *	@param relativePlane			Plane made of a position of a point of the plane in relative space and its normal,
+	 *									relative space being the component without its scale, @see FNavisPlane::GetLocalPosition()
+	 *	@param scale					scale of the component, applied to the elements of the body setup
 	 */
 	UFUNCTION()
-	static float GetBodySetupVolumeAtLevel(const UBodySetup *in, const FNavisPlane &relativePlane);
+	static float GetBodySetupVolumeAtLevel(const UBodySetup *in, const FNavisPlane &relativePlane, const FVector &scale);
 
 	/**
 	 * 	GetBodyInstanceVolumeAtLevel()	Calculate Volume for a body setup when cut by a plane (like a sea level)
 	 * 	@param in						The body Instance to consider.
- 	 *	@param relativePlane			Plane made of a position of a point of the plane in relative space and its normal
+ 	 *	@param relativePlane			Plane made of a position of a point of the plane in relative space and its normal,
+	 *									relative space being the component without its scale, where the shapes of the body are already scaled
 	 */
 	UFUNCTION()
 	static float GetBodyInstanceVolumeAtLevel(const FBodyInstance &in, const FNavisPlane &relativePlane);
 
+	/**
+	 * 	GetPrimitiveWaterline()			Polygons where a plane (like a sea level) cuts each convex element of a component
+	 * 	@param in						the component to cut
+	 *	@param worldPlane				Plane made of a position of a point of the plane in world space and its normal
+	 *	@param outWaterlines			one entry per convex element crossing the plane
+	 *	@return							true if at least one element crosses the plane
+	 *	@note							computed by the same pass as the submerged volume, for foam and wakes
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Volume")
+	static bool GetPrimitiveWaterline(const UPrimitiveComponent *in, const FNavisPlane &worldPlane, TArray<FNAVISWaterline> &outWaterlines);
+
 	/**
 	 * 	GetArchimedesForce()			Calculate Force applied to a component when put in water
 	 * 	@param in						The component in Water
@@ -115,4 +151,31 @@ public:
 	 */
 	UFUNCTION(BlueprintPure, Category = "Force")
 	static FVector GetArchimedesForce(const UPrimitiveComponent *solid, const FLiquidSurface &liquidWorldPlane);
+
+	/**
+	 * 	FindLiquidAtLocation()			Liquid governing a location, from the liquid volume tree of the world
+	 * 	@param WorldContextObject		valid object in a valid world context
+	 *	@return							nullptr if the location is in no liquid volume
+	 *	@see							FLiquidVolumeTree
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Liquid", meta = (WorldContext = "WorldContextObject"))
+	static ULiquidActorComponent * FindLiquidAtLocation(const UObject *WorldContextObject, const FVector &location);
+
+	/**
+	 * 	GetLiquidSurfaceAtLocation()	Surface and density of the liquid governing a location
+	 * 	@param WorldContextObject		valid object in a valid world context
+	 *	@param outSurface				surface plane under the location, with the density of its liquid
+	 *	@return							false if the location is in no liquid volume
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Liquid", meta = (WorldContext = "WorldContextObject"))
+	static bool GetLiquidSurfaceAtLocation(const UObject *WorldContextObject, const FVector &location, FLiquidSurface &outSurface);
+
+	/**
+	 * 	FindLiquidsInBox()				Every liquid whose volume overlaps a box, like the bounds of a hull across a harbour entrance
+	 * 	@param WorldContextObject		valid object in a valid world context
+	 *	@param outLiquids				the liquids, the one governing first
+	 *	@return							false if the box is in no liquid volume
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Liquid", meta = (WorldContext = "WorldContextObject"))
+	static bool FindLiquidsInBox(const UObject *WorldContextObject, const FBox &box, TArray<ULiquidActorComponent*> &outLiquids);
 };
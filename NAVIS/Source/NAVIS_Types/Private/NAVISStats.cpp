@@ -0,0 +1,15 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "NAVISStats.h"
+#include "NAVIS_TypesPCH.h"
+
+DEFINE_STAT(STAT_NAVIS_ShapeGathering);
+DEFINE_STAT(STAT_NAVIS_Clipping);
+DEFINE_STAT(STAT_NAVIS_ForceApplication);
+DEFINE_STAT(STAT_NAVIS_HullsProcessed);
+DEFINE_STAT(STAT_NAVIS_TrianglesClipped);
+DEFINE_STAT(STAT_NAVIS_WaveEvaluation);
+DEFINE_STAT(STAT_NAVIS_MeshUpdate);
+DEFINE_STAT(STAT_NAVIS_CacheHits);
+DEFINE_STAT(STAT_NAVIS_CacheMisses);
+DEFINE_STAT(STAT_NAVIS_AllocatedMemory);
@@ -74,18 +74,19 @@ public:
 
 	/**	
 	 * GetLocalPosition()	@return Plane position transformed from World To Local
+	 * @note				the scale of the transform is left out : that is the space of a physics body, whose shapes are already scaled
 	 */
     FORCEINLINE FVector GetLocalPosition(const FTransform &localToWorld ) const
     {
-        return localToWorld.TransformPosition(GetPosition());
+        return localToWorld.InverseTransformPositionNoScale(GetPosition());
     }
 
 	/**	
-	 * GetLocalNormal()		@return Plane normal transformed from World To Local
+	 * GetLocalNormal()		@return Plane normal transformed from World To Local, without the scale like @see GetLocalPosition()
 	 */
     FORCEINLINE FVector GetLocalNormal(const FTransform &localToWorld ) const
     {
-        return localToWorld.TransformVector(GetNormal());
+        return localToWorld.InverseTransformVectorNoScale(GetNormal());
     }
 
 	/**	
@@ -0,0 +1,30 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "Stats/Stats.h"
+
+/**
+ *  NAVIS_TYPES
+ *  STATGROUP_NAVIS
+ *  Costs of NAVIS, shared by every module : "stat NAVIS" in the console
+ */
+DECLARE_STATS_GROUP(TEXT("NAVIS"), STATGROUP_NAVIS, STATCAT_Advanced);
+
+// Buoyancy
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Shape gathering"),      STAT_NAVIS_ShapeGathering,      STATGROUP_NAVIS, NAVIS_TYPES_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Clipping"),             STAT_NAVIS_Clipping,            STATGROUP_NAVIS, NAVIS_TYPES_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Force application"),    STAT_NAVIS_ForceApplication,    STATGROUP_NAVIS, NAVIS_TYPES_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hulls processed"),      STAT_NAVIS_HullsProcessed,      STATGROUP_NAVIS, NAVIS_TYPES_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Triangles clipped"),    STAT_NAVIS_TrianglesClipped,    STATGROUP_NAVIS, NAVIS_TYPES_API);
+
+// Sea
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Wave evaluation"),      STAT_NAVIS_WaveEvaluation,      STATGROUP_NAVIS, NAVIS_TYPES_API);
+
+// Meshes
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Mesh update"),          STAT_NAVIS_MeshUpdate,          STATGROUP_NAVIS, NAVIS_TYPES_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Cache hits"),           STAT_NAVIS_CacheHits,           STATGROUP_NAVIS, NAVIS_TYPES_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Cache misses"),         STAT_NAVIS_CacheMisses,         STATGROUP_NAVIS, NAVIS_TYPES_API);
+
+// Memory
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Allocated memory"),    STAT_NAVIS_AllocatedMemory,     STATGROUP_NAVIS, NAVIS_TYPES_API);
@@ -13,7 +13,9 @@ public class NAVIS_Water : ModuleRules
         //In case you would like to add various classes that you're going to use in your game
         //you should add the core,coreuobject and engine dependencies.
         PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine" });
-        PublicDependencyModuleNames.AddRange(new string[] { "NAVIS_CustomMesh" });
+        PublicDependencyModuleNames.AddRange(new string[] { "NAVIS_CustomMesh", "NAVIS_Physics" });
+        PrivateDependencyModuleNames.AddRange(new string[] { "NAVIS_Types" });
+        PrivateDependencyModuleNames.AddRange(new string[] { "RHI", "RenderCore" });
 
         //The path for the header files
         PublicIncludePaths.AddRange(new string[] { "NAVIS_Water/Public" });
@@ -1,19 +1,30 @@
 // Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
 
 #include "SeaActor.h"
+#include "NAVIS_Water.h"
 #include "SeaSurfaceComponent.h"
+#include "SeaLiquidComponent.h"
+#include "NAVISPhysicsStatics.h"
 #include "Components/BoxComponent.h"
 #include "Components/PostProcessComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/World.h"
+#include "Async/ParallelFor.h"
 
 FName ASeaActor::SurfaceName        = FName("SeaComp");
 FName ASeaActor::VolumeName         = FName("UnderWaterComp");
 FName ASeaActor::PostProcessName    = FName("EffectComp");
+FName ASeaActor::LiquidName         = FName("LiquidComp");
 
-ASeaActor::ASeaActor() : Super() , Extent(FVector2D(100.f, 100.f))
+ASeaActor::ASeaActor() : Super() , Extent(FVector2D(100.f, 100.f)), DetectionMode(ESeaDetectionMode::Overlap), FollowSnapSize(10000.f), WakeStrength(0.f), BathymetryCellSize(500.f), BathymetryMaxDepth(5000.f), BathymetryMaxShoreDistance(50000.f), FollowBox(ForceInit)
 {
+    PrimaryActorTick.bCanEverTick = true;
+    PrimaryActorTick.bStartWithTickEnabled = false;
+
     SurfaceComp = CreateDefaultSubobject<USeaSurfaceComponent>(SurfaceName);
     VolumeComp  = CreateDefaultSubobject<UBoxComponent>(VolumeName);
     PPComp      = CreateDefaultSubobject<UPostProcessComponent>(PostProcessName);
+    LiquidComp  = CreateDefaultSubobject<USeaLiquidComponent>(LiquidName);
 
     RootComponent = SurfaceComp;
     VolumeComp->SetupAttachment(SurfaceComp);
@@ -29,15 +40,35 @@ ASeaActor::ASeaActor() : Super() , Extent(FVector2D(100.f, 100.f))
  {
     Super::BeginPlay();
 
-    if(VolumeComp)   // May be unecessary
+    ApplyDetectionMode();
+
+    if(VolumeComp && DetectionMode == ESeaDetectionMode::Overlap)   // May be unecessary
     {
         VolumeComp->GetOverlappingActors(OverlappingActors, /*TSubclassOf<AActor> ClassFilter*/ nullptr);
-    }   
+    }
  }
 
+void ASeaActor::OnConstruction(const FTransform& Transform)
+{
+    Super::OnConstruction(Transform);
+    ApplyDetectionMode();
+}
+
+void ASeaActor::Tick(float DeltaSeconds)
+{
+    Super::Tick(DeltaSeconds);
+
+    if(SurfaceComp && SurfaceComp->IsInfinite())
+        FollowViewers();
+
+    if(DetectionMode == ESeaDetectionMode::SurfaceTest)
+        UpdateFloatingComponents();
+}
+
 void ASeaActor::ApplyExtent(const FVector2D &newExtent)
 {
     Extent = newExtent;
+    FollowBox.Init();   // next follow has to apply the new extent
     /** @todo  Check if scale or unscaled should be called */
     const float depth = VolumeComp->GetUnscaledBoxExtent().Z;
     const FVector Extent3d = FVector(Extent,depth);
@@ -45,15 +76,286 @@ void ASeaActor::ApplyExtent(const FVector2D &newExtent)
     VolumeComp->SetBoxExtent(Extent3d, true);
     VolumeComp->SetRelativeLocation(FVector(0.f,0.f, -1.f * depth));
 
-	//FVector Origin = SurfaceComp->Bounds.Origin;
-	const FVector	BoxExtent = SurfaceComp->Bounds.BoxExtent;
-    SurfaceComp->SetRelativeScale3D(Extent3d / BoxExtent);
+    // tiled surfaces keep their vertex density, only the area covered changes
+    if(!SurfaceComp->SetSeaExtent(Extent))
+    {
+        //FVector Origin = SurfaceComp->Bounds.Origin;
+        const FVector	BoxExtent = SurfaceComp->Bounds.BoxExtent;
+        SurfaceComp->SetRelativeScale3D(Extent3d / BoxExtent);
+    }
+
+    // the volume goes from the surface down to twice the depth, @see SetRelativeLocation() above.
+    // The liquid volume tree only follows moves of the root on its own
+    if(LiquidComp)
+        LiquidComp->SetLiquidExtent(FVector(Extent, 2.f * depth));
+}
+
+void ASeaActor::BakeBathymetry()
+{
+    UWorld * World = GetWorld();
+    if(!World || !SurfaceComp)
+        return;
+
+    // world aligned grid over the extent, coarser when it would get too big. It is stored from the surface, @see FSeaBathymetry
+    const int32 MaxResolution = 4096;
+    const float CellSize = FMath::Max3(BathymetryCellSize, 2.f * Extent.X / (MaxResolution - 1), 2.f * Extent.Y / (MaxResolution - 1));
+    const FIntPoint Resolution(FMath::Clamp(FMath::CeilToInt(2.f * Extent.X / CellSize) + 1, 2, MaxResolution),
+                               FMath::Clamp(FMath::CeilToInt(2.f * Extent.Y / CellSize) + 1, 2, MaxResolution));
+
+    const FVector Center = SurfaceComp->GetComponentLocation();
+    const FVector2D Origin = -Extent;
+
+    // from high above, so land higher than the sea is hit from its top. Floating things are not world static
+    FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(NAVISBathymetry), true, this);
+    const FCollisionObjectQueryParams ObjectParams(ECC_WorldStatic);
+    const float TraceStart = Center.Z + HALF_WORLD_MAX;
+    const float TraceEnd   = Center.Z - BathymetryMaxDepth;
+
+    TArray<float> Depths;
+    Depths.SetNumUninitialized(Resolution.X * Resolution.Y);
+    ParallelFor(Resolution.Y, [&](int32 Y)
+    {
+        for(int32 X = 0; X < Resolution.X; X++)
+        {
+            const FVector2D Location = FVector2D(Center) + Origin + FVector2D(X, Y) * CellSize;
+            FHitResult Hit;
+            const bool bHit = World->LineTraceSingleByObjectType(Hit, FVector(Location, TraceStart), FVector(Location, TraceEnd), ObjectParams, QueryParams);
+            Depths[Y * Resolution.X + X] = bHit ? Center.Z - Hit.ImpactPoint.Z : BathymetryMaxDepth;
+        }
+    });
+
+    FSeaBathymetry Bathymetry;
+    Bathymetry.Init(Origin, CellSize, Resolution, Depths, BathymetryMaxDepth, BathymetryMaxShoreDistance);
+
+    SurfaceComp->Modify();
+    SurfaceComp->SetBathymetry(Bathymetry);
+    UE_LOG(LogNAVIS_Water, Log, TEXT("%s : baked a %dx%d bathymetry, %.0f units a cell, %d KB"), *GetName(), Resolution.X, Resolution.Y, CellSize, int32(Bathymetry.GetAllocatedSize() / 1024));
+}
+
+void ASeaActor::ApplyDetectionMode()
+{
+    if(!VolumeComp)
+        return;
+
+    const bool bUseOverlap = DetectionMode == ESeaDetectionMode::Overlap;
+
+    // no collision means no body : the box is not even part of the broadphase
+    VolumeComp->SetGenerateOverlapEvents(bUseOverlap);
+    VolumeComp->SetCollisionEnabled(bUseOverlap ? ECollisionEnabled::QueryOnly : ECollisionEnabled::NoCollision);
+    if(VolumeComp->IsRegistered())
+        VolumeComp->RecreatePhysicsState();
+
+    // an infinite sea moves its volume along with the players
+    SetActorTickEnabled(!bUseOverlap || (SurfaceComp && SurfaceComp->IsInfinite()));
+}
+
+void ASeaActor::SetDetectionMode(ESeaDetectionMode newMode)
+{
+    if(DetectionMode == newMode)
+        return;
+
+    // whatever the old mode tracked leaves the water, the new mode finds it again from scratch
+    for(int32 Idx = 0; Idx < FloatingComponents.Num(); Idx++)
+    {
+        UPrimitiveComponent * Component = FloatingComponents[Idx].Get();
+        if(Component && FloatingComponentsInWater[Idx])
+            OnLeaveVolume(VolumeComp, Component->GetOwner(), Component, 0);
+    }
+    const TArray<AActor *> Tracked = OverlappingActors;
+    for(AActor * Actor : Tracked)
+        OnLeaveVolume(VolumeComp, Actor, nullptr, 0);
+    OverlappingActors.Reset();
+    FloatingComponentsInWater.Init(false, FloatingComponents.Num());
+
+    DetectionMode = newMode;
+    ApplyDetectionMode();
+
+    // overlaps only fire for what is new to the volume, which is everything once its collision came back
+    if(DetectionMode == ESeaDetectionMode::Overlap)
+    {
+        if(VolumeComp && VolumeComp->IsRegistered())
+            VolumeComp->UpdateOverlaps();
+    }
+    else
+    {
+        UpdateFloatingComponents();
+    }
+}
+
+void ASeaActor::FollowViewers()
+{
+    UWorld * World = GetWorld();
+    if(!World || !VolumeComp)
+        return;
+
+    // union of the areas around every viewer, snapped so small moves change nothing
+    FBox NewBox(ForceInit);
+    const float Snap = FMath::Max(FollowSnapSize, 100.f);
+    for(FConstPlayerControllerIterator Iterator = World->GetPlayerControllerIterator(); Iterator; ++Iterator)
+    {
+        const APlayerController * PC = Iterator->Get();
+        if(!PC)
+            continue;
+
+        FVector ViewLocation;
+        FRotator ViewRotation;
+        PC->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+        const FVector2D Min = FVector2D(ViewLocation) - Extent;
+        const FVector2D Max = FVector2D(ViewLocation) + Extent;
+        NewBox += FVector(FMath::FloorToFloat(Min.X / Snap) * Snap, FMath::FloorToFloat(Min.Y / Snap) * Snap, 0.f);
+        NewBox += FVector(FMath::CeilToFloat(Max.X / Snap) * Snap,  FMath::CeilToFloat(Max.Y / Snap) * Snap,  0.f);
+    }
+
+    if(!NewBox.IsValid || NewBox == FollowBox)
+        return;
+
+    FollowBox = NewBox;
+
+    const float depth = VolumeComp->GetUnscaledBoxExtent().Z;
+    const FVector Center = FollowBox.GetCenter();
+    VolumeComp->SetBoxExtent(FVector(FVector2D(FollowBox.GetExtent()), depth), true);
+    VolumeComp->SetWorldLocation(FVector(Center.X, Center.Y, SurfaceComp->GetComponentLocation().Z - depth));
+}
+
+void ASeaActor::RegisterFloatingComponent(UPrimitiveComponent * component)
+{
+    if(!IsValid(component) || FloatingComponents.Contains(component))
+        return;
+
+    FloatingComponents.Add(component);
+    FloatingComponentsInWater.Add(false);
+}
+
+void ASeaActor::UnregisterFloatingComponent(UPrimitiveComponent * component)
+{
+    // a null weak pointer would match every stale entry. Dying components are forgotten by @see UpdateFloatingComponents()
+    if(!IsValid(component))
+        return;
+
+    const int32 Idx = FloatingComponents.IndexOfByKey(component);
+    if(Idx == INDEX_NONE)
+        return;
+
+    UPrimitiveComponent * Registered = FloatingComponents[Idx].Get();
+    if(Registered && FloatingComponentsInWater[Idx])
+        OnLeaveVolume(VolumeComp, Registered->GetOwner(), Registered, 0);
+
+    FloatingComponents.RemoveAtSwap(Idx);
+    FloatingComponentsInWater.RemoveAtSwap(Idx);
+}
+
+void ASeaActor::UpdateFloatingComponents()
+{
+    // forget about destroyed components, they cannot leave the water anymore
+    for(int32 Idx = FloatingComponents.Num() - 1; Idx >= 0; Idx--)
+    {
+        if(!FloatingComponents[Idx].IsValid())
+        {
+            FloatingComponents.RemoveAtSwap(Idx);
+            FloatingComponentsInWater.RemoveAtSwap(Idx);
+        }
+    }
+
+    const int32 Num = FloatingComponents.Num();
+    if(Num == 0 || !SurfaceComp)
+        return;
+
+    // gather : bounds of every component, in one go
+    BoundsOrigins.SetNumUninitialized(Num, false);
+    BoundsExtents.SetNumUninitialized(Num, false);
+    for(int32 Idx = 0; Idx < Num; Idx++)
+    {
+        const FBoxSphereBounds &Bounds = FloatingComponents[Idx]->Bounds;
+        BoundsOrigins[Idx] = Bounds.Origin;
+        BoundsExtents[Idx] = Bounds.BoxExtent;
+    }
+
+    SurfaceComp->GetSurfaceHeights(BoundsOrigins, SurfaceHeights);
+
+    // classify : lowest point under the surface and within the sea extent
+    const FTransform SeaTransform = GetActorTransform();
+    const bool bInfinite = SurfaceComp->IsInfinite();
+    TBitArray<> InWater(false, Num);
+    for(int32 Idx = 0; Idx < Num; Idx++)
+    {
+        const FVector &Origin  = BoundsOrigins[Idx];
+        const FVector &BoxExt  = BoundsExtents[Idx];
+        const FVector LocalPos = SeaTransform.InverseTransformPositionNoScale(Origin);
+
+        const bool bUnderSurface = Origin.Z - BoxExt.Z < SurfaceHeights[Idx];
+        const bool bInExtent     = bInfinite || (FMath::Abs(LocalPos.X) <= Extent.X + BoxExt.X && FMath::Abs(LocalPos.Y) <= Extent.Y + BoxExt.Y);
+        InWater[Idx] = bUnderSurface && bInExtent;
+    }
+
+    // wakes and foam : what crosses the waterline pushes the water as it moves, along the exact waterline of its hulls.
+    // Servers have no foam to draw, and without ripples either the waterlines are not worth clipping
+    const bool bStamps = SurfaceComp->CanDrawInteraction();
+    if(WakeStrength > 0.f && (bStamps || SurfaceComp->HasRipples()))
+    {
+        const float DeltaSeconds = GetWorld() ? GetWorld()->GetDeltaSeconds() : 0.f;
+        TArray<FNAVISWaterline> Waterlines;
+        for(int32 Idx = 0; Idx < Num; Idx++)
+        {
+            const FVector &Origin  = BoundsOrigins[Idx];
+            const FVector &BoxExt  = BoundsExtents[Idx];
+            if(!InWater[Idx] || Origin.Z + BoxExt.Z < SurfaceHeights[Idx])
+                continue;
+
+            UPrimitiveComponent * Component = FloatingComponents[Idx].Get();
+            const FVector Velocity = Component->GetComponentVelocity();
+            const float Speed = Velocity.Size2D() + FMath::Abs(Velocity.Z);
+            if(Speed <= KINDA_SMALL_NUMBER)
+                continue;
+
+            const float Strength = -WakeStrength * Speed * DeltaSeconds;
+            const FVector SurfacePoint = FVector(Origin.X, Origin.Y, SurfaceHeights[Idx]);
+
+            // bodies without convex elements fall back to their bounds
+            if(!UNAVISPhysicsStatics::GetPrimitiveWaterline(Component, FNavisPlane(SurfacePoint, FVector::UpVector), Waterlines))
+            {
+                SurfaceComp->AddRippleDisturbance(Origin, FMath::Max(BoxExt.X, BoxExt.Y), Strength);
+                if(bStamps)
+                    SurfaceComp->AddInteractionStamp(Origin, FMath::Max(BoxExt.X, BoxExt.Y), Speed * DeltaSeconds);
+                continue;
+            }
+
+            // one disturbance per waterline point, the strength shared along the hull
+            for(const FNAVISWaterline &Waterline : Waterlines)
+            {
+                const float Spacing = Waterline.GetPerimeter() / Waterline.Points.Num();
+                for(const FVector &Point : Waterline.Points)
+                {
+                    SurfaceComp->AddRippleDisturbance(Point, Spacing, Strength / Waterline.Points.Num());
+                    if(bStamps)
+                        SurfaceComp->AddInteractionStamp(Point, Spacing, Speed * DeltaSeconds);
+                }
+            }
+        }
+    }
+
+    // diff : only changes produce events
+    for(int32 Idx = 0; Idx < Num; Idx++)
+    {
+        if(InWater[Idx] == FloatingComponentsInWater[Idx])
+            continue;
+
+        UPrimitiveComponent * Component = FloatingComponents[Idx].Get();
+        if(InWater[Idx])
+            OnEnterVolume(VolumeComp, Component->GetOwner(), Component, 0, false, FHitResult());
+        else
+            OnLeaveVolume(VolumeComp, Component->GetOwner(), Component, 0);
+    }
+
+    FloatingComponentsInWater = MoveTemp(InWater);
 }
 
 void ASeaActor::OnEnterVolume( UPrimitiveComponent* overlappedComponent, AActor* otherActor, UPrimitiveComponent* otherComp, int32 otherBodyIndex, bool bFromSweep, const FHitResult & sweepResult)
 {
-    if(!OverlappingActors.Contains(otherActor)) // may be unecessary
-        OverlappingActors.AddUnique(otherActor);
+    // once per actor, whichever mode or component found it
+    if(!otherActor || OverlappingActors.Contains(otherActor))
+        return;
+    OverlappingActors.Add(otherActor);
 
     // notify BP
     Event_OnActorEnteredVolume(otherActor);
@@ -61,9 +363,10 @@ void ASeaActor::OnEnterVolume( UPrimitiveComponent* overlappedComponent, AActor*
 
 void ASeaActor::OnLeaveVolume( UPrimitiveComponent* overlappedComponent, AActor* otherActor, UPrimitiveComponent* otherComp, int32 otherBodyIndex)
 {
-    if(OverlappingActors.Contains(otherActor)) // may be unecessary
-        OverlappingActors.Remove(otherActor);
-    
+    // only what entered leaves : the volume also ends its overlaps when a mode change turns its collision off
+    if(OverlappingActors.Remove(otherActor) == 0)
+        return;
+
     // notify BP
     Event_OnActorLeftVolume(otherActor);
-}
\ No newline at end of file
+}
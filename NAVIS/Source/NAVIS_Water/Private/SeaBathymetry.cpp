@@ -0,0 +1,135 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "SeaBathymetry.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+    /** far enough for any grid, squared distances are in cells */
+    const float DistanceInfinity = 1.e20f;
+
+    /**
+     * 	DistanceTransform1D()   squared distance to the closest zero of a line, as the lower envelope of parabolas
+     *  @param values	        0 where a line starts, DistanceInfinity elsewhere, or the result of a previous pass
+     *  @param vertices, bounds scratch, Num and Num + 1 entries
+     *  @see                    Felzenszwalb and Huttenlocher, Distance Transforms of Sampled Functions
+	 */
+    void DistanceTransform1D(const float * values, int32 num, float * outDistances, int32 * vertices, float * bounds)
+    {
+        int32 K = 0;
+        vertices[0] = 0;
+        bounds[0] = -DistanceInfinity;
+        bounds[1] = DistanceInfinity;
+        for(int32 Q = 1; Q < num; Q++)
+        {
+            // where the parabola of Q gets under the one of the last vertex, those it hides are dropped
+            auto Intersection = [&](int32 V) { return ((values[Q] + Q * Q) - (values[V] + V * V)) / (2.f * (Q - V)); };
+            float S = Intersection(vertices[K]);
+            while(S <= bounds[K])
+            {
+                K--;
+                S = Intersection(vertices[K]);
+            }
+            K++;
+            vertices[K] = Q;
+            bounds[K] = S;
+            bounds[K + 1] = DistanceInfinity;
+        }
+
+        K = 0;
+        for(int32 Q = 0; Q < num; Q++)
+        {
+            while(bounds[K + 1] < Q)
+                K++;
+            const int32 V = vertices[K];
+            outDistances[Q] = (Q - V) * (Q - V) + values[V];
+        }
+    }
+
+    uint16 Quantize(float value, float maxValue)
+    {
+        return maxValue > 0.f ? uint16(FMath::RoundToInt(FMath::Clamp(value / maxValue, 0.f, 1.f) * 65535.f)) : 0;
+    }
+}
+
+void FSeaBathymetry::Init(const FVector2D &origin, float cellSize, const FIntPoint &resolution, const TArray<float> &depths, float maxDepth, float maxShoreDistance)
+{
+    check(depths.Num() == resolution.X * resolution.Y);
+
+    Origin = origin;
+    CellSize = cellSize;
+    Resolution = resolution;
+    MaxDepth = maxDepth;
+    MaxShoreDistance = maxShoreDistance;
+
+    const int32 Num = depths.Num();
+    Depths.SetNumUninitialized(Num);
+    TArray<float> Distances;
+    Distances.SetNumUninitialized(Num);
+    for(int32 Idx = 0; Idx < Num; Idx++)
+    {
+        Depths[Idx] = Quantize(depths[Idx], MaxDepth);
+        Distances[Idx] = depths[Idx] > 0.f ? DistanceInfinity : 0.f;
+    }
+
+    // separable : the columns, then the rows of what the columns gave
+    ParallelFor(Resolution.X, [this, &Distances](int32 X)
+    {
+        TArray<float> Column, Result, Bounds;
+        TArray<int32> Vertices;
+        Column.SetNumUninitialized(Resolution.Y);
+        Result.SetNumUninitialized(Resolution.Y);
+        Bounds.SetNumUninitialized(Resolution.Y + 1);
+        Vertices.SetNumUninitialized(Resolution.Y);
+        for(int32 Y = 0; Y < Resolution.Y; Y++)
+            Column[Y] = Distances[Y * Resolution.X + X];
+        DistanceTransform1D(Column.GetData(), Resolution.Y, Result.GetData(), Vertices.GetData(), Bounds.GetData());
+        for(int32 Y = 0; Y < Resolution.Y; Y++)
+            Distances[Y * Resolution.X + X] = Result[Y];
+    });
+
+    ShoreDistances.SetNumUninitialized(Num);
+    ParallelFor(Resolution.Y, [this, &Distances](int32 Y)
+    {
+        TArray<float> Result, Bounds;
+        TArray<int32> Vertices;
+        Result.SetNumUninitialized(Resolution.X);
+        Bounds.SetNumUninitialized(Resolution.X + 1);
+        Vertices.SetNumUninitialized(Resolution.X);
+        DistanceTransform1D(Distances.GetData() + Y * Resolution.X, Resolution.X, Result.GetData(), Vertices.GetData(), Bounds.GetData());
+        for(int32 X = 0; X < Resolution.X; X++)
+        {
+            // no dry sample at all leaves the whole grid at the maximum
+            const float Distance = Result[X] >= DistanceInfinity ? MaxShoreDistance : FMath::Sqrt(Result[X]) * CellSize;
+            ShoreDistances[Y * Resolution.X + X] = Quantize(Distance, MaxShoreDistance);
+        }
+    });
+}
+
+bool FSeaBathymetry::Sample(const FVector &relativeLocation, float &outDepth, float &outShoreDistance) const
+{
+    if(!IsValid())
+        return false;
+
+    const FVector2D Grid = (FVector2D(relativeLocation.X, relativeLocation.Y) - Origin) / CellSize;
+    if(Grid.X < 0.f || Grid.Y < 0.f || Grid.X > Resolution.X - 1 || Grid.Y > Resolution.Y - 1)
+        return false;
+
+    const int32 X0 = FMath::Min(FMath::FloorToInt(Grid.X), Resolution.X - 2);
+    const int32 Y0 = FMath::Min(FMath::FloorToInt(Grid.Y), Resolution.Y - 2);
+    const float AlphaX = Grid.X - X0;
+    const float AlphaY = Grid.Y - Y0;
+
+    auto Bilinear = [&](const TArray<uint16> &Samples) -> float
+    {
+        const uint16 * Row0 = Samples.GetData() + Y0 * Resolution.X + X0;
+        const uint16 * Row1 = Row0 + Resolution.X;
+        const float Top    = FMath::Lerp(float(Row0[0]), float(Row0[1]), AlphaX);
+        const float Bottom = FMath::Lerp(float(Row1[0]), float(Row1[1]), AlphaX);
+        return FMath::Lerp(Top, Bottom, AlphaY) / 65535.f;
+    };
+
+    outDepth = Bilinear(Depths) * MaxDepth;
+    outShoreDistance = Bilinear(ShoreDistances) * MaxShoreDistance;
+    return true;
+}
@@ -0,0 +1,91 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "SeaLiquidComponent.h"
+#include "SeaSurfaceComponent.h"
+#include "GameFramework/Actor.h"
+
+USeaLiquidComponent::USeaLiquidComponent(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer), Surface(nullptr)
+{
+}
+
+void USeaLiquidComponent::OnRegister()
+{
+    // before registering, the bounds depend on it
+    Surface = GetOwner() ? GetOwner()->FindComponentByClass<USeaSurfaceComponent>() : nullptr;
+    Super::OnRegister();
+}
+
+FBox USeaLiquidComponent::GetLiquidBounds() const
+{
+    FBox Bounds = Super::GetLiquidBounds();
+
+    // crests rise above the rest surface
+    if(Bounds.IsValid && Surface)
+        Bounds.Max.Z += Surface->GetMaxWaveHeight();
+
+    // an infinite sea governs everywhere its height range is, whatever area its volume follows
+    if(Bounds.IsValid && Surface && Surface->IsInfinite())
+    {
+        Bounds.Min.X = Bounds.Min.Y = -HALF_WORLD_MAX;
+        Bounds.Max.X = Bounds.Max.Y =  HALF_WORLD_MAX;
+    }
+    return Bounds;
+}
+
+FVector USeaLiquidComponent::GetSurfaceNormal() const
+{
+    return Surface ? Surface->GetUpVector() : Super::GetSurfaceNormal();
+}
+
+FVector USeaLiquidComponent::GetLocalSurfaceNormal() const
+{
+    return GetSurfaceNormal();
+}
+
+FVector USeaLiquidComponent::GetSurfaceLocationUnderPoint(FVector traceOrigin) const
+{
+    if(!Surface)
+        return Super::GetSurfaceLocationUnderPoint(traceOrigin);
+
+    return FVector(traceOrigin.X, traceOrigin.Y, Surface->GetComponentLocation().Z + Surface->GetWaveHeightAt(traceOrigin));
+}
+
+void USeaLiquidComponent::GetSurfaceLocationsUnderPoints(TArrayView<const FVector> points, TArrayView<FVector> outLocations) const
+{
+    if(!Surface)
+    {
+        Super::GetSurfaceLocationsUnderPoints(points, outLocations);
+        return;
+    }
+
+    check(points.Num() == outLocations.Num());
+    const float SurfaceHeight = Surface->GetComponentLocation().Z;
+    for(int32 Idx = 0; Idx < points.Num(); Idx++)
+    {
+        const FVector &Point = points[Idx];
+        outLocations[Idx] = FVector(Point.X, Point.Y, SurfaceHeight + Surface->GetWaveHeightAt(Point));
+    }
+}
+
+void USeaLiquidComponent::SnapshotQueries()
+{
+    Super::SnapshotQueries();
+    QuerySnapshot = Surface ? Surface->SnapshotSurface() : FSeaSurfaceSnapshot();
+}
+
+void USeaLiquidComponent::ResolveQueries(TArrayView<const FVector> points, TArrayView<FVector> outLocations) const
+{
+    if(!Surface)
+    {
+        Super::ResolveQueries(points, outLocations);
+        return;
+    }
+
+    check(points.Num() == outLocations.Num());
+    const float SurfaceHeight = QuerySnapshot.Transform.GetLocation().Z;
+    for(int32 Idx = 0; Idx < points.Num(); Idx++)
+    {
+        const FVector &Point = points[Idx];
+        outLocations[Idx] = FVector(Point.X, Point.Y, SurfaceHeight + Surface->GetWaveHeightAt(Point, QuerySnapshot));
+    }
+}
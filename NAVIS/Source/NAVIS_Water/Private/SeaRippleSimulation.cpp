@@ -0,0 +1,369 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "SeaRippleSimulation.h"
+#include "NAVISStats.h"
+#include "Engine/Texture2D.h"
+#include "Async/ParallelFor.h"
+
+/** Fixed time step, the wave equation is only stable for a bounded step */
+static const float RippleStepTime       = 1.f / 60.f;
+
+/** Steps done in one frame at most, a long frame slows the ripples down rather than the game */
+static const int32 RippleMaxSteps       = 4;
+
+/** Most tiles alive at once, disturbances past it are dropped */
+static const int32 RippleMaxTiles       = 1024;
+
+/** Average height under which a tile counts as calm */
+static const float RippleQuietHeight    = 0.01f;
+
+/** Steps a tile stays calm before it is removed */
+static const int32 RippleQuietSteps     = 30;
+
+/** Height on an edge above which the neighbouring tile gets created */
+static const float RippleSpreadHeight   = 0.02f;
+
+
+FSeaRippleSimulation::FTile::FTile()
+{
+    Current.SetNumZeroed(TileStride * TileStride);
+    Previous.SetNumZeroed(TileStride * TileStride);
+    INC_MEMORY_STAT_BY(STAT_NAVIS_AllocatedMemory, Current.GetAllocatedSize() + Previous.GetAllocatedSize());
+}
+
+FSeaRippleSimulation::FTile::~FTile()
+{
+    DEC_MEMORY_STAT_BY(STAT_NAVIS_AllocatedMemory, Current.GetAllocatedSize() + Previous.GetAllocatedSize());
+}
+
+FSeaRippleSimulation::FSeaRippleSimulation()
+    : CellSize(50.f)
+    , Courant2(0.f)
+    , Damping(0.99f)
+    , TimeAccumulator(0.f)
+{
+    SetParameters(50.f, 400.f, 0.99f);
+}
+
+void FSeaRippleSimulation::SetParameters(float cellSize, float waveSpeed, float damping)
+{
+    CellSize = FMath::Max(cellSize, 1.f);
+    Damping  = FMath::Clamp(damping, 0.f, 1.f);
+
+    // the 2D explicit scheme diverges past a courant number of 1/sqrt(2)
+    const float Courant = waveSpeed * RippleStepTime / CellSize;
+    Courant2 = FMath::Min(Courant * Courant, 0.5f);
+}
+
+void FSeaRippleSimulation::AddDisturbance(const FVector2D &location, float radius, float strength)
+{
+    if(radius <= 0.f || strength == 0.f)
+        return;
+
+    Disturbances.Add({ location, radius, strength });
+}
+
+FSeaRippleSimulation::FTile * FSeaRippleSimulation::FindOrAddTile(const FIntPoint &key)
+{
+    if(TUniquePtr<FTile> * Tile = Tiles.Find(key))
+        return Tile->Get();
+
+    if(Tiles.Num() >= RippleMaxTiles)
+        return nullptr;
+
+    RemovedTiles.Remove(key);
+    return Tiles.Add(key, MakeUnique<FTile>()).Get();
+}
+
+/**
+ *  SampleCells()   bilinear height at a location, shared by the simulation and its copies
+ *  @param findTile returns the heights of a tile with halo, nullptr if it does not exist
+ */
+template<typename FindTileType>
+static float SampleCells(const FVector2D &location, float cellSize, int32 tileSize, int32 tileStride, FindTileType &&findTile)
+{
+    auto GetCell = [&](int32 x, int32 y)
+    {
+        const FIntPoint Key(FMath::FloorToInt(float(x) / tileSize), FMath::FloorToInt(float(y) / tileSize));
+        const float * Heights = findTile(Key);
+        if(!Heights)
+            return 0.f;
+
+        const int32 LocalX = x - Key.X * tileSize;
+        const int32 LocalY = y - Key.Y * tileSize;
+        return Heights[(LocalY + 1) * tileStride + LocalX + 1];
+    };
+
+    // heights are at the cell centers
+    const float X = location.X / cellSize - 0.5f;
+    const float Y = location.Y / cellSize - 0.5f;
+    const int32 X0 = FMath::FloorToInt(X);
+    const int32 Y0 = FMath::FloorToInt(Y);
+    const float FracX = X - X0;
+    const float FracY = Y - Y0;
+
+    const float Bottom  = FMath::Lerp(GetCell(X0, Y0),     GetCell(X0 + 1, Y0),     FracX);
+    const float Top     = FMath::Lerp(GetCell(X0, Y0 + 1), GetCell(X0 + 1, Y0 + 1), FracX);
+    return FMath::Lerp(Bottom, Top, FracY);
+}
+
+float FSeaRippleSimulation::SampleHeight(const FVector2D &location) const
+{
+    if(Tiles.Num() == 0)
+        return 0.f;
+
+    return SampleCells(location, CellSize, TileSize, TileStride, [this](const FIntPoint &key) -> const float *
+    {
+        const TUniquePtr<FTile> * Tile = Tiles.Find(key);
+        return Tile ? (*Tile)->Current.GetData() : nullptr;
+    });
+}
+
+TSharedPtr<const FSeaRippleHeights, ESPMode::ThreadSafe> FSeaRippleSimulation::CopyHeights() const
+{
+    if(Tiles.Num() == 0)
+        return nullptr;
+
+    TSharedRef<FSeaRippleHeights, ESPMode::ThreadSafe> Heights = MakeShared<FSeaRippleHeights, ESPMode::ThreadSafe>();
+    Heights->CellSize = CellSize;
+    Heights->Tiles.Reserve(Tiles.Num());
+    for(const TPair<FIntPoint, TUniquePtr<FTile>> &Tile : Tiles)
+    {
+        Heights->Tiles.Add(Tile.Key, Tile.Value->Current);
+    }
+    return Heights;
+}
+
+float FSeaRippleHeights::SampleHeight(const FVector2D &location) const
+{
+    if(Tiles.Num() == 0)
+        return 0.f;
+
+    return SampleCells(location, CellSize, FSeaRippleSimulation::TileSize, FSeaRippleSimulation::TileStride, [this](const FIntPoint &key) -> const float *
+    {
+        const TArray<float> * Heights = Tiles.Find(key);
+        return Heights ? Heights->GetData() : nullptr;
+    });
+}
+
+void FSeaRippleSimulation::ApplyDisturbances()
+{
+    for(const FDisturbance &Disturbance : Disturbances)
+    {
+        const int32 MinX = FMath::FloorToInt((Disturbance.Location.X - Disturbance.Radius) / CellSize);
+        const int32 MaxX = FMath::FloorToInt((Disturbance.Location.X + Disturbance.Radius) / CellSize);
+        const int32 MinY = FMath::FloorToInt((Disturbance.Location.Y - Disturbance.Radius) / CellSize);
+        const int32 MaxY = FMath::FloorToInt((Disturbance.Location.Y + Disturbance.Radius) / CellSize);
+
+        for(int32 Y = MinY; Y <= MaxY; Y++)
+        {
+            for(int32 X = MinX; X <= MaxX; X++)
+            {
+                const FVector2D CellCenter = FVector2D(X + 0.5f, Y + 0.5f) * CellSize;
+                const float Distance = FVector2D::Distance(CellCenter, Disturbance.Location);
+                if(Distance >= Disturbance.Radius)
+                    continue;
+
+                const FIntPoint Key(FMath::FloorToInt(float(X) / TileSize), FMath::FloorToInt(float(Y) / TileSize));
+                FTile * Tile = FindOrAddTile(Key);
+                if(!Tile)
+                    continue;
+
+                // same offset on both steps : a displacement without initial speed, it spreads as a ring
+                const int32 Index = (Y - Key.Y * TileSize + 1) * TileStride + X - Key.X * TileSize + 1;
+                const float Height = Disturbance.Strength * 0.5f * (1.f + FMath::Cos(PI * Distance / Disturbance.Radius));
+                Tile->Current[Index]  += Height;
+                Tile->Previous[Index] += Height;
+                Tile->QuietSteps = 0;
+                Tile->bTextureDirty = true;
+            }
+        }
+    }
+    Disturbances.Reset();
+}
+
+void FSeaRippleSimulation::Step(float deltaTime)
+{
+    ApplyDisturbances();
+    if(Tiles.Num() == 0)
+    {
+        TimeAccumulator = 0.f;
+        return;
+    }
+
+    TimeAccumulator = FMath::Min(TimeAccumulator + deltaTime, RippleStepTime * RippleMaxSteps);
+    while(TimeAccumulator >= RippleStepTime && Tiles.Num() > 0)
+    {
+        TimeAccumulator -= RippleStepTime;
+        StepTiles();
+    }
+}
+
+void FSeaRippleSimulation::StepTiles()
+{
+    TArray<FIntPoint> Keys;
+    TArray<FTile*> TileList;
+    Keys.Reserve(Tiles.Num());
+    TileList.Reserve(Tiles.Num());
+    for(TPair<FIntPoint, TUniquePtr<FTile>> &Pair : Tiles)
+    {
+        Keys.Add(Pair.Key);
+        TileList.Add(Pair.Value.Get());
+    }
+
+    // halo : each tile copies the edges of its neighbours, writing only to its own halo
+    ParallelFor(TileList.Num(), [&](int32 TileIdx)
+    {
+        const FIntPoint &Key = Keys[TileIdx];
+        float * Cur = TileList[TileIdx]->Current.GetData();
+
+        const TUniquePtr<FTile> * Left   = Tiles.Find(Key - FIntPoint(1, 0));
+        const TUniquePtr<FTile> * Right  = Tiles.Find(Key + FIntPoint(1, 0));
+        const TUniquePtr<FTile> * Down   = Tiles.Find(Key - FIntPoint(0, 1));
+        const TUniquePtr<FTile> * Up     = Tiles.Find(Key + FIntPoint(0, 1));
+
+        for(int32 Idx = 1; Idx <= TileSize; Idx++)
+        {
+            Cur[Idx * TileStride]                       = Left  ? (*Left)->Current[Idx * TileStride + TileSize]   : 0.f;
+            Cur[Idx * TileStride + TileSize + 1]        = Right ? (*Right)->Current[Idx * TileStride + 1]         : 0.f;
+            Cur[Idx]                                    = Down  ? (*Down)->Current[TileSize * TileStride + Idx]   : 0.f;
+            Cur[(TileSize + 1) * TileStride + Idx]      = Up    ? (*Up)->Current[TileStride + Idx]                : 0.f;
+        }
+    });
+
+    // stencil : next = (2 * current - previous + c² * laplacian) * damping, four cells at once, written over previous
+    ParallelFor(TileList.Num(), [&](int32 TileIdx)
+    {
+        FTile &Tile = *TileList[TileIdx];
+        const float * Cur = Tile.Current.GetData();
+        float * Prev = Tile.Previous.GetData();
+
+        const VectorRegister Two        = VectorSetFloat1(2.f);
+        const VectorRegister Four       = VectorSetFloat1(4.f);
+        const VectorRegister VCourant2  = VectorSetFloat1(Courant2);
+        const VectorRegister VDamping   = VectorSetFloat1(Damping);
+        VectorRegister Energy           = VectorZero();
+
+        for(int32 Row = 1; Row <= TileSize; Row++)
+        {
+            for(int32 Col = 1; Col <= TileSize; Col += 4)
+            {
+                const int32 Idx = Row * TileStride + Col;
+                const VectorRegister Center   = VectorLoad(Cur + Idx);
+                const VectorRegister Sides    = VectorAdd(VectorAdd(VectorLoad(Cur + Idx - 1), VectorLoad(Cur + Idx + 1)),
+                                                           VectorAdd(VectorLoad(Cur + Idx - TileStride), VectorLoad(Cur + Idx + TileStride)));
+                const VectorRegister Laplacian = VectorSubtract(Sides, VectorMultiply(Four, Center));
+                const VectorRegister Wave     = VectorSubtract(VectorMultiply(Two, Center), VectorLoad(Prev + Idx));
+                const VectorRegister Next     = VectorMultiply(VectorMultiplyAdd(VCourant2, Laplacian, Wave), VDamping);
+                VectorStore(Next, Prev + Idx);
+                Energy = VectorAdd(Energy, VectorAbs(Next));
+            }
+        }
+
+        MS_ALIGN(16) float Lanes[4] GCC_ALIGN(16);
+        VectorStoreAligned(Energy, Lanes);
+        Tile.Energy = Lanes[0] + Lanes[1] + Lanes[2] + Lanes[3];
+
+        // edges reached by the ripples, their neighbours have to exist for the ripples to go on
+        float EdgeMax[4] = { 0.f, 0.f, 0.f, 0.f };
+        for(int32 Idx = 1; Idx <= TileSize; Idx++)
+        {
+            EdgeMax[0] = FMath::Max(EdgeMax[0], FMath::Abs(Prev[Idx * TileStride + 1]));
+            EdgeMax[1] = FMath::Max(EdgeMax[1], FMath::Abs(Prev[Idx * TileStride + TileSize]));
+            EdgeMax[2] = FMath::Max(EdgeMax[2], FMath::Abs(Prev[TileStride + Idx]));
+            EdgeMax[3] = FMath::Max(EdgeMax[3], FMath::Abs(Prev[TileSize * TileStride + Idx]));
+        }
+        for(int32 Edge = 0; Edge < 4; Edge++)
+        {
+            Tile.bEdgeActive[Edge] = EdgeMax[Edge] > RippleSpreadHeight;
+        }
+
+        Swap(Tile.Current, Tile.Previous);
+        Tile.bTextureDirty = true;
+    });
+
+    // spread to new tiles, and drop the calm ones
+    static const FIntPoint EdgeOffsets[4] = { FIntPoint(-1, 0), FIntPoint(1, 0), FIntPoint(0, -1), FIntPoint(0, 1) };
+    for(int32 TileIdx = 0; TileIdx < TileList.Num(); TileIdx++)
+    {
+        FTile &Tile = *TileList[TileIdx];
+        for(int32 Edge = 0; Edge < 4; Edge++)
+        {
+            if(Tile.bEdgeActive[Edge])
+                FindOrAddTile(Keys[TileIdx] + EdgeOffsets[Edge]);
+        }
+
+        const bool bQuiet = Tile.Energy < RippleQuietHeight * TileSize * TileSize;
+        Tile.QuietSteps = bQuiet ? Tile.QuietSteps + 1 : 0;
+    }
+    for(int32 TileIdx = 0; TileIdx < TileList.Num(); TileIdx++)
+    {
+        if(TileList[TileIdx]->QuietSteps > RippleQuietSteps)
+        {
+            Tiles.Remove(Keys[TileIdx]);
+            RemovedTiles.Add(Keys[TileIdx]);
+        }
+    }
+}
+
+void FSeaRippleSimulation::UpdateTexture(UTexture2D * texture, const FIntPoint &firstTile)
+{
+    if(!texture || !texture->Resource)
+        return;
+
+    const FIntPoint TextureTiles(texture->GetSizeX() / TileSize, texture->GetSizeY() / TileSize);
+    auto IsInTexture = [&](const FIntPoint &key)
+    {
+        const FIntPoint Local = key - firstTile;
+        return Local.X >= 0 && Local.Y >= 0 && Local.X < TextureTiles.X && Local.Y < TextureTiles.Y;
+    };
+
+    // changed tiles, then removed ones as zeros
+    TArray<FIntPoint> Uploads;
+    for(TPair<FIntPoint, TUniquePtr<FTile>> &Pair : Tiles)
+    {
+        if(Pair.Value->bTextureDirty && IsInTexture(Pair.Key))
+            Uploads.Add(Pair.Key);
+        Pair.Value->bTextureDirty = false;
+    }
+    const int32 NumChanged = Uploads.Num();
+    for(const FIntPoint &Key : RemovedTiles)
+    {
+        if(IsInTexture(Key))
+            Uploads.Add(Key);
+    }
+    RemovedTiles.Reset();
+
+    if(Uploads.Num() == 0)
+        return;
+
+    // one column of tiles as source, one region per tile
+    const int32 TileTexels = TileSize * TileSize;
+    float * Data = new float[Uploads.Num() * TileTexels];
+    FUpdateTextureRegion2D * Regions = new FUpdateTextureRegion2D[Uploads.Num()];
+    for(int32 UploadIdx = 0; UploadIdx < Uploads.Num(); UploadIdx++)
+    {
+        const FIntPoint Local = Uploads[UploadIdx] - firstTile;
+        Regions[UploadIdx] = FUpdateTextureRegion2D(Local.X * TileSize, Local.Y * TileSize, 0, UploadIdx * TileSize, TileSize, TileSize);
+
+        float * TileData = Data + UploadIdx * TileTexels;
+        if(UploadIdx >= NumChanged)
+        {
+            FMemory::Memzero(TileData, TileTexels * sizeof(float));
+            continue;
+        }
+
+        const float * Cur = Tiles[Uploads[UploadIdx]]->Current.GetData();
+        for(int32 Row = 0; Row < TileSize; Row++)
+        {
+            FMemory::Memcpy(TileData + Row * TileSize, Cur + (Row + 1) * TileStride + 1, TileSize * sizeof(float));
+        }
+    }
+
+    texture->UpdateTextureRegions(0, Uploads.Num(), Regions, TileSize * sizeof(float), sizeof(float), reinterpret_cast<uint8*>(Data),
+        [](uint8 * SrcData, const FUpdateTextureRegion2D * SrcRegions)
+    {
+        delete[] reinterpret_cast<float*>(SrcData);
+        delete[] SrcRegions;
+    });
+}
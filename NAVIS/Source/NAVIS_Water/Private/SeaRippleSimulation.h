@@ -0,0 +1,145 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "NAVIS_WaterPCH.h"
+
+class UTexture2D;
+
+/**
+ *  NAVIS_WATER
+ *	FSeaRippleHeights
+ *  Heights of the ripples at one step, copied out of a @see FSeaRippleSimulation for readers on worker threads
+ */
+class FSeaRippleHeights
+{
+public:
+
+    /** SampleHeight()  @see FSeaRippleSimulation::SampleHeight() */
+    float SampleHeight(const FVector2D &location) const;
+
+private:
+
+    friend class FSeaRippleSimulation;
+
+    /** heights of each tile, with halo */
+    TMap<FIntPoint, TArray<float>> Tiles;
+
+    float CellSize = 1.f;
+};
+
+/**
+ *  NAVIS_WATER
+ *	FSeaRippleSimulation
+ *  Wave equation on a sparse grid of tiles, for wakes and ripples on top of the sea waves.
+ *  Only tiles that were disturbed, or that ripples spread to, exist and get stepped.
+ *  They go away once they are calm again, so the cost follows the disturbed area and not the sea size.
+ *  @note   runs on the game thread, tiles are stepped in parallel. Works without rendering, for servers
+ */
+class FSeaRippleSimulation
+{
+public:
+
+    /** Cells along the edge of a tile */
+    static const int32 TileSize = 32;
+
+    FSeaRippleSimulation();
+
+    /**
+     * 	SetParameters()         Change the behaviour of the ripples, existing tiles are kept
+     *  @param cellSize	        size of a cell, in local units
+     *  @param waveSpeed	    speed of the ripples, in local units per second
+     *  @param damping	        fraction of the height kept at each step, lower calms down faster
+	 */
+    void SetParameters(float cellSize, float waveSpeed, float damping);
+
+    /**
+     * 	AddDisturbance()        Queue a bump or a dip, applied at the next step
+     *  @param location	        center, in local units
+     *  @param radius	        radius, in local units, the height fades to nothing there
+     *  @param strength	        height added at the center, negative for a dip
+	 */
+    void AddDisturbance(const FVector2D &location, float radius, float strength);
+
+    /** Step()   advance by fixed steps to catch up with deltaTime, a few steps at most */
+    void Step(float deltaTime);
+
+    /** SampleHeight()  @return bilinear height of the ripples at a location in local units, 0 where nothing moves */
+    float SampleHeight(const FVector2D &location) const;
+
+    /**
+     * 	CopyHeights()           Heights of the last step, for readers on worker threads
+     *  @return                 nullptr when there are no ripples. Queued disturbances are not in it, they are not stepped yet
+	 */
+    TSharedPtr<const FSeaRippleHeights, ESPMode::ThreadSafe> CopyHeights() const;
+
+    /** IsActive()  @return true while there are ripples or queued disturbances, the simulation costs nothing otherwise */
+    bool IsActive() const { return Tiles.Num() > 0 || Disturbances.Num() > 0; }
+
+    /** GetNumTiles()  @return number of tiles being stepped */
+    int32 GetNumTiles() const { return Tiles.Num(); }
+
+    /**
+     * 	UpdateTexture()         Upload the tiles that changed since the last upload, in a single render command
+     *  @param texture	        PF_R32_FLOAT texture, one texel per cell
+     *  @param firstTile	    tile at the texel (0,0) of the texture
+     *  @note                   tiles outside of the texture are skipped, removed tiles are written as zero
+	 */
+    void UpdateTexture(UTexture2D * texture, const FIntPoint &firstTile);
+
+private:
+
+    friend class FSeaRippleHeights;
+
+    /** Cells along the edge of a tile with its halo, copied from the neighbours before each step */
+    static const int32 TileStride = TileSize + 2;
+
+    struct FTile
+    {
+        /** heights at this step and the one before, with halo. Previous receives the next step */
+        TArray<float> Current;
+        TArray<float> Previous;
+
+        /** sum of the absolute heights after the last step */
+        float Energy = 0.f;
+
+        /** steps spent with a low energy, the tile is removed past a limit */
+        int32 QuietSteps = 0;
+
+        /** whether ripples reached each edge : -X, +X, -Y, +Y */
+        bool bEdgeActive[4] = { false, false, false, false };
+
+        /** changed since the last upload */
+        bool bTextureDirty = true;
+
+        FTile();
+        ~FTile();
+    };
+
+    struct FDisturbance
+    {
+        FVector2D Location;
+        float Radius;
+        float Strength;
+    };
+
+    /** FindOrAddTile()     @return the tile, nullptr if the tile budget is spent */
+    FTile * FindOrAddTile(const FIntPoint &key);
+
+    /** ApplyDisturbances() add the queued disturbances to the tiles, creating them as needed */
+    void ApplyDisturbances();
+
+    /** StepTiles()         one step of every tile */
+    void StepTiles();
+
+    TMap<FIntPoint, TUniquePtr<FTile>> Tiles;
+    TArray<FDisturbance> Disturbances;
+
+    /** tiles removed since the last upload, to clear from the texture */
+    TArray<FIntPoint> RemovedTiles;
+
+    float CellSize;
+    float Courant2;
+    float Damping;
+    float TimeAccumulator;
+};
@@ -1,18 +1,356 @@
 // Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
 
 #include "SeaSurfaceComponent.h"
+#include "SeaSurfaceSceneProxy.h"
+#include "SeaRippleSimulation.h"
+#include "NAVISStats.h"
 #include "Engine/CanvasRenderTarget2D.h"
+#include "Engine/Canvas.h"
+#include "Engine/World.h"
+#include "Engine/Texture2D.h"
+#include "Misc/App.h"
+#include "Misc/ScopeLock.h"
+#include "CanvasItem.h"
+#include "Materials/MaterialInstanceDynamic.h"
 
-USeaSurfaceComponent::FRenderTargetDimension USeaSurfaceComponent::RenderTargetDimension(1024,1024);
+/** a wave breaks once its height is more than 0.78 times the depth, its amplitude is half of it */
+static const float SeaBreakingRatio = 0.39f;
 
-USeaSurfaceComponent::USeaSurfaceComponent() : Super()
+/** SeaTanh()   hyperbolic tangent of a positive value */
+static FORCEINLINE float SeaTanh(float value)
 {
+    const float Exp = FMath::Exp(-2.f * value);
+    return (1.f - Exp) / (1.f + Exp);
+}
 
+USeaSurfaceComponent::USeaSurfaceComponent() : Super()
+    , RenderTargetResolution(1024, 1024)
+    , InteractionExtent(10000.f)
+    , InteractionTileSize(64)
+    , bTiledSurface(false)
+    , TileResolution(32)
+    , LODCount(8)
+    , MinTileSize(1000.f)
+    , LODDistanceRatio(2.f)
+    , SeaExtent(FVector2D(100.f, 100.f))
+    , bInfiniteSea(false)
+    , InfiniteViewDistance(500000.f)
+    , bEnableRipples(false)
+    , RippleCellSize(50.f)
+    , RippleWaveSpeed(400.f)
+    , RippleDamping(0.99f)
+    , RippleTextureTiles(16)
+    , WaveMaterial(nullptr)
+    , WaveOrigin(FIntVector::ZeroValue)
+    , RippleTexture(nullptr)
+    , BathymetryTexture(nullptr)
+{
+    // only ticks to flush interaction stamps and step ripples, at the end of the frame they were added
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.bStartWithTickEnabled = false;
+    PrimaryComponentTick.TickGroup = TG_LastDemotable;
 }
 
 void USeaSurfaceComponent::BeginPlay()
 {
     Super::BeginPlay();
+
+    WaveMaterial = CreateAndSetMaterialInstanceDynamic(0);
+    UpdateWavePhases();
+
+    if(WaveMaterial && GetRippleTexture())
+    {
+        // local origin and size of the area the texture covers, @see TickComponent()
+        const float TileWorldSize = FSeaRippleSimulation::TileSize * RippleCellSize;
+        const float RippleOrigin = -(RippleTextureTiles / 2) * TileWorldSize;
+        WaveMaterial->SetTextureParameterValue(TEXT("NAVIS_Ripples"), RippleTexture);
+        WaveMaterial->SetVectorParameterValue(TEXT("NAVIS_RippleArea"), FLinearColor(RippleOrigin, RippleOrigin, RippleTextureTiles * TileWorldSize, RippleTextureTiles * TileWorldSize));
+    }
+
+    UpdateBathymetryTexture();
+}
+
+void USeaSurfaceComponent::OnRegister()
+{
+    Super::OnRegister();
+
+    if(GetWorld())
+        WaveOrigin = GetWorld()->OriginLocation;
+    UpdateWavePhases();
+    PublishBathymetry();
+
+    if(!bEnableRipples)
+    {
+        RippleSimulation.Reset();
+    }
+    else
+    {
+        if(!RippleSimulation.IsValid())
+            RippleSimulation = MakeShared<FSeaRippleSimulation>();
+        RippleSimulation->SetParameters(RippleCellSize, RippleWaveSpeed, RippleDamping);
+    }
+}
+
+void USeaSurfaceComponent::ApplyWorldOffset(const FVector& InOffset, bool bWorldShift)
+{
+    Super::ApplyWorldOffset(InOffset, bWorldShift);
+
+    // only a world origin shift moves the frame the waves are evaluated in,
+    // a level offset moves the sea itself. The offset is old origin minus new origin, and origins are integers
+    if(bWorldShift)
+    {
+        WaveOrigin -= FIntVector(InOffset);
+        UpdateWavePhases();
+    }
+}
+
+void USeaSurfaceComponent::OnUpdateTransform(EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+    Super::OnUpdateTransform(UpdateTransformFlags, Teleport);
+
+    // the bathymetry follows the surface, the world space area the material reads moves with it
+    UpdateBathymetryArea();
+}
+
+void USeaSurfaceComponent::UpdateWavePhases()
+{
+    WavePhases.SetNumUninitialized(Waves.Num());
+    TSharedRef<FSeaSwell, ESPMode::ThreadSafe> NewSwell = MakeShared<FSeaSwell, ESPMode::ThreadSafe>();
+    NewSwell->Waves  = Waves;
+    NewSwell->Origin = WaveOrigin;
+    for(int32 Idx = 0; Idx < Waves.Num(); Idx++)
+    {
+        const FSeaWave &Wave = Waves[Idx];
+        const FVector2D Direction = Wave.Direction.GetSafeNormal();
+        const double WaveNumber = 2.0 * PI / FMath::Max(Wave.Wavelength, 1.f);
+
+        // far from the origin, floats would lose the phase : reduce it in double
+        const double OriginDistance = double(Direction.X) * double(WaveOrigin.X) + double(Direction.Y) * double(WaveOrigin.Y);
+        WavePhases[Idx] = float(FMath::Fmod(OriginDistance * WaveNumber, 2.0 * PI));
+
+        if(WaveMaterial)
+        {
+            WaveMaterial->SetVectorParameterValue(*FString::Printf(TEXT("NAVIS_Wave%d"), Idx), FLinearColor(Direction.X, Direction.Y, Wave.Amplitude, Wave.Wavelength));
+            WaveMaterial->SetScalarParameterValue(*FString::Printf(TEXT("NAVIS_WavePhase%d"), Idx), WavePhases[Idx]);
+        }
+    }
+
+    // queries in flight finish with the waves they started with
+    NewSwell->Phases = WavePhases;
+    FScopeLock ScopeLock(&SnapshotLock);
+    SwellSnapshot = NewSwell;
+}
+
+float USeaSurfaceComponent::GetWaveHeightAt(const FVector &worldLocation) const
+{
+    SCOPE_CYCLE_COUNTER(STAT_NAVIS_WaveEvaluation);
+
+    float Height = GetSwellHeightAt(worldLocation, SnapshotSwell());
+
+    // ripples live in local space, they move and scale with the component
+    if(RippleSimulation.IsValid() && RippleSimulation->IsActive())
+    {
+        const FVector Local = WorldToLocalScaledLocation(worldLocation);
+        Height += RippleSimulation->SampleHeight(FVector2D(Local.X, Local.Y)) * GetComponentScale().Z;
+    }
+    return Height;
+}
+
+float USeaSurfaceComponent::GetWaveHeightAt(const FVector &worldLocation, const FSeaSurfaceSnapshot &snapshot) const
+{
+    SCOPE_CYCLE_COUNTER(STAT_NAVIS_WaveEvaluation);
+
+    float Height = GetSwellHeightAt(worldLocation, snapshot);
+    if(snapshot.Ripples.IsValid())
+    {
+        const FVector Local = snapshot.Transform.InverseTransformPosition(worldLocation);
+        Height += snapshot.Ripples->SampleHeight(FVector2D(Local.X, Local.Y)) * snapshot.Transform.GetScale3D().Z;
+    }
+    return Height;
+}
+
+FSeaSurfaceSnapshot USeaSurfaceComponent::SnapshotSurface() const
+{
+    check(IsInGameThread());
+
+    FSeaSurfaceSnapshot Snapshot = SnapshotSwell();
+    if(RippleSimulation.IsValid())
+        Snapshot.Ripples = RippleSimulation->CopyHeights();
+    return Snapshot;
+}
+
+FSeaSurfaceSnapshot USeaSurfaceComponent::SnapshotSwell() const
+{
+    FSeaSurfaceSnapshot Snapshot;
+    Snapshot.Transform = GetComponentTransform();
+    if(const UWorld * World = GetWorld())
+    {
+        Snapshot.Time    = World->GetTimeSeconds();
+        Snapshot.Gravity = FMath::Abs(World->GetGravityZ());
+    }
+    {
+        FScopeLock ScopeLock(&SnapshotLock);
+        Snapshot.Swell      = SwellSnapshot;
+        Snapshot.Bathymetry = BathymetrySnapshot;
+    }
+    return Snapshot;
+}
+
+float USeaSurfaceComponent::GetSwellHeightAt(const FVector &worldLocation, const FSeaSurfaceSnapshot &snapshot)
+{
+    if(!snapshot.Swell.IsValid())
+        return 0.f;
+
+    const FSeaSwell &Swell = *snapshot.Swell;
+    const float Time    = snapshot.Time;
+    const float Gravity = snapshot.Gravity;
+
+    // one lookup for every wave, outside of the grid the water is deep
+    float Depth = 0.f, ShoreDistance = 0.f;
+    const bool bHasDepth = snapshot.Bathymetry.IsValid() && snapshot.Bathymetry->Sample(worldLocation - snapshot.Transform.GetLocation(), Depth, ShoreDistance);
+
+    float Height = 0.f;
+    for(int32 Idx = 0; Idx < Swell.Waves.Num() && Idx < Swell.Phases.Num(); Idx++)
+    {
+        const FSeaWave &Wave = Swell.Waves[Idx];
+        const FVector2D Direction = Wave.Direction.GetSafeNormal();
+        const float WaveNumber  = 2.f * PI / FMath::Max(Wave.Wavelength, 1.f);
+        // deep water dispersion
+        const float Pulsation   = FMath::Sqrt(Gravity * WaveNumber);
+        const float Distance    = Direction.X * worldLocation.X + Direction.Y * worldLocation.Y;
+        float WaveHeight = FMath::Sin(WaveNumber * Distance + Swell.Phases[Idx] - Pulsation * Time);
+        float Amplitude  = Wave.Amplitude;
+
+        if(bHasDepth)
+        {
+            // tanh(k d) is 1 in deep water, where nothing changes
+            const float DepthFactor = SeaTanh(WaveNumber * Depth);
+            if(DepthFactor < 0.99f)
+            {
+                // the pulsation stays, the wave number grows as the depth shrinks (Eckart).
+                // Refraction bends the crests toward the shore : the wave keeps its phase and direction,
+                // and also travels down the shore distance
+                const float ShallowWaveNumber = WaveNumber / FMath::Sqrt(FMath::Max(DepthFactor, 0.01f));
+                const float ShallowHeight = FMath::Sin(WaveNumber * Distance + Swell.Phases[Idx] - ShallowWaveNumber * ShoreDistance - Pulsation * Time);
+                WaveHeight = FMath::Lerp(WaveHeight, ShallowHeight, 1.f - DepthFactor);
+                Amplitude  = FMath::Clamp(Amplitude, -SeaBreakingRatio * Depth, SeaBreakingRatio * Depth);
+            }
+        }
+        Height += Amplitude * WaveHeight;
+    }
+    return Height;
+}
+
+void USeaSurfaceComponent::SetBathymetry(const FSeaBathymetry &newBathymetry)
+{
+    Bathymetry = newBathymetry;
+    PublishBathymetry();
+    UpdateBathymetryTexture();
+}
+
+void USeaSurfaceComponent::PublishBathymetry()
+{
+    TSharedPtr<const FSeaBathymetry, ESPMode::ThreadSafe> NewSnapshot;
+    if(Bathymetry.IsValid())
+        NewSnapshot = MakeShared<const FSeaBathymetry, ESPMode::ThreadSafe>(Bathymetry);
+
+    FScopeLock ScopeLock(&SnapshotLock);
+    BathymetrySnapshot = MoveTemp(NewSnapshot);
+}
+
+void USeaSurfaceComponent::UpdateBathymetryTexture()
+{
+    if(!WaveMaterial || !FApp::CanEverRender())
+        return;
+
+    if(!Bathymetry.IsValid())
+    {
+        BathymetryTexture = nullptr;
+        WaveMaterial->SetVectorParameterValue(TEXT("NAVIS_BathymetryRange"), FLinearColor::Transparent);
+        return;
+    }
+
+    BathymetryTexture = UTexture2D::CreateTransient(Bathymetry.Resolution.X, Bathymetry.Resolution.Y, PF_G16R16);
+    if(!BathymetryTexture)
+        return;
+
+    BathymetryTexture->SRGB = false;
+    BathymetryTexture->Filter = TF_Bilinear;
+    BathymetryTexture->AddressX = TA_Clamp;
+    BathymetryTexture->AddressY = TA_Clamp;
+
+    // depth in R and shore distance in G, the grid is already quantized the way the texture wants it
+    FTexture2DMipMap &Mip = BathymetryTexture->PlatformData->Mips[0];
+    uint16 * Texels = static_cast<uint16*>(Mip.BulkData.Lock(LOCK_READ_WRITE));
+    for(int32 Idx = 0; Idx < Bathymetry.Depths.Num(); Idx++)
+    {
+        Texels[2 * Idx]     = Bathymetry.Depths[Idx];
+        Texels[2 * Idx + 1] = Bathymetry.ShoreDistances[Idx];
+    }
+    Mip.BulkData.Unlock();
+    BathymetryTexture->UpdateResource();
+
+    WaveMaterial->SetTextureParameterValue(TEXT("NAVIS_Bathymetry"), BathymetryTexture);
+    WaveMaterial->SetVectorParameterValue(TEXT("NAVIS_BathymetryRange"), FLinearColor(Bathymetry.MaxDepth, Bathymetry.MaxShoreDistance, 0.f, 0.f));
+    UpdateBathymetryArea();
+}
+
+void USeaSurfaceComponent::UpdateBathymetryArea()
+{
+    if(!WaveMaterial || !BathymetryTexture)
+        return;
+
+    // the material works in world space. Texels are at the samples : the area goes half a cell past the first and last ones
+    const FVector2D Size = FVector2D(Bathymetry.Resolution) * Bathymetry.CellSize;
+    const FVector2D Origin = FVector2D(GetComponentLocation()) + Bathymetry.Origin - FVector2D(0.5f, 0.5f) * Bathymetry.CellSize;
+    WaveMaterial->SetVectorParameterValue(TEXT("NAVIS_BathymetryArea"), FLinearColor(Origin.X, Origin.Y, Size.X, Size.Y));
+}
+
+float USeaSurfaceComponent::GetMaxWaveHeight() const
+{
+    float Height = 0.f;
+    for(const FSeaWave &Wave : Waves)
+    {
+        Height += FMath::Abs(Wave.Amplitude);
+    }
+    return Height;
+}
+
+FPrimitiveSceneProxy* USeaSurfaceComponent::CreateSceneProxy()
+{
+    if(!bTiledSurface)
+        return Super::CreateSceneProxy();
+
+    return new FSeaSurfaceSceneProxy(this);
+}
+
+FBoxSphereBounds USeaSurfaceComponent::CalcBounds(const FTransform & LocalToWorld) const
+{
+    if(!bTiledSurface)
+        return Super::CalcBounds(LocalToWorld);
+
+    // tiles follow the views, anywhere in the world
+    if(bInfiniteSea)
+    {
+        const FVector BoxExtent = FVector(HALF_WORLD_MAX, HALF_WORLD_MAX, FMath::Max(GetMaxWaveHeight(), MinTileSize));
+        return FBoxSphereBounds(LocalToWorld.GetLocation(), BoxExtent, BoxExtent.Size());
+    }
+
+    // tiles are rounded up to whole root tiles, bounds only need to be conservative
+    const float RootSize = MinTileSize * float(1 << FMath::Clamp(LODCount - 1, 0, 15));
+    const FVector BoxExtent = FVector(SeaExtent + FVector2D(RootSize, RootSize), FMath::Max(GetMaxWaveHeight(), MinTileSize));
+    return FBoxSphereBounds(FVector::ZeroVector, BoxExtent, BoxExtent.Size()).TransformBy(LocalToWorld);
+}
+
+bool USeaSurfaceComponent::SetSeaExtent(const FVector2D &newExtent)
+{
+    if(!bTiledSurface)
+        return false;
+
+    SeaExtent = newExtent;
+    UpdateBounds();
+    MarkRenderStateDirty();
+    return true;
 }
 
  FVector USeaSurfaceComponent::WorldToLocalScaledLocation(const FVector &worldLocation) const
@@ -20,11 +358,226 @@ void USeaSurfaceComponent::BeginPlay()
      return GetComponentTransform().InverseTransformPosition(worldLocation);
  }
 
+void USeaSurfaceComponent::GetSurfaceHeights(const TArray<FVector> &worldLocations, TArray<float> &outHeights) const
+{
+    const float SurfaceHeight = GetComponentLocation().Z;
+    outHeights.SetNumUninitialized(worldLocations.Num(), false);
+    for(int32 Idx = 0; Idx < worldLocations.Num(); Idx++)
+    {
+        outHeights[Idx] = SurfaceHeight + GetWaveHeightAt(worldLocations[Idx]);
+    }
+}
+
+bool USeaSurfaceComponent::CanDrawInteraction() const
+{
+    const UWorld * World = GetWorld();
+    return FApp::CanEverRender() && World && World->Scene;
+}
+
 UCanvasRenderTarget2D * USeaSurfaceComponent::GetRenderTarget()
 {
-    if(RenderTarget != nullptr)
+    if(RenderTarget != nullptr || !CanDrawInteraction())
         return RenderTarget;
     
-    RenderTarget = UCanvasRenderTarget2D::CreateCanvasRenderTarget2D(this, UCanvasRenderTarget2D::StaticClass(),RenderTargetDimension.X, RenderTargetDimension.Y );
+    RenderTarget = UCanvasRenderTarget2D::CreateCanvasRenderTarget2D(this, UCanvasRenderTarget2D::StaticClass(), RenderTargetResolution.X, RenderTargetResolution.Y);
+    if(RenderTarget)
+    {
+        // tiles are cleared one by one, a full clear would erase the quiet ones for nothing
+        RenderTarget->bShouldClearRenderTargetOnReceiveUpdate = false;
+        RenderTarget->ClearColor = FLinearColor::Black;
+        RenderTarget->OnCanvasRenderTargetUpdate.AddDynamic(this, &USeaSurfaceComponent::DrawInteraction);
+        RenderTarget->UpdateResourceImmediate(true);
+
+        if(WaveMaterial)
+            WaveMaterial->SetTextureParameterValue(TEXT("NAVIS_Interaction"), RenderTarget);
+    }
+    ResetTiles();
 	return RenderTarget;
+}
+
+void USeaSurfaceComponent::SetRenderTargetResolution(FIntPoint newResolution)
+{
+    newResolution = FIntPoint(FMath::Clamp(newResolution.X, 64, 8192), FMath::Clamp(newResolution.Y, 64, 8192));
+    if(newResolution == RenderTargetResolution)
+        return;
+
+    // stamps are queued in texels of the old resolution
+    RenderTargetResolution = newResolution;
+    PendingStamps.Reset();
+    if(RenderTarget)
+    {
+        RenderTarget->ResizeTarget(RenderTargetResolution.X, RenderTargetResolution.Y);
+        RenderTarget->UpdateResourceImmediate(true);
+    }
+    ResetTiles();
+}
+
+FIntPoint USeaSurfaceComponent::GetTileCount() const
+{
+    const int32 TileSize = FMath::Max(InteractionTileSize, 1);
+    return FIntPoint(FMath::DivideAndRoundUp(RenderTargetResolution.X, TileSize), FMath::DivideAndRoundUp(RenderTargetResolution.Y, TileSize));
+}
+
+void USeaSurfaceComponent::ResetTiles()
+{
+    const FIntPoint TileCount = GetTileCount();
+    DirtyTiles.Init(false, TileCount.X * TileCount.Y);
+    DrawnTiles.Init(false, TileCount.X * TileCount.Y);
+}
+
+void USeaSurfaceComponent::AddInteractionStamp(const FVector &worldLocation, float radius, float strength)
+{
+    if(radius <= 0.f || !GetRenderTarget())
+        return;
+
+    // local XY in [-InteractionExtent, InteractionExtent] maps to the whole target
+    const FVector Local = WorldToLocalScaledLocation(worldLocation);
+    const FVector2D TexelsPerUnit = FVector2D(RenderTargetResolution) / (2.f * InteractionExtent);
+    const FVector2D Center = (FVector2D(Local.X, Local.Y) + FVector2D(InteractionExtent, InteractionExtent)) * TexelsPerUnit;
+    const float Radius = radius / FMath::Max(GetComponentScale().X, KINDA_SMALL_NUMBER) * TexelsPerUnit.X;
+
+    const int32 TileSize = FMath::Max(InteractionTileSize, 1);
+    const FIntPoint TileCount = GetTileCount();
+    const int32 MinX = FMath::Max(0, FMath::FloorToInt((Center.X - Radius) / TileSize));
+    const int32 MaxX = FMath::Min(TileCount.X - 1, FMath::FloorToInt((Center.X + Radius) / TileSize));
+    const int32 MinY = FMath::Max(0, FMath::FloorToInt((Center.Y - Radius) / TileSize));
+    const int32 MaxY = FMath::Min(TileCount.Y - 1, FMath::FloorToInt((Center.Y + Radius) / TileSize));
+
+    // outside of the covered area
+    if(MinX > MaxX || MinY > MaxY)
+        return;
+
+    for(int32 Y = MinY; Y <= MaxY; Y++)
+    {
+        for(int32 X = MinX; X <= MaxX; X++)
+        {
+            DirtyTiles[Y * TileCount.X + X] = true;
+        }
+    }
+
+    PendingStamps.Add({ Center, Radius, strength });
+    SetComponentTickEnabled(true);
+}
+
+void USeaSurfaceComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction)
+{
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    // one repaint for every stamp of the frame, @see DrawInteraction(). UpdateResource() would recreate the target
+    const bool bHasWork = PendingStamps.Num() > 0 || DrawnTiles.Contains(true);
+    if(bHasWork && GetRenderTarget())
+    {
+        RenderTarget->RepaintCanvas();
+    }
+
+    // cost follows the disturbed area, servers only need the heights
+    if(RippleSimulation.IsValid() && RippleSimulation->IsActive())
+    {
+        RippleSimulation->Step(DeltaTime);
+
+        const int32 HalfTiles = RippleTextureTiles / 2;
+        if(FApp::CanEverRender() && GetRippleTexture())
+            RippleSimulation->UpdateTexture(RippleTexture, FIntPoint(-HalfTiles, -HalfTiles));
+    }
+
+    // keep ticking one more frame to clear what was drawn, quiet seas then stop ticking
+    const bool bRipplesActive = RippleSimulation.IsValid() && RippleSimulation->IsActive();
+    if(!DrawnTiles.Contains(true) && !bRipplesActive)
+    {
+        SetComponentTickEnabled(false);
+    }
+}
+
+void USeaSurfaceComponent::AddRippleDisturbance(const FVector &worldLocation, float radius, float strength)
+{
+    if(!RippleSimulation.IsValid())
+        return;
+
+    const FVector Local = WorldToLocalScaledLocation(worldLocation);
+    const FVector Scale = GetComponentScale();
+    RippleSimulation->AddDisturbance(FVector2D(Local.X, Local.Y), radius / FMath::Max(Scale.X, KINDA_SMALL_NUMBER), strength / FMath::Max(Scale.Z, KINDA_SMALL_NUMBER));
+    SetComponentTickEnabled(true);
+}
+
+UTexture2D * USeaSurfaceComponent::GetRippleTexture()
+{
+    if(RippleTexture || !RippleSimulation.IsValid() || !FApp::CanEverRender())
+        return RippleTexture;
+
+    const int32 Size = RippleTextureTiles * FSeaRippleSimulation::TileSize;
+    RippleTexture = UTexture2D::CreateTransient(Size, Size, PF_R32_FLOAT);
+    if(RippleTexture)
+    {
+        RippleTexture->SRGB = false;
+        RippleTexture->Filter = TF_Bilinear;
+        RippleTexture->AddressX = TA_Clamp;
+        RippleTexture->AddressY = TA_Clamp;
+
+        // transient textures start with garbage, tiles only ever upload where ripples are
+        FTexture2DMipMap &Mip = RippleTexture->PlatformData->Mips[0];
+        void * MipData = Mip.BulkData.Lock(LOCK_READ_WRITE);
+        FMemory::Memzero(MipData, Mip.BulkData.GetBulkDataSize());
+        Mip.BulkData.Unlock();
+
+        RippleTexture->UpdateResource();
+    }
+    return RippleTexture;
+}
+
+void USeaSurfaceComponent::DrawInteraction(UCanvas* canvas, int32 width, int32 height)
+{
+    if(!canvas || !canvas->Canvas || DirtyTiles.Num() != DrawnTiles.Num())
+        return;
+
+    const int32 TileSize = FMath::Max(InteractionTileSize, 1);
+    const FIntPoint TileCount = GetTileCount();
+
+    // tiles drawn last time and not touched now get cleared, touched ones get cleared then stamped
+    FCanvasTriangleItem ClearItem(FVector2D::ZeroVector, FVector2D::ZeroVector, FVector2D::ZeroVector, GWhiteTexture);
+    ClearItem.TriangleList.Reset();
+    ClearItem.BlendMode = SE_BLEND_Opaque;
+    for(int32 TileIdx = 0; TileIdx < DirtyTiles.Num(); TileIdx++)
+    {
+        if(!DirtyTiles[TileIdx] && !DrawnTiles[TileIdx])
+            continue;
+
+        const FVector2D Min = FVector2D((TileIdx % TileCount.X) * TileSize, (TileIdx / TileCount.X) * TileSize);
+        const FVector2D Max = Min + FVector2D(TileSize, TileSize);
+
+        FCanvasUVTri Tri;
+        Tri.V0_Color = Tri.V1_Color = Tri.V2_Color = FLinearColor::Black;
+        Tri.V0_Pos = Min;                   Tri.V1_Pos = FVector2D(Max.X, Min.Y);   Tri.V2_Pos = Max;
+        ClearItem.TriangleList.Add(Tri);
+        Tri.V0_Pos = Min;                   Tri.V1_Pos = Max;                       Tri.V2_Pos = FVector2D(Min.X, Max.Y);
+        ClearItem.TriangleList.Add(Tri);
+    }
+    if(ClearItem.TriangleList.Num() > 0)
+        canvas->DrawItem(ClearItem);
+
+    // every stamp in a single batch : a fan fading from the strength at the center to nothing at the radius
+    const int32 FanSegments = 12;
+    FCanvasTriangleItem StampItem(FVector2D::ZeroVector, FVector2D::ZeroVector, FVector2D::ZeroVector, GWhiteTexture);
+    StampItem.TriangleList.Reset(PendingStamps.Num() * FanSegments);
+    StampItem.BlendMode = SE_BLEND_Additive;
+    for(const FSeaInteractionStamp &Stamp : PendingStamps)
+    {
+        FCanvasUVTri Tri;
+        Tri.V0_Pos = Stamp.Center;
+        Tri.V0_Color = FLinearColor(Stamp.Strength, Stamp.Strength, Stamp.Strength, 1.f);
+        Tri.V1_Color = Tri.V2_Color = FLinearColor(0.f, 0.f, 0.f, 1.f);
+        for(int32 Segment = 0; Segment < FanSegments; Segment++)
+        {
+            const float Angle0 = 2.f * PI * Segment / FanSegments;
+            const float Angle1 = 2.f * PI * (Segment + 1) / FanSegments;
+            Tri.V1_Pos = Stamp.Center + Stamp.Radius * FVector2D(FMath::Cos(Angle0), FMath::Sin(Angle0));
+            Tri.V2_Pos = Stamp.Center + Stamp.Radius * FVector2D(FMath::Cos(Angle1), FMath::Sin(Angle1));
+            StampItem.TriangleList.Add(Tri);
+        }
+    }
+    if(StampItem.TriangleList.Num() > 0)
+        canvas->DrawItem(StampItem);
+
+    DrawnTiles = DirtyTiles;
+    DirtyTiles.Init(false, DirtyTiles.Num());
+    PendingStamps.Reset();
 }
\ No newline at end of file
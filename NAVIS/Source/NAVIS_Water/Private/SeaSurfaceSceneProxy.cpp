@@ -0,0 +1,309 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#include "SeaSurfaceSceneProxy.h"
+#include "SeaSurfaceComponent.h"
+#include "Materials/Material.h"
+#include "Engine/Engine.h"
+#include "SceneManagement.h"
+
+
+FSeaSurfaceSceneProxy::FSeaSurfaceSceneProxy(USeaSurfaceComponent* Component) : FPrimitiveSceneProxy(Component)
+	, MaterialRelevance(Component->GetMaterialRelevance(GetScene().GetFeatureLevel()))
+	, VertexFactory(GetScene().GetFeatureLevel())
+{
+	// even resolution : every odd vertex of an edge has an even neighbour to be snapped on
+	TileResolution		= FMath::Clamp(Component->TileResolution & ~1, 2, 254);
+	MinTileSize			= FMath::Max(Component->MinTileSize, 1.f);
+	LODDistanceRatio	= FMath::Max(Component->LODDistanceRatio, 1.5f);
+	HeightMargin		= FMath::Max(Component->GetMaxWaveHeight(), 0.1f * MinTileSize);
+	bInfiniteSea		= Component->bInfiniteSea;
+	ViewDistance		= FMath::Max(Component->InfiniteViewDistance, MinTileSize);
+
+	// no need for root tiles bigger than the area drawn
+	const float SeaSize = 2.f * FMath::Max(bInfiniteSea ? ViewDistance : Component->SeaExtent.GetMax(), MinTileSize * 0.5f);
+	const int32 MaxUsefulLOD = FMath::CeilLogTwo(FMath::CeilToInt(SeaSize / MinTileSize));
+	LODCount = FMath::Clamp(FMath::Min(Component->LODCount, MaxUsefulLOD + 1), 1, 16);
+
+	const float RootSize = GetTileSize(LODCount - 1);
+	SeaRoots.NumRoots = FIntPoint(
+		FMath::Max(1, FMath::CeilToInt(2.f * Component->SeaExtent.X / RootSize)),
+		FMath::Max(1, FMath::CeilToInt(2.f * Component->SeaExtent.Y / RootSize)));
+	SeaRoots.Origin = -0.5f * RootSize * FVector2D(SeaRoots.NumRoots.X, SeaRoots.NumRoots.Y);
+
+	BuildGrid();
+
+	VertexFactory.Init(&VertexBuffer);
+
+	BeginInitResource(&VertexBuffer);
+	BeginInitResource(&IndexBuffer);
+	BeginInitResource(&VertexFactory);
+
+	Material = Component->GetMaterial(0);
+	if (Material == nullptr)
+	{
+		Material = UMaterial::GetDefaultMaterial(MD_Surface);
+	}
+}
+
+FSeaSurfaceSceneProxy::~FSeaSurfaceSceneProxy()
+{
+	VertexBuffer.ReleaseResource();
+	IndexBuffer.ReleaseResource();
+	VertexFactory.ReleaseResource();
+}
+
+void FSeaSurfaceSceneProxy::BuildGrid()
+{
+	const int32 N = TileResolution;
+	const int32 Stride = N + 1;
+	const FColor VertexColor(255, 255, 255);
+
+	// unit grid centered on the origin, tiles scale and move it
+	VertexBuffer.Vertices.Reset(Stride * Stride);
+	for (int32 Y = 0; Y <= N; Y++)
+	{
+		for (int32 X = 0; X <= N; X++)
+		{
+			const FVector2D UV(float(X) / N, float(Y) / N);
+			const FVector Position(UV.X - 0.5f, UV.Y - 0.5f, 0.f);
+			VertexBuffer.Vertices.Add(FDynamicMeshVertex(Position, FVector::ForwardVector, FVector::UpVector, UV, VertexColor));
+		}
+	}
+
+	// snap odd vertices of a stitched edge on their even neighbour : the edge then matches the coarser tile next to it
+	auto GetIndex = [N, Stride](int32 X, int32 Y, uint8 Mask) -> uint16
+	{
+		if ((Mask & North) && Y == N && (X & 1)) X--;
+		if ((Mask & South) && Y == 0 && (X & 1)) X--;
+		if ((Mask & East)  && X == N && (Y & 1)) Y--;
+		if ((Mask & West)  && X == 0 && (Y & 1)) Y--;
+		return uint16(Y * Stride + X);
+	};
+
+	IndexBuffer.Indices.Reset(NumStitchVariants * N * N * 6);
+	for (uint8 Mask = 0; Mask < NumStitchVariants; Mask++)
+	{
+		VariantFirstIndex[Mask] = IndexBuffer.Indices.Num();
+		for (int32 Y = 0; Y < N; Y++)
+		{
+			for (int32 X = 0; X < N; X++)
+			{
+				const uint16 V00 = GetIndex(X, Y, Mask);
+				const uint16 V10 = GetIndex(X + 1, Y, Mask);
+				const uint16 V01 = GetIndex(X, Y + 1, Mask);
+				const uint16 V11 = GetIndex(X + 1, Y + 1, Mask);
+
+				const uint16 Triangles[2][3] = { { V00, V01, V11 }, { V00, V11, V10 } };
+				for (const uint16 (&Tri)[3] : Triangles)
+				{
+					// snapping collapses some triangles, no need to send them
+					if (Tri[0] == Tri[1] || Tri[1] == Tri[2] || Tri[0] == Tri[2])
+						continue;
+					IndexBuffer.Indices.Add(Tri[0]);
+					IndexBuffer.Indices.Add(Tri[1]);
+					IndexBuffer.Indices.Add(Tri[2]);
+				}
+			}
+		}
+		VariantNumTriangles[Mask] = (IndexBuffer.Indices.Num() - VariantFirstIndex[Mask]) / 3;
+	}
+}
+
+FBox FSeaSurfaceSceneProxy::GetNodeBox(const FVector2D& Center, float Size) const
+{
+	const FVector HalfSize(0.5f * Size, 0.5f * Size, HeightMargin);
+	const FVector Center3d(Center, 0.f);
+	return FBox(Center3d - HalfSize, Center3d + HalfSize);
+}
+
+bool FSeaSurfaceSceneProxy::ShouldSplit(const FVector& LocalViewOrigin, const FVector2D& Center, int32 LOD) const
+{
+	if (LOD == 0)
+		return false;
+	const float Size = GetTileSize(LOD);
+	const float SplitDistance = Size * LODDistanceRatio;
+	if (GetNodeBox(Center, Size).ComputeSquaredDistanceToPoint(LocalViewOrigin) < SplitDistance * SplitDistance)
+		return true;
+	if (LOD == 1)
+		return false;
+
+	// the stitching only matches a neighbour one LOD coarser : split as well when the half of a neighbour
+	// along an edge splits, it would reach LOD - 2 there. Ratios above sqrt(2) never get here on their own
+	const float HalfSplitDistance = 0.5f * SplitDistance;
+	const float Offset = 0.75f * Size;
+	const FVector AlongX(0.25f * Size, 0.5f * Size, HeightMargin);
+	const FVector AlongY(0.5f * Size, 0.25f * Size, HeightMargin);
+	const FBox Halves[4] =
+	{
+		FBox::BuildAABB(FVector(Center.X, Center.Y + Offset, 0.f), AlongY),
+		FBox::BuildAABB(FVector(Center.X + Offset, Center.Y, 0.f), AlongX),
+		FBox::BuildAABB(FVector(Center.X, Center.Y - Offset, 0.f), AlongY),
+		FBox::BuildAABB(FVector(Center.X - Offset, Center.Y, 0.f), AlongX),
+	};
+	for (const FBox& Half : Halves)
+	{
+		if (Half.ComputeSquaredDistanceToPoint(LocalViewOrigin) < HalfSplitDistance * HalfSplitDistance)
+			return true;
+	}
+	return false;
+}
+
+void FSeaSurfaceSceneProxy::SelectNode(const FSceneView* View, const FVector& LocalViewOrigin, const FVector2D& Center, int32 LOD, TArray<FSelectedTile>& OutTiles) const
+{
+	const float Size = GetTileSize(LOD);
+	const FBox WorldBox = GetNodeBox(Center, Size).TransformBy(GetLocalToWorld());
+	if (!View->ViewFrustum.IntersectBox(WorldBox.GetCenter(), WorldBox.GetExtent()))
+		return;
+
+	if (!ShouldSplit(LocalViewOrigin, Center, LOD))
+	{
+		OutTiles.Add({ Center, Size, LOD });
+		return;
+	}
+
+	const float Quarter = 0.25f * Size;
+	SelectNode(View, LocalViewOrigin, Center + FVector2D(-Quarter, -Quarter), LOD - 1, OutTiles);
+	SelectNode(View, LocalViewOrigin, Center + FVector2D( Quarter, -Quarter), LOD - 1, OutTiles);
+	SelectNode(View, LocalViewOrigin, Center + FVector2D(-Quarter,  Quarter), LOD - 1, OutTiles);
+	SelectNode(View, LocalViewOrigin, Center + FVector2D( Quarter,  Quarter), LOD - 1, OutTiles);
+}
+
+FSeaSurfaceSceneProxy::FRootGrid FSeaSurfaceSceneProxy::GetRootGrid(const FVector& LocalViewOrigin) const
+{
+	if (!bInfiniteSea)
+		return SeaRoots;
+
+	// snapped on the root size : the same node always covers the same area, whatever the view
+	const float RootSize = GetTileSize(LODCount - 1);
+	const int32 MinX = FMath::FloorToInt((LocalViewOrigin.X - ViewDistance) / RootSize);
+	const int32 MinY = FMath::FloorToInt((LocalViewOrigin.Y - ViewDistance) / RootSize);
+	const int32 MaxX = FMath::CeilToInt((LocalViewOrigin.X + ViewDistance) / RootSize);
+	const int32 MaxY = FMath::CeilToInt((LocalViewOrigin.Y + ViewDistance) / RootSize);
+
+	FRootGrid Roots;
+	Roots.NumRoots = FIntPoint(MaxX - MinX, MaxY - MinY);
+	Roots.Origin = RootSize * FVector2D(MinX, MinY);
+	return Roots;
+}
+
+int32 FSeaSurfaceSceneProxy::GetLODAt(const FRootGrid& Roots, const FVector& LocalViewOrigin, const FVector2D& Location) const
+{
+	int32 LOD = LODCount - 1;
+	float Size = GetTileSize(LOD);
+
+	const FVector2D RootCoord = (Location - Roots.Origin) / Size;
+	const int32 RootX = FMath::FloorToInt(RootCoord.X);
+	const int32 RootY = FMath::FloorToInt(RootCoord.Y);
+	if (RootX < 0 || RootY < 0 || RootX >= Roots.NumRoots.X || RootY >= Roots.NumRoots.Y)
+		return INDEX_NONE;
+
+	FVector2D Center = Roots.Origin + Size * FVector2D(RootX + 0.5f, RootY + 0.5f);
+	while (ShouldSplit(LocalViewOrigin, Center, LOD))
+	{
+		const float Quarter = 0.25f * Size;
+		Center.X += Location.X < Center.X ? -Quarter : Quarter;
+		Center.Y += Location.Y < Center.Y ? -Quarter : Quarter;
+		Size *= 0.5f;
+		LOD--;
+	}
+	return LOD;
+}
+
+void FSeaSurfaceSceneProxy::GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_SeaSurfaceSceneProxy_GetDynamicMeshElements);
+
+	const bool bWireframe = AllowDebugViewmodes() && ViewFamily.EngineShowFlags.Wireframe;
+
+	FMaterialRenderProxy* MaterialProxy = Material->GetRenderProxy();
+	if (bWireframe)
+	{
+		auto WireframeMaterialInstance = new FColoredMaterialRenderProxy(
+			GEngine->WireframeMaterial ? GEngine->WireframeMaterial->GetRenderProxy() : nullptr,
+			FLinearColor(0, 0.5f, 1.f)
+			);
+		Collector.RegisterOneFrameMaterialProxy(WireframeMaterialInstance);
+		MaterialProxy = WireframeMaterialInstance;
+	}
+
+	const float RootSize = GetTileSize(LODCount - 1);
+	TArray<FSelectedTile> Tiles;
+
+	for (int32 ViewIndex = 0; ViewIndex < Views.Num(); ViewIndex++)
+	{
+		if (!(VisibilityMap & (1 << ViewIndex)))
+			continue;
+
+		const FSceneView* View = Views[ViewIndex];
+		const FVector LocalViewOrigin = GetLocalToWorld().InverseTransformPosition(View->ViewMatrices.GetViewOrigin());
+
+		// selection
+		const FRootGrid Roots = GetRootGrid(LocalViewOrigin);
+		Tiles.Reset();
+		for (int32 RootY = 0; RootY < Roots.NumRoots.Y; RootY++)
+		{
+			for (int32 RootX = 0; RootX < Roots.NumRoots.X; RootX++)
+			{
+				const FVector2D RootCenter = Roots.Origin + RootSize * FVector2D(RootX + 0.5f, RootY + 0.5f);
+				SelectNode(View, LocalViewOrigin, RootCenter, LODCount - 1, Tiles);
+			}
+		}
+
+		// one batch per tile, the grid is moved and scaled through the primitive uniform buffer
+		for (const FSelectedTile& Tile : Tiles)
+		{
+			// neighbours are at most one LOD coarser, @see ShouldSplit() : sample just past each edge
+			const float Probe = 0.75f * Tile.Size;
+			uint8 Mask = 0;
+			Mask |= GetLODAt(Roots, LocalViewOrigin, Tile.Center + FVector2D(0.f,  Probe)) > Tile.LOD ? North : 0;
+			Mask |= GetLODAt(Roots, LocalViewOrigin, Tile.Center + FVector2D( Probe, 0.f)) > Tile.LOD ? East  : 0;
+			Mask |= GetLODAt(Roots, LocalViewOrigin, Tile.Center + FVector2D(0.f, -Probe)) > Tile.LOD ? South : 0;
+			Mask |= GetLODAt(Roots, LocalViewOrigin, Tile.Center + FVector2D(-Probe, 0.f)) > Tile.LOD ? West  : 0;
+
+			const FMatrix TileToLocal = FScaleMatrix(FVector(Tile.Size, Tile.Size, 1.f)) * FTranslationMatrix(FVector(Tile.Center, 0.f));
+			const FMatrix TileToWorld = TileToLocal * GetLocalToWorld();
+			const FBoxSphereBounds TileLocalBounds(FBox(FVector(-0.5f, -0.5f, -HeightMargin), FVector(0.5f, 0.5f, HeightMargin)));
+			const FBoxSphereBounds TileWorldBounds(GetNodeBox(Tile.Center, Tile.Size).TransformBy(GetLocalToWorld()));
+
+			FDynamicPrimitiveUniformBuffer& DynamicPrimitiveUniformBuffer = Collector.AllocateOneFrameResource<FDynamicPrimitiveUniformBuffer>();
+			DynamicPrimitiveUniformBuffer.Set(TileToWorld, TileToWorld, TileWorldBounds, TileLocalBounds, true, false, DrawsVelocity(), false);
+
+			FMeshBatch& Mesh = Collector.AllocateMesh();
+			FMeshBatchElement& BatchElement = Mesh.Elements[0];
+			BatchElement.IndexBuffer = &IndexBuffer;
+			BatchElement.PrimitiveUniformBufferResource = &DynamicPrimitiveUniformBuffer.UniformBuffer;
+			BatchElement.FirstIndex = VariantFirstIndex[Mask];
+			BatchElement.NumPrimitives = VariantNumTriangles[Mask];
+			BatchElement.MinVertexIndex = 0;
+			BatchElement.MaxVertexIndex = VertexBuffer.Vertices.Num() - 1;
+			Mesh.bWireframe = bWireframe;
+			Mesh.VertexFactory = &VertexFactory;
+			Mesh.MaterialRenderProxy = MaterialProxy;
+			Mesh.ReverseCulling = IsLocalToWorldDeterminantNegative();
+			Mesh.Type = PT_TriangleList;
+			Mesh.DepthPriorityGroup = SDPG_World;
+			Mesh.bCanApplyViewModeOverrides = false;
+			Collector.AddMesh(ViewIndex, Mesh);
+		}
+	}
+}
+
+FPrimitiveViewRelevance FSeaSurfaceSceneProxy::GetViewRelevance(const FSceneView* View) const
+{
+	FPrimitiveViewRelevance Result;
+	Result.bDrawRelevance = IsShown(View);
+	Result.bShadowRelevance = IsShadowCast(View);
+	Result.bDynamicRelevance = true;
+	MaterialRelevance.SetPrimitiveViewRelevance(Result);
+	return Result;
+}
+
+SIZE_T FSeaSurfaceSceneProxy::GetTypeHash() const
+{
+	return 5457217LL /* SEA in ASCII */;
+}
+
+uint32 FSeaSurfaceSceneProxy::GetAllocatedSize() const
+{
+	return FPrimitiveSceneProxy::GetAllocatedSize() + VertexBuffer.Vertices.GetAllocatedSize() + IndexBuffer.Indices.GetAllocatedSize();
+}
@@ -0,0 +1,176 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "NAVIS_WaterPCH.h"
+#include "PrimitiveSceneProxy.h"
+#include "DynamicMeshBuilder.h"
+#include "LocalVertexFactory.h"
+#include "Materials/MaterialInterface.h"
+
+class USeaSurfaceComponent;
+
+/** Vertex buffer of the grid shared by every tile */
+class FSeaTileVertexBuffer : public FVertexBuffer
+{
+public:
+	TArray<FDynamicMeshVertex> Vertices;
+
+	virtual void InitRHI() override
+	{
+		FRHIResourceCreateInfo CreateInfo;
+		VertexBufferRHI = RHICreateVertexBuffer(Vertices.Num() * sizeof(FDynamicMeshVertex), BUF_Static, CreateInfo);
+
+		void* VertexBufferData = RHILockVertexBuffer(VertexBufferRHI, 0, Vertices.Num() * sizeof(FDynamicMeshVertex), RLM_WriteOnly);
+		FMemory::Memcpy(VertexBufferData, Vertices.GetData(), Vertices.Num() * sizeof(FDynamicMeshVertex));
+		RHIUnlockVertexBuffer(VertexBufferRHI);
+	}
+};
+
+/** Index buffer holding every stitching variant of the grid, one after the other */
+class FSeaTileIndexBuffer : public FIndexBuffer
+{
+public:
+	TArray<uint16> Indices;
+
+	virtual void InitRHI() override
+	{
+		FRHIResourceCreateInfo CreateInfo;
+		IndexBufferRHI = RHICreateIndexBuffer(sizeof(uint16), Indices.Num() * sizeof(uint16), BUF_Static, CreateInfo);
+
+		void* Buffer = RHILockIndexBuffer(IndexBufferRHI, 0, Indices.Num() * sizeof(uint16), RLM_WriteOnly);
+		FMemory::Memcpy(Buffer, Indices.GetData(), Indices.Num() * sizeof(uint16));
+		RHIUnlockIndexBuffer(IndexBufferRHI);
+	}
+};
+
+/** Vertex Factory */
+class FSeaTileVertexFactory : public FLocalVertexFactory
+{
+public:
+
+	FSeaTileVertexFactory(ERHIFeatureLevel::Type InFeatureLevel) : FLocalVertexFactory(InFeatureLevel, "NAVIS_SEA_TILE")
+	{}
+
+	/** Initialization */
+	void Init(const FSeaTileVertexBuffer* VertexBuffer)
+	{
+		check(!IsInRenderingThread());
+
+		FSeaTileVertexFactory* This = this;
+		ENQUEUE_RENDER_COMMAND(InitSeaTileVertexFactory)(
+			[This, VertexBuffer](FRHICommandListImmediate& RHICmdList)
+		{
+			FDataType NewData;
+			NewData.PositionComponent = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FDynamicMeshVertex, Position, VET_Float3);
+			NewData.TextureCoordinates.Add(
+				FVertexStreamComponent(VertexBuffer, STRUCT_OFFSET(FDynamicMeshVertex, TextureCoordinate), sizeof(FDynamicMeshVertex), VET_Float2)
+			);
+			NewData.TangentBasisComponents[0] = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FDynamicMeshVertex, TangentX, VET_PackedNormal);
+			NewData.TangentBasisComponents[1] = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FDynamicMeshVertex, TangentZ, VET_PackedNormal);
+			NewData.ColorComponent = STRUCTMEMBER_VERTEXSTREAMCOMPONENT(VertexBuffer, FDynamicMeshVertex, Color, VET_Color);
+			This->SetData(NewData);
+		});
+	}
+};
+
+/**
+ *	FSeaSurfaceSceneProxy
+ *	Draws the sea as a CDLOD quadtree : every tile uses the same grid, scaled to its LOD.
+ *	Tiles are selected per view with frustum culling, and edges next to a coarser tile
+ *	use a stitched index range so the surface has no cracks.
+ */
+class FSeaSurfaceSceneProxy : public FPrimitiveSceneProxy
+{
+public:
+
+	FSeaSurfaceSceneProxy(USeaSurfaceComponent* Component);
+
+	virtual ~FSeaSurfaceSceneProxy();
+
+	//~ Begin FPrimitiveSceneProxy Interface.
+	virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views, const FSceneViewFamily& ViewFamily, uint32 VisibilityMap, FMeshElementCollector& Collector) const override;
+	virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override;
+	virtual bool CanBeOccluded() const override { return !MaterialRelevance.bDisableDepthTest; }
+	virtual uint32 GetMemoryFootprint() const override { return sizeof(*this) + GetAllocatedSize(); }
+	virtual SIZE_T GetTypeHash() const override;
+	//~ End FPrimitiveSceneProxy Interface.
+
+	uint32 GetAllocatedSize() const;
+
+private:
+
+	/** Edges of a tile, used as bits of the stitching mask */
+	enum ETileEdge : uint8
+	{
+		North	= 1 << 0,	// +Y
+		East	= 1 << 1,	// +X
+		South	= 1 << 2,	// -Y
+		West	= 1 << 3,	// -X
+		NumStitchVariants = 16
+	};
+
+	/** A tile chosen for a view */
+	struct FSelectedTile
+	{
+		FVector2D	Center;
+		float		Size;
+		int32		LOD;
+	};
+
+	/** BuildGrid()	fill the shared vertex buffer and every stitching variant of the index buffer */
+	void BuildGrid();
+
+	/** Root nodes of the quadtree, laid as a grid */
+	struct FRootGrid
+	{
+		FIntPoint	NumRoots;
+		FVector2D	Origin;
+	};
+
+	/** GetRootGrid()	roots covering the sea, or the area around the view for an infinite sea */
+	FRootGrid GetRootGrid(const FVector& LocalViewOrigin) const;
+
+	/** SelectNode()	walk down the quadtree, keeping the nodes that are far enough or at the finest LOD */
+	void SelectNode(const FSceneView* View, const FVector& LocalViewOrigin, const FVector2D& Center, int32 LOD, TArray<FSelectedTile>& OutTiles) const;
+
+	/** GetLODAt()	LOD that the selection picks at a location, frustum aside. INDEX_NONE outside of the sea */
+	int32 GetLODAt(const FRootGrid& Roots, const FVector& LocalViewOrigin, const FVector2D& Location) const;
+
+	/** GetNodeBox()	local bounds of a quadtree node */
+	FBox GetNodeBox(const FVector2D& Center, float Size) const;
+
+	/** ShouldSplit()	whether a node is too close to the view for its LOD, or to a neighbour that would end two LODs finer */
+	bool ShouldSplit(const FVector& LocalViewOrigin, const FVector2D& Center, int32 LOD) const;
+
+	/** GetTileSize()	world size of a tile at a LOD */
+	float GetTileSize(int32 LOD) const { return MinTileSize * float(1 << LOD); }
+
+	UMaterialInterface*		Material;
+	FMaterialRelevance		MaterialRelevance;
+
+	FSeaTileVertexBuffer	VertexBuffer;
+	FSeaTileIndexBuffer		IndexBuffer;
+	FSeaTileVertexFactory	VertexFactory;
+
+	/** First index and number of triangles of each stitching variant in @see IndexBuffer */
+	uint32 VariantFirstIndex[NumStitchVariants];
+	uint32 VariantNumTriangles[NumStitchVariants];
+
+	int32		TileResolution;
+	int32		LODCount;
+	float		MinTileSize;
+	float		LODDistanceRatio;
+
+	/** Roots covering the sea extent, unused for an infinite sea */
+	FRootGrid	SeaRoots;
+
+	/** bInfiniteSea	roots follow each view, snapped to the root size so tiles never slide */
+	bool		bInfiniteSea;
+
+	/** ViewDistance		how far the tiles reach around the view for an infinite sea */
+	float		ViewDistance;
+
+	/** Vertical half size of the tiles bounds, leaves room for waves */
+	float		HeightMargin;
+};
@@ -6,9 +6,22 @@
 #include "SeaActor.generated.h"
 
 class USeaSurfaceComponent;
+class USeaLiquidComponent;
 class UBoxComponent;
 class UPostProcessComponent;
 
+/** 
+ *  NAVIS_WATER
+ *	ESeaDetectionMode 
+ *  How a sea finds out what is in its water
+ */
+UENUM(BlueprintType)
+enum class ESeaDetectionMode : uint8
+{
+    Overlap         UMETA(DisplayName = "Overlap Volume"),  /** PhysX overlap callbacks on the volume component     */
+    SurfaceTest     UMETA(DisplayName = "Surface Test")     /** per tick batched test of registered components bounds against the surface */
+};
+
 /** 
  *  NAVIS_WATER
  *	ASeaActor 
@@ -26,6 +39,8 @@ public:
 
     //~ Begin AActor Interface.
     virtual void BeginPlay() override;
+    virtual void OnConstruction(const FTransform& Transform) override;
+    virtual void Tick(float DeltaSeconds) override;
     //~ End AActor Interface.
 
 
@@ -34,8 +49,51 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, BlueprintSetter = "ApplyExtent" )
     FVector2D Extent;
 
+    /**
+     *  DetectionMode   How we know what is in the water
+     *  @note           SurfaceTest removes VolumeComp from the physics scene, only registered components are then considered
+     *  @see            RegisterFloatingComponent()
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly)
+    ESeaDetectionMode DetectionMode;
+
+    /**
+     *  FollowSnapSize  Step by which the water volume follows the players when the surface is infinite
+     *  @note           the volume only moves once a viewer crossed a step, to avoid touching physics every tick
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "100.0"))
+    float FollowSnapSize;
+
+    /**
+     *  WakeStrength    Ripple dip per unit of speed of a registered component crossing the surface, 0 turns wakes off
+     *  @note           only used with ESeaDetectionMode::SurfaceTest. Ripples and foam stamps follow the waterline of the convex elements,
+     *                  foam only where something is rendered
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (ClampMin = "0.0"))
+    float WakeStrength;
+
+    /** BathymetryCellSize      distance between two depth samples of @see BakeBathymetry(), grows to keep the grid under 4096 samples a side */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bathymetry", meta = (ClampMin = "10.0"))
+    float BathymetryCellSize;
+
+    /** BathymetryMaxDepth      deepest water told apart, waves are not affected by the seabed long before */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bathymetry", meta = (ClampMin = "100.0"))
+    float BathymetryMaxDepth;
+
+    /** BathymetryMaxShoreDistance  furthest distance to the shore told apart */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Bathymetry", meta = (ClampMin = "100.0"))
+    float BathymetryMaxShoreDistance;
+
 public:
 
+    /**
+	 * 	BakeBathymetry()	        Trace the seabed under @see Extent and give the depths to the surface, saved with the level
+     *  @note                       traces world static geometry, landscapes included, on worker threads.
+     *                              The grid is world aligned : bake again after moving or resizing the sea
+	 */
+    UFUNCTION(CallInEditor, BlueprintCallable, Category = "Bathymetry")
+    void BakeBathymetry();
+
     /**
 	 * 	ApplyExtent()		        Change the Extent of the Water Area
 	 * 	@param newExtent			the new extent you want to apply
@@ -44,6 +102,29 @@ public:
     UFUNCTION(BlueprintSetter, BlueprintCallable)
     void ApplyExtent(const FVector2D &newExtent);
 
+    /**
+	 * 	SetDetectionMode()	        Change how the sea finds out what is in its water, at runtime
+	 * 	@param newMode			    the new mode, registered components are kept either way
+	 *	@note						everything in the water leaves it, then enters again as the new mode finds it
+	 */
+    UFUNCTION(BlueprintCallable)
+    void SetDetectionMode(ESeaDetectionMode newMode);
+
+    /**
+	 * 	RegisterFloatingComponent()	Add a component to the ones tested against the surface every tick
+	 * 	@param component			the component that may enter or leave the water
+     *  @note                       only used with ESeaDetectionMode::SurfaceTest
+	 */
+    UFUNCTION(BlueprintCallable)
+    void RegisterFloatingComponent(UPrimitiveComponent * component);
+
+    /**
+	 * 	UnregisterFloatingComponent()	Stop testing a component against the surface, will call leave events if it was in the water
+	 * 	@param component				the component previously registered
+	 */
+    UFUNCTION(BlueprintCallable)
+    void UnregisterFloatingComponent(UPrimitiveComponent * component);
+
 
 protected:
 
@@ -51,6 +132,7 @@ protected:
     static FName SurfaceName;       /** SurfaceName         static name for @see SurfaceComp  */
     static FName VolumeName;        /** VolumeName          static name for @see VolumeComp  */
     static FName PostProcessName;   /** PostProcessName     static name for @see PPComp     */
+    static FName LiquidName;        /** LiquidName          static name for @see LiquidComp  */
 
 private:
 
@@ -66,6 +148,10 @@ private:
     UPROPERTY(VisibleDefaultsOnly, meta=(AllowPrivateAccess = "true"))
     UPostProcessComponent  * PPComp;
 
+    /** LiquidComp    Surface queries on the waves, batched or not  */
+    UPROPERTY(VisibleDefaultsOnly, BlueprintReadOnly, meta=(AllowPrivateAccess = "true"))
+    USeaLiquidComponent * LiquidComp;
+
     /**
 	 * 	OnEnterVolume()		        Callback called when something enters this actor
 	 * 	@param overlappedComponent	Will always be VolumeComp, as this is the component associated with this callback
@@ -92,6 +178,37 @@ private:
     UPROPERTY(transient)
     TArray<AActor *> OverlappingActors; 
 
+    /**
+     *  ApplyDetectionMode()    Enable or remove VolumeComp from the physics scene and set ticking according to @see DetectionMode
+     */
+    void ApplyDetectionMode();
+
+    /**
+     *  UpdateFloatingComponents()  Classify every registered component in a single pass and fire enter/leave events from the difference
+     */
+    void UpdateFloatingComponents();
+
+    /**
+     *  FollowViewers()     Move and resize VolumeComp to cover @see Extent around every player view, snapped to @see FollowSnapSize
+     *  @note               only used when the surface is infinite, the volume then moves with the players
+     */
+    void FollowViewers();
+
+    /** FollowBox       area covered by VolumeComp after the last @see FollowViewers(), in world space */
+    FBox FollowBox;
+
+    /** FloatingComponents      Components registered for @see ESeaDetectionMode::SurfaceTest */
+    UPROPERTY(transient)
+    TArray<TWeakObjectPtr<UPrimitiveComponent>> FloatingComponents;
+
+    /** FloatingComponentsInWater   result of the last classification, one bit per entry in @see FloatingComponents */
+    TBitArray<> FloatingComponentsInWater;
+
+    /** Scratch buffers for the batched test, kept between ticks to avoid allocations  */
+    TArray<FVector> BoundsOrigins;
+    TArray<FVector> BoundsExtents;
+    TArray<float>   SurfaceHeights;
+
 public:
 
      /**
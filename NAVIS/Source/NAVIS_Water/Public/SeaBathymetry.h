@@ -0,0 +1,70 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SeaBathymetry.generated.h"
+
+/**
+ *  NAVIS_WATER
+ *	FSeaBathymetry
+ *  Depth of the water and distance to the shore on a world aligned grid, baked from the seabed under a sea.
+ *  The grid is placed from the location of the sea surface : it follows the sea through level offsets and world origin shifts.
+ *  Both are quantized on 16 bits and sampled like a texture, the waves read them instead of tracing the seabed.
+ *  @see ASeaActor::BakeBathymetry()
+ */
+USTRUCT()
+struct NAVIS_WATER_API FSeaBathymetry
+{
+    GENERATED_BODY()
+
+    /** Origin      XY of the first sample, from the location of the sea surface */
+    UPROPERTY(VisibleAnywhere)
+    FVector2D Origin;
+
+    /** CellSize    distance between two samples, in unreal units */
+    UPROPERTY(VisibleAnywhere)
+    float CellSize;
+
+    /** Resolution  samples along X and Y */
+    UPROPERTY(VisibleAnywhere)
+    FIntPoint Resolution;
+
+    /** MaxDepth    depth of a sample of 65535, deeper water is clamped to it */
+    UPROPERTY(VisibleAnywhere)
+    float MaxDepth;
+
+    /** MaxShoreDistance    distance to the shore of a sample of 65535, further water is clamped to it */
+    UPROPERTY(VisibleAnywhere)
+    float MaxShoreDistance;
+
+    /** Depths      one per sample, row after row. 0 is dry land */
+    UPROPERTY()
+    TArray<uint16> Depths;
+
+    /** ShoreDistances      one per sample, distance to the closest dry sample */
+    UPROPERTY()
+    TArray<uint16> ShoreDistances;
+
+    FSeaBathymetry() : Origin(FVector2D::ZeroVector), CellSize(0.f), Resolution(FIntPoint::ZeroValue), MaxDepth(0.f), MaxShoreDistance(0.f) {}
+
+    /** IsValid()   @return true once baked */
+    bool IsValid() const { return Resolution.X > 1 && Resolution.Y > 1 && CellSize > 0.f && Depths.Num() == Resolution.X * Resolution.Y && ShoreDistances.Num() == Depths.Num(); }
+
+    /**
+     * 	Init()                  Quantize the depths and compute the distance to the shore from them
+     *  @param depths	        one per sample, row after row. Anything not deeper than 0 is dry
+     *  @note                   the distance field is exact, computed a column then a row at a time on worker threads
+	 */
+    void Init(const FVector2D &origin, float cellSize, const FIntPoint &resolution, const TArray<float> &depths, float maxDepth, float maxShoreDistance);
+
+    /**
+     * 	Sample()                Bilinear depth and shore distance at a location
+     *  @param relativeLocation	where to sample from the location of the sea surface, only X and Y matter
+     *  @return                 false outside of the grid, the water is then considered deep
+	 */
+    bool Sample(const FVector &relativeLocation, float &outDepth, float &outShoreDistance) const;
+
+    /** GetAllocatedSize()  @return bytes used by the samples */
+    SIZE_T GetAllocatedSize() const { return Depths.GetAllocatedSize() + ShoreDistances.GetAllocatedSize(); }
+};
@@ -0,0 +1,52 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+#include "LiquidActorComponent.h"
+#include "SeaSurfaceComponent.h"
+#include "SeaLiquidComponent.generated.h"
+
+/** 
+ *  NAVIS_WATER
+ *	USeaLiquidComponent 
+ *  Liquid queries answered by the waves of the sea surface of the same actor
+ *  @note   batched queries read a snapshot of the surface taken when they launch, ripples included
+ */
+UCLASS(Category = "WATER")
+class NAVIS_WATER_API USeaLiquidComponent : public ULiquidActorComponent
+{
+    GENERATED_BODY()
+
+public:
+
+    /** USeaLiquidComponent   constructor  */
+    USeaLiquidComponent(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+    //~ Begin UActorComponent Interface.
+    virtual void OnRegister() override;
+    //~ End UActorComponent Interface.
+
+    //~ Begin ULiquidActorComponent Interface.
+    virtual FBox GetLiquidBounds() const override;
+    virtual FVector GetSurfaceNormal() const override;
+    virtual FVector GetLocalSurfaceNormal() const override;
+    virtual FVector GetSurfaceLocationUnderPoint(FVector traceOrigin) const override;
+    virtual void GetSurfaceLocationsUnderPoints(TArrayView<const FVector> points, TArrayView<FVector> outLocations) const override;
+    //~ End ULiquidActorComponent Interface.
+
+protected:
+
+    //~ Begin ULiquidActorComponent Interface.
+    virtual void SnapshotQueries() override;
+    virtual void ResolveQueries(TArrayView<const FVector> points, TArrayView<FVector> outLocations) const override;
+    //~ End ULiquidActorComponent Interface.
+
+private:
+
+    /** Surface     the waves, found on the owner when registered */
+    UPROPERTY(transient)
+    USeaSurfaceComponent * Surface;
+
+    /** QuerySnapshot   the surface when the batch in flight launched */
+    FSeaSurfaceSnapshot QuerySnapshot;
+};
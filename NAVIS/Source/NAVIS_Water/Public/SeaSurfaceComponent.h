@@ -3,10 +3,85 @@
 #pragma once
 
 #include "NAVISCustomMeshComponent.h"
+#include "SeaBathymetry.h"
 #include "SeaSurfaceComponent.generated.h"
 
 
+class UCanvas;
 class UCanvasRenderTarget2D;
+class UMaterialInstanceDynamic;
+class UTexture2D;
+class FSeaRippleSimulation;
+class FSeaRippleHeights;
+
+/**
+ *  NAVIS_WATER
+ *	FSeaWave
+ *  A single directional wave, the surface is the sum of those
+ */
+USTRUCT(BlueprintType)
+struct FSeaWave
+{
+    GENERATED_BODY()
+
+    /** Direction   direction of travel, in the sea plane */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    FVector2D Direction;
+
+    /** Amplitude   half the crest to trough height, in unreal units */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    float Amplitude;
+
+    /** Wavelength  crest to crest distance, in unreal units */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1.0"))
+    float Wavelength;
+
+    FSeaWave() : Direction(FVector2D(1.f, 0.f)), Amplitude(0.f), Wavelength(10000.f) {}
+};
+
+/**
+ *  NAVIS_WATER
+ *	FSeaSwell
+ *  The waves of a surface with their phases at its world origin, replaced as a whole whenever one of them changes
+ */
+struct FSeaSwell
+{
+    /** Waves       @see USeaSurfaceComponent::Waves */
+    TArray<FSeaWave> Waves;
+
+    /** Phases      phase offset of each wave at @see Origin */
+    TArray<float> Phases;
+
+    /** Origin      world origin the phases were computed at */
+    FIntVector Origin = FIntVector::ZeroValue;
+};
+
+/**
+ *  NAVIS_WATER
+ *	FSeaSurfaceSnapshot
+ *  What the waves read that the game thread changes during a frame, copied for queries on worker threads
+ *  @see USeaSurfaceComponent::SnapshotSurface()
+ */
+struct FSeaSurfaceSnapshot
+{
+    /** Transform   of the surface, the ripples live in its local space */
+    FTransform Transform;
+
+    /** Time        world time the waves are evaluated at */
+    float Time = 0.f;
+
+    /** Gravity     pulls the waves, positive */
+    float Gravity = 980.f;
+
+    /** Swell       waves and phases, nullptr before the surface is registered */
+    TSharedPtr<const FSeaSwell, ESPMode::ThreadSafe> Swell;
+
+    /** Bathymetry  depths under the sea, nullptr when none is baked */
+    TSharedPtr<const FSeaBathymetry, ESPMode::ThreadSafe> Bathymetry;
+
+    /** Ripples     heights of the last ripple step, nullptr when the sea is calm */
+    TSharedPtr<const FSeaRippleHeights, ESPMode::ThreadSafe> Ripples;
+};
 
 /** 
  *  NAVIS_WATER - minimalAPI
@@ -23,8 +98,19 @@ public:
 
 	//~ Begin UActorComponent Interface.
     virtual void BeginPlay() override;
+    virtual void OnRegister() override;
+    virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction *ThisTickFunction) override;
     //~ End UActorComponent Interface.
 
+	//~ Begin USceneComponent Interface.
+    virtual void ApplyWorldOffset(const FVector& InOffset, bool bWorldShift) override;
+    virtual void OnUpdateTransform(EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport = ETeleportType::None) override;
+    //~ End USceneComponent Interface.
+
+	//~ Begin UPrimitiveComponent Interface.
+    virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
+    //~ End UPrimitiveComponent Interface.
+
     /**
      * 	Event_OnActorLeftVolume()       Callback called when something leaves this actor
      *  @param worldLocation	        Whatever entered the water
@@ -32,25 +118,215 @@ public:
 	 */
     virtual FVector WorldToLocalScaledLocation(const FVector &worldLocation) const;
 
+    /**
+     * 	GetSurfaceHeights()             Batched query of the surface height under a set of points
+     *  @param worldLocations	        points to project, in world space
+     *  @param outHeights	            world Z of the surface under each point, resized to match worldLocations
+	 */
+    virtual void GetSurfaceHeights(const TArray<FVector> &worldLocations, TArray<float> &outHeights) const;
+
+    /**
+     * 	SetSeaExtent()                  Change the area covered by the tiled surface
+     *  @param newExtent	            half size of the sea, in local space
+     *  @return                         false if the surface is not tiled, in which case the owner has to scale it
+	 */
+    bool SetSeaExtent(const FVector2D &newExtent);
+
+    /** IsTiled()   @return true when the surface is drawn as LOD tiles rather than as a generated mesh  */
+    bool IsTiled() const { return bTiledSurface; }
+
+    /** IsInfinite()   @return true when the surface follows the views instead of covering a fixed extent  */
+    bool IsInfinite() const { return bTiledSurface && bInfiniteSea; }
+
+    /**
+     * 	GetWaveHeightAt()               Height of the waves above the rest surface, ripples included
+     *  @param worldLocation	        where to evaluate the waves, only X and Y matter
+     *  @note                           over a baked @see Bathymetry, waves shorten and bend toward the shore in shallow water,
+     *                                  and break where the depth is too small for them
+	 */
+    float GetWaveHeightAt(const FVector &worldLocation) const;
+
+    /**
+     * 	GetWaveHeightAt()               @see GetWaveHeightAt(), from a snapshot rather than from this component
+     *  @note                           safe on any thread while the snapshot lives, whatever the game thread does
+	 */
+    float GetWaveHeightAt(const FVector &worldLocation, const FSeaSurfaceSnapshot &snapshot) const;
+
+    /**
+     * 	SnapshotSurface()               Copy what the waves read, for @see GetWaveHeightAt() on worker threads
+     *  @note                           game thread only. The ripples are copied when there are some
+	 */
+    FSeaSurfaceSnapshot SnapshotSurface() const;
+
+    /**
+     * 	SetBathymetry()                 Change the depth grid the waves read, saved with the level
+     *  @param newBathymetry	        baked by @see ASeaActor::BakeBathymetry(), an empty one turns shallow waves off
+     *  @note                           safe while queries run on worker threads, they finish with the previous grid
+	 */
+    void SetBathymetry(const FSeaBathymetry &newBathymetry);
+
+    /** GetBathymetry()     @return the depth grid the waves read */
+    const FSeaBathymetry &GetBathymetry() const { return Bathymetry; }
+
+    /** GetMaxWaveHeight()  @return highest crest the waves can reach, sum of their amplitudes  */
+    float GetMaxWaveHeight() const;
+
+    /**
+     * 	AddInteractionStamp()           Queue a disturbance of the water for the interaction render target
+     *  @param worldLocation	        center of the stamp, only X and Y matter
+     *  @param radius	                radius of the stamp, in world units
+     *  @param strength	                value added at the center, fading to nothing at the radius
+     *  @note                           stamps are drawn in one batch at the end of the frame, only on the tiles they touch
+	 */
+    UFUNCTION(BlueprintCallable, Category = "Interaction")
+    void AddInteractionStamp(const FVector &worldLocation, float radius, float strength = 1.f);
+
+    /** CanDrawInteraction()  @return false on servers and in worlds without a render scene, stamps are then dropped */
+    bool CanDrawInteraction() const;
+
+    /** HasRipples()    @return true when ripples are simulated, @see bEnableRipples */
+    bool HasRipples() const { return RippleSimulation.IsValid(); }
+
+    /**
+     * 	SetRenderTargetResolution()     Change the resolution of the interaction render target
+     *  @param newResolution	        size in texels, clamped to [64, 8192]
+	 */
+    UFUNCTION(BlueprintCallable, Category = "Interaction")
+    void SetRenderTargetResolution(FIntPoint newResolution);
+
+    /** GetRenderTargetResolution()  @return size of the interaction render target, in texels  */
+    FIntPoint GetRenderTargetResolution() const { return RenderTargetResolution; }
+
+    /**
+     * 	AddRippleDisturbance()          Push the water up or down, the ripples then spread from there
+     *  @param worldLocation	        center of the disturbance, only X and Y matter
+     *  @param radius	                radius of the disturbance, in world units
+     *  @param strength	                height added at the center, negative for a dip
+     *  @note                           does nothing unless @see bEnableRipples
+	 */
+    UFUNCTION(BlueprintCallable, Category = "Ripples")
+    void AddRippleDisturbance(const FVector &worldLocation, float radius, float strength);
+
+    /** HasRipples()   @return true when the surface simulates ripples, @see AddRippleDisturbance()  */
+    bool HasRipples() const { return RippleSimulation.IsValid(); }
+
 
 protected:
 
+	//~ Begin USceneComponent Interface.
+    virtual FBoxSphereBounds CalcBounds(const FTransform & LocalToWorld) const override;
+    //~ End USceneComponent Interface.
+
     /**
      *  GetRenderTarget()       Render Target used to produce object on water effects  
-     *  @returns                RenderTarget, will create it if not already present
+     *  @returns                RenderTarget, will create it if not already present. nullptr when @see CanDrawInteraction() is false
      */
     virtual UCanvasRenderTarget2D * GetRenderTarget();
 
+    /** RenderTargetResolution  How precise our render target shall be, @see SetRenderTargetResolution() */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Interaction", meta = (ClampMin = "64", ClampMax = "8192"))
+    FIntPoint RenderTargetResolution;
+
+    /** InteractionExtent       Half size of the area covered by the render target, in local space around the component */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Interaction", meta = (ClampMin = "1.0"))
+    float InteractionExtent;
+
     /**
-     *  RenderTargetDimension   How precise our render target shall be
-     *  @note   	           We might want to make this non static to be allowed to change resolution dynamically
+     *  InteractionTileSize     Size of the tiles of the render target, in texels
+     *  @note                   only tiles touched by stamps this frame or the previous one get redrawn
      */
-    static struct FRenderTargetDimension 
-    {
-        uint16 X;
-        uint16 Y; 
-        FRenderTargetDimension(uint16 newX, uint16 newY ) : X(newX), Y(newY) {}
-    }RenderTargetDimension; //: uint32
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Interaction", meta = (ClampMin = "8", ClampMax = "1024"))
+    int32 InteractionTileSize;
+
+    /**
+     *  DrawInteraction()       Draw the queued stamps, called by the render target on update
+     *  @note                   the target is not cleared, dirty tiles are cleared one by one
+     */
+    UFUNCTION()
+    void DrawInteraction(UCanvas* canvas, int32 width, int32 height);
+
+    /**
+     *  bTiledSurface       Draw the sea as a quadtree of tiles sharing one grid, instead of stretching the generated mesh
+     *  @note               vertex count then depends on the view, not on @see SeaExtent. Off by default, seas keep their generated mesh
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Surface")
+    bool bTiledSurface;
+
+    /** TileResolution      Number of quads along the edge of a tile, the same for every LOD. Rounded to an even number for stitching */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Surface", meta = (EditCondition = "bTiledSurface", ClampMin = "2", ClampMax = "254"))
+    int32 TileResolution;
+
+    /** LODCount            Number of levels in the quadtree, each level doubles the tile size */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Surface", meta = (EditCondition = "bTiledSurface", ClampMin = "1", ClampMax = "16"))
+    int32 LODCount;
+
+    /** MinTileSize         Size of the finest tiles (LOD 0), in unreal units */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Surface", meta = (EditCondition = "bTiledSurface", ClampMin = "1.0"))
+    float MinTileSize;
+
+    /** LODDistanceRatio    A tile gets split in four when the view is closer than its size times this ratio */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Surface", meta = (EditCondition = "bTiledSurface", ClampMin = "1.5"))
+    float LODDistanceRatio;
+
+    /** SeaExtent           Half size of the tiled surface, @see SetSeaExtent() */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Surface")
+    FVector2D SeaExtent;
+
+    /**
+     *  bInfiniteSea        Ignore @see SeaExtent, tiles are laid around every view up to @see InfiniteViewDistance
+     *  @note               draw cost and memory then depend on the view distance, not on the world size
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Surface", meta = (EditCondition = "bTiledSurface"))
+    bool bInfiniteSea;
+
+    /** InfiniteViewDistance    How far from the view an infinite sea is drawn */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Surface", meta = (EditCondition = "bInfiniteSea", ClampMin = "1000.0"))
+    float InfiniteViewDistance;
+
+    /**
+     *  Waves       Waves summed on the surface, also sent to the surface material
+     *  @note       the material gets NAVIS_WaveN (direction X, direction Y, amplitude, wavelength) and NAVIS_WavePhaseN parameters
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Waves")
+    TArray<FSeaWave> Waves;
+
+    /**
+     *  Bathymetry  Depth and distance to the shore under the sea, world aligned and placed from the location of the component
+     *  @note       sent to the material as the NAVIS_Bathymetry texture (depth in R, shore distance in G),
+     *              with NAVIS_BathymetryArea (world origin, size) and NAVIS_BathymetryRange (max depth, max shore distance)
+     *              No material of the plugin reads them yet, only the height queries see the depth
+     */
+    UPROPERTY()
+    FSeaBathymetry Bathymetry;
+
+    /**
+     *  bEnableRipples      Simulate ripples and wakes on the CPU, they add to the waves in height queries
+     *  @note               sent to the material as the NAVIS_Ripples texture, unless nothing is ever rendered
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ripples")
+    bool bEnableRipples;
+
+    /** RippleCellSize      Size of a cell of the ripple grid, in local units */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ripples", meta = (EditCondition = "bEnableRipples", ClampMin = "1.0"))
+    float RippleCellSize;
+
+    /** RippleWaveSpeed     How fast ripples spread, in local units per second. Limited by the cell size */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ripples", meta = (EditCondition = "bEnableRipples", ClampMin = "0.0"))
+    float RippleWaveSpeed;
+
+    /** RippleDamping       Fraction of the ripple height kept at each step, 60 steps per second */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ripples", meta = (EditCondition = "bEnableRipples", ClampMin = "0.9", ClampMax = "1.0"))
+    float RippleDamping;
+
+    /** RippleTextureTiles  Ripple tiles along each side of the texture, centered on the component. A tile is 32 cells */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ripples", meta = (EditCondition = "bEnableRipples", ClampMin = "1", ClampMax = "64"))
+    int32 RippleTextureTiles;
+
+    /**
+     *  UpdateWavePhases()  Compute the phase of each wave at the current world origin, and publish them with the waves to the queries
+     *  @note               world origin rebasing would otherwise make the waves jump. Call it after changing @see Waves
+     */
+    void UpdateWavePhases();
 
 private :
 
@@ -61,4 +337,82 @@ private :
     UPROPERTY()
     UCanvasRenderTarget2D * RenderTarget;
 
+    /** WaveMaterial    dynamic instance of the surface material, receiving wave parameters */
+    UPROPERTY(transient)
+    UMaterialInstanceDynamic * WaveMaterial;
+
+    /** WaveOrigin      world origin the component lives in, so waves are evaluated in absolute coordinates */
+    FIntVector WaveOrigin;
+
+    /** WavePhases      phase offset of each wave due to @see WaveOrigin, computed in double precision */
+    TArray<float> WavePhases;
+
+    /** RippleSimulation    created on register when @see bEnableRipples */
+    TSharedPtr<FSeaRippleSimulation> RippleSimulation;
+
+    /** RippleTexture       heights of the ripples around the component, one texel per cell */
+    UPROPERTY(transient)
+    UTexture2D * RippleTexture;
+
+    /** GetRippleTexture()  @return the ripple texture, created on first use. nullptr when nothing is rendered */
+    UTexture2D * GetRippleTexture();
+
+    /**
+     *  SwellSnapshot       copy of @see Waves and @see WavePhases read by @see GetWaveHeightAt(), made by @see UpdateWavePhases()
+     *  @note               replaced, never changed : a query on a worker thread keeps the one it started with alive
+     */
+    TSharedPtr<const FSeaSwell, ESPMode::ThreadSafe> SwellSnapshot;
+
+    /**
+     *  BathymetrySnapshot  copy of @see Bathymetry read by @see GetWaveHeightAt()
+     *  @note               replaced, never changed like @see SwellSnapshot
+     */
+    TSharedPtr<const FSeaBathymetry, ESPMode::ThreadSafe> BathymetrySnapshot;
+
+    /** SnapshotLock        only held to copy or replace @see SwellSnapshot and @see BathymetrySnapshot */
+    mutable FCriticalSection SnapshotLock;
+
+    /** PublishBathymetry() make @see Bathymetry the one the queries read */
+    void PublishBathymetry();
+
+    /** SnapshotSwell()     @see SnapshotSurface(), without the ripples that the live queries read in place */
+    FSeaSurfaceSnapshot SnapshotSwell() const;
+
+    /** GetSwellHeightAt()  height of the waves alone, without the ripples. Only reads the snapshot */
+    static float GetSwellHeightAt(const FVector &worldLocation, const FSeaSurfaceSnapshot &snapshot);
+
+    /** BathymetryTexture   @see Bathymetry, uploaded once for the material */
+    UPROPERTY(transient)
+    UTexture2D * BathymetryTexture;
+
+    /** UpdateBathymetryTexture()   upload @see Bathymetry and give it to the material, if there is one */
+    void UpdateBathymetryTexture();
+
+    /** UpdateBathymetryArea()      give the world area of @see Bathymetry to the material, wherever the component is now */
+    void UpdateBathymetryArea();
+
+    /** FSeaInteractionStamp    a queued stamp, in texels */
+    struct FSeaInteractionStamp
+    {
+        FVector2D Center;
+        float Radius;
+        float Strength;
+    };
+
+    /** PendingStamps   stamps added this frame, drawn then discarded */
+    TArray<FSeaInteractionStamp> PendingStamps;
+
+    /** DirtyTiles      tiles touched by @see PendingStamps */
+    TBitArray<> DirtyTiles;
+
+    /** DrawnTiles      tiles written by the last update, cleared by the next one if nothing touches them again */
+    TBitArray<> DrawnTiles;
+
+    /** GetTileCount()  tiles along X and Y of the render target */
+    FIntPoint GetTileCount() const;
+
+    /** ResetTiles()    size the tile bits to the render target, every tile clean */
+    void ResetTiles();
+
+    friend class FSeaSurfaceSceneProxy;
 };
\ No newline at end of file
@@ -0,0 +1,111 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+/**
+ *	NAVISCoreBench
+ *	Time the volume math of NAVIS_Core : convex hulls of growing size, then the analytic primitives,
+ *	each against random planes crossing them. Prints the time per call and the throughput.
+ *	usage : NAVISCoreBench [iterations per case]
+ */
+
+#include "NAVISCoreMath.h"
+#include "NAVISCoreShapes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace NAVISCore;
+
+namespace
+{
+	/** MakePlanes()	random planes crossing the unit sphere */
+	std::vector<FPlane3> MakePlanes(int32_t Count)
+	{
+		std::mt19937 Random(42);
+		std::uniform_real_distribution<float> Unit(-1.f, 1.f);
+		std::vector<FPlane3> Planes;
+		Planes.reserve(Count);
+		while (int32_t(Planes.size()) < Count)
+		{
+			const FVec3 Normal(Unit(Random), Unit(Random), Unit(Random));
+			if (Dot(Normal, Normal) < 1.e-3f)
+				continue;
+			const FVec3 Point(Unit(Random) * 0.5f, Unit(Random) * 0.5f, Unit(Random) * 0.5f);
+			Planes.push_back(FPlane3::FromPointNormal(Point, Normal));
+		}
+		return Planes;
+	}
+
+	/** Run()	time Function over Iterations calls, @return nanoseconds per call */
+	template<typename FunctionType>
+	double Run(int32_t Iterations, volatile float& Sink, FunctionType&& Function)
+	{
+		const auto Start = std::chrono::steady_clock::now();
+		float Sum = 0.f;
+		for (int32_t Idx = 0; Idx < Iterations; ++Idx)
+			Sum += Function(Idx);
+		const auto End = std::chrono::steady_clock::now();
+		Sink = Sum;
+		return std::chrono::duration<double, std::nano>(End - Start).count() / Iterations;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int32_t Iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200000;
+	const int32_t NumPlanes = 1024;
+	const std::vector<FPlane3> Planes = MakePlanes(NumPlanes);
+	const FVec3 Scale(100.f, 100.f, 100.f);
+	std::vector<FPlane3> ScaledPlanes;
+	for (const FPlane3& Plane : Planes)
+		ScaledPlanes.push_back(FPlane3(Plane.Normal, Plane.W * 100.f));
+
+	volatile float Sink = 0.f;
+
+	std::printf("%-24s %10s %12s %14s\n", "case", "triangles", "ns/call", "Mtriangles/s");
+
+	const int32_t Sizes[][2] = { {4, 3}, {8, 5}, {16, 9}, {32, 17}, {64, 33} };
+	for (const auto& Size : Sizes)
+	{
+		const FToolMesh Hull(Size[0], Size[1]);
+		const FConvexHullView View = Hull.GetView();
+		const int32_t HullIterations = std::max(1, Iterations * 16 / View.NumTriangles);
+
+		const double Nanoseconds = Run(HullIterations, Sink, [&](int32_t Idx)
+		{
+			return ClipConvexVolume(View, ScaledPlanes[Idx % NumPlanes], Scale);
+		});
+		std::printf("%-24s %10d %12.1f %14.2f\n", "hull", View.NumTriangles, Nanoseconds, View.NumTriangles / Nanoseconds * 1.e3);
+
+		std::vector<FVec3> Waterline;
+		const double WaterlineNanoseconds = Run(HullIterations, Sink, [&](int32_t Idx)
+		{
+			return ClipConvexVolume(View, ScaledPlanes[Idx % NumPlanes], Scale, &Waterline);
+		});
+		std::printf("%-24s %10d %12.1f %14.2f\n", "hull + waterline", View.NumTriangles, WaterlineNanoseconds, View.NumTriangles / WaterlineNanoseconds * 1.e3);
+	}
+
+	const double SphereNanoseconds = Run(Iterations, Sink, [&](int32_t Idx)
+	{
+		return SphereTruncatedVolume(FVec3(), 100.f, ScaledPlanes[Idx % NumPlanes]);
+	});
+	std::printf("%-24s %10s %12.1f %14s\n", "sphere", "-", SphereNanoseconds, "-");
+
+	const double CapsuleNanoseconds = Run(Iterations, Sink, [&](int32_t Idx)
+	{
+		return CapsuleTruncatedVolume(FVec3(-100.f, 0.f, 0.f), FVec3(100.f, 0.f, 0.f), 50.f, ScaledPlanes[Idx % NumPlanes]);
+	});
+	std::printf("%-24s %10s %12.1f %14s\n", "capsule", "-", CapsuleNanoseconds, "-");
+
+	const FVec3 Axes[3] = { FVec3(1.f, 0.f, 0.f), FVec3(0.f, 1.f, 0.f), FVec3(0.f, 0.f, 1.f) };
+	const double BoxNanoseconds = Run(Iterations, Sink, [&](int32_t Idx)
+	{
+		return BoxTruncatedVolume(FVec3(), Axes, FVec3(100.f, 50.f, 25.f), ScaledPlanes[Idx % NumPlanes]);
+	});
+	std::printf("%-24s %10d %12.1f %14.2f\n", "box", 12, BoxNanoseconds, 12 / BoxNanoseconds * 1.e3);
+
+	return 0;
+}
@@ -0,0 +1,117 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+/**
+ *	NAVISCoreReplay
+ *	Run the volume queries of a capture ("navis.Capture.Start" in the game) through NAVIS_Core again.
+ *	Prints the time per query, and checks the volumes against the captured ones : a changed implementation
+ *	can be compared on real workloads. Fails when a volume moved past the tolerance.
+ *	usage : NAVISCoreReplay <capture> [passes] [relative tolerance]
+ */
+
+#include "NAVISCoreCapture.h"
+#include "NAVISCoreMath.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+using namespace NAVISCore;
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::printf("usage : NAVISCoreReplay <capture> [passes] [relative tolerance]\n");
+		return 1;
+	}
+	const int32_t Passes = argc > 2 ? std::max(1, std::atoi(argv[2])) : 10;
+	const float Tolerance = argc > 3 ? float(std::atof(argv[3])) : 1.e-4f;
+
+	std::ifstream Stream(argv[1], std::ios::binary);
+	if (!Stream)
+	{
+		std::printf("cannot open %s\n", argv[1]);
+		return 1;
+	}
+	const std::vector<uint8_t> Data((std::istreambuf_iterator<char>(Stream)), std::istreambuf_iterator<char>());
+
+	std::vector<FCaptureHull> Hulls;
+	std::vector<FCaptureQuery> Queries;
+	if (!ReadCapture(Data.data(), Data.size(), Hulls, Queries))
+	{
+		std::printf("%s is not a NAVIS capture of version %u\n", argv[1], CaptureVersion);
+		return 1;
+	}
+
+	// queries point to their hull directly, the lookup is not part of the timing
+	std::unordered_map<uint32_t, FConvexHullView> Views;
+	for (const FCaptureHull& Hull : Hulls)
+		Views[Hull.HullId] = Hull.GetView();
+
+	std::vector<const FConvexHullView*> QueryHulls;
+	std::vector<FCaptureQuery> Replayed;
+	QueryHulls.reserve(Queries.size());
+	Replayed.reserve(Queries.size());
+	int64_t Triangles = 0;
+	for (const FCaptureQuery& Query : Queries)
+	{
+		const auto Found = Views.find(Query.HullId);
+		if (Found == Views.end())
+			continue;
+		QueryHulls.push_back(&Found->second);
+		Replayed.push_back(Query);
+		Triangles += Found->second.NumTriangles;
+	}
+
+	std::printf("%s : %zu hulls, %zu queries", argv[1], Hulls.size(), Replayed.size());
+	if (Replayed.size() != Queries.size())
+		std::printf(", %zu without their hull skipped", Queries.size() - Replayed.size());
+	std::printf("\n");
+	if (Replayed.empty())
+		return 0;
+
+	std::vector<float> Volumes(Replayed.size());
+	double BestNanoseconds = 0.0;
+	for (int32_t Pass = 0; Pass < Passes; ++Pass)
+	{
+		const auto Start = std::chrono::steady_clock::now();
+		for (size_t Idx = 0; Idx < Replayed.size(); ++Idx)
+			Volumes[Idx] = ClipConvexVolume(*QueryHulls[Idx], Replayed[Idx].Plane, Replayed[Idx].Scale);
+		const auto End = std::chrono::steady_clock::now();
+		const double Nanoseconds = std::chrono::duration<double, std::nano>(End - Start).count();
+		BestNanoseconds = Pass == 0 ? Nanoseconds : std::min(BestNanoseconds, Nanoseconds);
+	}
+
+	// relative to the volume, or to the largest one for the volumes close to 0
+	float Largest = 0.f;
+	for (const FCaptureQuery& Query : Replayed)
+		Largest = std::max(Largest, std::fabs(Query.Volume));
+
+	size_t Mismatches = 0;
+	float WorstError = 0.f;
+	size_t WorstIdx = 0;
+	for (size_t Idx = 0; Idx < Replayed.size(); ++Idx)
+	{
+		const float Reference = Replayed[Idx].Volume;
+		const float Error = std::fabs(Volumes[Idx] - Reference) / std::max(std::fabs(Reference), Largest * 1.e-3f + 1.e-6f);
+		if (Error > Tolerance)
+			++Mismatches;
+		if (Error > WorstError)
+		{
+			WorstError = Error;
+			WorstIdx = Idx;
+		}
+	}
+
+	std::printf("best of %d passes : %.1f ns/query, %.2f Mtriangles/s\n", Passes, BestNanoseconds / Replayed.size(), Triangles / BestNanoseconds * 1.e3);
+	std::printf("worst relative error %g on query %zu (captured %g, replayed %g), %zu past %g\n",
+		WorstError, WorstIdx, Replayed[WorstIdx].Volume, Volumes[WorstIdx], Mismatches, Tolerance);
+
+	return Mismatches > 0 ? 1 : 0;
+}
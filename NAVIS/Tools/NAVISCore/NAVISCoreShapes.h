@@ -0,0 +1,84 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+#pragma once
+
+/**
+ *	NAVISCoreShapes
+ *	Meshes shared by the NAVIS_Core benchmark and validation
+ */
+
+#include "NAVISCoreMath.h"
+
+#include <cmath>
+#include <vector>
+
+namespace NAVISCore
+{
+	/**
+	 *	FToolMesh
+	 *	UV sphere of unit radius, closed and wound counter clockwise from the outside.
+	 *	With Bumps above 0 the radius changes with the direction : the mesh is star shaped, no longer convex
+	 */
+	struct FToolMesh
+	{
+		std::vector<FVec3> Vertices;
+		std::vector<uint32_t> Indices;
+
+		FToolMesh(int32_t Segments, int32_t Rings, float Bumps = 0.f)
+		{
+			const float Pi = 3.14159265358979323846f;
+			auto Radius = [Bumps](float Theta, float Phi)
+			{
+				return 1.f + Bumps * std::sin(3.f * Theta) * std::cos(Phi);
+			};
+
+			Vertices.push_back(FVec3(0.f, 0.f, -1.f));
+			for (int32_t Ring = 1; Ring < Rings; ++Ring)
+			{
+				const float Phi = Pi * Ring / Rings - Pi / 2.f;
+				for (int32_t Segment = 0; Segment < Segments; ++Segment)
+				{
+					const float Theta = 2.f * Pi * Segment / Segments;
+					const float R = Radius(Theta, Phi);
+					Vertices.push_back(FVec3(R * std::cos(Phi) * std::cos(Theta), R * std::cos(Phi) * std::sin(Theta), R * std::sin(Phi)));
+				}
+			}
+			Vertices.push_back(FVec3(0.f, 0.f, 1.f));
+
+			const uint32_t Bottom = 0;
+			const uint32_t Top = uint32_t(Vertices.size() - 1);
+			auto Ring = [Segments](int32_t RingIdx, int32_t Segment) -> uint32_t
+			{
+				return uint32_t(1 + (RingIdx - 1) * Segments + (Segment % Segments));
+			};
+
+			for (int32_t Segment = 0; Segment < Segments; ++Segment)
+			{
+				AddTriangle(Bottom, Ring(1, Segment + 1), Ring(1, Segment));
+				AddTriangle(Top, Ring(Rings - 1, Segment), Ring(Rings - 1, Segment + 1));
+				for (int32_t RingIdx = 1; RingIdx < Rings - 1; ++RingIdx)
+				{
+					AddTriangle(Ring(RingIdx, Segment), Ring(RingIdx, Segment + 1), Ring(RingIdx + 1, Segment + 1));
+					AddTriangle(Ring(RingIdx, Segment), Ring(RingIdx + 1, Segment + 1), Ring(RingIdx + 1, Segment));
+				}
+			}
+		}
+
+		void AddTriangle(uint32_t A, uint32_t B, uint32_t C)
+		{
+			Indices.push_back(A);
+			Indices.push_back(B);
+			Indices.push_back(C);
+		}
+
+		FConvexHullView GetView() const
+		{
+			FConvexHullView View;
+			View.Vertices = Vertices.data();
+			View.NumVertices = int32_t(Vertices.size());
+			View.Indices = Indices.data();
+			View.NumTriangles = int32_t(Indices.size() / 3);
+			return View;
+		}
+	};
+}
@@ -0,0 +1,535 @@
+// Noe Perard-Gayot <noe.perard@gmail.com> 2019 - All Rights Reserved
+
+/**
+ *	NAVISCoreValidation
+ *	Accuracy against cost of every truncated volume of NAVIS_Core.
+ *	Each shape gets random sizes, rotations, scales and planes, its volume under the plane is compared to an exact reference,
+ *	computed in double precision in the world, independently of the frame the kernel works in :
+ *	the spherical cap, the corners of the box, the clipped triangles of the meshes.
+ *	A capsule has no closed form, but its slices across the axis do : they are integrated along the axis far below the tolerances.
+ *	Errors are relative to the volume of the whole shape, a case fails when one exceeds its tolerance.
+ *	The waterline is checked the same way, its area against the exact cut of a hull with a non uniform scale.
+ *	usage : NAVISCoreValidation [trials per case]
+ */
+
+#include "NAVISCoreMath.h"
+#include "NAVISCoreShapes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace NAVISCore;
+
+namespace
+{
+	const double Pi = 3.14159265358979323846;
+
+	/** calls timed for each trial */
+	const int32_t TimedCalls = 64;
+
+	/** FTrial	one shape placed in the world, cut by one plane */
+	struct FTrial
+	{
+		std::function<float()> Kernel;
+
+		/** what the kernel should return */
+		double Reference;
+
+		/** errors are relative to it */
+		double FullVolume;
+	};
+
+	/** FCase	a kernel to validate, and how to make its trials */
+	struct FCase
+	{
+		const char* Name;
+
+		/** error allowed, relative to the volume of the whole shape */
+		double Tolerance;
+
+		std::function<FTrial(std::mt19937&)> MakeTrial;
+	};
+
+	/** FRotation	rotation matrix, as the images of X, Y and Z */
+	struct FRotation
+	{
+		FVec3 Axes[3];
+
+		FVec3 Rotate(const FVec3& V) const { return Axes[0] * V.X + Axes[1] * V.Y + Axes[2] * V.Z; }
+		FVec3 Unrotate(const FVec3& V) const { return FVec3(Dot(Axes[0], V), Dot(Axes[1], V), Dot(Axes[2], V)); }
+	};
+
+	/** RandomRotation()	uniform over rotations, from a random unit quaternion */
+	FRotation RandomRotation(std::mt19937& Random)
+	{
+		std::uniform_real_distribution<float> Unit(0.f, 1.f);
+		const float U1 = Unit(Random), U2 = Unit(Random) * 2.f * Pi, U3 = Unit(Random) * 2.f * Pi;
+		const float X = std::sqrt(1.f - U1) * std::sin(U2), Y = std::sqrt(1.f - U1) * std::cos(U2);
+		const float Z = std::sqrt(U1) * std::sin(U3), W = std::sqrt(U1) * std::cos(U3);
+
+		FRotation Rotation;
+		Rotation.Axes[0] = FVec3(1.f - 2.f * (Y * Y + Z * Z), 2.f * (X * Y + Z * W), 2.f * (X * Z - Y * W));
+		Rotation.Axes[1] = FVec3(2.f * (X * Y - Z * W), 1.f - 2.f * (X * X + Z * Z), 2.f * (Y * Z + X * W));
+		Rotation.Axes[2] = FVec3(2.f * (X * Z + Y * W), 2.f * (Y * Z - X * W), 1.f - 2.f * (X * X + Y * Y));
+		return Rotation;
+	}
+
+	/** FVecD	double precision vector of the references, so that their own rounding stays far below the tolerances */
+	struct FVecD
+	{
+		double X, Y, Z;
+
+		FVecD() : X(0.0), Y(0.0), Z(0.0) {}
+		FVecD(double InX, double InY, double InZ) : X(InX), Y(InY), Z(InZ) {}
+		explicit FVecD(const FVec3& V) : X(V.X), Y(V.Y), Z(V.Z) {}
+
+		FVecD operator+(const FVecD& V) const { return FVecD(X + V.X, Y + V.Y, Z + V.Z); }
+		FVecD operator-(const FVecD& V) const { return FVecD(X - V.X, Y - V.Y, Z - V.Z); }
+		FVecD operator*(double S) const { return FVecD(X * S, Y * S, Z * S); }
+	};
+
+	double Dot(const FVecD& A, const FVecD& B) { return A.X * B.X + A.Y * B.Y + A.Z * B.Z; }
+	FVecD Cross(const FVecD& A, const FVecD& B) { return FVecD(A.Y * B.Z - A.Z * B.Y, A.Z * B.X - A.X * B.Z, A.X * B.Y - A.Y * B.X); }
+
+	/** SphereVolume()	volume of a sphere under the plane of the points P where Dot(Normal, P) == W, the spherical cap */
+	double SphereVolume(const FVecD& Center, double Radius, const FVecD& Normal, double W)
+	{
+		const double Height = std::min(std::max(Radius - (Dot(Normal, Center) - W), 0.0), 2.0 * Radius);
+		return Pi * Height * Height * (3.0 * Radius - Height) / 3.0;
+	}
+
+	/**
+	 *	BoxVolume()		volume of the box of half size Extent around the origin, under the plane of the points P where Dot(Normal, P) == W.
+	 *					The box is moved to a corner and mirrored so that the normal is positive, then each corner of the box
+	 *					adds or removes the simplex it cuts under the plane. Axes the plane barely leans on would cancel out
+	 *					in the sum, they are left out and only stretch the volume : that moves the plane by less than 1e-4 of the box
+	 */
+	double BoxVolume(const FVecD& Extent, const FVecD& Normal, double W)
+	{
+		const double Extents[3] = { Extent.X, Extent.Y, Extent.Z };
+		const double Normals[3] = { Normal.X, Normal.Y, Normal.Z };
+
+		double Slopes[3], Sizes[3];
+		int32_t Count = 0;
+		double Stretch = 1.0, Reach = W, Denominator = 1.0;
+		for (int32_t Axis = 0; Axis < 3; ++Axis)
+		{
+			const double Slope = std::fabs(Normals[Axis]);
+			if (Slope < 1.e-4)
+			{
+				Stretch *= 2.0 * Extents[Axis];
+				continue;
+			}
+			Reach += Slope * Extents[Axis];
+			Slopes[Count] = Slope;
+			Sizes[Count] = 2.0 * Extents[Axis];
+			Denominator *= Slope * (Count + 1);
+			++Count;
+		}
+
+		double Sum = 0.0;
+		for (int32_t Corner = 0; Corner < (1 << Count); ++Corner)
+		{
+			double Height = Reach, Sign = 1.0;
+			for (int32_t Axis = 0; Axis < Count; ++Axis)
+			{
+				if (Corner & (1 << Axis))
+				{
+					Height -= Slopes[Axis] * Sizes[Axis];
+					Sign = -Sign;
+				}
+			}
+			if (Height > 0.0)
+				Sum += Sign * std::pow(Height, Count);
+		}
+		return Stretch * Sum / Denominator;
+	}
+
+	/** OrientedBoxVolume()		@see BoxVolume(), for a box placed in the world */
+	double OrientedBoxVolume(const FVecD& Center, const FRotation& Rotation, const FVecD& Extent, const FVecD& Normal, double W)
+	{
+		const FVecD LocalNormal(Dot(FVecD(Rotation.Axes[0]), Normal), Dot(FVecD(Rotation.Axes[1]), Normal), Dot(FVecD(Rotation.Axes[2]), Normal));
+		return BoxVolume(Extent, LocalNormal, W - Dot(Normal, Center));
+	}
+
+	/** SimpsonStep()	adaptive Simpson, the interval is halved until its halves agree with it */
+	template <typename FunctionType>
+	double SimpsonStep(const FunctionType& Function, double A, double B, double FA, double FM, double FB, double Whole, double Tolerance, int32_t Depth)
+	{
+		const double M = (A + B) * 0.5;
+		const double FLeft = Function((A + M) * 0.5), FRight = Function((M + B) * 0.5);
+		const double Left = (M - A) / 6.0 * (FA + 4.0 * FLeft + FM);
+		const double Right = (B - M) / 6.0 * (FM + 4.0 * FRight + FB);
+		if (Depth <= 0 || std::fabs(Left + Right - Whole) <= 15.0 * Tolerance)
+			return Left + Right + (Left + Right - Whole) / 15.0;
+		return SimpsonStep(Function, A, M, FA, FLeft, FM, Left, Tolerance * 0.5, Depth - 1) + SimpsonStep(Function, M, B, FM, FRight, FB, Right, Tolerance * 0.5, Depth - 1);
+	}
+
+	/** Integrate()		integral of a continuous function to an absolute tolerance, split first so that no feature falls between the first samples */
+	template <typename FunctionType>
+	double Integrate(const FunctionType& Function, double A, double B, double Tolerance)
+	{
+		const int32_t Pieces = 16;
+		double Sum = 0.0;
+		for (int32_t Piece = 0; Piece < Pieces; ++Piece)
+		{
+			const double PieceA = A + (B - A) * Piece / Pieces, PieceB = A + (B - A) * (Piece + 1) / Pieces;
+			const double FA = Function(PieceA), FM = Function((PieceA + PieceB) * 0.5), FB = Function(PieceB);
+			Sum += SimpsonStep(Function, PieceA, PieceB, FA, FM, FB, (PieceB - PieceA) / 6.0 * (FA + 4.0 * FM + FB), Tolerance / Pieces, 40);
+		}
+		return Sum;
+	}
+
+	/**
+	 *	CapsuleVolume()	volume of a capsule under the plane of the points P where Dot(Normal, P) == W.
+	 *					Its slices across the axis are disks cut by a line, their area is closed form and integrated along the axis
+	 */
+	double CapsuleVolume(const FVecD& A, const FVecD& B, double Radius, const FVecD& Normal, double W)
+	{
+		const FVecD Axis = B - A;
+		const double AxisLength = std::sqrt(Dot(Axis, Axis));
+		const double Along = AxisLength > 1.e-9 ? Dot(Normal, Axis) / AxisLength : 0.0;
+		const double Across = std::sqrt(std::max(1.0 - Along * Along, 0.0));
+		const double Start = W - Dot(Normal, A);
+
+		auto SliceArea = [=](double Z)
+		{
+			const double Beyond = Z < 0.0 ? -Z : std::max(Z - AxisLength, 0.0);
+			const double SquaredRadius = std::max(Radius * Radius - Beyond * Beyond, 0.0);
+			const double SliceRadius = std::sqrt(SquaredRadius);
+
+			// the slice is under the plane on the side of a line, at Room / Across from its center
+			const double Room = Start - Along * Z;
+			if (std::fabs(Room) >= Across * SliceRadius)
+				return Room > 0.0 ? Pi * SquaredRadius : 0.0;
+			const double Height = Room / Across;
+			return SquaredRadius * std::acos(-Height / SliceRadius) + Height * std::sqrt(SquaredRadius - Height * Height);
+		};
+
+		const double Tolerance = 1.e-10 * Radius * Radius * Radius;
+		return Integrate(SliceArea, -Radius, 0.0, Tolerance) + Integrate(SliceArea, 0.0, AxisLength, Tolerance) + Integrate(SliceArea, AxisLength, AxisLength + Radius, Tolerance);
+	}
+
+	/**
+	 *	MeshVolume()	volume of a closed mesh under the plane of the points P where Dot(Normal, P) == W.
+	 *					Each triangle is clipped to the plane and adds the signed volume of the tetrahedron it makes with a point of the plane,
+	 *					the cut lies on the plane so it adds nothing
+	 */
+	double MeshVolume(const std::vector<FVecD>& Vertices, const std::vector<uint32_t>& Indices, const FVecD& Normal, double W)
+	{
+		const FVecD Apex = Normal * W;
+		double Volume = 0.0;
+		for (size_t Idx = 0; Idx + 2 < Indices.size(); Idx += 3)
+		{
+			// one plane cuts a triangle into four points at most
+			FVecD Clipped[4];
+			int32_t Count = 0;
+			for (int32_t Corner = 0; Corner < 3; ++Corner)
+			{
+				const FVecD& P = Vertices[Indices[Idx + Corner]];
+				const FVecD& Q = Vertices[Indices[Idx + (Corner + 1) % 3]];
+				const double DistP = Dot(Normal, P) - W, DistQ = Dot(Normal, Q) - W;
+				if (DistP <= 0.0)
+					Clipped[Count++] = P;
+				if ((DistP <= 0.0) != (DistQ <= 0.0))
+					Clipped[Count++] = P + (Q - P) * (DistP / (DistP - DistQ));
+			}
+			for (int32_t Fan = 1; Fan + 1 < Count; ++Fan)
+				Volume += Dot(Clipped[0] - Apex, Cross(Clipped[Fan] - Apex, Clipped[Fan + 1] - Apex)) / 6.0;
+		}
+		return std::fabs(Volume);
+	}
+
+	FVec3 RandomDirection(std::mt19937& Random)
+	{
+		std::normal_distribution<float> Normal;
+		FVec3 Direction;
+		do
+		{
+			Direction = FVec3(Normal(Random), Normal(Random), Normal(Random));
+		} while (Dot(Direction, Direction) < 1.e-6f);
+		return Direction * (1.f / Length(Direction));
+	}
+
+	FVec3 RandomPoint(std::mt19937& Random, const FVec3& Min, const FVec3& Max)
+	{
+		std::uniform_real_distribution<float> Unit(0.f, 1.f);
+		return FVec3(Min.X + (Max.X - Min.X) * Unit(Random), Min.Y + (Max.Y - Min.Y) * Unit(Random), Min.Z + (Max.Z - Min.Z) * Unit(Random));
+	}
+
+	/** RandomPlane()	plane with a random normal, through a point of the middle of the bounds so that it mostly cuts the shape */
+	FPlane3 RandomPlane(std::mt19937& Random, const FVec3& Min, const FVec3& Max)
+	{
+		const FVec3 Center = (Min + Max) * 0.5f;
+		const FVec3 Quarter = (Max - Min) * 0.25f;
+		return FPlane3::FromPointNormal(RandomPoint(Random, Center - Quarter, Center + Quarter), RandomDirection(Random));
+	}
+
+	/** MeshTrial()		a mesh rotated, scaled and moved. The plane is taken to the space of the mesh, as NAVIS_Physics does */
+	FTrial MeshTrial(std::mt19937& Random, const FToolMesh& Mesh)
+	{
+		std::uniform_real_distribution<float> Size(20.f, 100.f);
+		const FRotation Rotation = RandomRotation(Random);
+		const FVec3 Scale(Size(Random), Size(Random), Size(Random));
+		const FVec3 Translation = RandomPoint(Random, FVec3(-100.f, -100.f, -100.f), FVec3(100.f, 100.f, 100.f));
+
+		// the reference cuts the mesh in the world
+		std::vector<FVecD> World;
+		FVec3 BoundsMin(1.e30f, 1.e30f, 1.e30f), BoundsMax(-1.e30f, -1.e30f, -1.e30f);
+		for (const FVec3& Vertex : Mesh.Vertices)
+		{
+			const FVecD Scaled = FVecD(Vertex.X * double(Scale.X), Vertex.Y * double(Scale.Y), Vertex.Z * double(Scale.Z));
+			World.push_back(FVecD(Rotation.Axes[0]) * Scaled.X + FVecD(Rotation.Axes[1]) * Scaled.Y + FVecD(Rotation.Axes[2]) * Scaled.Z + FVecD(Translation));
+			const FVec3 Point(float(World.back().X), float(World.back().Y), float(World.back().Z));
+			BoundsMin = FVec3(std::min(BoundsMin.X, Point.X), std::min(BoundsMin.Y, Point.Y), std::min(BoundsMin.Z, Point.Z));
+			BoundsMax = FVec3(std::max(BoundsMax.X, Point.X), std::max(BoundsMax.Y, Point.Y), std::max(BoundsMax.Z, Point.Z));
+		}
+		const FPlane3 Plane = RandomPlane(Random, BoundsMin, BoundsMax);
+
+		FTrial Trial;
+		const FConvexHullView View = Mesh.GetView();
+		const FPlane3 LocalPlane(Rotation.Unrotate(Plane.Normal), Plane.W - Dot(Plane.Normal, Translation));
+		Trial.Kernel = [View, LocalPlane, Scale]() { return ClipConvexVolume(View, LocalPlane, Scale); };
+		Trial.Reference = MeshVolume(World, Mesh.Indices, FVecD(Plane.Normal), Plane.W);
+		Trial.FullVolume = MeshVolume(World, Mesh.Indices, FVecD(0.0, 0.0, 1.0), BoundsMax.Z + 1.0);
+		return Trial;
+	}
+
+	/** PolygonArea()	signed area of a polygon around a normal, negative when it turns clockwise */
+	double PolygonArea(const std::vector<FVec3>& Points, const FVec3& Normal)
+	{
+		double Area = 0.0;
+		for (size_t Idx = 0; Idx < Points.size(); ++Idx)
+			Area += Dot(Cross(Points[Idx], Points[(Idx + 1) % Points.size()]), Normal);
+		return Area * 0.5;
+	}
+
+	/** ConvexArea()	area of the convex hull of points of a plane, by a monotone chain in the axes of the plane */
+	double ConvexArea(const std::vector<FVec3>& Points, const FVec3& Normal)
+	{
+		const FVec3 Up = std::fabs(Normal.Z) < 0.9f ? FVec3(0.f, 0.f, 1.f) : FVec3(1.f, 0.f, 0.f);
+		FVec3 AxisX = Cross(Up, Normal);
+		AxisX = AxisX * (1.f / Length(AxisX));
+		const FVec3 AxisY = Cross(Normal, AxisX);
+
+		std::vector<std::pair<double, double>> Flat;
+		for (const FVec3& Point : Points)
+			Flat.emplace_back(Dot(Point, AxisX), Dot(Point, AxisY));
+		std::sort(Flat.begin(), Flat.end());
+		if (Flat.size() < 3)
+			return 0.0;
+
+		auto Turn = [](const std::pair<double, double>& O, const std::pair<double, double>& A, const std::pair<double, double>& B)
+		{
+			return (A.first - O.first) * (B.second - O.second) - (A.second - O.second) * (B.first - O.first);
+		};
+		std::vector<std::pair<double, double>> Chain(Flat.size() * 2);
+		size_t Count = 0;
+		for (size_t Idx = 0; Idx < Flat.size(); ++Idx)
+		{
+			while (Count >= 2 && Turn(Chain[Count - 2], Chain[Count - 1], Flat[Idx]) <= 0.0)
+				--Count;
+			Chain[Count++] = Flat[Idx];
+		}
+		for (size_t Idx = Flat.size() - 1, Lower = Count + 1; Idx-- > 0;)
+		{
+			while (Count >= Lower && Turn(Chain[Count - 2], Chain[Count - 1], Flat[Idx]) <= 0.0)
+				--Count;
+			Chain[Count++] = Flat[Idx];
+		}
+
+		double Area = 0.0;
+		for (size_t Idx = 0; Idx + 1 < Count; ++Idx)
+			Area += Chain[Idx].first * Chain[Idx + 1].second - Chain[Idx + 1].first * Chain[Idx].second;
+		return Area * 0.5;
+	}
+
+	/**
+	 *	WaterlineTrial()	area of the waterline of a convex mesh with a non uniform scale, in the space of the body like NAVIS_Physics :
+	 *						the plane is moved and rotated but not scaled, the scale goes to the vertices.
+	 *						The reference is the convex hull of every edge cut by the plane, scaled independently
+	 */
+	FTrial WaterlineTrial(std::mt19937& Random, const FToolMesh& Mesh)
+	{
+		std::uniform_real_distribution<float> Size(20.f, 100.f);
+		const FVec3 Scale(Size(Random), Size(Random) * 0.5f, Size(Random) * 2.f);
+
+		std::vector<FVec3> Scaled;
+		for (const FVec3& Vertex : Mesh.Vertices)
+			Scaled.push_back(Vertex * Scale);
+
+		const FPlane3 Plane = RandomPlane(Random, Scale * -1.f, Scale);
+		const FConvexHullView View = Mesh.GetView();
+
+		FTrial Trial;
+		std::vector<FVec3> Cuts;
+		for (size_t Idx = 0; Idx < Mesh.Indices.size(); ++Idx)
+		{
+			const FVec3& A = Scaled[Mesh.Indices[Idx]];
+			const FVec3& B = Scaled[Mesh.Indices[Idx % 3 == 2 ? Idx - 2 : Idx + 1]];
+			const float DistA = Plane.Distance(A), DistB = Plane.Distance(B);
+			if ((DistA < 0.f) != (DistB < 0.f))
+				Cuts.push_back(A + (B - A) * (DistA / (DistA - DistB)));
+		}
+		Trial.Reference = ConvexArea(Cuts, Plane.Normal);
+		Trial.FullVolume = std::max(Trial.Reference, 1.0);
+
+		// the points must be on the plane, in the space of the scaled hull, and turn counter clockwise
+		auto Waterline = std::make_shared<std::vector<FVec3>>();
+		const float Tolerance = Length(Scale) * 1.e-4f;
+		Trial.Kernel = [View, Plane, Scale, Waterline, Tolerance]()
+		{
+			ClipConvexVolume(View, Plane, Scale, Waterline.get());
+			for (const FVec3& Point : *Waterline)
+			{
+				if (std::fabs(Plane.Distance(Point)) > Tolerance)
+					return 0.f;
+			}
+			return float(PolygonArea(*Waterline, Plane.Normal));
+		};
+		return Trial;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int32_t Trials = argc > 1 ? std::max(1, std::atoi(argv[1])) : 50;
+
+	const FToolMesh Hull(16, 9);
+	const FToolMesh Bumpy(16, 9, 0.3f);
+
+	auto CapsuleCase = [](int32_t Steps)
+	{
+		return [Steps](std::mt19937& Random)
+		{
+			std::uniform_real_distribution<float> Size(10.f, 60.f);
+			const float Radius = Size(Random);
+			const FVec3 Center = RandomPoint(Random, FVec3(-100.f, -100.f, -100.f), FVec3(100.f, 100.f, 100.f));
+			const FVec3 HalfAxis = RandomDirection(Random) * (Size(Random) * 2.f - 20.f);
+			const FVec3 A = Center - HalfAxis, B = Center + HalfAxis;
+
+			const FVec3 BoundsMin(std::min(A.X, B.X) - Radius, std::min(A.Y, B.Y) - Radius, std::min(A.Z, B.Z) - Radius);
+			const FVec3 BoundsMax(std::max(A.X, B.X) + Radius, std::max(A.Y, B.Y) + Radius, std::max(A.Z, B.Z) + Radius);
+			const FPlane3 Plane = RandomPlane(Random, BoundsMin, BoundsMax);
+
+			FTrial Trial;
+			Trial.Kernel = [A, B, Radius, Plane, Steps]() { return CapsuleTruncatedVolume(A, B, Radius, Plane, Steps); };
+			Trial.Reference = CapsuleVolume(FVecD(A), FVecD(B), Radius, FVecD(Plane.Normal), Plane.W);
+			Trial.FullVolume = Pi * Radius * Radius * (2.0 * Length(HalfAxis) + 4.0 / 3.0 * Radius);
+			return Trial;
+		};
+	};
+
+	const std::vector<FCase> Cases =
+	{
+		{ "sphere", 0.005, [](std::mt19937& Random)
+		{
+			std::uniform_real_distribution<float> Size(10.f, 100.f);
+			const float Radius = Size(Random);
+			const FVec3 Center = RandomPoint(Random, FVec3(-100.f, -100.f, -100.f), FVec3(100.f, 100.f, 100.f));
+			const FPlane3 Plane = RandomPlane(Random, Center - FVec3(Radius, Radius, Radius), Center + FVec3(Radius, Radius, Radius));
+
+			FTrial Trial;
+			Trial.Kernel = [Center, Radius, Plane]() { return SphereTruncatedVolume(Center, Radius, Plane); };
+			Trial.Reference = SphereVolume(FVecD(Center), Radius, FVecD(Plane.Normal), Plane.W);
+			Trial.FullVolume = 4.0 / 3.0 * Pi * Radius * Radius * Radius;
+			return Trial;
+		}},
+		{ "box", 0.005, [](std::mt19937& Random)
+		{
+			std::uniform_real_distribution<float> Size(10.f, 100.f);
+			const FRotation Rotation = RandomRotation(Random);
+			const FVec3 Extent(Size(Random), Size(Random), Size(Random));
+			const FVec3 Center = RandomPoint(Random, FVec3(-100.f, -100.f, -100.f), FVec3(100.f, 100.f, 100.f));
+
+			const FVec3 Reach(
+				std::fabs(Rotation.Axes[0].X) * Extent.X + std::fabs(Rotation.Axes[1].X) * Extent.Y + std::fabs(Rotation.Axes[2].X) * Extent.Z,
+				std::fabs(Rotation.Axes[0].Y) * Extent.X + std::fabs(Rotation.Axes[1].Y) * Extent.Y + std::fabs(Rotation.Axes[2].Y) * Extent.Z,
+				std::fabs(Rotation.Axes[0].Z) * Extent.X + std::fabs(Rotation.Axes[1].Z) * Extent.Y + std::fabs(Rotation.Axes[2].Z) * Extent.Z);
+			const FPlane3 Plane = RandomPlane(Random, Center - Reach, Center + Reach);
+
+			FTrial Trial;
+			Trial.Kernel = [Center, Rotation, Extent, Plane]() { return BoxTruncatedVolume(Center, Rotation.Axes, Extent, Plane); };
+			Trial.Reference = OrientedBoxVolume(FVecD(Center), Rotation, FVecD(Extent), FVecD(Plane.Normal), Plane.W);
+			Trial.FullVolume = 8.0 * Extent.X * Extent.Y * Extent.Z;
+			return Trial;
+		}},
+		{ "box, scaled body", 0.005, [](std::mt19937& Random)
+		{
+			// a box element of a body setup under the non uniform scale of its component, as NAVIS_Physics measures it :
+			// the plane is taken to the body, moved and rotated but not scaled, the scale goes to the element.
+			// The element is aligned with its body, a rotated one would be sheared by the scale.
+			// The reference places the box in the world instead
+			std::uniform_real_distribution<float> Size(10.f, 50.f);
+			std::uniform_real_distribution<float> BodyScale(0.5f, 3.f);
+			const FRotation Rotation = RandomRotation(Random);
+			const FVec3 Scale(BodyScale(Random), BodyScale(Random), BodyScale(Random));
+			const FVec3 Translation = RandomPoint(Random, FVec3(-100.f, -100.f, -100.f), FVec3(100.f, 100.f, 100.f));
+			const FVec3 Center = RandomPoint(Random, FVec3(-50.f, -50.f, -50.f), FVec3(50.f, 50.f, 50.f)) * Scale;
+			const FVec3 Extent = FVec3(Size(Random), Size(Random), Size(Random)) * Scale;
+
+			const FVec3 WorldCenter = Rotation.Rotate(Center) + Translation;
+			const FVec3 Reach(
+				std::fabs(Rotation.Axes[0].X) * Extent.X + std::fabs(Rotation.Axes[1].X) * Extent.Y + std::fabs(Rotation.Axes[2].X) * Extent.Z,
+				std::fabs(Rotation.Axes[0].Y) * Extent.X + std::fabs(Rotation.Axes[1].Y) * Extent.Y + std::fabs(Rotation.Axes[2].Y) * Extent.Z,
+				std::fabs(Rotation.Axes[0].Z) * Extent.X + std::fabs(Rotation.Axes[1].Z) * Extent.Y + std::fabs(Rotation.Axes[2].Z) * Extent.Z);
+			const FPlane3 Plane = RandomPlane(Random, WorldCenter - Reach, WorldCenter + Reach);
+
+			FTrial Trial;
+			const FPlane3 LocalPlane(Rotation.Unrotate(Plane.Normal), Plane.W - Dot(Plane.Normal, Translation));
+			const FVec3 Axes[3] = { FVec3(1.f, 0.f, 0.f), FVec3(0.f, 1.f, 0.f), FVec3(0.f, 0.f, 1.f) };
+			Trial.Kernel = [Center, Axes, Extent, LocalPlane]() { return BoxTruncatedVolume(Center, Axes, Extent, LocalPlane); };
+			const FVecD ReferenceCenter = FVecD(Rotation.Axes[0]) * Center.X + FVecD(Rotation.Axes[1]) * Center.Y + FVecD(Rotation.Axes[2]) * Center.Z + FVecD(Translation);
+			Trial.Reference = OrientedBoxVolume(ReferenceCenter, Rotation, FVecD(Extent), FVecD(Plane.Normal), Plane.W);
+			Trial.FullVolume = 8.0 * Extent.X * Extent.Y * Extent.Z;
+			return Trial;
+		}},
+		{ "capsule, 2 steps", 0.04, CapsuleCase(2) },
+		{ "capsule, 8 steps", 0.005, CapsuleCase(8) },
+		{ "capsule, 32 steps", 0.005, CapsuleCase(32) },
+		{ "convex hull", 0.005, [&Hull](std::mt19937& Random) { return MeshTrial(Random, Hull); } },
+		{ "tri-mesh", 0.005, [&Bumpy](std::mt19937& Random) { return MeshTrial(Random, Bumpy); } },
+		{ "waterline, scaled", 0.001, [&Hull](std::mt19937& Random) { return WaterlineTrial(Random, Hull); } },
+	};
+
+	std::printf("%-20s %12s %12s %12s\n", "case", "mean err %", "max err %", "ns/call");
+
+	int32_t Failures = 0;
+	volatile float Sink = 0.f;
+	for (const FCase& Case : Cases)
+	{
+		std::mt19937 Random(1234);
+		double SumError = 0.0, MaxError = 0.0, Nanoseconds = 0.0;
+		bool bFailed = false;
+		for (int32_t TrialIdx = 0; TrialIdx < Trials; ++TrialIdx)
+		{
+			const FTrial Trial = Case.MakeTrial(Random);
+
+			const auto Start = std::chrono::steady_clock::now();
+			// every call is stored to the sink so none of them can be dropped, the volume is read back from it
+			for (int32_t Call = 0; Call < TimedCalls; ++Call)
+				Sink = Trial.Kernel();
+			const auto End = std::chrono::steady_clock::now();
+			Nanoseconds += std::chrono::duration<double, std::nano>(End - Start).count() / TimedCalls;
+			const float Volume = Sink;
+
+			const double Error = std::fabs(Volume - Trial.Reference) / Trial.FullVolume;
+			SumError += Error;
+			MaxError = std::max(MaxError, Error);
+			if (Error > Case.Tolerance)
+				bFailed = true;
+		}
+
+		std::printf("%-20s %12.3f %12.3f %12.1f %s\n", Case.Name, SumError / Trials * 100.0, MaxError * 100.0, Nanoseconds / Trials, bFailed ? "FAILED" : "");
+		Failures += bFailed ? 1 : 0;
+	}
+
+	return Failures > 0 ? 1 : 0;
+}